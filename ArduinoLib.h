@@ -100,6 +100,9 @@
 #define LIVEWEB_RW_PORT 8081    
 #define LIVEWEB_RO_PORT 8082    
 
+// largest allowed -t earth map render threads
+#define MAX_MAP_THREADS 16
+
 // character codes for tft.get/putChar(), mostly ASCII control plus a few more
 #define CHAR_NONE       0
 #define CHAR_BS         '\b'
@@ -185,6 +188,7 @@ extern int liveweb_max;
 extern int liveweb_to;
 extern const int liveweb_maxmax;
 extern int restful_port;
+extern int map_threads;
 extern bool skip_skip;
 extern bool init_iploc;
 extern bool want_kbcursor;
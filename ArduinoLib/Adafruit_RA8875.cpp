@@ -14,6 +14,10 @@
  * FB_X0 and FB_Y0 are the upper left coords on the hardware of drawing area FB_YRES x FB_XRES.
  *
  * Earth map pixels are mmap'd from local day and night files.
+ *
+ * Gray display is applied through gray_lut, never per drawing call: GRAY_ALL converts each changed tile as it
+ * is copied from fb_canvas to fb_stage, so fb_canvas always holds color; GRAY_MAP converts just the map
+ * pixels in plotEarth().
  * 
  * This class assumes the original ESP Arduino code was drawing onto a canvas 800w x 480h, set by APP_WIDTH
  * and APP_HEIGHT. If it weren't for fonts and the Earth map this could be scaled rather easily to any size.
@@ -151,22 +155,54 @@ Adafruit_RA8875::Adafruit_RA8875(uint8_t CS, uint8_t RST)
         DEARTH_BIG = NULL;
         NEARTH_BIG = NULL;
 
+        // color until told otherwise
+        gray_type = GRAY_OFF;
+
         // not ready until proven
         ready = false;
 
         // reset until known
         screen_w = screen_h = 0;
+
+        // stage everything first time
+        memset ((void*)fb_tiles, 1, sizeof(fb_tiles));
+        memset (stage_tile_gen, 0, sizeof(stage_tile_gen));
+        stage_gen = 0;
+}
+
+/* set day and night earth map pyramids, both must be the same size.
+ */
+void Adafruit_RA8875::setEarthPix (const EarthPyr *day_pyr, const EarthPyr *night_pyr)
+{
+        DEARTH_BIG = day_pyr;
+        NEARTH_BIG = night_pyr;
 }
 
-/* set mmap'ed location and size of day and night images, size in units of uint16_t
+// RGB565 to gray fbpix_t, built the first time gray is engaged
+static fbpix_t *gray_lut;
+
+/* set gray display type, building gray_lut if first time.
  */
-void Adafruit_RA8875::setEarthPix (char *day_pixels, char *night_pixels, int width, int height)
+void Adafruit_RA8875::setGrayDisplay (GrayDpy_t g)
 {
-        DEARTH_BIG = (uint16_t*) day_pixels;
-        NEARTH_BIG = (uint16_t*) night_pixels;
+        if (g != GRAY_OFF && !gray_lut) {
+            fbpix_t *lut = (fbpix_t *) malloc (0x10000 * sizeof(fbpix_t));
+            if (!lut) {
+                ::printf ("RA8875: no memory for gray table\n");
+                exit(1);
+            }
+            for (uint32_t c = 0; c < 0x10000; c++) {
+                uint32_t gray = RGB2GRAY (RGB565_R(c), RGB565_G(c), RGB565_B(c));
+                lut[c] = RGB32TOFBPIX ((gray<<16) | (gray<<8) | (gray));
+            }
+            gray_lut = lut;
+        }
 
-        EARTH_BIG_W = width;
-        EARTH_BIG_H = height;
+        if (g != gray_type) {
+            gray_type = g;
+            memset ((void*)fb_tiles, 1, sizeof(fb_tiles));   // restage everything in the new style
+            fb_dirty = true;
+        }
 }
 
 #if defined(_USE_X11)
@@ -793,6 +829,7 @@ bool Adafruit_RA8875::setBackingStore (uint8_t *&backing_store, int x0, int y0,
             bs_walk += row_bytes;
             fb_row += FB_XRES;
         }
+        markTiles (x0, y0, x0+w-1, y0+h-1);
 
         free (backing_store);
         backing_store = NULL;
@@ -817,6 +854,65 @@ bool Adafruit_RA8875::getRawPix(uint8_t *rgb24, int npix)
         return (true);
 }
 
+/* same as getRawPix() but only update rgb24 within tiles that have changed in fb_stage since gen, which
+ * must be 0 the first time to get everything. gen is then updated for use on the next call.
+ * if tile_rows is not NULL, each of its FB_TILES_H entries is set to whether that row of tiles changed.
+ */
+bool Adafruit_RA8875::getRawPix(uint8_t *rgb24, int npix, uint32_t &gen, bool tile_rows[])
+{
+        if (npix != FB_XRES * FB_YRES) {
+            ::printf ("getRawPix: %d != %d\n", npix, FB_XRES * FB_YRES);
+            return (false);
+        }
+
+        // N.B. all tiles marked <= gen_now have been completely staged
+        pthread_mutex_lock (&fb_lock);
+            uint32_t gen_now = stage_gen;
+        pthread_mutex_unlock (&fb_lock);
+
+        for (int ty = 0; ty < FB_TILES_H; ty++) {
+
+            int y0 = ty*FB_TILE_SZ;
+            int y1 = y0 + FB_TILE_SZ;
+            if (y1 > FB_YRES)
+                y1 = FB_YRES;
+
+            // check for any change in this row of tiles
+            bool row_changed = false;
+            for (int tx = 0; !row_changed && tx < FB_TILES_W; tx++)
+                if (gen == 0 || stage_tile_gen[ty*FB_TILES_W + tx] > gen)
+                    row_changed = true;
+            if (tile_rows)
+                tile_rows[ty] = row_changed;
+            if (!row_changed)
+                continue;
+
+            // convert each changed tile
+            for (int tx = 0; tx < FB_TILES_W; tx++) {
+                if (gen != 0 && stage_tile_gen[ty*FB_TILES_W + tx] <= gen)
+                    continue;
+                int x0 = tx*FB_TILE_SZ;
+                int x1 = x0 + FB_TILE_SZ;
+                if (x1 > FB_XRES)
+                    x1 = FB_XRES;
+                for (int y = y0; y < y1; y++) {
+                    const fbpix_t *sp = &fb_stage[y*FB_XRES + x0];
+                    uint8_t *rp = &rgb24[3*(y*FB_XRES + x0)];
+                    for (int x = x0; x < x1; x++) {
+                        fbpix_t fbp = *sp++;
+                        uint32_t p32 = FBPIXTORGB32(fbp);
+                        *rp++ = p32 >> 16;
+                        *rp++ = p32 >> 8;
+                        *rp++ = p32;
+                    }
+                }
+            }
+        }
+
+        gen = gen_now;
+        return (true);
+}
+
 void Adafruit_RA8875::setFont (const GFXfont *f)
 {
 	if (f)
@@ -1654,28 +1750,135 @@ int16_t thick, fbpix_t color)
  */
 void Adafruit_RA8875::plotfb (int16_t x, int16_t y, fbpix_t color)
 {
-        // perform gray_type
-        switch (gray_type) {
-        case GRAY_OFF:
-        case GRAY_MAP:
-            // no change -- color ok
-            break;
-        case GRAY_ALL: {
-            uint32_t rgb = FBPIXTORGB32(color);
-            int r = (rgb >> 16) & 0xff;
-            int g = (rgb >> 8) & 0xff;
-            int b = rgb & 0xff;
-            int gray = RGB2GRAY(r,g,b);
-            color = RGB32TOFBPIX ((gray<<16) | (gray<<8) | (gray));
-            }
-            break;
-        }
-
         int index = y*FB_XRES + x;
         if (index < 0 || index >= FB_XRES*FB_YRES)
             ::printf ("no! %d %d\n", x, y);
-        else
+        else {
             fb_canvas[index] = color;
+            fb_tiles[FB_TILE_I (index%FB_XRES, index/FB_XRES)] = 1;
+        }
+}
+
+/* mark all tiles touching the given inclusive fb region as needing to be staged.
+ */
+void Adafruit_RA8875::markTiles (int x0, int y0, int x1, int y1)
+{
+        if (x0 < 0)
+            x0 = 0;
+        if (y0 < 0)
+            y0 = 0;
+        if (x1 >= FB_XRES)
+            x1 = FB_XRES - 1;
+        if (y1 >= FB_YRES)
+            y1 = FB_YRES - 1;
+        for (int ty = y0>>FB_TILE_SHIFT; ty <= (y1>>FB_TILE_SHIFT); ty++)
+            for (int tx = x0>>FB_TILE_SHIFT; tx <= (x1>>FB_TILE_SHIFT); tx++)
+                fb_tiles[ty*FB_TILES_W + tx] = 1;
+}
+
+/* copy n pixels from canvas to stage if they differ, return whether they did.
+ * if lut is not NULL, stage gets each canvas pixel converted through it.
+ */
+static bool stageSpan (fbpix_t *stage, const fbpix_t *canvas, int n, const fbpix_t *lut)
+{
+        if (n <= 0)
+            return (false);
+
+        if (lut) {
+            bool changed = false;
+            for (int i = 0; i < n; i++) {
+                fbpix_t p = lut[FBPIXTORGB16(canvas[i])];
+                if (stage[i] != p) {
+                    stage[i] = p;
+                    changed = true;
+                }
+            }
+            return (changed);
+        }
+
+        if (memcmp (stage, canvas, n*sizeof(fbpix_t)) == 0)
+            return (false);
+        memcpy (stage, canvas, n*sizeof(fbpix_t));
+        return (true);
+}
+
+/* copy each marked fb_canvas tile to fb_stage, avoiding the protected region unless pr_draw.
+ * pass back the inclusive bounding box of all tiles that actually changed, return whether any did.
+ * N.B. we assume fb_lock is held
+ */
+bool Adafruit_RA8875::stageTiles (int &bb_x0, int &bb_y0, int &bb_x1, int &bb_y1)
+{
+        bool any_change = false;
+        bool pr_on = !pr_draw && pr_w > 0 && pr_h > 0;
+        int pr_r = pr_x + pr_w;                                 // right of PR
+        int pr_b = pr_y + pr_h;                                 // bottom of PR
+        uint32_t gen = stage_gen + 1;
+        const fbpix_t *lut = gray_type == GRAY_ALL ? gray_lut : NULL;
+
+        for (int ty = 0; ty < FB_TILES_H; ty++) {
+            int y0 = ty*FB_TILE_SZ;
+            int y1 = y0 + FB_TILE_SZ;
+            if (y1 > FB_YRES)
+                y1 = FB_YRES;
+
+            for (int tx = 0; tx < FB_TILES_W; tx++) {
+                int ti = ty*FB_TILES_W + tx;
+                if (!fb_tiles[ti])
+                    continue;
+
+                int x0 = tx*FB_TILE_SZ;
+                int x1 = x0 + FB_TILE_SZ;
+                if (x1 > FB_XRES)
+                    x1 = FB_XRES;
+
+                // tiles overlapping the protected region are staged only around it and stay marked until
+                // pr_draw. others are unmarked before copying so unlocked plotEarth() can not be missed.
+                bool in_pr = pr_on && x1 > pr_x && y1 > pr_y && x0 < pr_r && y0 < pr_b;
+                if (!in_pr)
+                    fb_tiles[ti] = 0;
+
+                bool tile_changed = false;
+                for (int y = y0; y < y1; y++) {
+                    fbpix_t *stage_p = &fb_stage[y*FB_XRES];
+                    fbpix_t *canvas_p = &fb_canvas[y*FB_XRES];
+                    if (in_pr && y >= pr_y && y < pr_b) {
+                        int l1 = x1 < pr_x ? x1 : pr_x;         // end of span left of PR
+                        int r0 = x0 > pr_r ? x0 : pr_r;         // start of span right of PR
+                        if (stageSpan (stage_p+x0, canvas_p+x0, l1-x0, lut))
+                            tile_changed = true;
+                        if (stageSpan (stage_p+r0, canvas_p+r0, x1-r0, lut))
+                            tile_changed = true;
+                    } else {
+                        if (stageSpan (stage_p+x0, canvas_p+x0, x1-x0, lut))
+                            tile_changed = true;
+                    }
+                }
+
+                if (tile_changed) {
+                    stage_tile_gen[ti] = gen;
+                    if (!any_change) {
+                        bb_x0 = x0;
+                        bb_y0 = y0;
+                        bb_x1 = x1 - 1;
+                        bb_y1 = y1 - 1;
+                        any_change = true;
+                    } else {
+                        if (x0 < bb_x0)
+                            bb_x0 = x0;
+                        if (x1 - 1 > bb_x1)
+                            bb_x1 = x1 - 1;
+                        if (y1 - 1 > bb_y1)
+                            bb_y1 = y1 - 1;
+                        // y can't get any smaller
+                    }
+                }
+            }
+        }
+
+        if (any_change)
+            stage_gen = gen;
+
+        return (any_change);
 }
 
 /* plot hi res earth lat0,lng0 at app's screen location x0,y0.
@@ -1705,39 +1908,61 @@ float dlatr, float dlngr, float dlatd, float dlngd, float fract_day)
 	x0 *= SCALESZ;
 	y0 *= SCALESZ;
 
+        // pick the pyramid level whose texels best match our pixel size, the far side of a globe
+        // can step over several full size texels per pixel
+        float tpp_x = fmaxf (fabsf(dlngr), fabsf(dlngd)) * DEARTH_BIG->w / 360;
+        float tpp_y = fmaxf (fabsf(dlatr), fabsf(dlatd)) * DEARTH_BIG->h / 180;
+        const int lev = earthPyrLevel (DEARTH_BIG, fmaxf (tpp_x, tpp_y));
+        const int lev_w = DEARTH_BIG->lev_w[lev];
+        const int lev_h = DEARTH_BIG->lev_h[lev];
+
+        // find each map texel, gathering both day and night only if blending
+        #define MAX_SCALESZ 4
+        uint16_t day_pix[MAX_SCALESZ*MAX_SCALESZ];
+        uint16_t night_pix[MAX_SCALESZ*MAX_SCALESZ];
+        uint16_t twi_pix[MAX_SCALESZ*MAX_SCALESZ];
+        const uint16_t *src_pix;
+        int n_pix = 0;
 	for (int r = 0; r < SCALESZ; r++) {
-	    fbpix_t *frow = &fb_canvas[(y0+r)*FB_XRES + x0];
 	    for (int c = 0; c < SCALESZ; c++) {
                 float lat = lat0 + dlatr*c + dlatd*r;
                 float lng = lng0 + dlngr*c + dlngd*r;
-                int ex = (int)((lng+180)*EARTH_BIG_W/360 + EARTH_BIG_W + 0.5F);
-                int ey = (int)((90-lat)*EARTH_BIG_H/180 + EARTH_BIG_H + 0.5F);
-                ex = (ex + EARTH_BIG_W) % EARTH_BIG_W;
-                ey = (ey + EARTH_BIG_H) % EARTH_BIG_H;
-		uint16_t c16; 
+                int ex = (int)((lng+180)*lev_w/360 + lev_w + 0.5F);
+                int ey = (int)((90-lat)*lev_h/180 + lev_h + 0.5F);
+                ex = (ex + lev_w) % lev_w;
+                ey = (ey + lev_h) % lev_h;
 		if (fract_day == 0) {
-		    c16 = EPIXEL(NEARTH_BIG,ey,ex);
+		    night_pix[n_pix] = earthPyrPixel (NEARTH_BIG, lev, ey, ex);
 		} else if (fract_day == 1) {
-		    c16 = EPIXEL(DEARTH_BIG,ey,ex);
+		    day_pix[n_pix] = earthPyrPixel (DEARTH_BIG, lev, ey, ex);
 		} else {
-		    // blend from day to night
-		    uint16_t day_pix = EPIXEL(DEARTH_BIG,ey,ex);
-		    uint16_t night_pix = EPIXEL(NEARTH_BIG,ey,ex);
-		    uint8_t day_r = RGB565_R(day_pix);
-		    uint8_t day_g = RGB565_G(day_pix);
-		    uint8_t day_b = RGB565_B(day_pix);
-		    uint8_t night_r = RGB565_R(night_pix);
-		    uint8_t night_g = RGB565_G(night_pix);
-		    uint8_t night_b = RGB565_B(night_pix);
-		    float fract_night = 1 - fract_day;
-		    uint8_t twi_r = (fract_day*day_r + fract_night*night_r);
-		    uint8_t twi_g = (fract_day*day_g + fract_night*night_g);
-		    uint8_t twi_b = (fract_day*day_b + fract_night*night_b);
-		    c16 = RGB565 (twi_r, twi_g, twi_b);
+		    day_pix[n_pix] = earthPyrPixel (DEARTH_BIG, lev, ey, ex);
+		    night_pix[n_pix] = earthPyrPixel (NEARTH_BIG, lev, ey, ex);
 		}
-		*frow++ = RGB16TOFBPIX(c16);
+                n_pix++;
 	    }
 	}
+
+        // blend the whole block at once if twilight
+        if (fract_day == 0) {
+            src_pix = night_pix;
+        } else if (fract_day == 1) {
+            src_pix = day_pix;
+        } else {
+            blendRGB565 (day_pix, night_pix, twi_pix, n_pix, fract_day);
+            src_pix = twi_pix;
+        }
+
+        // copy to canvas, converting to gray here if only the map is gray
+        const fbpix_t *lut = gray_type == GRAY_MAP ? gray_lut : NULL;
+	for (int r = 0; r < SCALESZ; r++) {
+	    fbpix_t *frow = &fb_canvas[(y0+r)*FB_XRES + x0];
+	    for (int c = 0; c < SCALESZ; c++) {
+                uint16_t c16 = *src_pix++;
+		*frow++ = lut ? lut[c16] : RGB16TOFBPIX(c16);
+            }
+	}
+        markTiles (x0, y0, x0+SCALESZ-1, y0+SCALESZ-1);
 }
 
 void Adafruit_RA8875::plotChar (char ch)
@@ -1745,18 +1970,16 @@ void Adafruit_RA8875::plotChar (char ch)
 	if (ch < current_font->first || ch > current_font->last)
 	    return;     // don't print if don't count length
 	GFXglyph *gp = &current_font->glyph[ch-current_font->first];
-	uint8_t *bp = &current_font->bitmap[gp->bitmapOffset];
 	int16_t x = cursor_x + gp->xOffset;
 	int16_t y = cursor_y + gp->yOffset;
-	uint16_t bitn = 0;
 	pthread_mutex_lock (&fb_lock);
-	    for (uint16_t r = 0; r < gp->height; r++) {
-		for (uint16_t c = 0; c < gp->width; c++) {
-		    uint8_t bit = bp[bitn/8] & (1 << (7-(bitn%8)));
-		    if (bit)
-			plotfb (x+c, y+r, text_color);
-		    bitn++;
-		}
+	    // fill the glyph's pre-expanded runs, see glyphspans.cpp
+	    int n_spans;
+	    const GlyphSpan *sp = getGlyphSpans (current_font, (uint8_t)ch, n_spans);
+	    if (sp && n_spans > 0) {
+		fillGlyphSpans (fb_canvas, FB_XRES, FB_YRES, x, y, gp->width, gp->height, sp, n_spans,
+				text_color);
+		markTiles (x, y, x + gp->width - 1, y + gp->height - 1);
 	    }
 	    fb_dirty = true;
 	pthread_mutex_unlock (&fb_lock);
@@ -1850,52 +2073,13 @@ void *Adafruit_RA8875::fbThreadHelper(void *me)
 // _USE_X11
 void Adafruit_RA8875::drawCanvas()
 {
-        // send one block containing the rectangular bounding box of the changed pixels. smaller
+        // send one block containing the rectangular bounding box of the changed tiles. smaller
         // transations would send fewer pixels but each transaction is expensive.. found no happy medium.
 
-        bool any_change = false;
-
         // bounding box
         int bb_x0 = 0, bb_y0 = 0, bb_x1 = 0, bb_y1 = 0;
 
-        for (int y = 0; y < FB_YRES; y++) {
-
-            // we assume protected region is at lower right
-            int max_x = pr_draw || pr_w == 0 || y < pr_y ? FB_XRES : pr_x;
-
-            // handy start of this row
-            fbpix_t *stage_p = &fb_stage[y*FB_XRES];
-            fbpix_t *canvas_p = &fb_canvas[y*FB_XRES];
-
-            for (int x = 0; x < FB_XRES; x++) {
-
-                int max_y = pr_draw || pr_h == 0 || x < pr_x ? FB_YRES : pr_y;
-                if (x >= max_x && y >= max_y)
-                    continue;
-
-                if (stage_p[x] != canvas_p[x]) {
-
-                    // update pixel
-                    stage_p[x] = canvas_p[x];
-
-                    // update bounding box
-                    if (!any_change) {
-                        bb_x0 = bb_x1 = x;
-                        bb_y0 = bb_y1 = y;
-                    }
-                    if (x < bb_x0)
-                        bb_x0 = x;
-                    if (x > bb_x1)
-                        bb_x1 = x;
-                    if (y > bb_y1)
-                        bb_y1 = y;
-                    // y can't get any smaller
-
-                    // found something to do
-                    any_change = true;
-                }
-            }
-        }
+        bool any_change = stageTiles (bb_x0, bb_y0, bb_x1, bb_y1);
 
         if (any_change) {
 
@@ -2446,24 +2630,9 @@ void Adafruit_RA8875::fbThread ()
 // _WEB_ONLY
 void Adafruit_RA8875::drawCanvas()
 {
-        for (int y = 0; y < FB_YRES; y++) {
-
-            // we assume protected region is at lower right
-            int max_x = pr_draw || pr_w == 0 || y < pr_y ? FB_XRES : pr_x;
-
-            // handy start of this row
-            fbpix_t *stage_p = &fb_stage[y*FB_XRES];
-            fbpix_t *canvas_p = &fb_canvas[y*FB_XRES];
-
-            for (int x = 0; x < FB_XRES; x++) {
-
-                int max_y = pr_draw || pr_h == 0 || x < pr_x ? FB_YRES : pr_y;
-                if (x >= max_x && y >= max_y)
-                    continue;
-
-                stage_p[x] = canvas_p[x];
-            }
-        }
+        // just update fb_stage for getRawPix()
+        int bb_x0, bb_y0, bb_x1, bb_y1;
+        (void) stageTiles (bb_x0, bb_y0, bb_x1, bb_y1);
 }
 
 // _WEB_ONLY
@@ -2863,34 +3032,15 @@ void Adafruit_RA8875::setCursorIfVis (uint16_t row, uint16_t col, fbpix_t color)
             fb_cursor[row*FB_XRES + col] = color;
 }
 
-/* display fb_canvas.
+/* stage fb_canvas.
  * N.B. we assume fb_lock is held
  */
 // _USE_FB0
 void Adafruit_RA8875::drawCanvas()
 {
-        // put only the unproteced region unless pr_draw is set
-        if (pr_draw) {
-            // draw everything
-            memcpy (fb_stage, fb_canvas, fb_nbytes);
-        } else {
-            // draw only around the protected area
-            uint16_t bw = FB_XRES*BYTESPFBPIX;                                  // bytes wide
-            uint16_t pr_r = pr_x + pr_w;                                        // right of PR
-            uint16_t pr_b = pr_y + pr_h;                                        // bottom of PR
-            fbpix_t *s_row = fb_stage;                                          // next stage row
-            fbpix_t *c_row = fb_canvas;                                         // next canvas row
-            for (uint16_t y = 0; y < FB_YRES; y++, c_row += FB_XRES, s_row += FB_XRES) {
-                if (y < pr_y) {
-                    memcpy (s_row, c_row, bw);                                  // above
-                } else if (y < pr_b) {
-                    memcpy (s_row, c_row, pr_x*BYTESPFBPIX);                    // left
-                    memcpy (s_row+pr_r, c_row+pr_r, (FB_XRES-pr_r)*BYTESPFBPIX);// right
-                } else {
-                    memcpy (s_row, c_row, bw);                                  // below
-                }
-            }
-        }
+        // stage only the marked tiles, fbThread() copies to hardware
+        int bb_x0, bb_y0, bb_x1, bb_y1;
+        (void) stageTiles (bb_x0, bb_y0, bb_x1, bb_y1);
 }
 
 /* thread that runs forever to update display buffer whenever fb_canvas changes
@@ -2901,17 +3051,21 @@ void Adafruit_RA8875::fbThread ()
         // init cursor timeout off soon
         gettimeofday (&mouse_tv, NULL);
 
+        // whether hardware display currently includes the cursor, start with full copy
+        bool cursor_shown = true;
+
         // update screen periodically
 	for (;;) {
 
             // all set
             ready = true;
 
-	    // get stable copy of canvas into staging area
+	    // get stable copy of changed canvas tiles into staging area
+            int bb_x0 = 0, bb_y0 = 0, bb_x1 = 0, bb_y1 = 0;
 	    pthread_mutex_lock (&fb_lock);
-		bool is_new = fb_dirty || pr_draw;
-		if (is_new) {
-                    drawCanvas();
+		bool is_new = false;
+		if (fb_dirty || pr_draw) {
+                    is_new = stageTiles (bb_x0, bb_y0, bb_x1, bb_y1);
 		    fb_dirty = false;
                     pr_draw = false;
 		}
@@ -2922,15 +3076,23 @@ void Adafruit_RA8875::fbThread ()
             gettimeofday (&tv, NULL);
             mouse_idle = (tv.tv_sec - mouse_tv.tv_sec)*1000 + (tv.tv_usec - mouse_tv.tv_usec)/1000;
 
-            // copy fb_stage to hardware display if new or mouse moved
-            if (is_new || mouse_idle < MOUSE_FADE) {
+            // if the cursor is not showing, just copy the changed region of fb_stage directly to hardware
+            if (is_new && mouse_idle >= MOUSE_FADE && !cursor_shown) {
+                const int bb_bytes = (bb_x1 - bb_x0 + 1)*BYTESPFBPIX;
+                for (int y = bb_y0; y <= bb_y1; y++)
+                    memcpy (fb_fb + (FB_Y0+y)*fb_si.xres + FB_X0 + bb_x0, fb_stage + y*FB_XRES + bb_x0, bb_bytes);
+            }
+
+            // else copy all of fb_stage to hardware display if new, mouse moved or cursor just faded
+            else if (is_new || mouse_idle < MOUSE_FADE || cursor_shown) {
 
                 // copy to cursor layer
                 memcpy (fb_cursor, fb_stage, fb_nbytes);
 
                 // add cursor if moved
                 // N.B.: CAN NOT use the nice drawing tools because they use fb_canvas
-                if (mouse_idle < MOUSE_FADE) {
+                cursor_shown = mouse_idle < MOUSE_FADE;
+                if (cursor_shown) {
                     const fbpix_t fgcolor = RGB16TOFBPIX(RGB565(0,0,0));
                     const fbpix_t bgcolor = RGB16TOFBPIX(RGB565(0xFF,0x22,0x22));
                     // fill top half
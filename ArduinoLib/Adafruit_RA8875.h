@@ -8,6 +8,7 @@
 #include "Arduino.h"
 
 #include <stdint.h>
+#include <stddef.h>
 #include <pthread.h>
 #include <sys/time.h>
 
@@ -86,6 +87,50 @@ extern const GFXfont Courier_Prime_Sans6pt7b;
 #endif
 
 
+// blend RGB565 day and night earth pixels, see blend565.cpp
+extern void blendRGB565 (const uint16_t *day, const uint16_t *night, uint16_t *out, int n, float fract_day);
+
+
+// GFX glyphs pre-expanded to runs of set pixels, see glyphspans.cpp
+typedef struct {
+    uint16_t r, c, n;                                   // row and first column within glyph box, n pixels
+} GlyphSpan;
+extern const GlyphSpan *getGlyphSpans (const GFXfont *f, uint16_t ch, int &n_spans);
+extern void fillGlyphSpans (fbpix_t *fb, int fb_w, int fb_h, int x, int y, int w, int h,
+        const GlyphSpan *sp, int n_spans, fbpix_t color);
+
+
+// mip-mapped earth map storage, level 0 row-major, the others tiled, see earthpyr.cpp
+#define EPYR_MAGIC      "HCEPYR2"                       // 8 bytes including EOS
+#define EPYR_TSHIFT     6                               // log2 of tile edge
+#define EPYR_TILE       (1<<EPYR_TSHIFT)                // tile edge, pixels
+#define EPYR_TMASK      (EPYR_TILE-1)
+#define EPYR_MAXLEV     8                               // max levels including full size
+typedef struct {
+    char magic[8];                                      // EPYR_MAGIC
+    int64_t src_mtime;                                  // mod time of source image, for caller's use
+    int32_t w, h;                                       // level 0 size, pixels
+    int32_t n_lev;                                      // levels in use
+    int32_t lev_w[EPYR_MAXLEV], lev_h[EPYR_MAXLEV];     // size of each level, pixels
+    int32_t lev_tx[EPYR_MAXLEV];                        // tiles in each row of each level, 0 if row-major
+    int32_t lev_off[EPYR_MAXLEV];                       // first pixel of each level after header
+    int32_t n_pix;                                      // total RGB565 pixels following header
+} EarthPyr;
+extern size_t earthPyrSize (int w, int h);
+extern bool earthPyrOk (const EarthPyr *pyr, size_t nbytes, int w, int h);
+extern void buildEarthPyr (const uint16_t *src, int w, int h, int64_t src_mtime, EarthPyr *pyr);
+extern int earthPyrLevel (const EarthPyr *pyr, float texels_per_pix);
+
+// return pixel at row r column c of the given level
+static inline uint16_t earthPyrPixel (const EarthPyr *pyr, int l, int r, int c)
+{
+    const uint16_t *lp = (const uint16_t *)(pyr+1) + pyr->lev_off[l];
+    if (l == 0)
+        return (lp[r*pyr->w + c]);
+    return (lp[(((r >> EPYR_TSHIFT)*pyr->lev_tx[l] + (c >> EPYR_TSHIFT)) << (2*EPYR_TSHIFT))
+                + ((r & EPYR_TMASK) << EPYR_TSHIFT) + (c & EPYR_TMASK)]);
+}
+
 
 // basic background refresh interval, usecs
 #define REFRESH_US      50000
@@ -191,8 +236,8 @@ class Adafruit_RA8875 {
         void setMouse (int x, int y);
         bool warpCursor (char dir, unsigned n, int *xp, int *yp);
 
-        // set mmap'ed location and size of day and night images, size in units of uint16_t
-        void setEarthPix (char *day_pixels, char *night_pixels, int width, int height);
+        // set day and night earth map pyramids, see earthpyr.cpp
+        void setEarthPix (const EarthPyr *day_pyr, const EarthPyr *night_pyr);
 
         // used to engage/disengage X11 fullscreen
         void X11OptionsEngageNow (bool fullscreen);
@@ -207,12 +252,11 @@ class Adafruit_RA8875 {
         bool getBackingStore (uint8_t *&bs, int x0, int y0, int w, int h);
         bool setBackingStore (uint8_t *&bs, int x0, int y0, int w, int h);
         bool getRawPix (uint8_t *rgb24, int npix);
+        bool getRawPix (uint8_t *rgb24, int npix, uint32_t &gen, bool tile_rows[]);
 
 
         // control whether to display gray
-        void setGrayDisplay (GrayDpy_t g) {
-            gray_type = g;
-        };
+        void setGrayDisplay (GrayDpy_t g);
 
     protected:
 
@@ -249,6 +293,14 @@ class Adafruit_RA8875 {
 
 #endif
 
+        // the canvas is divided into square tiles, each marked when drawn so only those need be staged
+        #define FB_TILE_SHIFT   5
+        #define FB_TILE_SZ      (1<<FB_TILE_SHIFT)                      // tile size, pixels
+        #define FB_TILES_W      ((FB_XRES+FB_TILE_SZ-1)/FB_TILE_SZ)     // tiles across
+        #define FB_TILES_H      ((FB_YRES+FB_TILE_SZ-1)/FB_TILE_SZ)     // tiles down
+        #define FB_NTILES       (FB_TILES_W*FB_TILES_H)                 // total tiles
+        #define FB_TILE_I(x,y)  (((y)>>FB_TILE_SHIFT)*FB_TILES_W + ((x)>>FB_TILE_SHIFT))
+
 #ifdef _USE_X11
 
 	Display *display;
@@ -327,6 +379,11 @@ class Adafruit_RA8875 {
 	fbpix_t *fb_canvas;             // main drawing image buffer
 	fbpix_t *fb_stage;              // temp image during staging to fb hw
 	int fb_nbytes;                  // bytes in each in-memory image buffer
+        volatile uint8_t fb_tiles[FB_NTILES];   // set when fb_canvas tile is drawn, cleared when staged
+        uint32_t stage_gen;                     // incremented each time any fb_stage tile changes
+        uint32_t stage_tile_gen[FB_NTILES];     // stage_gen when each fb_stage tile last changed
+        void markTiles (int x0, int y0, int x1, int y1);
+        bool stageTiles (int &bb_x0, int &bb_y0, int &bb_x1, int &bb_y1);
 	void plotChar (char c);
 	fbpix_t text_color;
 	uint16_t cursor_x, cursor_y;
@@ -350,13 +407,9 @@ class Adafruit_RA8875 {
         void drawThickLine (int16_t aXStart, int16_t aYStart, int16_t aXEnd, int16_t aYEnd,
                         int16_t aThickness, uint8_t aThicknessMode, fbpix_t aColor);
 
-	// big earth mmap'd maps, actually 2d EARTH_BIG_H rows x EARTH_BIG_W columns
-        uint16_t *DEARTH_BIG;
-        uint16_t *NEARTH_BIG;
-        int EARTH_BIG_H, EARTH_BIG_W;
-
-        // handy macro to implement the 2d nature of the arrays
-        #define EPIXEL(a,r,c)   ((a)[(r)*EARTH_BIG_W + (c)])
+	// big earth day and night map pyramids, same size
+        const EarthPyr *DEARTH_BIG;
+        const EarthPyr *NEARTH_BIG;
 
         // swap two pairs of x and y
         void swap2 (int16_t &x0, int16_t &y0, int16_t &x1, int16_t &y1) {
@@ -364,7 +417,7 @@ class Adafruit_RA8875 {
             int16_t ty = y0; y0 = y1; y1 = ty;
         }
 
-        // set whether to display gray
+        // whether to display gray, applied via gray_lut in stageTiles() or plotEarth()
         GrayDpy_t gray_type;
 
 };
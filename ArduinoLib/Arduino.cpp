@@ -1,6 +1,7 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <math.h>
+#include <signal.h>
 #include <stdarg.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -13,12 +14,12 @@
 #include <unistd.h>
 
 #include "Arduino.h"
+#include "EEPROM.h"
 
 char **our_argv;      // our argv for restarting
 std::string our_dir;  // our storage directory, including trailing /
 bool rm_eeprom;       // set by -0 to rm eeprom to restore defaults
 bool ignore_x11geom;  // set by -q to ignore startup loc and size
-bool verbose_logging; // set by -D to enable verbose logs
 
 // list of diagnostic files, newest first
 const char *diag_files[N_DIAG_FILES] = {
@@ -380,6 +381,8 @@ static void usage(const char *errfmt, ...) {
             LIVEWEB_RO_PORT);
     fprintf(stderr, " -s d : start time as if UTC now is d formatted as "
                     "YYYY-MM-DDTHH:MM:SS\n");
+    fprintf(stderr, " -t n : render earth map at once in n bands on all cpus, 0 for "
+                    "one row per loop; default 0\n");
     fprintf(stderr, " -v   : show version info then exit\n");
     fprintf(stderr,
             " -w p : set read-write live web server port to p or -1 to "
@@ -531,7 +534,7 @@ static void crackArgs(int ac, char *av[]) {
         ignore_x11geom = true;
         break;
       case 'D':
-        verbose_logging = true;
+        log_level = LOG_DEBUG;
         break;
       case 'r':
         if (ac < 2)
@@ -545,6 +548,14 @@ static void crackArgs(int ac, char *av[]) {
         setUsrDateTime(*++av);
         ac--;
         break;
+      case 't':
+        if (ac < 2)
+          usage("missing number of map bands for -t");
+        map_threads = atoi(*++av);
+        if (map_threads < 0 || map_threads > MAX_MAP_THREADS)
+          usage("-t must be [0,%d]", MAX_MAP_THREADS);
+        ac--;
+        break;
       case 'v':
         showVersion();
         exit(0);
@@ -618,6 +629,57 @@ static void crackArgs(int ac, char *av[]) {
     setX11FullScreen(full_screen);
 }
 
+// SIGTERM and SIGINT are passed from onExitSignal() to exitSignalThread() through this pipe
+static int exit_pipe[2] = {-1, -1};
+
+/* SIGTERM and SIGINT handler: just pass the signal along, doExit() is far from signal safe.
+ */
+static void onExitSignal(int sig) {
+  char c = (char)sig;
+  (void)!write(exit_pipe[1], &c, 1);
+}
+
+/* thread that waits for onExitSignal() then exits cleanly, much as the X11 thread does on window close.
+ */
+static void *exitSignalThread(void *arg) {
+  (void)arg;
+  pthread_detach(pthread_self());
+
+  char c;
+  while (read(exit_pipe[0], &c, 1) != 1)
+    continue;
+  printf("Exiting on signal %d\n", c);
+  doExit(); // saves settings, never returns
+  return (NULL);
+}
+
+/* arrange for SIGTERM and SIGINT to save pending settings and logs before exiting.
+ * a handler rather than a blocked mask so children we exec still get default signal handling.
+ */
+static void catchExitSignals(void) {
+  if (pipe(exit_pipe) < 0) {
+    printf("exit signal pipe: %s\n", strerror(errno));
+    return;
+  }
+  fcntl(exit_pipe[0], F_SETFD, FD_CLOEXEC);
+  fcntl(exit_pipe[1], F_SETFD, FD_CLOEXEC);
+
+  pthread_t tid;
+  int e = pthread_create(&tid, NULL, exitSignalThread, NULL);
+  if (e) {
+    printf("exit signal thread: %s\n", strerror(e));
+    return;
+  }
+
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = onExitSignal;
+  sa.sa_flags = SA_RESTART;
+  sigemptyset(&sa.sa_mask);
+  sigaction(SIGTERM, &sa, NULL);
+  sigaction(SIGINT, &sa, NULL);
+}
+
 /* Every normal C program requires a main().
  * This is provided as magic in the Arduino IDE so here we must do it ourselves.
  */
@@ -629,6 +691,9 @@ int main(int ac, char *av[]) {
   fcntl(1, F_SETFL, fcntl(1, F_GETFL, 0) | O_APPEND);
   setbuf(stdout, NULL);
 
+  // exit cleanly if told to
+  catchExitSignals();
+
   // initialize extra defines
   initBuildVariables();
 
@@ -655,6 +720,8 @@ int main(int ac, char *av[]) {
 
   for (;;) {
     loop();
+    runTaskCallbacks(); // finish pool jobs that need this thread
+    EEPROM.poll(); // write any settings committed a while ago
     usleep(40000); // 40ms sleep to reduce CPU usage
   }
 }
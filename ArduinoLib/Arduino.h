@@ -65,6 +65,7 @@ extern void capturePasswords (const char *fn);
 
 #include "ESP.h"
 #include "Serial.h"
+#include "TaskPool.h"
 #include "TimeLib.h"
 
 
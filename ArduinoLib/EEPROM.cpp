@@ -1,6 +1,10 @@
 /* implement EEPROM class using a local file.
- * format is %08X %02X\n for each address/byte pair.
- * updates of existing address are performed in place.
+ *
+ * format is a small header followed by the raw bytes, see EEHeader. commit() only notes a change is
+ * pending; the file is rewritten by poll() once COMMIT_MS has passed so a burst of commits costs one
+ * write, and always to a temp file renamed into place so a crash can never leave a partial file.
+ * the original text format, %08X %02X\n for each address/byte pair, is still read, such as from
+ * configurations saved by earlier versions, and rewritten as binary.
  */
 
 #include <string>
@@ -9,6 +13,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <sys/stat.h>
 #include <sys/file.h>
@@ -16,12 +21,42 @@
 #include "Arduino.h"
 #include "EEPROM.h"
 
+#define COMMIT_MS       2000            // max delay from commit() to file
+
+// file header, followed by n_bytes of data
+typedef struct {
+    char magic[8];                      // EE_MAGIC
+    uint32_t n_bytes;                   // bytes following
+    uint32_t checksum;                  // eeChecksum() of those bytes
+} EEHeader;
+
 class EEPROM EEPROM;
 
+/* FNV-1a of the given bytes
+ */
+static uint32_t eeChecksum (const uint8_t *p, size_t n)
+{
+        uint32_t h = 2166136261U;
+        while (n-- > 0) {
+            h ^= *p++;
+            h *= 16777619U;
+        }
+        return (h);
+}
+
+/* write everything pending at exit
+ */
+static void eeAtExit(void)
+{
+        (void) EEPROM.flush();
+}
+
 EEPROM::EEPROM()
 {
-        fp = NULL;
         filename = NULL;
+        lock_fd = -1;
+        changed = false;
+        commit_ms = 0;
 }
 
 const char *EEPROM::getFilename(void)
@@ -43,16 +78,52 @@ const char *EEPROM::getFilename(void)
         return (filename);
 }
 
+/* init data_array from the given binary file image.
+ * return whether it was in the binary format, even if rejected.
+ */
+bool EEPROM::readBinary (const uint8_t *file, size_t n_file)
+{
+        EEHeader hdr;
+        if (n_file < sizeof(hdr))
+            return (false);
+        memcpy (&hdr, file, sizeof(hdr));
+        if (memcmp (hdr.magic, EE_MAGIC, sizeof(hdr.magic)) != 0)
+            return (false);
+
+        const uint8_t *data = file + sizeof(hdr);
+        if (hdr.n_bytes != n_file - sizeof(hdr) || hdr.checksum != eeChecksum (data, hdr.n_bytes)) {
+            printf ("eeprom: %s checksum error, starting over\n", filename);
+            return (true);
+        }
+
+        memcpy (data_array, data, hdr.n_bytes < n_data_array ? hdr.n_bytes : n_data_array);
+        return (true);
+}
+
+/* init data_array from the given text format file .. support old version of random memory locations ...
+ * and another old version with bug that wrote valid locations a second time with zeros.
+ */
+void EEPROM::readText (FILE *fp)
+{
+	char line[64];
+	unsigned int a, v;
+        unsigned int largest_a = 0;
+	while (fgets (line, sizeof(line), fp)) {
+	    if (sscanf (line, "%x %x", &a, &v) == 2 && a < n_data_array && a >= largest_a) {
+                data_array[a] = v;
+                largest_a = a;
+            }
+        }
+}
+
 void EEPROM::begin (int s)
 {
         // establish filename
         filename = getFilename();
 
-        // start over if called again or force
-        if (fp) {
-            fclose(fp);
-            fp = NULL;
-        }
+        // start over if called again, keeping anything pending, or force
+        if (data_array)
+            (void) flush();
         if (rm_eeprom) {
             (void) unlink (filename);
             rm_eeprom = false;  // only once!
@@ -62,54 +133,106 @@ void EEPROM::begin (int s)
             data_array = NULL;
         }
 
-        // open RW, create if new owned by real user
-	fp = fopen (filename, "r+");
-        if (!fp) {
-            fp = fopen (filename, "w+");
-            if (!fp) {
-                fprintf (stderr, "%s: %s\n", filename, strerror(errno));
+        // lock a companion file, not the store itself because commits replace it
+        if (lock_fd < 0) {
+            std::string lockfn = std::string(filename) + ".lock";
+            lock_fd = open (lockfn.c_str(), O_RDWR|O_CREAT, 0664);
+            if (lock_fd < 0) {
+                fprintf (stderr, "%s: %s\n", lockfn.c_str(), strerror(errno));
                 exit(1);
             }
-        }
-        (void) !fchown (fileno(fp), getuid(), getgid());
-
-        // check lock
-        if (flock (fileno(fp), LOCK_EX|LOCK_NB) < 0) {
-            fprintf (stderr, "Another instance of HamClock has been detected.\n"
-                        "Only one at a time is allowed or use -d, -e and -w to make each unique.\n");
-            exit(1);
+            (void) !fchown (lock_fd, getuid(), getgid());
+            if (flock (lock_fd, LOCK_EX|LOCK_NB) < 0) {
+                fprintf (stderr, "Another instance of HamClock has been detected.\n"
+                            "Only one at a time is allowed or use -d, -e and -w to make each unique.\n");
+                exit(1);
+            }
+            atexit (eeAtExit);
         }
 
         // malloc memory, init as zeros
         n_data_array = s;
         data_array = (uint8_t *) calloc (n_data_array, sizeof(uint8_t));
+        changed = false;
 
-        // init data_array from file .. support old version of random memory locations ...
-        // and another old version with bug that wrote valid locations a second time with zeros.
-	char line[64];
-	unsigned int a, v;
-        unsigned int largest_a = 0;
-	while (fp && fgets (line, sizeof(line), fp)) {
-	    if (sscanf (line, "%x %x", &a, &v) == 2 && a < n_data_array && a >= largest_a) {
-                data_array[a] = v;
-                largest_a = a;
+        // init data_array from file if any, converting text format to binary
+        FILE *fp = fopen (filename, "r");
+        if (fp) {
+            struct stat sbuf;
+            uint8_t *file = NULL;
+            size_t n_file = 0;
+            if (fstat (fileno(fp), &sbuf) == 0 && (file = (uint8_t *) malloc (sbuf.st_size + 1)) != NULL)
+                n_file = fread (file, 1, sbuf.st_size, fp);
+            if (n_file > 0 && !readBinary (file, n_file)) {
+                rewind (fp);
+                readText (fp);
+                printf ("eeprom: converting %s to binary\n", filename);
+                changed = true;
+                (void) flush();
             }
+            free (file);
+            fclose (fp);
         }
 }
 
+/* note data_array must be saved, poll() does the work later.
+ * N.B. always returns true, problems writing are reported by flush()
+ */
 bool EEPROM::commit(void)
 {
-        // (over)write entire data_array array
-        if (ftruncate (fileno(fp), 0) < 0 || fseek (fp, 0L, SEEK_SET) < 0) {
-            printf ("eeprom: %s\n", strerror(errno));
+        if (changed && commit_ms == 0)
+            commit_ms = millis() | 1;                           // 0 means not pending
+        return (true);
+}
+
+/* call often to write data_array if committed long enough ago
+ */
+void EEPROM::poll(void)
+{
+        if (commit_ms && millis() - commit_ms >= COMMIT_MS)
+            (void) flush();
+}
+
+/* write data_array now if it has changed or the file does not exist yet, via a temp file renamed over
+ * the store. return whether io ok.
+ */
+bool EEPROM::flush(void)
+{
+        if (!data_array)
+            return (true);
+        if (!changed && access (filename, F_OK) == 0)
+            return (true);
+
+        EEHeader hdr;
+        memcpy (hdr.magic, EE_MAGIC, sizeof(hdr.magic));
+        hdr.n_bytes = n_data_array;
+        hdr.checksum = eeChecksum (data_array, n_data_array);
+
+        std::string tmpfn = std::string(filename) + ".new";
+        FILE *fp = fopen (tmpfn.c_str(), "w");
+        if (!fp) {
+            printf ("eeprom: %s: %s\n", tmpfn.c_str(), strerror(errno));
             return (false);
         }
-        for (unsigned a = 0; a < n_data_array; a++)
-            fprintf (fp, "%08X %02X\n", a, data_array[a]);
-        fflush (fp);
+        (void) !fchown (fileno(fp), getuid(), getgid());
+        bool ok = fwrite (&hdr, sizeof(hdr), 1, fp) == 1
+                        && fwrite (data_array, 1, n_data_array, fp) == n_data_array
+                        && fflush (fp) == 0
+                        && fsync (fileno(fp)) == 0;
+        if (fclose (fp) != 0)
+            ok = false;
+        if (ok && rename (tmpfn.c_str(), filename) < 0)
+            ok = false;
+
+        if (ok) {
+            changed = false;
+            commit_ms = 0;
+        } else {
+            printf ("eeprom: write %s failed: %s\n", filename, strerror(errno));
+            (void) unlink (tmpfn.c_str());
+        }
 
-        // return whether io ok
-        return (!feof(fp) && !ferror(fp));
+        return (ok);
 }
 
 void EEPROM::write (uint32_t address, uint8_t byte)
@@ -119,8 +242,10 @@ void EEPROM::write (uint32_t address, uint8_t byte)
             printf ("EEPROM.write: no data_array\n");
         else if (address >= n_data_array)
             printf ("EEPROM.write: %d >= %d\n", address, (int)n_data_array);
-        else 
+        else if (data_array[address] != byte) {
             data_array[address] = byte;
+            changed = true;
+        }
 }
 
 uint8_t EEPROM::read (uint32_t address)
@@ -7,6 +7,8 @@
 /* EEPROM class that uses a local file
  */
 
+#define EE_MAGIC        "HCEEPRM1"      // first 8 chars of the binary file format, no EOS
+
 class EEPROM
 {
     public:
@@ -19,13 +21,20 @@ class EEPROM
 
         // non-standard
         const char *getFilename(void);
+        bool flush(void);
+        void poll(void);
 
     private:
 
 	const char *filename;
-        FILE *fp;
+        int lock_fd;
         uint8_t *data_array;
         size_t n_data_array;
+        bool changed;                   // data_array differs from file
+        uint32_t commit_ms;             // millis() of first commit() since file was last written, if changed
+
+        bool readBinary (const uint8_t *file, size_t n_file);
+        void readText (FILE *fp);
 };
 
 extern class EEPROM EEPROM;
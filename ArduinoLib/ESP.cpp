@@ -6,6 +6,7 @@
 #include "Arduino.h"
 #include "ESP8266WiFi.h"
 #include "ESP.h"
+#include "EEPROM.h"
 
 class ESP ESP;
 
@@ -68,7 +69,9 @@ void ESP::restart (bool minus_K, bool minus_0)
         // add final sentinel
         addArgv (tmp_argv, tmp_argc, NULL);
 
-        // log
+        // save pending settings and log, after anything still queued
+        EEPROM.flush();
+        Serial.flush();
         printf ("Restart: args will be:\n");
         for (int i = 0; tmp_argv[i] != NULL; i++)
             printf ("  argv[%d]: %s\n", i, tmp_argv[i]);
@@ -1,10 +1,290 @@
 /* simple Serial.cpp
+ *
+ * all log output goes through a small pipeline so logging never makes one thread wait for another:
+ *   each thread formats into its own lock-free single producer ring,
+ *   a background writer thread merges the rings back into time order onto stdout.
+ * levels are checked before formatting so messages that will not be shown cost almost nothing.
  */
 
+#include <atomic>
+#include <sys/time.h>
+
 #include "Serial.h"
 #include "Arduino.h"
 
-Serial::Serial(void) { pthread_mutex_init(&serial_lock, NULL); }
+#define LOG_RING_SZ 65536 // bytes in each thread's ring, power of 2
+#define LOG_MAX_MSG 2048  // longest message
+#define LOG_WRITER_US 10000 // writer polling period, usecs
+
+volatile int log_level = LOG_ERR;
+
+// each message in a ring is one of these followed by len bytes of text
+typedef struct {
+  uint64_t seq;  // overall order
+  uint32_t ms;   // millis() when logged
+  uint32_t len;  // text bytes following
+} LogRecHdr;
+
+// one thread's ring. head and tail are running byte counts, so head - tail is the number in use.
+struct LogRing {
+  char buf[LOG_RING_SZ];
+  std::atomic<uint32_t> head; // written only by owning thread
+  std::atomic<uint32_t> tail; // written only by log_drain_lock holder
+  std::atomic<bool> owned;    // whether a live thread is using this ring
+  LogRing *next;              // next in log_rings
+};
+
+static std::atomic<LogRing *> log_rings;  // all rings, only ever added to
+static pthread_mutex_t log_rings_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t log_drain_lock = PTHREAD_MUTEX_INITIALIZER;
+static std::atomic<uint64_t> log_seq;     // next LogRecHdr.seq
+static pthread_once_t log_once = PTHREAD_ONCE_INIT;
+static volatile bool log_direct;           // write immediately, eg, in a forked child without our writer
+static pthread_mutex_t log_wake_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t log_wake_cv = PTHREAD_COND_INITIALIZER;    // wakes writer early if a ring is filling
+
+// Serial.printf() format classes, cached by format address as (address << 2) | class
+enum { FMT_UNKNOWN, FMT_DROP, FMT_KEEP, FMT_CHECK };
+#define FMT_CACHE_N 512 // power of 2
+static std::atomic<uint64_t> fmt_cache[FMT_CACHE_N];
+
+// releases this thread's ring for reuse when the thread exits
+struct LogRingOwner {
+  LogRing *ring;
+  ~LogRingOwner() {
+    if (ring)
+      ring->owned.store(false, std::memory_order_release);
+  }
+};
+static thread_local LogRingOwner my_ring;
+
+/* copy n bytes at running offset off of the given ring to dst, allowing for wrap.
+ */
+static void ringGet(const LogRing *r, uint32_t off, void *dst, uint32_t n) {
+  uint32_t i = off & (LOG_RING_SZ - 1);
+  uint32_t n1 = n < LOG_RING_SZ - i ? n : LOG_RING_SZ - i;
+  memcpy(dst, &r->buf[i], n1);
+  memcpy((char *)dst + n1, &r->buf[0], n - n1);
+}
+
+/* copy n bytes from src to running offset off of the given ring, allowing for wrap.
+ */
+static void ringPut(LogRing *r, uint32_t off, const void *src, uint32_t n) {
+  uint32_t i = off & (LOG_RING_SZ - 1);
+  uint32_t n1 = n < LOG_RING_SZ - i ? n : LOG_RING_SZ - i;
+  memcpy(&r->buf[i], src, n1);
+  memcpy(&r->buf[0], (const char *)src + n1, n - n1);
+}
+
+/* write one message to stdout now, prefixed with ms.
+ * N.B. don't use now() because getNTPUTC logs which can get recursive
+ */
+static void writeMsg(uint32_t ms, const char *msg, uint32_t len) {
+  fprintf(stdout, "%7u.%03u ", ms / 1000, ms % 1000);
+  fwrite(msg, 1, len, stdout);
+  fflush(stdout);
+}
+
+/* write all messages now in all rings to stdout in seq order.
+ */
+static void logDrain(void) {
+  static char out[4 * LOG_MAX_MSG];
+  int n_out = 0;
+
+  pthread_mutex_lock(&log_drain_lock);
+
+  for (;;) {
+    // find the ring whose oldest message is the oldest overall
+    LogRing *best = NULL;
+    LogRecHdr best_h = {};
+    for (LogRing *r = log_rings.load(std::memory_order_acquire); r; r = r->next) {
+      uint32_t tail = r->tail.load(std::memory_order_relaxed);
+      if (r->head.load(std::memory_order_acquire) == tail)
+        continue;
+      LogRecHdr h;
+      ringGet(r, tail, &h, sizeof(h));
+      if (!best || h.seq < best_h.seq) {
+        best = r;
+        best_h = h;
+      }
+    }
+    if (!best)
+      break;
+
+    // append to out, emptying first if no room
+    if (n_out + 32 + best_h.len > sizeof(out)) {
+      fwrite(out, 1, n_out, stdout);
+      n_out = 0;
+    }
+    n_out += snprintf(out + n_out, 32, "%7u.%03u ", best_h.ms / 1000, best_h.ms % 1000);
+    uint32_t tail = best->tail.load(std::memory_order_relaxed);
+    ringGet(best, tail + sizeof(best_h), out + n_out, best_h.len);
+    n_out += best_h.len;
+    best->tail.store(tail + sizeof(best_h) + best_h.len, std::memory_order_release);
+  }
+
+  if (n_out > 0) {
+    fwrite(out, 1, n_out, stdout);
+    fflush(stdout);
+  }
+
+  pthread_mutex_unlock(&log_drain_lock);
+}
+
+/* background thread that empties the rings every LOG_WRITER_US or sooner if woken
+ */
+static void *logWriterThread(void *unused) {
+  (void)unused;
+  for (;;) {
+    logDrain();
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    long ns = (tv.tv_usec + LOG_WRITER_US) * 1000L;
+    struct timespec ts = {tv.tv_sec + ns / 1000000000L, ns % 1000000000L};
+    pthread_mutex_lock(&log_wake_lock);
+    pthread_cond_timedwait(&log_wake_cv, &log_wake_lock, &ts);
+    pthread_mutex_unlock(&log_wake_lock);
+  }
+  return (NULL);
+}
+
+/* fork child has no writer so just write directly
+ */
+static void logForkChild(void) { log_direct = true; }
+
+/* one-time setup of the writer thread
+ */
+static void logInit(void) {
+  pthread_t tid;
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+  if (pthread_create(&tid, &attr, logWriterThread, NULL) != 0)
+    log_direct = true;
+  pthread_attr_destroy(&attr);
+  pthread_atfork(NULL, NULL, logForkChild);
+  atexit(logFlush);
+}
+
+/* return this thread's ring, reusing an empty one left by an exited thread if possible.
+ */
+static LogRing *myRing(void) {
+  if (my_ring.ring)
+    return (my_ring.ring);
+
+  pthread_mutex_lock(&log_rings_lock);
+  LogRing *mine = NULL;
+  for (LogRing *r = log_rings.load(std::memory_order_acquire); r && !mine; r = r->next) {
+    if (!r->owned.load(std::memory_order_acquire) &&
+        r->head.load(std::memory_order_acquire) == r->tail.load(std::memory_order_acquire)) {
+      r->owned.store(true, std::memory_order_relaxed);
+      mine = r;
+    }
+  }
+  if (!mine) {
+    mine = new LogRing();
+    mine->owned.store(true, std::memory_order_relaxed);
+    mine->next = log_rings.load(std::memory_order_relaxed);
+    log_rings.store(mine, std::memory_order_release);
+  }
+  pthread_mutex_unlock(&log_rings_lock);
+
+  my_ring.ring = mine;
+  return (mine);
+}
+
+/* add one message of len bytes to this thread's ring.
+ * only waits if the writer has fallen a full ring behind.
+ */
+static void logEnqueue(const char *msg, uint32_t len) {
+  uint32_t ms = millis();
+
+  pthread_once(&log_once, logInit);
+  if (log_direct) {
+    writeMsg(ms, msg, len);
+    return;
+  }
+
+  LogRing *r = myRing();
+  LogRecHdr h;
+  uint32_t need = sizeof(h) + len;
+  uint32_t head = r->head.load(std::memory_order_relaxed);
+  while (head + need - r->tail.load(std::memory_order_acquire) > LOG_RING_SZ) {
+    pthread_cond_signal(&log_wake_cv);
+    usleep(100);
+  }
+
+  h.seq = log_seq.fetch_add(1, std::memory_order_relaxed);
+  h.ms = ms;
+  h.len = len;
+  ringPut(r, head, &h, sizeof(h));
+  ringPut(r, head + sizeof(h), msg, len);
+  r->head.store(head + need, std::memory_order_release);
+
+  // nudge writer when crossing half full
+  uint32_t used = head + need - r->tail.load(std::memory_order_relaxed);
+  if (used > LOG_RING_SZ / 2 && used - need <= LOG_RING_SZ / 2)
+    pthread_cond_signal(&log_wake_cv);
+}
+
+/* write everything logged so far, eg, before exit or exec
+ */
+void logFlush(void) {
+  logDrain();
+}
+
+/* format and log a message. caller has already checked l against log_level.
+ */
+void logPrintf(LogLevel l, const char *fmt, ...) {
+  (void)l;
+  char buf[LOG_MAX_MSG];
+  va_list ap;
+  va_start(ap, fmt);
+  int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+  va_end(ap);
+  if (n > 0)
+    logEnqueue(buf, n < (int)sizeof(buf) ? n : sizeof(buf) - 1);
+}
+
+/* return whether s mentions error, fail, fatal or panic in any case, the words that make a message
+ * worth showing even when quiet
+ */
+static bool hasAlertWord(const char *s) {
+  for (; *s; s++) {
+    switch (*s | 0x20) {
+    case 'e':
+      if (strncasecmp(s + 1, "rror", 4) == 0)
+        return (true);
+      break;
+    case 'f':
+      if (strncasecmp(s + 1, "ail", 3) == 0 || strncasecmp(s + 1, "atal", 4) == 0)
+        return (true);
+      break;
+    case 'p':
+      if (strncasecmp(s + 1, "anic", 4) == 0)
+        return (true);
+      break;
+    }
+  }
+  return (false);
+}
+
+/* return whether fmt has any %s or %c conversion that might bring in an alert word
+ */
+static bool hasTextConversion(const char *fmt) {
+  for (const char *p = fmt; (p = strchr(p, '%')) != NULL;) {
+    if (*++p == '%') {
+      p++;
+      continue;
+    }
+    p += strspn(p, "-+ #'0123456789.*hlLqjzt");
+    if (*p == 's' || *p == 'c' || *p == 'S' || *p == 'C')
+      return (true);
+  }
+  return (false);
+}
+
+Serial::Serial(void) {}
 
 void Serial::begin(int baud) { (void)baud; }
 
@@ -28,50 +308,47 @@ void Serial::println(const char *s) { printf("%s\n", s); }
 
 void Serial::println(int i) { printf("%d\n", i); }
 
-#include <string.h>
+/* return the FMT_ class of the given Serial.printf() format:
+ *   FMT_KEEP if it mentions an alert word itself,
+ *   FMT_CHECK if its text arguments might,
+ *   else FMT_DROP
+ */
+static int fmtClass(const char *fmt) {
+  uint64_t addr = (uintptr_t)fmt;
+  std::atomic<uint64_t> &cp = fmt_cache[(addr ^ (addr >> 9)) & (FMT_CACHE_N - 1)];
+  uint64_t c = cp.load(std::memory_order_relaxed);
+  if ((c >> 2) == addr)
+    return (c & 3);
 
-extern bool verbose_logging;
+  int cls = hasAlertWord(fmt) ? FMT_KEEP : (hasTextConversion(fmt) ? FMT_CHECK : FMT_DROP);
+  cp.store((addr << 2) | cls, std::memory_order_relaxed);
+  return (cls);
+}
 
+/* log at LOG_INFO, or LOG_ERR if the message mentions error, fail, fatal or panic.
+ * decide from fmt alone whenever possible so quiet mode need not format at all.
+ * N.B. fmt classes are cached by address so fmt must not be a buffer that is reused with new text.
+ */
 int Serial::printf(const char *fmt, ...) {
-  pthread_mutex_lock(&serial_lock);
+  int cls = log_level >= LOG_INFO ? FMT_KEEP : fmtClass(fmt);
+  if (cls == FMT_DROP)
+    return (0);
+  bool keep = cls == FMT_KEEP;
 
-  // format the message first to check content
-  char buf[2048];
+  char buf[LOG_MAX_MSG];
   va_list ap;
   va_start(ap, fmt);
   int n = vsnprintf(buf, sizeof(buf), fmt, ap);
   va_end(ap);
 
-  // default to QUIET (suppress logs).
-  // if verbose_logging is set, print everything.
-  // otherwise, only print if error/fail/fatal/panic
-  if (!verbose_logging) {
-    bool keep = false;
-    if (strcasestr(buf, "error") || strcasestr(buf, "fail") ||
-        strcasestr(buf, "fatal") || strcasestr(buf, "panic"))
-      keep = true;
-
-    if (!keep) {
-      pthread_mutex_unlock(&serial_lock);
-      return n;
-    }
-  }
-
-  // prefix with millis()
-  // N.B. don't call now() because getNTPUTC calls print which can get recursive
-  uint32_t m = millis();
-  fprintf(stdout, "%7u.%03u ", m / 1000, m % 1000);
-
-  // now the message
-  fputs(buf, stdout);
-  fflush(stdout);
+  if ((keep || hasAlertWord(buf)) && n > 0)
+    logEnqueue(buf, n < (int)sizeof(buf) ? n : sizeof(buf) - 1);
 
-  pthread_mutex_unlock(&serial_lock);
-
-  // lint
   return (n);
 }
 
+void Serial::flush(void) { logFlush(); }
+
 Serial::operator bool() { return (true); }
 
 class Serial Serial;
@@ -11,11 +11,37 @@
 
 #include "Arduino.h"
 
-class Serial {
+/* log levels, most important first.
+ * LOG_MAX_LEVEL removes less important messages at compile time, log_level at run time, both before
+ * any formatting. Serial.printf() messages are LOG_INFO unless they mention error, fail, fatal or panic.
+ */
+typedef enum {
+    LOG_ERR,
+    LOG_WARN,
+    LOG_INFO,
+    LOG_DEBUG,
+} LogLevel;
+
+#if !defined(LOG_MAX_LEVEL)
+#define LOG_MAX_LEVEL   LOG_DEBUG
+#endif
+
+extern volatile int log_level;                  // LOG_ERR unless -D
 
-    private:
+#define LOG(l,...)      do { if ((l) <= LOG_MAX_LEVEL && (l) <= log_level) logPrintf ((l), __VA_ARGS__); } while (0)
+#define LOGE(...)       LOG(LOG_ERR, __VA_ARGS__)
+#define LOGW(...)       LOG(LOG_WARN, __VA_ARGS__)
+#define LOGI(...)       LOG(LOG_INFO, __VA_ARGS__)
+#define LOGD(...)       LOG(LOG_DEBUG, __VA_ARGS__)
 
-        pthread_mutex_t serial_lock;
+#if defined(__GNUC__)
+extern void logPrintf (LogLevel l, const char *fmt, ...) __attribute__ ((format (__printf__, 2, 3)));
+#else
+extern void logPrintf (LogLevel l, const char *fmt, ...);
+#endif
+extern void logFlush (void);
+
+class Serial {
 
     public:
 
@@ -25,6 +51,8 @@ class Serial {
 
 	operator bool();
 
+        void flush (void);
+
         void print (void);
 	void print (char c);
 	void print (char *s);
@@ -0,0 +1,262 @@
+/* fixed size work-stealing thread pool, see TaskPool.h for usage.
+ */
+
+#include <atomic>
+#include <deque>
+
+#include "Arduino.h"
+#include "TaskPool.h"
+
+#define TP_MIN_WORKERS 2 // fewest workers so one long job never holds up all others
+#define TP_MAX_WORKERS 8 // most workers regardless of cores
+
+struct PoolTask {
+  TaskFunc work;  // runs on a worker
+  TaskFunc done;  // runs on the loop() thread after work, unless NULL
+  void *arg;      // passed to both
+  bool future;    // whether someone will waitTask() on this
+  bool finished;  // set under tp_lock once work has returned, futures only
+  PoolTask *next; // tp_done list link
+};
+
+// one worker's tasks: the owner pushes and pops the back, thieves take the front
+struct PoolDeque {
+  pthread_mutex_t lock;
+  std::deque<PoolTask *> q;
+};
+
+static PoolDeque tp_deques[TP_MAX_WORKERS];
+static std::atomic<int> tp_n;          // n workers actually running
+static std::atomic<int> tp_queued;     // n tasks in all deques
+static std::atomic<unsigned> tp_rr;    // next deque for tasks from outside the pool
+static thread_local int tp_me = -1;    // this thread's deque index if a worker
+static pthread_once_t tp_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t tp_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t tp_work_cv = PTHREAD_COND_INITIALIZER;     // signaled as tasks are queued
+static pthread_cond_t tp_finished_cv = PTHREAD_COND_INITIALIZER; // broadcast as futures finish
+static PoolTask *tp_done_head, *tp_done_tail; // tasks awaiting done(), guarded by tp_lock
+
+/* remove and return the next task for deque me, stealing from the others if it is empty, else NULL.
+ * me < 0 means not a worker, so only steal.
+ */
+static PoolTask *takeTask(int me) {
+  PoolTask *t = NULL;
+
+  // own newest first, it is most likely still warm in cache
+  if (me >= 0) {
+    PoolDeque &d = tp_deques[me];
+    pthread_mutex_lock(&d.lock);
+    if (!d.q.empty()) {
+      t = d.q.back();
+      d.q.pop_back();
+    }
+    pthread_mutex_unlock(&d.lock);
+  }
+
+  // else steal the oldest from someone else
+  int n = tp_n;
+  for (int i = 1; !t && i <= n; i++) {
+    PoolDeque &d = tp_deques[(me + i + n) % n];
+    pthread_mutex_lock(&d.lock);
+    if (!d.q.empty()) {
+      t = d.q.front();
+      d.q.pop_front();
+    }
+    pthread_mutex_unlock(&d.lock);
+  }
+
+  if (t)
+    tp_queued--;
+  return (t);
+}
+
+/* run the given task then hand it on to whoever needs to know it's done.
+ */
+static void runOne(PoolTask *t) {
+  (*t->work)(t->arg);
+
+  if (t->done) {
+    pthread_mutex_lock(&tp_lock);
+    t->next = NULL;
+    if (tp_done_tail)
+      tp_done_tail->next = t;
+    else
+      tp_done_head = t;
+    tp_done_tail = t;
+    pthread_mutex_unlock(&tp_lock);
+  } else if (t->future) {
+    pthread_mutex_lock(&tp_lock);
+    t->finished = true;
+    pthread_cond_broadcast(&tp_finished_cv);
+    pthread_mutex_unlock(&tp_lock);
+  } else
+    free(t);
+}
+
+/* thread that runs tasks forever, sleeping while there are none.
+ */
+static void *poolWorker(void *arg) {
+  pthread_detach(pthread_self());
+  tp_me = (int)(long)arg;
+
+  for (;;) {
+    PoolTask *t = takeTask(tp_me);
+    if (t)
+      runOne(t);
+    else {
+      pthread_mutex_lock(&tp_lock);
+      while (tp_queued.load() <= 0)
+        pthread_cond_wait(&tp_work_cv, &tp_lock);
+      pthread_mutex_unlock(&tp_lock);
+    }
+  }
+
+  return (NULL);
+}
+
+/* start one worker per core, within limits.
+ */
+static void startPool(void) {
+  long n_cores = sysconf(_SC_NPROCESSORS_ONLN);
+  int n_want = n_cores < TP_MIN_WORKERS ? TP_MIN_WORKERS : (n_cores > TP_MAX_WORKERS ? TP_MAX_WORKERS : n_cores);
+
+  for (int i = 0; i < n_want; i++)
+    pthread_mutex_init(&tp_deques[i].lock, NULL);
+
+  // workers may start stealing as soon as they exist so publish tp_n first then trim if any fail
+  tp_n = n_want;
+  for (int i = 0; i < n_want; i++) {
+    pthread_t tid;
+    int e = pthread_create(&tid, NULL, poolWorker, (void *)(long)i);
+    if (e) {
+      printf("TaskPool: worker %d: %s\n", i, strerror(e));
+      tp_n = i;
+      break;
+    }
+  }
+
+  printf("TaskPool: %d workers\n", tp_n.load());
+}
+
+/* create a new task and queue it, or just run it here if there are no workers.
+ */
+static PoolTask *submit(TaskFunc work, TaskFunc done, void *arg, bool future) {
+  pthread_once(&tp_once, startPool);
+
+  PoolTask *t = (PoolTask *)calloc(1, sizeof(PoolTask));
+  if (!t) {
+    printf("TaskPool: no memory for new task\n");
+    exit(1);
+  }
+  t->work = work;
+  t->done = done;
+  t->arg = arg;
+  t->future = future;
+
+  if (tp_n == 0) {
+    runOne(t);
+    return (t);
+  }
+
+  // tasks from a worker stay on its own deque, others are spread around
+  int di = tp_me >= 0 ? tp_me : (int)(tp_rr++ % tp_n);
+  PoolDeque &d = tp_deques[di];
+  pthread_mutex_lock(&d.lock);
+  d.q.push_back(t);
+  pthread_mutex_unlock(&d.lock);
+
+  tp_queued++;
+  pthread_mutex_lock(&tp_lock);
+  pthread_cond_signal(&tp_work_cv);
+  pthread_mutex_unlock(&tp_lock);
+
+  return (t);
+}
+
+/* queue work(arg) to run on the pool then, if done is not NULL, done(arg) on the loop() thread.
+ */
+void runTask(TaskFunc work, TaskFunc done, void *arg) {
+  (void)submit(work, done, arg, false);
+}
+
+/* queue work(arg) to run on the pool and return a future that must be passed to waitTask().
+ */
+TaskFuture startTask(TaskFunc work, void *arg) {
+  return (submit(work, NULL, arg, true));
+}
+
+/* return whether the task behind the given future has finished, without waiting.
+ */
+bool taskReady(TaskFuture f) {
+  pthread_mutex_lock(&tp_lock);
+  bool ready = f->finished;
+  pthread_mutex_unlock(&tp_lock);
+  return (ready);
+}
+
+/* remove the given task from whichever deque holds it.
+ * return whether found, ie, no worker has started it yet.
+ */
+static bool claimTask(PoolTask *t) {
+  int n = tp_n;
+  for (int i = 0; i < n; i++) {
+    PoolDeque &d = tp_deques[i];
+    pthread_mutex_lock(&d.lock);
+    for (std::deque<PoolTask *>::iterator it = d.q.begin(); it != d.q.end(); ++it) {
+      if (*it == t) {
+        d.q.erase(it);
+        pthread_mutex_unlock(&d.lock);
+        tp_queued--;
+        return (true);
+      }
+    }
+    pthread_mutex_unlock(&d.lock);
+  }
+  return (false);
+}
+
+/* wait for the task behind the given future to finish, then release it.
+ * if no worker has started it yet we run it ourselves, so waiting from inside a task can never run the
+ * pool out of threads. we never run any other task, so the loop() thread is not held up by unrelated work.
+ */
+void waitTask(TaskFuture f) {
+  if (!taskReady(f) && claimTask(f))
+    runOne(f);
+
+  pthread_mutex_lock(&tp_lock);
+  while (!f->finished)
+    pthread_cond_wait(&tp_finished_cv, &tp_lock);
+  pthread_mutex_unlock(&tp_lock);
+
+  free(f);
+}
+
+/* call the done() function of each task that has finished since last time.
+ * N.B. call only from the loop() thread
+ */
+void runTaskCallbacks(void) {
+  pthread_mutex_lock(&tp_lock);
+  PoolTask *t = tp_done_head;
+  tp_done_head = tp_done_tail = NULL;
+  pthread_mutex_unlock(&tp_lock);
+
+  while (t) {
+    PoolTask *next = t->next;
+    (*t->done)(t->arg);
+    free(t);
+    t = next;
+  }
+}
+
+/* return whether we are running on one of the pool workers.
+ */
+bool inTaskPool(void) {
+  return (tp_me >= 0);
+}
+
+/* return the number of workers in the pool.
+ */
+int taskPoolSize(void) {
+  pthread_once(&tp_once, startPool);
+  return (tp_n.load());
+}
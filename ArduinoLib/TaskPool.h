@@ -0,0 +1,30 @@
+#ifndef _TASKPOOL_H
+#define _TASKPOOL_H
+
+/* a small fixed pool of worker threads for jobs too long to run inline in loop().
+ *
+ * each worker owns a deque of tasks; it runs its own newest first and steals the oldest from others
+ * when it runs dry. tasks submitted from within a task stay on that worker's deque.
+ *
+ * two ways to use it:
+ *   runTask():   fire and forget; done(arg), if given, is later called on the loop() thread by
+ *                runTaskCallbacks() so it may safely touch the display and app state.
+ *   startTask(): returns a TaskFuture that must be given to waitTask(), which blocks until work(arg) has
+ *                run. if no worker has started it yet the waiter runs it, so waiting from inside a task can
+ *                not deadlock, but it never runs any other task.
+ *
+ * N.B. work() runs on a worker thread so must not draw, call updateClocks() or change shared state.
+ */
+
+typedef void (*TaskFunc)(void *arg);
+typedef struct PoolTask *TaskFuture;
+
+extern void runTask (TaskFunc work, TaskFunc done, void *arg);
+extern TaskFuture startTask (TaskFunc work, void *arg);
+extern bool taskReady (TaskFuture f);
+extern void waitTask (TaskFuture f);
+extern void runTaskCallbacks (void);
+extern int taskPoolSize (void);
+extern bool inTaskPool (void);
+
+#endif // _TASKPOOL_H
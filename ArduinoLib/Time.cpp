@@ -232,6 +232,7 @@ time_t makeTime(const tmElements_t &tm){
 static uint32_t sysTime = 0;
 static uint32_t prevMillis = 0;
 static uint32_t nextSyncTime = 0;
+static uint16_t syncMillis = 0;  // how far into its second the provider's time was, 0 if whole
 static timeStatus_t Status = timeNotSet;
 
 getExternalTime getTimePtr;  // pointer to external sync function
@@ -254,9 +255,11 @@ time_t now() {
   }
   if (nextSyncTime <= sysTime) {
     if (getTimePtr != 0) {
+      syncMillis = 0;
       time_t t = getTimePtr();
       if (t != 0) {
         setTime(t);
+        prevMillis -= syncMillis;  // keep the provider's phase within the second
       } else {
         nextSyncTime = sysTime + syncInterval;
         Status = (Status == timeNotSet) ?  timeNotSet : timeNeedsSync;
@@ -310,6 +313,10 @@ void setSyncProvider( getExternalTime getTimeFunction){
   now(); // this will sync the clock
 }
 
+void setSyncMillis(uint16_t ms){ // call from within the provider, ms is how long ago its time began
+  syncMillis = ms < 1000 ? ms : 999;
+}
+
 void setSyncInterval(time_t interval){ // set the number of seconds between re-sync
   syncInterval = (uint32_t)interval;
   nextSyncTime = sysTime + syncInterval;
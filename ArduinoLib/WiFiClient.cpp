@@ -19,7 +19,7 @@ WiFiClient::WiFiClient()
 WiFiClient::WiFiClient(int fd)
 {
         if (fd >= 0 && debugLevel (DEBUG_NET, 1))
-            printf ("WiFiCl: new WiFiClient inheriting fd %d\n", fd);
+            LOGD ("WiFiCl: new WiFiClient inheriting fd %d\n", fd);
 
         // init
 	socket = fd;
@@ -32,7 +32,7 @@ WiFiClient::operator bool()
 {
         bool active = socket >= 0;
         if (active && debugLevel (DEBUG_NET, 2))
-            printf ("WiFiCl: fd %d is active\n", socket);
+            LOGD ("WiFiCl: fd %d is active\n", socket);
 	return (active);
 }
 
@@ -70,7 +70,7 @@ int WiFiClient::connect_to (int sockfd, struct sockaddr *serv_addr, int addrlen,
 
         /* looks good - restore blocking */
         if (fcntl (sockfd, F_SETFL, flags) < 0)
-            printf ("WiFiCl: fcntl fd %d: %s\n", sockfd, strerror(errno));
+            LOGE ("WiFiCl: fcntl fd %d: %s\n", sockfd, strerror(errno));
 
         return (0);
 }
@@ -113,7 +113,7 @@ bool WiFiClient::connect(const char *host, int port)
         snprintf (port_str, sizeof(port_str), "%d", port);
         int error = ::getaddrinfo (host, port_str, &hints, &aip);
         if (error) {
-            printf ("WiFiCl: getaddrinfo(%s:%d): %s\n", host, port, gai_strerror(error));
+            LOGE ("WiFiCl: getaddrinfo(%s:%d): %s\n", host, port, gai_strerror(error));
             return (false);
         }
 
@@ -121,13 +121,13 @@ bool WiFiClient::connect(const char *host, int port)
         sockfd = ::socket (aip->ai_family, aip->ai_socktype, aip->ai_protocol);
         if (sockfd < 0) {
             freeaddrinfo (aip);
-            printf ("WiFiCl: socket(%s:%d): %s\n", host, port, strerror(errno));
+            LOGE ("WiFiCl: socket(%s:%d): %s\n", host, port, strerror(errno));
 	    return (false);
         }
 
         /* connect */
         if (connect_to (sockfd, aip->ai_addr, aip->ai_addrlen, 8000) < 0) {
-            printf ("WiFiCl: connect(%s:%d): %s\n", host, port, strerror(errno));
+            LOGE ("WiFiCl: connect(%s:%d): %s\n", host, port, strerror(errno));
             freeaddrinfo (aip);
             close (sockfd);
             return (false);
@@ -138,7 +138,7 @@ bool WiFiClient::connect(const char *host, int port)
 
         /* ok start fresh */
         if (debugLevel (DEBUG_NET, 1))
-            printf ("WiFiCl: new %s:%d fd %d\n", host, port, sockfd);
+            LOGD ("WiFiCl: new %s:%d fd %d\n", host, port, sockfd);
         freeaddrinfo (aip);
 
         // init much like constructors
@@ -161,21 +161,21 @@ void WiFiClient::setNoDelay(bool on)
         // control Nagle algorithm
         socklen_t flag = on;
         if (setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, (void *) &flag, sizeof(flag)) < 0)
-            printf ("WiFiCl: TCP_NODELAY(%d): %s\n", on, strerror(errno));     // not fatal
+            LOGE ("WiFiCl: TCP_NODELAY(%d): %s\n", on, strerror(errno));     // not fatal
 }
 
 void WiFiClient::stop()
 {
 	if (socket >= 0) {
             if (debugLevel (DEBUG_NET, 1))
-                printf ("WiFiCl: stopping fd %d\n", socket);
+                LOGD ("WiFiCl: stopping fd %d\n", socket);
 	    shutdown (socket, SHUT_RDWR);
 	    close (socket);
 	    socket = -1;
 	    n_peek = 0;
             next_peek = 0;
 	} else if (debugLevel (DEBUG_NET, 2))
-            printf ("WiFiCl: fd %d already stopped\n", socket);
+            LOGD ("WiFiCl: fd %d already stopped\n", socket);
 }
 
 bool WiFiClient::connected()
@@ -196,7 +196,7 @@ bool WiFiClient::pending(int ms)
         tv.tv_usec = (ms-1000*tv.tv_sec)*1000;
         int s = select (socket+1, &rset, NULL, NULL, &tv);
         if (s < 0) {
-            printf ("WiFiCl: fd %d select(%d ms): %s\n", socket, ms, strerror(errno));
+            LOGE ("WiFiCl: fd %d select(%d ms): %s\n", socket, ms, strerror(errno));
 	    stop();
 	    return (false);
 	}
@@ -204,7 +204,7 @@ bool WiFiClient::pending(int ms)
         bool more = s > 0;
 
         if (debugLevel (DEBUG_NET, 2))
-            printf ("WiFiCl: %smore pending\n", more ? "" : "no ");
+            LOGD ("WiFiCl: %smore pending\n", more ? "" : "no ");
 
         return (more);
 }
@@ -230,7 +230,7 @@ int WiFiClient::available (int pending_ms)
 	int nr = ::read(socket, peek, sizeof(peek));
 	if (nr > 0) {
             if (debugLevel (DEBUG_NET, 2))
-                printf ("WiFiCl: available read(%d,%ld) %d\n", socket, (long)sizeof(peek), nr);
+                LOGD ("WiFiCl: available read(%d,%ld) %d\n", socket, (long)sizeof(peek), nr);
             if (debugLevel (DEBUG_NET, 3))
                 logBuffer (peek, nr);
 	    n_peek = nr;
@@ -238,12 +238,12 @@ int WiFiClient::available (int pending_ms)
 	    return (1);
 	} else if (nr == 0) {
             if (debugLevel (DEBUG_NET, 1))
-                printf ("WiFiCl: available read(%d) EOF\n", socket);
+                LOGD ("WiFiCl: available read(%d) EOF\n", socket);
 	    stop();
 	    return (0);
         } else {
             if (debugLevel (DEBUG_NET, 1))
-                printf ("WiFiCl: available read(%d): %s\n", socket, strerror(errno));
+                LOGD ("WiFiCl: available read(%d): %s\n", socket, strerror(errno));
 	    stop();
 	    return (0);
 	}
@@ -259,9 +259,9 @@ int WiFiClient::read()
             if (debugLevel (DEBUG_NET, 3)) {
                 int n_more = n_peek - next_peek;
                 if (isprint (p))
-                    printf ("WiFiCl: read(%d) returning %c %d, %d more\n", socket, p, p, n_more);
+                    LOGD ("WiFiCl: read(%d) returning %c %d, %d more\n", socket, p, p, n_more);
                 else
-                    printf ("WiFiCl: read(%d) returning   %d, %d more\n", socket, p, n_more);
+                    LOGD ("WiFiCl: read(%d) returning   %d, %d more\n", socket, p, n_more);
             }
             return (p);
         }
@@ -283,7 +283,93 @@ int WiFiClient::readArray (uint8_t *array, long count)
         }
 
         if (debugLevel (DEBUG_NET, 2))
-            printf ("WiFiCl: readArray(%d,%ld) %d\n", socket, count, n_return);
+            LOGD ("WiFiCl: readArray(%d,%ld) %d\n", socket, count, n_return);
+        return (n_return);
+}
+
+/* wait as long as READ_PENDING_MS for the next complete line and return it in place in the read-ahead
+ * buffer, with any trailing CR LF replaced by EOS, and its length if len is not NULL.
+ * the line remains valid only until the next read of any kind.
+ * return false at EOF; as with reading a char at a time, a final fragment without a newline is dropped.
+ * non-standard
+ */
+bool WiFiClient::readLine (char **line, int *len)
+{
+        int n_scanned = 0;                      // bytes already known to contain no newline
+
+        for (;;) {
+
+            // look for newline in what's left
+            char *start = (char *) &peek[next_peek];
+            int n_avail = n_peek - next_peek;
+            char *nl = (char *) memchr (start + n_scanned, '\n', n_avail - n_scanned);
+            if (nl) {
+                int ll = nl - start;
+                next_peek += ll + 1;
+                if (ll > 0 && start[ll-1] == '\r')
+                    ll--;
+                start[ll] = '\0';
+                *line = start;
+                if (len)
+                    *len = ll;
+                if (debugLevel (DEBUG_NET, 3))
+                    LOGD ("WiFiCl: readLine(%d) %d: %s\n", socket, ll, start);
+                return (true);
+            }
+            n_scanned = n_avail;
+
+            // no newline yet so slide partial line down to make room for more
+            if (next_peek > 0) {
+                memmove (peek, start, n_avail);
+                n_peek = n_avail;
+                next_peek = 0;
+            }
+
+            // if buffer is full return it as one line, leaving room for EOS
+            if (n_peek >= (int)sizeof(peek) - 1) {
+                peek[n_peek] = '\0';
+                *line = (char *) peek;
+                if (len)
+                    *len = n_peek;
+                next_peek = n_peek;
+                return (true);
+            }
+
+            // add more
+            if (socket < 0 || !pending(READ_PENDING_MS))
+                return (false);
+            int nr = ::read (socket, &peek[n_peek], sizeof(peek) - 1 - n_peek);
+            if (nr <= 0) {
+                if (debugLevel (DEBUG_NET, 1))
+                    LOGD ("WiFiCl: readLine read(%d): %s\n", socket, nr == 0 ? "EOF" : strerror(errno));
+                stop();
+                return (false);
+            }
+            if (debugLevel (DEBUG_NET, 2))
+                LOGD ("WiFiCl: readLine read(%d,%ld) %d\n", socket, (long)(sizeof(peek)-1-n_peek), nr);
+            if (debugLevel (DEBUG_NET, 3))
+                logBuffer (&peek[n_peek], nr);
+            n_peek += nr;
+        }
+}
+
+/* same as readArray() but rather than copying, return span pointing directly into the read-ahead buffer.
+ * span remains valid only until the next read of any kind.
+ * non-standard
+ */
+int WiFiClient::readSpan (const uint8_t **span, long count)
+{
+        int n_return = 0;
+
+        if (available (READ_PENDING_MS)) {
+            int n_available = n_peek - next_peek;
+            n_return = count > n_available ? n_available : count;
+            *span = &peek[next_peek];
+            next_peek += n_return;
+        }
+
+        if (debugLevel (DEBUG_NET, 2))
+            LOGD ("WiFiCl: readSpan(%d,%ld) %d\n", socket, count, n_return);
         return (n_return);
 }
 
@@ -299,20 +385,20 @@ int WiFiClient::write (const uint8_t *buf, int n)
 	    if (nw < 0) {
                 // select says it won't block but it still might be temporarily EAGAIN
                 if (errno != EAGAIN) {
-                    printf ("WiFiCl: write(%d) after %d: %s\n", socket, ntot, strerror(errno));
+                    LOGE ("WiFiCl: write(%d) after %d: %s\n", socket, ntot, strerror(errno));
                     stop();             // avoid repeated failed attempts
                     return (0);
                 } else
                     nw = 0;             // act like nothing happened
 	    } else if (nw == 0) {
-                printf ("WiFiCl: write(%d) returns 0 after %d\n", socket, ntot);
+                LOGE ("WiFiCl: write(%d) returns 0 after %d\n", socket, ntot);
                 stop();             // avoid repeated failed attempts
                 return (0);
             }
 	}
 
         if (debugLevel (DEBUG_NET, 2))
-            printf ("WiFiCl: write(%d) %d\n", socket, n);
+            LOGD ("WiFiCl: write(%d) %d\n", socket, n);
         if (debugLevel (DEBUG_NET, 3))
             logBuffer (buf, n);
 
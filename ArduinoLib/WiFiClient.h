@@ -44,6 +44,8 @@ class WiFiClient {
 	bool connected();
 	int read();
         int readArray (uint8_t *array, long count);
+        bool readLine (char **line, int *len);
+        int readSpan (const uint8_t **span, long count);
 	operator bool();
 	int write (const uint8_t *buf, int n);
 	void print (void);
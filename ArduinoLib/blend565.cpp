@@ -0,0 +1,169 @@
+/* blend arrays of RGB565 day and night earth map texels with a fixed-point weight.
+ *
+ * used by Adafruit_RA8875::plotEarth() for grayline twilight pixels. each app pixel has its own weight so
+ * there are never more than SCALESZ*SCALESZ texels per call, too few for SIMD to pay, so this is a plain
+ * integer loop which is still much faster than the original float math per channel.
+ *
+ * to build and run a stand-alone main test and benchmark against the original float loop:
+ *    g++ -Wall -O2 -D_UNIT_TEST -I. -o x.blend565 blend565.cpp && ./x.blend565
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "Adafruit_RA8875.h"
+
+
+/* blend n pixels using simple integer math.
+ * each channel is blended in its native width: out = (day*day_w + night*(256-day_w)) >> 8
+ */
+static void blendRGB565Scalar (const uint16_t *day, const uint16_t *night, uint16_t *out, int n, int day_w)
+{
+        int night_w = 256 - day_w;
+        for (int i = 0; i < n; i++) {
+            uint32_t d = day[i];
+            uint32_t c = night[i];
+            uint32_t r = (((d>>11)        *day_w + (c>>11)        *night_w) >> 8);
+            uint32_t g = ((((d>>5) & 0x3F)*day_w + ((c>>5) & 0x3F)*night_w) >> 8);
+            uint32_t b = (( (d & 0x1F)    *day_w + (c & 0x1F)     *night_w) >> 8);
+            out[i] = (uint16_t)((r << 11) | (g << 5) | b);
+        }
+}
+
+/* blend n RGB565 day and night pixels into out.
+ * fract_day is 1 for all day, 0 for all night, else blend.
+ */
+void blendRGB565 (const uint16_t *day, const uint16_t *night, uint16_t *out, int n, float fract_day)
+{
+        int day_w = (int)(fract_day*256 + 0.5F);
+        if (day_w < 0)
+            day_w = 0;
+        if (day_w > 256)
+            day_w = 256;
+
+        blendRGB565Scalar (day, night, out, n, day_w);
+}
+
+
+
+
+
+#if defined(_UNIT_TEST)
+
+#include <sys/time.h>
+
+// a large block of twilight texels, about one full grayline sweep at 3200x1920
+#define NPIX    (660*16*16)
+#define NRUNS   200
+
+// microseconds between two timevals
+static long tvdelus (const struct timeval &tv0, const struct timeval &tv1)
+{
+        return ((tv1.tv_sec - tv0.tv_sec)*1000000L + (tv1.tv_usec - tv0.tv_usec));
+}
+
+/* the original per-pixel float blend from plotEarth()
+ */
+static void blendRGB565Float (const uint16_t *day, const uint16_t *night, uint16_t *out, int n,
+float fract_day)
+{
+        for (int i = 0; i < n; i++) {
+            uint16_t day_pix = day[i];
+            uint16_t night_pix = night[i];
+            uint8_t day_r = RGB565_R(day_pix);
+            uint8_t day_g = RGB565_G(day_pix);
+            uint8_t day_b = RGB565_B(day_pix);
+            uint8_t night_r = RGB565_R(night_pix);
+            uint8_t night_g = RGB565_G(night_pix);
+            uint8_t night_b = RGB565_B(night_pix);
+            float fract_night = 1 - fract_day;
+            uint8_t twi_r = (fract_day*day_r + fract_night*night_r);
+            uint8_t twi_g = (fract_day*day_g + fract_night*night_g);
+            uint8_t twi_b = (fract_day*day_b + fract_night*night_b);
+            out[i] = RGB565 (twi_r, twi_g, twi_b);
+        }
+}
+
+// return the largest per-channel difference between two RGB565 pixels, in 8 bit units
+static int maxChanDiff (uint16_t a, uint16_t b)
+{
+        int dr = abs ((int)RGB565_R(a) - (int)RGB565_R(b));
+        int dg = abs ((int)RGB565_G(a) - (int)RGB565_G(b));
+        int db = abs ((int)RGB565_B(a) - (int)RGB565_B(b));
+        int m = dr > dg ? dr : dg;
+        return (m > db ? m : db);
+}
+
+int main (int ac, char *av[])
+{
+        (void) ac;
+        (void) av;
+
+        uint16_t *day = (uint16_t *) malloc (NPIX * sizeof(uint16_t));
+        uint16_t *night = (uint16_t *) malloc (NPIX * sizeof(uint16_t));
+        uint16_t *out_f = (uint16_t *) malloc (NPIX * sizeof(uint16_t));
+        uint16_t *out_b = (uint16_t *) malloc (NPIX * sizeof(uint16_t));
+        if (!day || !night || !out_f || !out_b) {
+            printf ("no memory\n");
+            return (1);
+        }
+
+        srand (1);
+        for (int i = 0; i < NPIX; i++) {
+            day[i] = rand() & 0xFFFF;
+            night[i] = rand() & 0xFFFF;
+        }
+
+        // check blendRGB565 is close to the original float at many weights
+        int worst = 0;
+        for (int w = 0; w <= 100; w++) {
+            float fract_day = w/100.0F;
+            blendRGB565Float (day, night, out_f, NPIX, fract_day);
+            blendRGB565 (day, night, out_b, NPIX, fract_day);
+            for (int i = 0; i < NPIX; i++) {
+                int d = maxChanDiff (out_f[i], out_b[i]);
+                if (d > worst)
+                    worst = d;
+            }
+        }
+        printf ("worst channel difference from float: %d of 255\n", worst);
+        if (worst > 12) {
+            printf ("FAIL: fixed point too far from float\n");
+            return (1);
+        }
+
+        // time each
+        struct timeval tv0, tv1;
+
+        gettimeofday (&tv0, NULL);
+        for (int r = 0; r < NRUNS; r++)
+            blendRGB565Float (day, night, out_f, NPIX, 0.37F + r*1e-4F);
+        gettimeofday (&tv1, NULL);
+        long float_us = tvdelus (tv0, tv1);
+
+        gettimeofday (&tv0, NULL);
+        for (int r = 0; r < NRUNS; r++)
+            blendRGB565Scalar (day, night, out_b, NPIX, 95 + (r&1));
+        gettimeofday (&tv1, NULL);
+        long scalar_us = tvdelus (tv0, tv1);
+
+        // same again but in SCALESZ x SCALESZ blocks as plotEarth() calls it
+        gettimeofday (&tv0, NULL);
+        for (int r = 0; r < NRUNS; r++)
+            for (int i = 0; i + 16 <= NPIX; i += 16)
+                blendRGB565 (&day[i], &night[i], &out_b[i], 16, 0.37F + r*1e-4F);
+        gettimeofday (&tv1, NULL);
+        long block_us = tvdelus (tv0, tv1);
+
+        double mpix = (double)NPIX*NRUNS/1e6;
+        printf ("%d runs of %d pixels:\n", NRUNS, NPIX);
+        printf ("  original float  %8ld us  %7.1f Mpix/s\n", float_us, mpix/(float_us*1e-6));
+        printf ("  fixed scalar    %8ld us  %7.1f Mpix/s\n", scalar_us, mpix/(scalar_us*1e-6));
+        printf ("  fixed 4x4       %8ld us  %7.1f Mpix/s\n", block_us, mpix/(block_us*1e-6));
+
+        return (0);
+}
+
+#endif // _UNIT_TEST
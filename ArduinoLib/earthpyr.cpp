@@ -0,0 +1,276 @@
+/* mip-mapped RGB565 earth map storage used by Adafruit_RA8875::plotEarth().
+ *
+ * level 0 is the full resolution map, each further level is half the size of the one before made by
+ * averaging 2x2 blocks. level 0 is stored row-major: it is only sampled when zoomed in, where each screen
+ * pixel steps less than one texel so plain rows are already cache friendly and measured faster than tiles.
+ * the reduced levels are sampled when each screen pixel steps over several texels, so they are stored as
+ * EPYR_TILE x EPYR_TILE tiles to keep the texels for a patch of screen close together in memory regardless
+ * of the map projection. edge tiles are padded by replicating the last row and column.
+ *
+ * the layout is a flat EarthPyr header followed by all pixels so it may be written to a file and mmap'ed.
+ *
+ * to build and run a stand-alone main test and benchmark against row-major sampling:
+ *    g++ -Wall -O2 -D_UNIT_TEST -I. -o x.earthpyr earthpyr.cpp && ./x.earthpyr
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "Adafruit_RA8875.h"
+
+
+/* fill in the geometry portion of the given header for a level 0 map of the given size.
+ */
+static void initEarthPyr (EarthPyr *pyr, int w, int h)
+{
+        memset (pyr, 0, sizeof(*pyr));
+        memcpy (pyr->magic, EPYR_MAGIC, sizeof(pyr->magic));
+        pyr->w = w;
+        pyr->h = h;
+
+        int32_t off = 0;
+        for (int l = 0; l < EPYR_MAXLEV; l++) {
+            pyr->lev_w[l] = w;
+            pyr->lev_h[l] = h;
+            pyr->lev_off[l] = off;
+            if (l == 0) {
+                // row-major
+                pyr->lev_tx[l] = 0;
+                off += w * h;
+            } else {
+                pyr->lev_tx[l] = (w + EPYR_TILE - 1) >> EPYR_TSHIFT;
+                off += pyr->lev_tx[l] * ((h + EPYR_TILE - 1) >> EPYR_TSHIFT) * EPYR_TILE * EPYR_TILE;
+            }
+            pyr->n_lev = l + 1;
+
+            // stop when one tile holds it all
+            if (w <= EPYR_TILE && h <= EPYR_TILE)
+                break;
+            w = (w + 1) / 2;
+            h = (h + 1) / 2;
+        }
+        pyr->n_pix = off;
+}
+
+/* return total bytes, including header, required to hold a pyramid for a w x h map.
+ */
+size_t earthPyrSize (int w, int h)
+{
+        EarthPyr pyr;
+        initEarthPyr (&pyr, w, h);
+        return (sizeof(EarthPyr) + (size_t)pyr.n_pix * sizeof(uint16_t));
+}
+
+/* return whether pyr looks like a pyramid for a w x h map occupying nbytes.
+ */
+bool earthPyrOk (const EarthPyr *pyr, size_t nbytes, int w, int h)
+{
+        EarthPyr ref;
+        initEarthPyr (&ref, w, h);
+        return (nbytes == sizeof(EarthPyr) + (size_t)ref.n_pix * sizeof(uint16_t)
+                    && memcmp (pyr->magic, ref.magic, sizeof(ref.magic)) == 0
+                    && memcmp (&pyr->w, &ref.w, sizeof(EarthPyr) - offsetof(EarthPyr, w)) == 0);
+}
+
+/* return the average of 4 RGB565 pixels
+ */
+static uint16_t avg4RGB565 (uint16_t a, uint16_t b, uint16_t c, uint16_t d)
+{
+        uint32_t r = ((a>>11)        + (b>>11)        + (c>>11)        + (d>>11)        + 2) >> 2;
+        uint32_t g = (((a>>5)&0x3F)  + ((b>>5)&0x3F)  + ((c>>5)&0x3F)  + ((d>>5)&0x3F)  + 2) >> 2;
+        uint32_t e = ((a&0x1F)       + (b&0x1F)       + (c&0x1F)       + (d&0x1F)       + 2) >> 2;
+        return ((uint16_t)((r << 11) | (g << 5) | e));
+}
+
+/* build a complete pyramid in pyr, which must be at least earthPyrSize(w,h) bytes, from the given
+ * row-major w x h RGB565 map. src_mtime is just stored for the caller's use.
+ */
+void buildEarthPyr (const uint16_t *src, int w, int h, int64_t src_mtime, EarthPyr *pyr)
+{
+        initEarthPyr (pyr, w, h);
+        pyr->src_mtime = src_mtime;
+        uint16_t *pix = (uint16_t *)(pyr+1);
+
+        // level 0 is a straight copy
+        memcpy (pix, src, (size_t)w * h * sizeof(uint16_t));
+
+        // each further level averages the one above
+        for (int l = 1; l < pyr->n_lev; l++) {
+            const int pw = pyr->lev_w[l-1];
+            const int ph = pyr->lev_h[l-1];
+            const int lw = pyr->lev_w[l];
+            const int lh = pyr->lev_h[l];
+            const int ltx = pyr->lev_tx[l];
+            const int lty = (lh + EPYR_TILE - 1) >> EPYR_TSHIFT;
+            for (int ty = 0; ty < lty; ty++) {
+                for (int tx = 0; tx < ltx; tx++) {
+                    uint16_t *tp = &pix[pyr->lev_off[l] + ((ty*ltx + tx) << (2*EPYR_TSHIFT))];
+                    for (int tr = 0; tr < EPYR_TILE; tr++) {
+                        int r = (ty << EPYR_TSHIFT) + tr;
+                        if (r >= lh)
+                            r = lh - 1;
+                        int r0 = 2*r;
+                        int r1 = 2*r+1 < ph ? 2*r+1 : ph-1;
+                        for (int tc = 0; tc < EPYR_TILE; tc++) {
+                            int c = (tx << EPYR_TSHIFT) + tc;
+                            if (c >= lw)
+                                c = lw - 1;
+                            int c0 = 2*c;
+                            int c1 = 2*c+1 < pw ? 2*c+1 : pw-1;
+                            *tp++ = avg4RGB565 (earthPyrPixel (pyr, l-1, r0, c0), earthPyrPixel (pyr, l-1, r0, c1),
+                                                earthPyrPixel (pyr, l-1, r1, c0), earthPyrPixel (pyr, l-1, r1, c1));
+                        }
+                    }
+                }
+            }
+        }
+}
+
+/* return the level plotEarth() should sample when each screen pixel steps over texels_per_pix level 0
+ * texels, ie, the coarsest level whose texels are still no larger than one screen pixel.
+ */
+int earthPyrLevel (const EarthPyr *pyr, float texels_per_pix)
+{
+        int l = 0;
+        while (texels_per_pix >= 2 && l < pyr->n_lev - 1) {
+            texels_per_pix /= 2;
+            l++;
+        }
+        return (l);
+}
+
+
+
+#if defined(_UNIT_TEST)
+
+#include <sys/time.h>
+#include <math.h>
+
+// a zoomed 3200x1920 build map
+#define MAP_W   (660*4*2)
+#define MAP_H   (330*4*2)
+#define NRUNS   20
+
+// microseconds between two timevals
+static long tvdelus (const struct timeval &tv0, const struct timeval &tv1)
+{
+        return ((tv1.tv_sec - tv0.tv_sec)*1000000L + (tv1.tv_usec - tv0.tv_usec));
+}
+
+int main (int ac, char *av[])
+{
+        (void) ac;
+        (void) av;
+
+        // make a map with some structure
+        uint16_t *map = (uint16_t *) malloc ((size_t)MAP_W * MAP_H * sizeof(uint16_t));
+        size_t pyr_n = earthPyrSize (MAP_W, MAP_H);
+        EarthPyr *pyr = (EarthPyr *) malloc (pyr_n);
+        if (!map || !pyr) {
+            printf ("no memory\n");
+            return (1);
+        }
+        srand (1);
+        for (int r = 0; r < MAP_H; r++)
+            for (int c = 0; c < MAP_W; c++)
+                map[(size_t)r*MAP_W + c] = (uint16_t)(((r*7) ^ (c*13)) + (rand() & 0x3));
+
+        struct timeval tv0, tv1;
+        gettimeofday (&tv0, NULL);
+        buildEarthPyr (map, MAP_W, MAP_H, 12345, pyr);
+        gettimeofday (&tv1, NULL);
+        printf ("built %d levels %zu bytes in %ld us\n", pyr->n_lev, pyr_n, tvdelus (tv0, tv1));
+        for (int l = 0; l < pyr->n_lev; l++)
+            printf ("  level %d: %5d x %5d\n", l, pyr->lev_w[l], pyr->lev_h[l]);
+
+        // check header
+        int n_bad = 0;
+        if (!earthPyrOk (pyr, pyr_n, MAP_W, MAP_H) || earthPyrOk (pyr, pyr_n, MAP_W, MAP_H+1)
+                                || earthPyrOk (pyr, pyr_n-2, MAP_W, MAP_H) || pyr->src_mtime != 12345) {
+            printf ("header check failed\n");
+            n_bad++;
+        }
+
+        // level 0 must be exact
+        for (int r = 0; r < MAP_H; r++)
+            for (int c = 0; c < MAP_W; c++)
+                if (earthPyrPixel (pyr, 0, r, c) != map[(size_t)r*MAP_W + c])
+                    n_bad++;
+
+        // level 1 must be the 2x2 average of the map
+        for (int r = 0; r < pyr->lev_h[1]; r++)
+            for (int c = 0; c < pyr->lev_w[1]; c++) {
+                const uint16_t *p = &map[(size_t)2*r*MAP_W + 2*c];
+                if (earthPyrPixel (pyr, 1, r, c) != avg4RGB565 (p[0], p[1], p[MAP_W], p[MAP_W+1]))
+                    n_bad++;
+            }
+        printf ("%d bad pixels\n", n_bad);
+
+        // sample like plotEarth() for a rotated view at full zoom and for a whole globe where each screen
+        // pixel steps over several texels. the texel coordinates are computed first so only the map reads
+        // are timed. report how long each takes and how many bytes of map it used.
+        static const struct { const char *name; float step; } views[] = {
+            {"zoomed", 0.5F},
+            {"globe",  4.0F},
+        };
+        const int scr_w = MAP_W/8, scr_h = MAP_H/4;
+        int *rows_rc = (int *) malloc ((size_t)scr_w * scr_h * 2 * sizeof(int));
+        int *tiles_rc = (int *) malloc ((size_t)scr_w * scr_h * 2 * sizeof(int));
+        if (!rows_rc || !tiles_rc) {
+            printf ("no memory\n");
+            return (1);
+        }
+        for (unsigned v = 0; v < sizeof(views)/sizeof(views[0]); v++) {
+            const float step = views[v].step;                   // level 0 texels per screen pixel
+            const float ang = 0.6F;
+            const float dcr = step*cosf(ang), drr = step*sinf(ang);
+            const float dcd = -drr, drd = dcr;
+            const int l = earthPyrLevel (pyr, step);
+            const int lw = pyr->lev_w[l], lh = pyr->lev_h[l];
+            const float ls = (float)lw / MAP_W;
+            int *rp = rows_rc, *tp = tiles_rc;
+            for (int y = 0; y < scr_h; y++) {
+                for (int x = 0; x < scr_w; x++) {
+                    *rp++ = ((int)(drr*x + drd*y) + 2*MAP_H) % MAP_H;
+                    *rp++ = ((int)(dcr*x + dcd*y) + 2*MAP_W) % MAP_W;
+                    *tp++ = ((int)(ls*(drr*x + drd*y)) + 2*lh) % lh;
+                    *tp++ = ((int)(ls*(dcr*x + dcd*y)) + 2*lw) % lw;
+                }
+            }
+            const int n_rc = scr_w * scr_h;
+
+            uint32_t sum_rows = 0;
+            gettimeofday (&tv0, NULL);
+            for (int run = 0; run < NRUNS; run++)
+                for (int i = 0; i < n_rc; i++)
+                    sum_rows += map[(size_t)rows_rc[2*i]*MAP_W + rows_rc[2*i+1]];
+            gettimeofday (&tv1, NULL);
+            long us_rows = tvdelus (tv0, tv1);
+
+            uint32_t sum_pyr = 0;
+            gettimeofday (&tv0, NULL);
+            for (int run = 0; run < NRUNS; run++)
+                for (int i = 0; i < n_rc; i++)
+                    sum_pyr += earthPyrPixel (pyr, l, tiles_rc[2*i], tiles_rc[2*i+1]);
+            gettimeofday (&tv1, NULL);
+            long us_pyr = tvdelus (tv0, tv1);
+
+            printf ("%-6s: row-major %6ld us over %ld KB, pyramid level %d %6ld us over %ld KB, %.2fx\n",
+                        views[v].name, us_rows/NRUNS, (long)MAP_W*MAP_H*2/1024, l, us_pyr/NRUNS,
+                        (long)lw*lh*2/1024, (float)us_rows/us_pyr);
+            if (l == 0 && sum_rows != sum_pyr) {
+                printf ("level 0 sweep disagrees\n");
+                n_bad++;
+            }
+        }
+
+        free (rows_rc);
+        free (tiles_rc);
+        free (map);
+        free (pyr);
+        return (n_bad > 0);
+}
+
+#endif // _UNIT_TEST
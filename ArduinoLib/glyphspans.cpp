@@ -0,0 +1,365 @@
+/* GFX font glyphs pre-expanded to horizontal pixel runs for fast text drawing.
+ *
+ * the GFX glyph bitmap is a packed bit stream, so drawing it directly means testing every bit and plotting
+ * each set pixel one at a time. Instead the first time a font is used all its glyphs are decoded once
+ * into runs of set pixels along each row; Adafruit_RA8875::plotChar() then fills each run as a span of
+ * the frame buffer with one clip test per glyph. Runs depend only on the glyph shape, so color and gray
+ * mode are applied once per glyph when the span color is chosen.
+ *
+ * to build and run a stand-alone main test and benchmark against the original per-bit plotting, drawing
+ * a full spot list pane of text in the fast font:
+ *    g++ -Wall -O2 -D_UNIT_TEST -I. -o x.glyphspans glyphspans.cpp CourierPrimeSans6.cpp && ./x.glyphspans
+ * add eg -D_CLOCK_1600x960 to both to try the larger builds.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "Adafruit_RA8875.h"
+
+
+// all the runs for one font
+typedef struct {
+        const GFXfont *font;                            // font these are for
+        uint32_t *start;                                // index of each glyph's first span, plus one at end
+        GlyphSpan *spans;                               // spans of all glyphs in order
+} FontSpans;
+
+static FontSpans *font_spans;                           // malloced list, one per font seen so far
+static int n_font_spans;                                // n in font_spans[]
+static int last_fs = -1;                                // font_spans index used last, likely again
+
+
+/* decode the bitmap of the given glyph into runs of set pixels, storing them in spans[] if not NULL.
+ * return the number of runs.
+ */
+static int glyphRuns (const GFXfont *f, const GFXglyph *gp, GlyphSpan *spans)
+{
+        const uint8_t *bp = &f->bitmap[gp->bitmapOffset];
+        uint32_t bitn = 0;
+        int n = 0;
+
+        for (uint16_t r = 0; r < gp->height; r++) {
+            int run_c = -1;                             // column of current run, -1 if none
+            for (uint16_t c = 0; c <= gp->width; c++) {
+                bool set = c < gp->width && (bp[bitn/8] & (1 << (7-(bitn%8))));
+                if (c < gp->width)
+                    bitn++;
+                if (set && run_c < 0)
+                    run_c = c;
+                else if (!set && run_c >= 0) {
+                    if (spans) {
+                        spans[n].r = r;
+                        spans[n].c = run_c;
+                        spans[n].n = c - run_c;
+                    }
+                    n++;
+                    run_c = -1;
+                }
+            }
+        }
+
+        return (n);
+}
+
+/* build and add the spans for all glyphs in the given font, return its font_spans index.
+ */
+static int addFontSpans (const GFXfont *f)
+{
+        int n_glyphs = f->last - f->first + 1;
+
+        FontSpans fs;
+        fs.font = f;
+        fs.start = (uint32_t *) malloc ((n_glyphs+1) * sizeof(uint32_t));
+        if (!fs.start) {
+            printf ("glyphspans: no memory for %d glyph starts\n", n_glyphs);
+            exit(1);
+        }
+
+        // count all then fill all
+        uint32_t n_spans = 0;
+        for (int i = 0; i < n_glyphs; i++) {
+            fs.start[i] = n_spans;
+            n_spans += glyphRuns (f, &f->glyph[i], NULL);
+        }
+        fs.start[n_glyphs] = n_spans;
+
+        fs.spans = (GlyphSpan *) malloc ((n_spans ? n_spans : 1) * sizeof(GlyphSpan));
+        if (!fs.spans) {
+            printf ("glyphspans: no memory for %u spans\n", n_spans);
+            exit(1);
+        }
+        for (int i = 0; i < n_glyphs; i++)
+            (void) glyphRuns (f, &f->glyph[i], &fs.spans[fs.start[i]]);
+
+        font_spans = (FontSpans *) realloc (font_spans, (n_font_spans+1) * sizeof(FontSpans));
+        if (!font_spans) {
+            printf ("glyphspans: no memory for %d fonts\n", n_font_spans+1);
+            exit(1);
+        }
+        font_spans[n_font_spans] = fs;
+        return (n_font_spans++);
+}
+
+/* return the spans of the given glyph in the given font and set n_spans, or NULL if ch is not in the font.
+ * N.B. not thread safe, Adafruit_RA8875 calls with fb_lock held
+ */
+const GlyphSpan *getGlyphSpans (const GFXfont *f, uint16_t ch, int &n_spans)
+{
+        if (ch < f->first || ch > f->last)
+            return (NULL);
+
+        // find the font, adding it if first time
+        if (last_fs < 0 || font_spans[last_fs].font != f) {
+            last_fs = -1;
+            for (int i = 0; i < n_font_spans; i++) {
+                if (font_spans[i].font == f) {
+                    last_fs = i;
+                    break;
+                }
+            }
+            if (last_fs < 0)
+                last_fs = addFontSpans (f);
+        }
+
+        const FontSpans &fs = font_spans[last_fs];
+        int gi = ch - f->first;
+        n_spans = fs.start[gi+1] - fs.start[gi];
+        return (&fs.spans[fs.start[gi]]);
+}
+
+/* fill the given glyph spans in color into the fb_w x fb_h frame buffer fb with glyph box origin at x,y.
+ * the glyph is w x h; the spans are only clipped individually if the glyph is not wholly within fb.
+ */
+void fillGlyphSpans (fbpix_t *fb, int fb_w, int fb_h, int x, int y, int w, int h,
+const GlyphSpan *sp, int n_spans, fbpix_t color)
+{
+        bool inside = x >= 0 && y >= 0 && x + w <= fb_w && y + h <= fb_h;
+
+        for (int i = 0; i < n_spans; i++, sp++) {
+            int py = y + sp->r;
+            int px0 = x + sp->c;
+            int px1 = px0 + sp->n;
+            if (!inside) {
+                if (py < 0 || py >= fb_h)
+                    continue;
+                if (px0 < 0)
+                    px0 = 0;
+                if (px1 > fb_w)
+                    px1 = fb_w;
+                if (px0 >= px1)
+                    continue;
+            }
+            fbpix_t *p = &fb[py*fb_w + px0];
+            for (int n = px1 - px0; n > 0; --n)
+                *p++ = color;
+        }
+}
+
+
+#if defined(_UNIT_TEST)
+
+#include <sys/time.h>
+
+#define BM_W    800                                     // benchmark canvas, scaled below to match build
+#define BM_H    480
+#define NRUNS   200
+
+// a spot list pane worth of lines
+static const char *spot_lines[] = {
+        " 14025.0 K1ABC      JA1XYZ   1234",
+        "  7004.5 DL2ZZ      VK3QQ    1233",
+        " 21074.0 W9/G4ABC   PY2AA    1231",
+        " 28400.0 VE3XYZ     ZS6ZZ    1229",
+        "  3573.0 OH2BH      JR0ABC   1228",
+        " 10136.0 N0CALL     EA8XX    1226",
+        " 18100.0 KH6AA      LU1DMA   1225",
+        "  1840.0 G3ABC      9M2AB    1223",
+        " 24915.0 5B4AAA     HC1ZZ    1221",
+        " 50313.0 F5XYZ      CT3AB    1220",
+        " 14074.0 JA7ZZZ     KL7QQ    1218",
+        "  7074.0 ZL2ABC     UA9XYZ   1217",
+        " 14195.0 3Y0J       K3LR     1215",
+        " 21295.0 VP8DXU     W1AW     1214",
+};
+#define N_SPOT_LINES ((int)(sizeof(spot_lines)/sizeof(spot_lines[0])))
+
+// microseconds between two timevals
+static long tvdelus (const struct timeval &tv0, const struct timeval &tv1)
+{
+        return ((tv1.tv_sec - tv0.tv_sec)*1000000L + (tv1.tv_usec - tv0.tv_usec));
+}
+
+// stand-in for the original gray switch in plotfb()
+static int gray_type;
+
+/* the original plotfb(): gray switch, index and bounds check for every pixel
+ */
+static void plotfbRef (fbpix_t *fb, int fb_w, int fb_h, int16_t x, int16_t y, fbpix_t color)
+{
+        switch (gray_type) {
+        case 0:
+            break;
+        case 1: {
+            uint32_t rgb = FBPIXTORGB32(color);
+            int r = (rgb >> 16) & 0xff;
+            int g = (rgb >> 8) & 0xff;
+            int b = rgb & 0xff;
+            int gray = RGB2GRAY(r,g,b);
+            color = RGB32TOFBPIX ((gray<<16) | (gray<<8) | (gray));
+            }
+            break;
+        }
+
+        int index = y*fb_w + x;
+        if (index < 0 || index >= fb_w*fb_h)
+            ::printf ("no! %d %d\n", x, y);
+        else
+            fb[index] = color;
+}
+
+/* the original plotChar() loop, return x advance
+ */
+static int plotCharRef (fbpix_t *fb, int fb_w, int fb_h, const GFXfont *f, int cx, int cy, char ch,
+fbpix_t color)
+{
+        if (ch < f->first || ch > f->last)
+            return (0);
+        const GFXglyph *gp = &f->glyph[ch-f->first];
+        const uint8_t *bp = &f->bitmap[gp->bitmapOffset];
+        int16_t x = cx + gp->xOffset;
+        int16_t y = cy + gp->yOffset;
+        uint16_t bitn = 0;
+        for (uint16_t r = 0; r < gp->height; r++) {
+            for (uint16_t c = 0; c < gp->width; c++) {
+                uint8_t bit = bp[bitn/8] & (1 << (7-(bitn%8)));
+                if (bit)
+                    plotfbRef (fb, fb_w, fb_h, x+c, y+r, color);
+                bitn++;
+            }
+        }
+        return (gp->xAdvance);
+}
+
+/* the plotChar() loop again but clipping each pixel to the canvas, as fillGlyphSpans() must,
+ * return x advance
+ */
+static int plotCharClip (fbpix_t *fb, int fb_w, int fb_h, const GFXfont *f, int cx, int cy, char ch,
+fbpix_t color)
+{
+        if (ch < f->first || ch > f->last)
+            return (0);
+        const GFXglyph *gp = &f->glyph[ch-f->first];
+        const uint8_t *bp = &f->bitmap[gp->bitmapOffset];
+        int x = cx + gp->xOffset;
+        int y = cy + gp->yOffset;
+        uint16_t bitn = 0;
+        for (uint16_t r = 0; r < gp->height; r++) {
+            for (uint16_t c = 0; c < gp->width; c++) {
+                uint8_t bit = bp[bitn/8] & (1 << (7-(bitn%8)));
+                if (bit && x+c >= 0 && x+c < fb_w && y+r >= 0 && y+r < fb_h)
+                    fb[(y+r)*fb_w + x+c] = color;
+                bitn++;
+            }
+        }
+        return (gp->xAdvance);
+}
+
+/* same using spans, return x advance
+ */
+static int plotCharSpans (fbpix_t *fb, int fb_w, int fb_h, const GFXfont *f, int cx, int cy, char ch,
+fbpix_t color)
+{
+        int n_spans;
+        const GlyphSpan *sp = getGlyphSpans (f, ch, n_spans);
+        if (!sp)
+            return (0);
+        const GFXglyph *gp = &f->glyph[ch-f->first];
+        fillGlyphSpans (fb, fb_w, fb_h, cx + gp->xOffset, cy + gp->yOffset, gp->width, gp->height,
+                                sp, n_spans, color);
+        return (gp->xAdvance);
+}
+
+/* draw the spot pane text with the given char plotter starting at x0, return n glyphs drawn
+ */
+static int drawPane (int (*plot)(fbpix_t*,int,int,const GFXfont*,int,int,char,fbpix_t),
+fbpix_t *fb, int fb_w, int fb_h, const GFXfont *f, int x0, int y0)
+{
+        int n = 0;
+        for (int l = 0; l < N_SPOT_LINES; l++) {
+            int x = x0;
+            int y = y0 + (l+1)*f->yAdvance;
+            for (const char *s = spot_lines[l]; *s; s++, n++)
+                x += (*plot) (fb, fb_w, fb_h, f, x, y, *s, (fbpix_t)(0x00A0C0E0 + l));
+        }
+        return (n);
+}
+
+int main (int ac, char *av[])
+{
+        (void) ac;
+        (void) av;
+
+        const GFXfont *f = &Courier_Prime_Sans6pt7b;
+        int scale = f->yAdvance / 10 > 0 ? f->yAdvance / 10 : 1;
+        int fb_w = BM_W*scale, fb_h = BM_H*scale;
+        size_t nbytes = (size_t)fb_w*fb_h*sizeof(fbpix_t);
+        fbpix_t *fb_ref = (fbpix_t *) calloc (1, nbytes);
+        fbpix_t *fb_spn = (fbpix_t *) calloc (1, nbytes);
+        if (!fb_ref || !fb_spn) {
+            printf ("no memory\n");
+            return (1);
+        }
+
+        // check identical results inside and straddling every edge. the original only checks the index so
+        // it would wrap rows at the sides, hence compare with the per pixel clipping version.
+        int xs[] = {10, 5*fb_w/8, -7, fb_w-60};
+        int ys[] = {10, fb_h/2, -9, fb_h-30};
+        for (int xi = 0; xi < 4; xi++) {
+            for (int yi = 0; yi < 4; yi++) {
+                memset (fb_ref, 0, nbytes);
+                memset (fb_spn, 0, nbytes);
+                (void) drawPane (plotCharClip, fb_ref, fb_w, fb_h, f, xs[xi], ys[yi]);
+                (void) drawPane (plotCharSpans, fb_spn, fb_w, fb_h, f, xs[xi], ys[yi]);
+                if (memcmp (fb_ref, fb_spn, nbytes) != 0) {
+                    printf ("FAIL: spans differ from bits at %d %d\n", xs[xi], ys[yi]);
+                    return (1);
+                }
+            }
+        }
+
+        // and the original agrees away from the edges
+        memset (fb_ref, 0, nbytes);
+        memset (fb_spn, 0, nbytes);
+        (void) drawPane (plotCharRef, fb_ref, fb_w, fb_h, f, 10, 10);
+        (void) drawPane (plotCharSpans, fb_spn, fb_w, fb_h, f, 10, 10);
+        if (memcmp (fb_ref, fb_spn, nbytes) != 0) {
+            printf ("FAIL: spans differ from original bits\n");
+            return (1);
+        }
+        printf ("spans match bits; %d fonts cached\n", n_font_spans);
+
+        // time each
+        struct timeval tv0, tv1;
+        int n_glyphs = 0;
+        gettimeofday (&tv0, NULL);
+        for (int i = 0; i < NRUNS; i++)
+            n_glyphs += drawPane (plotCharRef, fb_ref, fb_w, fb_h, f, 10, 10);
+        gettimeofday (&tv1, NULL);
+        long ref_us = tvdelus (tv0, tv1);
+
+        gettimeofday (&tv0, NULL);
+        for (int i = 0; i < NRUNS; i++)
+            (void) drawPane (plotCharSpans, fb_spn, fb_w, fb_h, f, 10, 10);
+        gettimeofday (&tv1, NULL);
+        long spn_us = tvdelus (tv0, tv1);
+
+        printf ("%d glyphs of %dpx font: bits %.1f ns/glyph, spans %.1f ns/glyph, %.1fx\n", n_glyphs/NRUNS,
+                        f->yAdvance, 1e3*ref_us/n_glyphs, 1e3*spn_us/n_glyphs, (float)ref_us/(spn_us?spn_us:1));
+
+        return (0);
+}
+
+#endif // _UNIT_TEST
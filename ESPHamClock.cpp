@@ -255,6 +255,7 @@ void setup()
     while (!Serial)
         wdDelay(500);
     Serial.printf("HamClock version %s platform %s\n", hc_version, platform);
+    bootPhase ("display");
 
     // show config
     showDefines();
@@ -383,6 +384,7 @@ void setup()
     initBRBRotset();
 
     // run Setup at full brighness
+    bootPhase ("setup");
     clockSetup();
 
     // set desried gray display
@@ -486,6 +488,7 @@ void setup()
 
 #if !defined(NO_UPGRADE)
     // ask to update if new version available -- never returns if update succeeds
+    bootPhase ("version check");
     if (!skip_skip) {
         new_avail = newVersionIsAvailable (new_version, sizeof(new_version));
         if (new_avail && askOTAupdate (new_version, true, false)) {
@@ -497,6 +500,7 @@ void setup()
 #endif // !NO_UPGRADE
 
     // init sensors
+    bootPhase ("layout");
     initBME280();
 
     // read plot settings from NVnsure sane defaults 
@@ -646,8 +650,13 @@ void setup()
     // log screen lock
     Serial.printf ("Screen lock is now %s\n", screenIsLocked() ? "On" : "Off");
 
+    // start fetching what the panes will need while the screen comes up
+    startPaneWarmUp();
+
     // here we go
+    bootPhase ("screen");
     initScreen();
+    bootPhase ("first panes");
 }
 
 // called repeatedly forever
@@ -667,6 +676,7 @@ void loop()
 
         // check on wifi including plots and NCDXF_b
         updateWiFi();
+        checkBootDone();
 
         // update clocks
         updateClocks(false);
@@ -2197,8 +2207,9 @@ bool postDiags (void)
     snprintf (fn, sizeof(fn), "/ham/HamClock/diagnostic-logs/dl-%lld-%s-%u.txt", (long long)myNow(),
                                                 remote_addr, ESP.getChipId());
 
-    // get total size of all diag files for content length
+    // get total size of all diag files for content length, after writing everything still queued
     // N.B. DO NOT use Serial after this because it adds to the log file !
+    Serial.flush();
     struct stat s;
     int cl = 0;
     for (int i = 0; i < N_DIAG_FILES; i++) {
@@ -2207,7 +2218,8 @@ bool postDiags (void)
             cl += s.st_size;
     }
 
-    // add eeprom file
+    // add eeprom file, including anything pending
+    (void) EEPROM.flush();
     if (stat (EEPROM.getFilename(), &s) == 0)
         cl += s.st_size;
 
@@ -2465,6 +2477,13 @@ void doExit()
         // X11 calls doExit on window close, so drawing would be recursive back to that thread
         eraseScreen();
     #endif
+
+    // save any settings still waiting for their commit delay, _exit() skips the atexit() that would
+    (void) EEPROM.flush();
+
+    // likewise write all queued log messages
+    Serial.flush();
+
     _exit(0);
 }
 
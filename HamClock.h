@@ -161,9 +161,11 @@ typedef struct {
 #define NV_COREMAPSTYLE_LEN     10
 
 
-/* allows reading from array, WiFiClient or FILE
+/* allows reading from array, WiFiClient or FILE.
+ * getChar() returns one byte at a time; getLine() and getSpan() return larger pieces in place for speed.
  */
 extern bool getTCPChar (WiFiClient &client, char *cp);
+extern void fatalError (const char *fmt, ...);
 class GenReader 
 {
     public:
@@ -173,7 +175,9 @@ class GenReader
         GenReader (WiFiClient &client, long content_length = 0) {
             my_type = GR_CLIENT;
             my_client = &client;
-            my_clen = content_length;   // ignored if 0
+            my_clen = content_length > 0 ? content_length : -1;         // < 0 for no limit
+            my_buf = NULL;
+            my_buf_len = 0;
         }
 
         // instantiate to read from a FILE *p
@@ -181,6 +185,8 @@ class GenReader
         GenReader (FILE *fp) {
             my_type = GR_FILE;
             my_fp = fp;
+            my_buf = NULL;
+            my_buf_len = 0;
         }
 
         // instantiate to read from a memory array
@@ -189,6 +195,12 @@ class GenReader
             my_type = GR_ARRAY;
             my_array = a;
             my_array_end = a + n_a;
+            my_buf = NULL;
+            my_buf_len = 0;
+        }
+
+        ~GenReader () {
+            free (my_buf);
         }
 
         // return next byte from the source
@@ -210,13 +222,96 @@ class GenReader
                 }
                 break;
             case GR_CLIENT:
-                return ((!my_clen || my_clen-- > 0) && getTCPChar (*my_client, bp));
+                return ((my_clen < 0 || my_clen-- > 0) && getTCPChar (*my_client, bp));
                 break;
             default:
                 return (false);
             }
         }
 
+        // return next line without its newline or any \r just before, and its length if len is not NULL.
+        // line remains valid only until the next read of any kind. return false at EOF.
+        bool getLine (char **line, int *len = NULL) {
+            switch (my_type) {
+            case GR_ARRAY: {
+                if (my_array >= my_array_end)
+                    return (false);
+                const char *nl = (const char *) memchr (my_array, '\n', my_array_end - my_array);
+                int ll = (nl ? nl : my_array_end) - my_array;
+                growBuf (ll + 1);
+                memcpy (my_buf, my_array, ll);
+                my_array += nl ? ll + 1 : ll;
+                return (finishLine (ll, line, len));
+                }
+                break;
+            case GR_FILE: {
+                ssize_t ll = getline (&my_buf, &my_buf_len, my_fp);
+                if (ll <= 0)
+                    return (false);
+                if (my_buf[ll-1] == '\n')
+                    ll--;
+                return (finishLine (ll, line, len));
+                }
+                break;
+            case GR_CLIENT:
+                if (my_clen < 0)
+                    return (my_client->readLine (line, len));
+                else {
+                    // content length requires counting each byte
+                    int ll = 0;
+                    char c;
+                    bool any = false;
+                    while (getChar (&c)) {
+                        any = true;
+                        if (c == '\n')
+                            break;
+                        growBuf (ll + 2);
+                        my_buf[ll++] = c;
+                    }
+                    if (!any)
+                        return (false);
+                    growBuf (ll + 1);
+                    return (finishLine (ll, line, len));
+                }
+                break;
+            default:
+                return (false);
+            }
+        }
+
+        // return the next run of bytes in *span and its length, else 0 at EOF.
+        // span remains valid only until the next read of any kind.
+        int getSpan (const char **span) {
+            switch (my_type) {
+            case GR_ARRAY: {
+                int n = my_array_end - my_array;
+                *span = my_array;
+                my_array = my_array_end;
+                return (n);
+                }
+                break;
+            case GR_FILE: {
+                growBuf (GR_SPANSZ);
+                int n = fread (my_buf, 1, GR_SPANSZ, my_fp);
+                *span = my_buf;
+                return (n > 0 ? n : 0);
+                }
+                break;
+            case GR_CLIENT: {
+                if (my_clen == 0)
+                    return (0);
+                long want = my_clen < 0 || my_clen > GR_SPANSZ ? GR_SPANSZ : my_clen;
+                int n = my_client->readSpan ((const uint8_t **)span, want);
+                if (my_clen > 0)
+                    my_clen -= n;
+                return (n);
+                }
+                break;
+            default:
+                return (0);
+            }
+        }
+
         // type tests
         bool isFile(void) { return (my_type == GR_FILE); }
         bool isClient(void) { return (my_type == GR_CLIENT); }
@@ -230,12 +325,40 @@ class GenReader
             GR_CLIENT
         } GRType;
 
+        static const int GR_SPANSZ = 16384;     // largest getSpan() from a file or client
+
+        // insure my_buf can hold at least n bytes
+        void growBuf (size_t n) {
+            if (n > my_buf_len) {
+                my_buf = (char *) realloc (my_buf, my_buf_len = n + 256);
+                if (!my_buf)
+                    fatalError ("GenReader: no memory for %ld", (long)n);
+            }
+        }
+
+        // strip trailing \r from the ll bytes in my_buf, add EOS and return as the next line
+        bool finishLine (int ll, char **line, int *len) {
+            if (ll > 0 && my_buf[ll-1] == '\r')
+                ll--;
+            my_buf[ll] = '\0';
+            *line = my_buf;
+            if (len)
+                *len = ll;
+            return (true);
+        }
+
         GRType my_type;
         FILE *my_fp;
         WiFiClient *my_client;  // pointer to avoid having to init the reference everywhere with a dummy
-        long my_clen;
+        long my_clen;           // remaining content length, or < 0 if unlimited
         const char *my_array;
         const char *my_array_end;
+        char *my_buf;           // malloced line or span buffer for GR_FILE and GR_ARRAY
+        size_t my_buf_len;      // bytes malloced in my_buf
+
+        // no copies, we own my_buf
+        GenReader (const GenReader &);
+        GenReader &operator= (const GenReader &);
 };
 
 
@@ -1248,6 +1371,7 @@ extern bool onADIFList (const DXSpot &spot, bool chk_dxcc, bool chk_grid, bool c
  */
 
 extern int readADIFFile (GenReader &gr, DXSpot *&spots, bool use_wl, int &n_bad);
+extern int parseADIFFile (GenReader &gr, DXSpot *&spots, int &n_bad);
 
 
 
@@ -1392,6 +1516,28 @@ extern bool writeBMP565File (const char *filename, uint16_t *&pix_565, int img_w
 
 
 
+/*********************************************************************************************
+ *
+ * boot.cpp
+ *
+ */
+
+typedef struct {
+    const char *name;                           // phase name
+    uint32_t ms;                                // duration, or so far if still running, millis
+} BootPhase;
+
+extern void bootPhase (const char *name);
+extern void checkBootDone (void);
+extern int getBootTrace (const BootPhase **phases, uint32_t &total_ms, bool &done);
+extern void startWarmUp (void);
+extern void startPaneWarmUp (void);
+
+
+
+
+
+
 /*********************************************************************************************
  *
  * brightness.cpp
@@ -1426,6 +1572,8 @@ extern void doNCDXFBoxTouch (TouchType tt, const SCoord &s);
 #define CACHE_NONE    1                         // remove all files older than 1 second
 
 extern FILE *openCachedFile (const char *fn, const char *url, int max_age, int min_size);
+extern void prefetchCachedFile (const char *fn, const char *url, int max_age, int min_size);
+extern void checkCachePrefetches (void);
 extern bool cleanCache (const char *contains, int max_age);
 
 
@@ -1453,6 +1601,7 @@ extern void setCallsignInfo (Call_t t, const char *text, uint16_t *fg, uint16_t
  *
  */
 extern const char *getNearestCity (const LatLong &ll, LatLong &city_ll, int *max_l);
+extern void prefetchCitiesFile (void);
 
 
 
@@ -1548,6 +1697,7 @@ extern void runConfigManagement(void);
 extern bool updateContests (const SBox &box, bool fresh);
 extern bool checkContestsTouch (const SCoord &s, const SBox &box);
 extern int getContests (char **&titles, char **&dates);
+extern void prefetchContestsFile (void);
 
 
 
@@ -1678,6 +1828,7 @@ extern void resetDXPedsWorked (void);
 extern int findDXPedsWorked (const DXPedEntry *dxp, DXPedsWorked *&worked);
 extern bool findDXPedsCall (const DXSpot *sp);
 extern bool dxpedsWatchingCluster(void);
+extern void prefetchDXPedsFile (void);
 
 
 
@@ -1716,6 +1867,14 @@ typedef struct {
     int16_t pan_x, pan_y;               // offset from original position, unzoomed pixels, + right/up
 } PanZoom;
 extern PanZoom pan_zoom;
+
+typedef struct {
+    SBox b;                             // map_b
+    PanZoom pz;                         // pan_zoom
+    uint8_t proj;                       // map_proj
+    int16_t center_lng;                 // getCenterLng()
+    float de_lng, sdelat, cdelat;       // DE
+} MapProj;                              // snapshot of what ll2sRaw() depends on, see getMapProj()
 #define MIN_ZOOM     1                                  // minimum zoom factor
 #define MAX_ZOOM     (BUILD_W == 800 ? 4 : 3)           // max zoom factor
 #define MIN_PANX     (-EARTH_W/2)                       // smallest allowed pan_x
@@ -1787,6 +1946,8 @@ extern void ll2s (const LatLong &ll, SCoord &s, uint8_t edge);
 extern void ll2s (float lat, float lng, SCoord &s, uint8_t edge);
 extern void ll2sRaw (const LatLong &ll, SCoord &s, uint8_t edge);
 extern void ll2sRaw (float lat, float lng, SCoord &s, uint8_t edge);
+extern void ll2sRaw (const MapProj &mp, float lat, float lng, SCoord &s, uint8_t edge);
+extern void getMapProj (MapProj &mp);
 extern bool s2ll (uint16_t x, uint16_t y, LatLong &ll);
 extern bool s2ll (const SCoord &s, LatLong &ll);
 extern bool checkPathDirTouch (const SCoord &s);
@@ -1883,6 +2044,25 @@ extern void writeFavicon (FILE *fp);
 
 
 
+/*********************************************************************************************
+ *
+ * fetch.cpp
+ *
+ */
+
+typedef enum {
+    FETCH_PENDING,                              // still in progress
+    FETCH_OK,                                   // complete response is ready
+    FETCH_FAILED,                               // gave up
+} FetchState;
+
+extern int startFetch (const char *host, int port, const char *request);
+extern FetchState checkFetch (int id, int *fd);
+extern FetchState waitFetch (int id, int *fd);
+extern void cancelFetch (int id);
+
+
+
 /*********************************************************************************************
  *
  * fsfree.cpp
@@ -1973,21 +2153,36 @@ extern void drawInfoBox(void);
  *
  */
 
-struct kd_node_t {
+typedef struct {
     float s[3];                         // xyz coords on unit sphere
-    struct kd_node_t *left, *right;     // branches
+    uint8_t axis;                       // split axis if in tree, fits in padding
     void *data;                         // user data
-};
+} KD3Point;
 
-typedef struct kd_node_t KD3Node;
+// N.B. init to {}
+typedef struct {
+    KD3Point *pts;                      // malloced, [0,n_tree) in tree order then any pending
+    int n_pts;                          // n pts[] in use
+    int n_tree;                         // n pts[] arranged as tree, rest are pending a rebuild
+    int n_malloced;                     // n pts[] malloced
+} KD3Tree;
 
-extern KD3Node* mkKD3NodeTree (KD3Node *t, int len, int idx);
-extern void freeKD3NodeTree (KD3Node *t, int n_t);
-extern void nearestKD3Node (const KD3Node *root, const KD3Node *nd, int level, const KD3Node **best,
-    float *best_dist, int *n_visited);
-extern void ll2KD3Node (const LatLong &ll, KD3Node *kp);
-extern void KD3Node2ll (const KD3Node &n, LatLong *llp);
-extern float nearestKD3Dist2Miles(float d);
+typedef bool (*KD3Filter)(const KD3Point *pp, void *arg);
+
+extern KD3Point *allocKD3Points (KD3Tree &t, int n);
+extern void buildKD3Tree (KD3Tree &t);
+extern void addKD3Point (KD3Tree &t, const LatLong &ll, void *data);
+extern void freeKD3Tree (KD3Tree &t);
+extern const KD3Point *nearestKD3Point (const KD3Tree &t, const LatLong &ll, float *miles);
+extern const KD3Point *nearestKD3PointFilter (const KD3Tree &t, const LatLong &ll, KD3Filter filter, void *arg,
+    float *miles);
+extern int kNearestKD3Points (const KD3Tree &t, const LatLong &ll, int k, const KD3Point *found[], float miles[]);
+extern int radiusKD3Points (const KD3Tree &t, const LatLong &ll, float miles, const KD3Point *found[],
+    int max_found);
+extern void nearestKD3Batch (const KD3Tree &t, const LatLong lls[], int n_lls, const KD3Point *found[],
+    float miles[]);
+extern void ll2KD3Point (const LatLong &ll, KD3Point *kp);
+extern void KD3Point2ll (const KD3Point &n, LatLong *llp);
 
 
 
@@ -2006,6 +2201,17 @@ extern char live_html[];
 
 
 
+/*********************************************************************************************
+ *
+ * qoi.cpp
+ *
+ */
+
+extern uint8_t *qoiEncode (const uint8_t *rgb, int w, int h, int stride, int *len);
+
+
+
+
 /*********************************************************************************************
  *
  * liveweb.cpp
@@ -2019,6 +2225,16 @@ extern int n_roweb, n_rwweb;
 extern void openLiveWebURL (const char *url);
 extern bool isLiveWebTouch (void);
 
+typedef struct {
+    uint32_t n_gens;                                    // screen changes encoded as updates
+    uint32_t n_fulls;                                   // full images encoded
+    uint64_t encode_us;                                 // total time spent encoding all of the above
+    uint32_t n_requests;                                // client update and image requests served
+    uint32_t n_sent;                                    // encoded updates and images sent to clients
+    uint64_t n_bytes;                                   // total bytes of all of the above
+} LiveWebStats;
+extern void getLiveWebStats (LiveWebStats &s);
+
 
 
 
@@ -2112,6 +2328,7 @@ extern CoreMapInfo cm_info[CM_N];               // info about each core map
 extern SBox mapscale_b;                         // map scale box
 
 extern void initCoreMaps(void);
+extern void prefetchCoreMap (void);
 extern bool installFreshMaps(void);
 extern float propBand2MHz (PropMapBand band);
 extern int propBand2Band (PropMapBand band);
@@ -2311,6 +2528,29 @@ extern bool checkNMEAFilename (const char *fn, Message &ynot);
 
 
 
+/*********************************************************************************************
+ *
+ * ntp.cpp
+ *
+ */
+
+typedef struct {
+    const char *server;                         // name of server
+    int rsp_time;                               // last known response time, millis(), see getNTPRspTime()
+} NTPServer;
+#define NTP_TOO_LONG 5000U                      // too long response time, millis()
+
+extern void startNTP (void);
+extern time_t getNTPUTC (uint16_t &ms);
+extern int getNTPServers (const NTPServer **listp);
+extern int getNTPRspTime (int i);
+extern const NTPServer *findBestNTP(void);
+
+
+
+
+
+
 /*********************************************************************************************
  *
  * nvram.cpp
@@ -2547,6 +2787,8 @@ extern void restoreNormPANE0(void);
 extern bool ll2Prefix (const LatLong &ll, char prefix[MAX_PREF_LEN]);
 extern bool call2LL (const char *call, LatLong &ll);
 extern bool call2DXCC (const char *call, int &dxcc);
+extern void prefetchCtyFile (void);
+extern bool loadCtyFile (void);
 extern void findCallPrefix (const char *call, char prefix[MAX_PREF_LEN]);
 extern void splitCallSign (const char *call, char home_call[NV_CALLSIGN_LEN], char dx_call[NV_CALLSIGN_LEN]);
 
@@ -2662,7 +2904,7 @@ extern void radioResetIO(void);
  *
  */
 
-extern void ll2sRobinson (const LatLong &ll, SCoord &s, int edge, int scalesz);
+extern void ll2sRobinson (const MapProj &mp, const LatLong &ll, SCoord &s, int edge, int scalesz);
 extern bool s2llRobinson (const SCoord &s, LatLong &ll);
 extern float RobLat2G (const float lat_d);
 
@@ -2709,6 +2951,26 @@ extern SBox santa_b;
 
 
 
+/*********************************************************************************************
+ *
+ * satpass.cpp
+ *
+ */
+
+// one time a sat crosses SAT_MIN_EL, from findSatEvents()
+typedef struct {
+    DateTime t;                         // when
+    float az;                           // az then, degrees
+    bool rising;                        // whether rising, else setting
+} SatEvent;
+
+extern int findSatEvents (Satellite *sat, const Observer *obs, const DateTime &t0, float max_days,
+    SatEvent events[], int max_events, bool &ever_up, bool &ever_down);
+
+
+
+
+
 /*********************************************************************************************
  *
  * sattool.cpp
@@ -3249,16 +3511,16 @@ typedef struct {
     int n_points;                               // n points defined
 } DSTData;
 
-extern bool retrieveBzBt (BzBtData &bzbt);
-extern bool retrieveSolarWind(SolarWindData &sw);
-extern bool retrieveSunSpots (SunSpotData &ssn);
-extern bool retrieveSolarFlux (SolarFluxData &sf);
-extern bool retrieveDRAP (DRAPData &drap);
-extern bool retrieveXRay (XRayData &xray);
-extern bool retrieveKp (KpData &kp);
-extern bool retrieveNOAASWx (NOAASpaceWxData &noaa);
-extern bool retrieveAurora (AuroraData &a);
-extern bool retrieveDST (DSTData &a);
+extern bool retrieveBzBt (BzBtData &bzbt, bool wait = true);
+extern bool retrieveSolarWind(SolarWindData &sw, bool wait = true);
+extern bool retrieveSunSpots (SunSpotData &ssn, bool wait = true);
+extern bool retrieveSolarFlux (SolarFluxData &sf, bool wait = true);
+extern bool retrieveDRAP (DRAPData &drap, bool wait = true);
+extern bool retrieveXRay (XRayData &xray, bool wait = true);
+extern bool retrieveKp (KpData &kp, bool wait = true);
+extern bool retrieveNOAASWx (NOAASpaceWxData &noaa, bool wait = true);
+extern bool retrieveAurora (AuroraData &a, bool wait = true);
+extern bool retrieveDST (DSTData &a, bool wait = true);
 
 extern void doNCDXFSpcWxTouch (const SCoord &s);
 extern void drawNCDXFSpcWxStats(uint16_t color);
@@ -3292,8 +3554,17 @@ extern void solveSphere (float A, float b, float cc, float sc, float *cap, float
 
 typedef bool (*SpotFilter)(const DXSpot *sp);
 
-extern bool getClosestSpot (DXSpot *list, int n_list, SpotFilter sfp, LabelOnMapEnd which_ends,
-    LatLong &ll, DXSpot *sp, LatLong *llp);
+#define SPOTS_ALLBANDS  (~0U)                   // getClosestSpot() bands mask to consider all
+
+// spatial index of spot ends for getClosestSpot(), one per list. N.B. init to {}
+typedef struct {
+    KD3Tree tree;                               // rx and tx end of each spot
+    bool valid;                                 // whether tree matches the list
+} SpotIndex;
+
+extern void resetSpotIndex (SpotIndex &si);
+extern bool getClosestSpot (SpotIndex &si, DXSpot *list, int n_list, SpotFilter sfp, uint32_t bands,
+    LabelOnMapEnd which_ends, LatLong &ll, DXSpot *sp, LatLong *llp);
 extern void drawSpotLabelOnMap (DXSpot &spot, LabelOnMapEnd txrx, LabelOnMapDot dot);
 extern void drawSpotPathOnMap (const DXSpot &spot);
 extern void ditherLL (LatLong &ll);
@@ -3540,11 +3811,6 @@ extern bool bypass_pw;
 
 
 
-typedef struct {
-    const char *server;                         // name of server
-    int rsp_time;                               // last known response time, millis()
-} NTPServer;
-#define NTP_TOO_LONG 5000U                      // too long response time, millis()
 
 extern void initSys (void);
 extern void initWiFiRetry(void);
@@ -3552,27 +3818,27 @@ extern void scheduleNewPlot (PlotChoice ch);
 extern void scheduleNewCoreMap (CoreMaps cm);
 extern void updateWiFi(void);
 extern bool checkBCTouch (const SCoord &s, const SBox &b);
+extern void prefetchBandConditions (void);
 extern void setPlotVisible (PlotChoice pc);
 extern bool setPlotChoice (PlotPane new_pp, PlotChoice new_ch);
-extern time_t getNTPUTC (NTPServer *);
 extern void scheduleRSSNow(void);
 extern bool getTCPLine (WiFiClient &client, char line[], uint16_t line_len, uint16_t *ll);
 extern void sendUserAgent (WiFiClient &client);
 extern void httpHCGET (WiFiClient &client, const char *server, const char *hc_page);
+extern int startHCFetch (const char *hc_page);
 extern bool httpSkipHeader (WiFiClient &client);
 extern bool httpSkipHeader (WiFiClient &client, const char *header, char *value, int value_len);
-extern int getNTPServers (const NTPServer **listp);
 extern bool setRSSTitle (const char *title, int &n_titles, int &max_titles);
 extern time_t nextPaneRotation (PlotPane pp);
 extern time_t nextWiFiRetry (PlotChoice pc);
 extern time_t nextWiFiRetry (const char *str);
 extern void scheduleFreshMap (void);
 extern PlotPane ignorePaneTouch(void);
-extern NTPServer *findBestNTP(void);
 
 
 extern char remote_addr[16];
 extern time_t next_update[PANE_N];
+extern bool pane_drawn[PANE_N];
 extern uint8_t rss_interval;
 
 
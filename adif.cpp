@@ -81,11 +81,155 @@ class FileSignature
 static ADIFSorts adif_sort;                             // current sort code index into adif_pqsf
 static DXSpot *adif_spots;                              // malloced
 static ScrollState adif_ss;                             // scroll controller, n_data is count
+static SpotIndex adif_six;                              // getClosestSpot() index of adif_spots
 static bool showing_set_adif;                           // set when not checking for local file
 static bool newfile_pending;                            // set when find new file while scrolled away
 static FileSignature fsig;                              // used to decide whether to read file again
 static int n_adif_bad;                                  // n bad spots found, global to maintain context
 
+/* one ADIF file being read and sorted on the task pool, see freshenADIFFile()
+ */
+typedef struct {
+    FILE *fp;                                           // file to read, closed by adifLoadTask()
+    ADIFSorts sort;                                     // adif_sort when started
+    uint32_t gen;                                       // adif_gen when started
+    DXSpot *spots;                                      // all good spots found, malloced
+    int n_spots;                                        // n spots[]
+    int n_bad;                                          // n busted spots
+} ADIFLoad;
+static ADIFLoad *adif_loading;                          // set while a file is being read on the pool
+static uint32_t adif_gen;                               // bumped whenever adif_spots is reset
+
+
+/* onADIFList() hash sets.
+ * for each combination of fields a watch list can require to match, the set of distinct values of those
+ * fields found in adif_spots[], so each check is O(1) rather than a search of the whole log. a set is built
+ * the first time its combination is used, then rebuilt each time the file is loaded.
+ */
+#define ADIFK_DXCC      0x1                             // match tx_dxcc
+#define ADIFK_GRID      0x2                             // match first 4 chars of tx_grid
+#define ADIFK_PREF      0x4                             // match prefix of tx_call
+#define ADIFK_BAND      0x8                             // match band of kHz
+#define ADIFK_N         16                              // n combinations
+
+typedef struct {
+    char pref[MAX_PREF_LEN];                            // upper case prefix, 0 padded, if ADIFK_PREF
+    char grid[4];                                       // upper case grid, 0 padded, if ADIFK_GRID
+    int dxcc;                                           // if ADIFK_DXCC
+    int band;                                           // HamBandSetting, if ADIFK_BAND
+} ADIFKey;
+
+typedef struct {
+    uint32_t hash;                                      // hash of key, 0 marks an empty slot
+    ADIFKey key;
+} ADIFKeySlot;
+
+typedef struct {
+    ADIFKeySlot *slots;                                 // malloced open-addressed table
+    int n_slots;                                        // size of slots[], always a power of 2
+    int n_used;                                         // n slots in use
+    bool wanted;                                        // set once onADIFList() uses this combination
+} ADIFKeySet;
+
+static ADIFKeySet adif_keysets[ADIFK_N];                // indexed by ADIFK_* mask
+
+/* fill k with the fields of s selected by mask, all others 0.
+ */
+static void makeADIFKey (const DXSpot &s, int mask, ADIFKey &k)
+{
+    memset (&k, 0, sizeof(k));
+    if (mask & ADIFK_PREF) {
+        char pref[MAX_PREF_LEN];
+        findCallPrefix (s.tx_call, pref);
+        for (int i = 0; i < MAX_PREF_LEN-1 && pref[i]; i++)
+            k.pref[i] = toupper (pref[i]);
+    }
+    if (mask & ADIFK_GRID) {
+        for (int i = 0; i < 4 && s.tx_grid[i]; i++)
+            k.grid[i] = toupper (s.tx_grid[i]);
+    }
+    if (mask & ADIFK_DXCC)
+        k.dxcc = s.tx_dxcc;
+    if (mask & ADIFK_BAND)
+        k.band = (int) findHamBand (s.kHz);
+}
+
+/* return FNV-1a hash of k, never 0.
+ */
+static uint32_t hashADIFKey (const ADIFKey &k)
+{
+    const uint8_t *kp = (const uint8_t *) &k;
+    uint32_t h = 2166136261U;
+    for (size_t i = 0; i < sizeof(k); i++)
+        h = (h ^ kp[i]) * 16777619U;
+    return (h ? h : 1);
+}
+
+/* return the slot in ks for k with hash h: either where it is or the empty slot where it belongs.
+ */
+static ADIFKeySlot &findADIFKeySlot (const ADIFKeySet &ks, const ADIFKey &k, uint32_t h)
+{
+    int mask = ks.n_slots - 1;
+    for (int i = h & mask; ; i = (i+1) & mask) {
+        ADIFKeySlot &slot = ks.slots[i];
+        if (slot.hash == 0 || (slot.hash == h && memcmp (&slot.key, &k, sizeof(k)) == 0))
+            return (slot);
+    }
+}
+
+/* add k to ks if not already present, growing as needed to stay at most half full.
+ */
+static void addADIFKey (ADIFKeySet &ks, const ADIFKey &k)
+{
+    if (2*(ks.n_used+1) > ks.n_slots) {
+        ADIFKeySlot *old_slots = ks.slots;
+        int old_n = ks.n_slots;
+        ks.n_slots = old_n ? 2*old_n : 64;
+        ks.slots = (ADIFKeySlot *) calloc (ks.n_slots, sizeof(ADIFKeySlot));
+        if (!ks.slots)
+            fatalError ("No memory for %d ADIF keys", ks.n_slots);
+        for (int i = 0; i < old_n; i++)
+            if (old_slots[i].hash)
+                findADIFKeySlot (ks, old_slots[i].key, old_slots[i].hash) = old_slots[i];
+        free (old_slots);
+    }
+
+    uint32_t h = hashADIFKey (k);
+    ADIFKeySlot &slot = findADIFKeySlot (ks, k, h);
+    if (slot.hash == 0) {
+        slot.hash = h;
+        slot.key = k;
+        ks.n_used++;
+    }
+}
+
+/* empty ks, leaving wanted as is.
+ */
+static void resetADIFKeySet (ADIFKeySet &ks)
+{
+    free (ks.slots);
+    ks.slots = NULL;
+    ks.n_slots = 0;
+    ks.n_used = 0;
+}
+
+/* (re)build the set for the given combination from adif_spots[]
+ */
+static void buildADIFKeySet (int mask)
+{
+    ADIFKeySet &ks = adif_keysets[mask];
+    resetADIFKeySet (ks);
+    for (int i = 0; i < adif_ss.n_data; i++) {
+        ADIFKey k;
+        makeADIFKey (adif_spots[i], mask, k);
+        addADIFKey (ks, k);
+    }
+    ks.wanted = true;
+
+    if (debugLevel (DEBUG_ADIF, 1))
+        Serial.printf ("ADIF: key set 0x%x has %d distinct of %d\n", mask, ks.n_used, adif_ss.n_data);
+}
+
 
 /* save sort and file name
  */
@@ -135,9 +279,13 @@ static void scrollADIFDown (const SBox &box)
 
 static void resetADIFMem(void)
 {
+    adif_gen++;                                         // orphans any load in progress
     free (adif_spots);
     adif_spots = NULL;
     adif_ss.n_data = 0;
+    resetSpotIndex (adif_six);
+    for (int i = 0; i < ADIFK_N; i++)
+        resetADIFKeySet (adif_keysets[i]);
 }
 
 /* draw complete ADIF pane in the given box.
@@ -315,7 +463,87 @@ static void runADIFMenu (const SBox &box)
 
 }
 
+/* install spots found by parseADIFFile(), already sorted by adif_sort, as the new adif_spots.
+ * we take ownership of spots; from_client is whether they came from set_adif rather than a file.
+ * N.B. we set n_adif_bad for drawADIFPane()
+ */
+static void installADIFSpots (DXSpot *spots, int n_spots, int n_bad, bool from_client)
+{
+    // restart list and insure settings are loaded
+    resetADIFMem();
+    loadADIFSettings();
+
+    // DXPeds worked list includes all spots but adif_spots only those that qualify the watch list
+    resetDXPedsWorked();
+    int n_good = 0;
+    for (int i = 0; i < n_spots; i++) {
+        addDXPedsWorked (spots[i]);
+        if (checkWatchListSpot (WLID_ADIF, spots[i]) != WLS_NO)
+            spots[n_good++] = spots[i];
+    }
+    adif_spots = (DXSpot *) realloc (spots, n_good * sizeof(DXSpot));
+    adif_ss.n_data = n_good;
+
+    // report
+    n_adif_bad = n_bad;
+    Serial.printf ("ADIF: loaded %d qualifying %d busted spots\n", n_good, n_bad);
+
+    // prep for display
+    resetSpotIndex (adif_six);
+    adif_ss.scrollToNewest();
+
+    // rebuild the onADIFList() sets already in use so the next spot check does not pay for it
+    for (int i = 0; i < ADIFK_N; i++)
+        if (adif_keysets[i].wanted)
+            buildADIFKeySet (i);
+
+    // note new source type ready
+    showing_set_adif = from_client;
+
+    // final message
+    mapMsg (1000, "Loaded ADIF file");
+}
+
+/* pool task to read and sort one ADIF file.
+ */
+static void adifLoadTask (void *arg)
+{
+    ADIFLoad *lp = (ADIFLoad *) arg;
+
+    GenReader gr(lp->fp);
+    lp->n_spots = parseADIFFile (gr, lp->spots, lp->n_bad);
+    fclose (lp->fp);
+
+    qsort (lp->spots, lp->n_spots, sizeof(DXSpot), adif_pqsf[lp->sort]);
+}
+
+/* back on the loop() thread after adifLoadTask(): install the new spots unless the list was reset or
+ * the sort changed while we were reading, in which case just try again.
+ */
+static void adifLoadDone (void *arg)
+{
+    ADIFLoad *lp = (ADIFLoad *) arg;
+
+    if (lp->gen == adif_gen && lp->sort == adif_sort) {
+        installADIFSpots (lp->spots, lp->n_spots, lp->n_bad, false);
+
+        // update list if showing
+        PlotPane pp = findPaneChoiceNow (PLOT_CH_ADIF);
+        if (pp != PANE_NONE)
+            drawADIFPane (plot_b[pp], getADIFilename());
+    } else {
+        free (lp->spots);
+        if (!showing_set_adif)
+            newfile_pending = true;
+    }
+
+    free (lp);
+    adif_loading = NULL;
+}
+
 /* freshen the ADIF file if used and necessary then update pane if in use.
+ * the file is read on the task pool so the new entries appear a little later, but large logs never
+ * hold up loop().
  * leave with newfile_pending set if file changed but we're currently not in a position to show new entries.
  * N.B. io errors are fatal.
  */
@@ -337,28 +565,31 @@ void freshenADIFFile (void)
     if (fsig.fileChanged (fn_exp))
         newfile_pending = true;
 
-    // read file if newer and not scrolled away
-    if (newfile_pending && adif_ss.atNewest()) {
+    // start reading file if newer, not scrolled away and not already reading
+    if (newfile_pending && adif_ss.atNewest() && !adif_loading) {
 
         // open
         FILE *fp = fopen (fn_exp, "r");
         if (!fp)
             fatalError ("ADIF %s: %s", fn_exp, strerror(errno));        // never returns
 
-        // ingest
-        GenReader gr(fp);
-        int n_good;
-        loadADIFFile (gr, n_good, n_adif_bad);
-        fclose (fp);
-
-        // update list if showing
-        PlotPane pp = findPaneChoiceNow (PLOT_CH_ADIF);
-        if (pp != PANE_NONE)
-            drawADIFPane (plot_b[pp], getADIFilename());
+        // announce but no waiting, message will remain until adifLoadDone() replaces it
+        mapMsg (0, "Loading ADIF file");
+
+        // read and sort on the pool, adifLoadDone() installs the results back here.
+        // the task can only look up calls, so get the cty table ready here first.
+        loadADIFSettings();
+        (void) loadCtyFile();
+        adif_loading = (ADIFLoad *) calloc (1, sizeof(ADIFLoad));
+        if (!adif_loading)
+            fatalError ("No memory for ADIF load");
+        adif_loading->fp = fp;
+        adif_loading->sort = adif_sort;
+        adif_loading->gen = adif_gen;
+        runTask (adifLoadTask, adifLoadDone, adif_loading);
 
         // caught up
         newfile_pending = false;
-        showing_set_adif = false;
     }
 }
 
@@ -366,34 +597,23 @@ void freshenADIFFile (void)
  * pass back number of qualifying spots and bad spots found.
  * N.B. caller must close gr
  * N.B. we set n_adif_bad for drawADIFPane()
- * N.B. unless loading directly from the network, you probably want freshenADIFFile().
+ * N.B. this reads gr right here; unless loading directly from the network, you probably want
+ *      freshenADIFFile() which does its reading on the task pool.
  */
 void loadADIFFile (GenReader &gr, int &n_good, int &n_bad)
 {
     // announce but no waiting, message will remain until this function returns
     mapMsg (0, "Loading ADIF file");
 
-    // restart list and insure settings are loaded
-    resetADIFMem();
+    // crack and sort
     loadADIFSettings();
+    DXSpot *spots = NULL;
+    int n_spots = parseADIFFile (gr, spots, n_bad);
+    qsort (spots, n_spots, sizeof(DXSpot), adif_pqsf[adif_sort]);
 
-    // crack file, adds good entries to adif_spots[]
-    adif_ss.n_data = readADIFFile (gr, adif_spots, true, n_bad);
-
-    // report
+    // install
+    installADIFSpots (spots, n_spots, n_bad, gr.isClient());
     n_good = adif_ss.n_data;
-    n_adif_bad = n_bad;
-    Serial.printf ("ADIF: loaded %d qualifying %d busted spots\n", n_good, n_bad);
-
-    // sort spots and prep for display
-    qsort (adif_spots, adif_ss.n_data, sizeof(DXSpot), adif_pqsf[adif_sort]);
-    adif_ss.scrollToNewest();
-
-    // note new source type ready
-    showing_set_adif = gr.isClient();
-    
-    // final message
-    mapMsg (1000, "Loaded ADIF file");
 }
 
 /* called frequently to check for new ADIF records.
@@ -507,7 +727,8 @@ bool checkADIFTouch (const SCoord &s, const SBox &box)
 bool getClosestADIFSpot (LatLong &ll, DXSpot *sp, LatLong *llp)
 {
     return (adif_spots && findPaneForChoice(PLOT_CH_ADIF) != PANE_NONE
-                && getClosestSpot (adif_spots, adif_ss.n_data, NULL, LOME_BOTH, ll, sp, llp));
+                && getClosestSpot (adif_six, adif_spots, adif_ss.n_data, NULL, SPOTS_ALLBANDS, LOME_BOTH,
+                                        ll, sp, llp));
 }
 
 
@@ -554,26 +775,19 @@ bool getADIFPaneSpot (const SCoord &ms, DXSpot *dxs, LatLong *ll)
  */
 bool onADIFList (const DXSpot &spot, bool chk_dxcc, bool chk_grid, bool chk_pref, bool chk_band)
 {
-    // prep spot
-    HamBandSetting spot_band = findHamBand (spot.kHz);
-    char spot_pref[MAX_PREF_LEN];
-    findCallPrefix (spot.tx_call, spot_pref);
-
-    // compare with each 
-    for (int i = 0; i < adif_ss.n_data; i++) {
-        DXSpot &adif_spot = adif_spots[i];
-        bool pref_match = false;
-        if (chk_pref) {
-            char adif_pref[MAX_PREF_LEN];
-            findCallPrefix (adif_spot.tx_call, adif_pref);
-            pref_match = strcasecmp (spot_pref, adif_pref) == 0;
-        }
-        if (       (!chk_pref || pref_match)
-                && (!chk_dxcc || spot.tx_dxcc == adif_spot.tx_dxcc)
-                && (!chk_band || spot_band == findHamBand (adif_spot.kHz))
-                && (!chk_grid || strncasecmp (spot.tx_grid, adif_spot.tx_grid, 4) == 0))
-            return (true);
-    }
-
-    return (false);
+    // no tests match any spot at all
+    int mask = (chk_dxcc ? ADIFK_DXCC : 0) | (chk_grid ? ADIFK_GRID : 0)
+                        | (chk_pref ? ADIFK_PREF : 0) | (chk_band ? ADIFK_BAND : 0);
+    if (!mask)
+        return (adif_ss.n_data > 0);
+
+    // look up in the set for this combination, building if first time
+    ADIFKeySet &ks = adif_keysets[mask];
+    if (!ks.wanted)
+        buildADIFKeySet (mask);
+    if (ks.n_used == 0)
+        return (false);
+    ADIFKey k;
+    makeADIFKey (spot, mask, k);
+    return (findADIFKeySlot (ks, k, hashADIFKey (k)).hash != 0);
 }
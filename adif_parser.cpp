@@ -642,15 +642,13 @@ static bool parseADIF (char c, ADIFParser &adif, DXSpot &spot)
     return (finished);
 }
 
-/* general purpose ADIF parser from a GenReader.
- * add malloced DXSpots to spots, add to prefix table and return count.
- * also:
- *   we pass back count of any broken spots or did not qualify WLID_ADIF if used.
- *   use_wl determines whether spots are checked against WLID_ADIF.
- * N.B. must call with spots = NULL and caller is responsible to free (spots).
- * N.B. caller must close gr
+/* ADIF parser from a GenReader shared by readADIFFile() and parseADIFFile().
+ * add malloced DXSpots to spots and return count, pass back count of broken spots.
+ * use_wl determines whether spots are checked against WLID_ADIF.
+ * on_loop rebuilds the DXPeds worked list and keeps the clocks going, else we touch nothing shared so
+ * may run on a pool task.
  */
-int readADIFFile (GenReader &gr, DXSpot *&spots, bool use_wl, int &n_bad)
+static int crackADIFFile (GenReader &gr, DXSpot *&spots, bool use_wl, bool on_loop, int &n_bad)
 {
     // init counts, timer
     int n_read = 0;
@@ -662,50 +660,55 @@ int readADIFFile (GenReader &gr, DXSpot *&spots, bool use_wl, int &n_bad)
     gettimeofday (&tv0, NULL);
 
     // reset dxpeds worked list
-    resetDXPedsWorked();
+    if (on_loop)
+        resetDXPedsWorked();
 
     // crack file
     DXSpot spot;
     ADIFParser adif;
     adif.ps = ADIFPS_STARTFILE;
-    char c;
+    const char *span;
+    int span_len;
     if (debugLevel (DEBUG_ADIF, 1))
         Serial.printf ("ADIF: WL DE_Call   Grid   DXCC  DX_Call   Grid   DXCC    Lat   Long Mode      kHz\n");
-    while (gr.getChar(&c)) {
-        if (parseADIF (c, adif, spot)) {
-            // spot parsing complete
-            if (spotLooksGood (adif, spot)) {
-                // at this point all spot fields are complete
-                n_read++;
-
-                // add to the DXPeds indices regardless of watch list
-                addDXPedsWorked (spot);
-
-                // add to list if qualifies watch list
-                bool wl_ok = !use_wl || checkWatchListSpot(WLID_ADIF, spot) != WLS_NO;
-                if (wl_ok) {
-                    // add to *spots_p
-                    if (n_good+1 > n_malloc) {
-                        spots = (DXSpot *) realloc (spots, (n_malloc += malloc_more) * sizeof(DXSpot));
-                        if (!spots)
-                            fatalError ("No memory for %d ADIF Spots", n_malloc);
+    while ((span_len = gr.getSpan (&span)) > 0) {
+        for (const char *span_end = span + span_len; span < span_end; span++) {
+            if (parseADIF (*span, adif, spot)) {
+                // spot parsing complete
+                if (spotLooksGood (adif, spot)) {
+                    // at this point all spot fields are complete
+                    n_read++;
+
+                    // add to the DXPeds indices regardless of watch list
+                    if (on_loop)
+                        addDXPedsWorked (spot);
+
+                    // add to list if qualifies watch list
+                    bool wl_ok = !use_wl || checkWatchListSpot(WLID_ADIF, spot) != WLS_NO;
+                    if (wl_ok) {
+                        // add to *spots_p
+                        if (n_good+1 > n_malloc) {
+                            spots = (DXSpot *) realloc (spots, (n_malloc += malloc_more) * sizeof(DXSpot));
+                            if (!spots)
+                                fatalError ("No memory for %d ADIF Spots", n_malloc);
+                        }
+                        spots[n_good++] = spot;
                     }
-                    spots[n_good++] = spot;
-                }
-                // nice logging if enabled
-                if ((wl_ok && debugLevel (DEBUG_ADIF, 1)) || (!wl_ok && debugLevel (DEBUG_ADIF, 2))) {
-                    Serial.printf("ADIF: %s %-9.9s %-6.6s %4d  %-9.9s %-6.6s %4d  %5.1f %6.1f %4.4s %8.1f\n", 
-                        wl_ok ? "OK" : "NO",
-                        spot.rx_call, spot.rx_grid, spot.rx_dxcc,
-                        spot.tx_call, spot.tx_grid, spot.tx_dxcc,
-                        spot.tx_ll.lat_d, spot.tx_ll.lng_d, spot.mode, spot.kHz);
-                }
-            } else
-                n_bad++;        // count actual broken spots, not ones that just aren't selected by WL
+                    // nice logging if enabled
+                    if ((wl_ok && debugLevel (DEBUG_ADIF, 1)) || (!wl_ok && debugLevel (DEBUG_ADIF, 2))) {
+                        Serial.printf("ADIF: %s %-9.9s %-6.6s %4d  %-9.9s %-6.6s %4d  %5.1f %6.1f %4.4s %8.1f\n", 
+                            wl_ok ? "OK" : "NO",
+                            spot.rx_call, spot.rx_grid, spot.rx_dxcc,
+                            spot.tx_call, spot.tx_grid, spot.tx_dxcc,
+                            spot.tx_ll.lat_d, spot.tx_ll.lng_d, spot.mode, spot.kHz);
+                    }
+                } else
+                    n_bad++;        // count actual broken spots, not ones that just aren't selected by WL
 
-            // look alive
-            if (((n_good + n_bad)%100) == 0)
-                updateClocks(false);
+                // look alive
+                if (on_loop && ((n_good + n_bad)%100) == 0)
+                    updateClocks(false);
+            }
         }
     }
 
@@ -722,3 +725,26 @@ int readADIFFile (GenReader &gr, DXSpot *&spots, bool use_wl, int &n_bad)
 
     return (n_good);
 }
+
+/* general purpose ADIF parser from a GenReader.
+ * add malloced DXSpots to spots, add to prefix table and return count.
+ * also:
+ *   we pass back count of any broken spots or did not qualify WLID_ADIF if used.
+ *   use_wl determines whether spots are checked against WLID_ADIF.
+ * N.B. must call with spots = NULL and caller is responsible to free (spots).
+ * N.B. caller must close gr
+ */
+int readADIFFile (GenReader &gr, DXSpot *&spots, bool use_wl, int &n_bad)
+{
+    return (crackADIFFile (gr, spots, use_wl, true, n_bad));
+}
+
+/* same as readADIFFile() but safe to call from a pool task: every good spot is returned, the caller
+ * must do any watch list checks and addDXPedsWorked() back on the loop() thread.
+ * N.B. must call with spots = NULL and caller is responsible to free (spots).
+ * N.B. caller must close gr
+ */
+int parseADIFFile (GenReader &gr, DXSpot *&spots, int &n_bad)
+{
+    return (crackADIFFile (gr, spots, false, false, n_bad));
+}
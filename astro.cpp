@@ -868,15 +868,131 @@ void getSolarCir (time_t t0, const LatLong &ll, AstroCir &cir)
 
 
 
+/* rise/set solutions are memoized two ways:
+ *   solar events from the start of whole UTC days, as used by the grayline plot, are kept in a table
+ *     for each year at each of a few places, so changing DE or DX just takes over another table;
+ *   all others are kept in a small ring keyed by place and minute so all the panes showing the same
+ *     events share one solution. t0 is reduced to the start of its minute which is well within the
+ *     MAX_DT convergence of riseset() anyway.
+ * N.B. like getLunarCir() these are not thread safe.
+ */
+
+typedef void (*CirFunc)(time_t t0, const LatLong &ll, AstroCir &cir);
+
+#define RS_DAYSECS      86400                   // seconds per day
+#define RS_YEARDAYS     366                     // max days per year
+#define RS_NYEARS       4                       // year tables kept, at least DE and DX
+#define RS_NRECENT      8                       // recent solutions kept
+
+typedef struct {
+    float lat_d, lng_d;                         // location
+    time_t yr0;                                 // 00:00 UTC Jan 1, 0 if unused
+    time_t riset[RS_YEARDAYS];                  // rise each day, if have
+    time_t sett[RS_YEARDAYS];                   // set each day, if have
+    bool have[RS_YEARDAYS];                     // whether day has been solved
+    unsigned long used;                         // rs_uses when last used, for LRU
+} RSYear;
+
+typedef struct {
+    CirFunc cir_func;                           // sun or moon, NULL if unused
+    float lat_d, lng_d;                         // location
+    time_t t0;                                  // start of minute
+    time_t t_solved;                            // time within that minute actually solved
+    time_t riset, sett;                         // solution
+} RSRecent;
+
+static RSYear rs_years[RS_NYEARS];
+static RSRecent rs_recent[RS_NRECENT];
+static int rs_recent_next;                      // next rs_recent to replace
+static unsigned long rs_uses;                   // rs_years use counter
+
+/* find solar rise/set for t0, which must be 00:00 UTC, via rs_years
+ */
+static void yearSolarRS (const time_t t0, const LatLong &ll, time_t *riset, time_t *sett)
+{
+        struct tm tm;
+        gmtime_r (&t0, &tm);
+        const int doy = tm.tm_yday;
+        const time_t yr0 = t0 - doy*RS_DAYSECS;
+
+        // find table for this place and year, else reuse the least recently used
+        RSYear *ryp = &rs_years[0];
+        for (int i = 0; i < RS_NYEARS; i++) {
+            RSYear &ry = rs_years[i];
+            if (ry.yr0 == yr0 && ry.lat_d == ll.lat_d && ry.lng_d == ll.lng_d) {
+                ryp = &ry;
+                break;
+            }
+            if (ry.used < ryp->used)
+                ryp = &ry;
+        }
+        if (ryp->yr0 != yr0 || ryp->lat_d != ll.lat_d || ryp->lng_d != ll.lng_d) {
+            memset (ryp->have, 0, sizeof(ryp->have));
+            ryp->yr0 = yr0;
+            ryp->lat_d = ll.lat_d;
+            ryp->lng_d = ll.lng_d;
+        }
+        ryp->used = ++rs_uses;
+
+        // solve this day if new
+        if (!ryp->have[doy]) {
+            riseset (t0, ll, getSolarCir, &ryp->riset[doy], &ryp->sett[doy]);
+            ryp->have[doy] = true;
+        }
+
+        *riset = ryp->riset[doy];
+        *sett = ryp->sett[doy];
+}
+
+/* find rise/set for t0 via rs_recent.
+ * an entry solved earlier in the same minute is reused only while both its events are still later than
+ * t0, else solve again from t0 so an event that has just passed is not reported in place of the next one.
+ */
+static void recentRS (const time_t t0, const LatLong &ll, CirFunc cir_func, time_t *riset, time_t *sett)
+{
+        const time_t t0m = t0 - t0 % 60;
+
+        RSRecent *rrp = NULL;
+        for (int i = 0; i < RS_NRECENT; i++) {
+            RSRecent &rr = rs_recent[i];
+            if (rr.cir_func == cir_func && rr.t0 == t0m && rr.lat_d == ll.lat_d && rr.lng_d == ll.lng_d) {
+                if (rr.t_solved == t0 || (rr.riset >= t0 && rr.sett >= t0)) {
+                    *riset = rr.riset;
+                    *sett = rr.sett;
+                    return;
+                }
+                rrp = &rr;                      // stale, solve again in place
+                break;
+            }
+        }
+
+        if (!rrp) {
+            rrp = &rs_recent[rs_recent_next];
+            rs_recent_next = (rs_recent_next + 1) % RS_NRECENT;
+        }
+        RSRecent &rr = *rrp;
+        riseset (t0, ll, cir_func, &rr.riset, &rr.sett);
+        rr.cir_func = cir_func;
+        rr.t0 = t0m;
+        rr.t_solved = t0;
+        rr.lat_d = ll.lat_d;
+        rr.lng_d = ll.lng_d;
+        *riset = rr.riset;
+        *sett = rr.sett;
+}
+
 void getSolarRS (const time_t t0, const LatLong &ll, time_t *riset, time_t *sett)
 {
-        riseset (t0, ll, getSolarCir, riset, sett);
+        if (t0 % RS_DAYSECS == 0)
+            yearSolarRS (t0, ll, riset, sett);
+        else
+            recentRS (t0, ll, getSolarCir, riset, sett);
 }
 
 
 void getLunarRS (const time_t t0, const LatLong &ll, time_t *riset, time_t *sett)
 {
-        riseset (t0, ll, getLunarCir, riset, sett);
+        recentRS (t0, ll, getLunarCir, riset, sett);
 }
 
 
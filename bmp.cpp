@@ -4,7 +4,20 @@
 #include "HamClock.h"
 
 
-static bool we_are_big_endian;                  // set if arch is BE
+/* return whether we are big-endian architecture
+ */
+static inline bool determineBigEndian (void)
+{
+    union {
+        uint16_t e2;
+        uint8_t a[2];
+    } e2;
+
+    e2.e2 = 1;
+    return (e2.a[1] == 1);
+}
+
+static const bool we_are_big_endian = determineBigEndian();     // set once, tasks may read in parallel
 
 
 /* return value of four bytes starting at buf as 32 bit little endian number.
@@ -127,22 +140,6 @@ static inline bool skipGRToPos (GenReader &gr, int &byte_os, int to)
     return (true);
 }
 
-/* return whether we are big-endian architecture
- */
-static inline bool determineBigEndian (void)
-{
-    union {
-        uint16_t e2;
-        uint8_t a[2];
-    } e2;
-
-    e2.e2 = 1;
-    bool be = e2.a[1] == 1;
-    if (debugLevel (DEBUG_BMP, 2))
-        Serial.printf ("BMP: we are %s-endian\n", be ? "big" : "lil");
-    return (be);
-}
-
 
 /* read the next 24 bpp pixel from gr as RGB565 pixel
  */
@@ -251,146 +248,147 @@ Message &ynot)
     return (true);
 }
 
-/* copy img_565 with dimensions img_w/h to box_565 with the given box dimensions so as to
- * expand the image to exactly fill the box.
- * all pixelsa are RGB565 uint16_t
+/* fill map[] for each of n_box box pixels with the image pixel that scales n_img image pixels evenly
+ * across n_vis box pixels centered in the box, else -1 for the black margins.
  */
-static void fillU16Image (const uint16_t *img_565, int img_w, int img_h, uint16_t *box_565, const SBox &box)
+static void scaleFitMap (int *map, int n_box, int n_vis, int n_img)
 {
-    for (int box_dy = 0; box_dy < box.h; box_dy++) {
-        int img_y = box_dy * img_h / box.h;
-        for (int box_dx = 0; box_dx < box.w; box_dx++) {
-            int img_x = box_dx * img_w / box.w;
-            box_565[(box.y+box_dy)*box.w + (box.x+box_dx)] = img_565[img_y*img_w + img_x];
-        }
-    }
+    int gap = (n_box - n_vis)/2;                                // margin each side
+    for (int b = 0; b < n_box; b++)
+        map[b] = b < gap || b >= gap + n_vis ? -1 : (b - gap) * n_img / n_vis;
 }
 
-
-
-/* copy img_565 with dimensions img_w/h to box_565 with the given box dimensions so as to
- * resize the image AMAP while maintaining its aspect ratio.
- * all pixelsa are RGB565 uint16_t
+/* fill map[] for each of n_box box pixels with the image pixel that centers n_img image pixels within
+ * the box without scaling, else -1 where the image does not reach.
  */
-static void resizeU16Image (const uint16_t *img_565, int img_w, int img_h, uint16_t *box_565, const SBox &box)
+static void cropFitMap (int *map, int n_box, int n_img)
 {
-    // time
-    struct timeval tv0;
-    if (debugLevel(DEBUG_BMP, 1))
-        gettimeofday (&tv0, NULL);
-
-    // black
-    int n_box_bytes = (int)box.w * (int)box.h * sizeof(uint16_t);
-    memset (box_565, 0, n_box_bytes);
-
-    if (img_w > img_h * box.w / box.h) {
-        // image aspect is wider than box aspect: full width and center vertically
-        if (debugLevel (DEBUG_BMP, 1))
-            Serial.printf ("BMP: img wider aspect: img %d x %d box %d x %d\n", img_w, img_h, box.w, box.h);
-        int box_v_h = box.w * img_h / img_w;                    // visible height
-        int box_v_gap = (box.h - box_v_h)/2;                    // vertical gap on top and bottom
-        for (int box_dy = 0; box_dy < box_v_h; box_dy++) {      // scan y through visible portion of box
-            int img_y = box_dy * img_h / box_v_h;               // closest image y coord
-            for (int box_dx = 0; box_dx < box.w; box_dx++) {    // scan x full width
-                int img_x = box_dx * img_w / box.w;             // closest image x coord
-                box_565[(box_dy+box_v_gap)*box.w + box_dx] = img_565[img_y*img_w + img_x];
-            }
-        }
+    int off = (n_img - n_box)/2;                                // < 0 if image is smaller
+    for (int b = 0; b < n_box; b++) {
+        int i = b + off;
+        map[b] = i < 0 || i >= n_img ? -1 : i;
+    }
+}
 
-    } else if (img_h > img_w * box.h / box.w) {
-        // image aspect is taller than box aspect: full height and center horizontally
-        if (debugLevel (DEBUG_BMP, 1))
-            Serial.printf ("BMP: img taller aspect: img %d x %d box %d x %d\n", img_w, img_h, box.w, box.h);
-        int box_v_w = box.h * img_w / img_h;                    // visible width
-        int box_h_gap = (box.w - box_v_w)/2;                    // horizontal gap on each side
-        for (int box_dy = 0; box_dy < box.h; box_dy++) {        // scan y full height
-            int img_y = box_dy * img_h / box.h;                 // closest image y coord
-            for (int box_dx = 0; box_dx < box_v_w; box_dx++) {  // scan across vis portion
-                int img_x = box_dx * img_w / box_v_w;           // closest image x coord
-                box_565[box_dy*box.w + (box_dx+box_h_gap)] = img_565[img_y*img_w + img_x];
-            }
+/* one band of box rows for fitBandTask()
+ */
+typedef struct {
+    const uint16_t *img_565;                                    // image pixels
+    int img_w;                                                  // image width
+    uint16_t *box_565;                                          // box pixels
+    int box_w;                                                  // box width
+    const int *xmap, *ymap;                                     // box x,y to image x,y or -1 for black
+    int y0, y1;                                                 // box rows [y0,y1) in this band
+} FitBand;
+
+/* pool task to fill one band of box rows according to its maps.
+ */
+static void fitBandTask (void *arg)
+{
+    FitBand *fb = (FitBand *) arg;
+
+    for (int box_y = fb->y0; box_y < fb->y1; box_y++) {
+        uint16_t *box_row = &fb->box_565[box_y*fb->box_w];
+        int img_y = fb->ymap[box_y];
+        if (img_y < 0) {
+            memset (box_row, 0, fb->box_w * sizeof(uint16_t));
+            continue;
         }
-
-    } else {
-        // aspect ratios match: no gaps
-        if (debugLevel (DEBUG_BMP, 1))
-            Serial.printf ("BMP: equal aspect: img %d x %d box %d x %d\n", img_w, img_h, box.w, box.h);
-        for (int box_dy = 0; box_dy < box.h; box_dy++) {        // scan y full height
-            int img_y = box_dy * img_h / box.h;                 // closest image y coord
-            for (int box_dx = 0; box_dx < box.w; box_dx++) {    // scan x full width
-                int img_x = box_dx * img_w / box.w;             // closest image x coord
-                box_565[box_dy*box.w + box_dx] = img_565[img_y*img_w + img_x];
-            }
+        const uint16_t *img_row = &fb->img_565[img_y*fb->img_w];
+        for (int box_x = 0; box_x < fb->box_w; box_x++) {
+            int img_x = fb->xmap[box_x];
+            box_row[box_x] = img_x < 0 ? 0 : img_row[img_x];
         }
     }
-
-    if (debugLevel(DEBUG_BMP, 1)) {
-        struct timeval tv1;
-        gettimeofday (&tv1, NULL);
-        Serial.printf ("BMP: resize time %ld us\n", (long)TVDELUS(tv0,tv1));
-    }
 }
 
-/* copy img_565 with dimensions img_w/h to box_565 with the given box dimensions so as to
- * crop and center the image into the box without changing its pixel density.
- * all pixelsa are RGB565 uint16_t
+/* copy img_565 with dimensions img_w/h to box_565 with the given box dimensions using the given fit:
+ *   FIT_CROP:   center the image in the box without changing its pixel density, black if smaller.
+ *   FIT_RESIZE: resize the image AMAP while maintaining its aspect ratio, centered with black margins.
+ *   FIT_FILL:   expand the image to exactly fill the box.
+ * each method just decides which image pixel lands on each box row and column, then bands of rows are
+ * filled in parallel on the task pool.
+ * all pixels are RGB565 uint16_t
  */
-static void cropU16Image (const uint16_t *img_565, int img_w, int img_h, uint16_t *box_565, const SBox &box)
+static void fitU16Image (const uint16_t *img_565, int img_w, int img_h, uint16_t *box_565, const SBox &box,
+ImageRefit fit)
 {
     // time
     struct timeval tv0;
     if (debugLevel(DEBUG_BMP, 1))
         gettimeofday (&tv0, NULL);
 
-    int n_box_bytes = (int)box.w * (int)box.h * sizeof(uint16_t);
-
-    if (img_w == box.w && img_h == box.h) {
-        // exact size match
-        memcpy (box_565, img_565, n_box_bytes);
-
-    } else if (img_w > box.w && img_h > box.h) {
-        // image is larger than box: use center portion
-        int img_lgap = (img_w - box.w)/2;                       // image left gap
-        int img_tgap = (img_h - box.h)/2;                       // image top gap
-        for (int dy = 0; dy < box.h; dy++)                      // box dy
-            for (int dx = 0; dx < box.w; dx++)                  // box dx
-                box_565[dy*box.w + dx] = img_565[(img_tgap+dy)*img_w + (img_lgap+dx)];
-
-    } else if (img_w < box.w && img_h < box.h) {
-        // image is smaller than box: center within box
-        memset (box_565, 0, n_box_bytes);                       // init box_565 black
-        int box_lgap = (box.w - img_w)/2;                       // box left gap
-        int box_tgap = (box.h - img_h)/2;                       // box top gap
-        for (int dy = 0; dy < img_h; dy++)                      // image dy
-            for (int dx = 0; dx < img_w; dx++)                  // image dx
-                box_565[(box_tgap+dy)*box.w + (box_lgap+dx)] = img_565[dy*img_w + dx];
-
-    } else if (img_w < box.w && img_h > box.h) {
-        // image is narrower but taller than box: show full img width centered horizontally
-        memset (box_565, 0, n_box_bytes);                       // init box_565 black
-        int box_lgap = (box.w - img_w)/2;                       // box left gap
-        int img_tgap = (img_h - box.h)/2;                       // image top gap
-        for (int dy = 0; dy < box.h; dy++)                      // box dy
-            for (int dx = 0; dx < img_w; dx++)                  // image dx
-                box_565[dy*box.w + (box_lgap+dx)] = img_565[(img_tgap+dy)*img_w + dx];
-
-    } else if (img_w > box.w && img_h < box.h) {
-        // image is wider but shorter than box: show full img height centered vertically
-        memset (box_565, 0, n_box_bytes);                       // init box_565 black
-        int box_tgap = (box.h - img_h)/2;                       // box top gap
-        int img_lgap = (img_w - box.w)/2;                       // image left gap
-        for (int dy = 0; dy < img_h; dy++)                      // image dy
-            for (int dx = 0; dx < box.w; dx++)                  // box dx
-                box_565[(box_tgap+dy)*box.w + dx] = img_565[dy*img_w + (img_lgap+dx)];
+    // decide image column for each box column and image row for each box row
+    StackMalloc xmap_mem(box.w * sizeof(int));
+    StackMalloc ymap_mem(box.h * sizeof(int));
+    int *xmap = (int *) xmap_mem.getMem();
+    int *ymap = (int *) ymap_mem.getMem();
+    if (!xmap || !ymap)
+        fatalError ("no mem for %d x %d BMP fit maps", box.w, box.h);
 
-    } else {
-        fatalError ("cropU16Image bad overlap img %d x %d box %d x %d", img_w, img_h, box.w, box.h);
+    switch (fit) {
+    case FIT_CROP:
+        cropFitMap (xmap, box.w, img_w);
+        cropFitMap (ymap, box.h, img_h);
+        break;
+
+    case FIT_RESIZE:
+        if (img_w > img_h * box.w / box.h) {
+            // image aspect is wider than box aspect: full width and center vertically
+            if (debugLevel (DEBUG_BMP, 1))
+                Serial.printf ("BMP: img wider aspect: img %d x %d box %d x %d\n", img_w, img_h, box.w, box.h);
+            scaleFitMap (xmap, box.w, box.w, img_w);
+            scaleFitMap (ymap, box.h, box.w * img_h / img_w, img_h);
+        } else if (img_h > img_w * box.h / box.w) {
+            // image aspect is taller than box aspect: full height and center horizontally
+            if (debugLevel (DEBUG_BMP, 1))
+                Serial.printf ("BMP: img taller aspect: img %d x %d box %d x %d\n", img_w, img_h, box.w, box.h);
+            scaleFitMap (xmap, box.w, box.h * img_w / img_h, img_w);
+            scaleFitMap (ymap, box.h, box.h, img_h);
+        } else {
+            // aspect ratios match: no gaps
+            if (debugLevel (DEBUG_BMP, 1))
+                Serial.printf ("BMP: equal aspect: img %d x %d box %d x %d\n", img_w, img_h, box.w, box.h);
+            scaleFitMap (xmap, box.w, box.w, img_w);
+            scaleFitMap (ymap, box.h, box.h, img_h);
+        }
+        break;
+
+    case FIT_FILL:
+        scaleFitMap (xmap, box.w, box.w, img_w);
+        scaleFitMap (ymap, box.h, box.h, img_h);
+        break;
+
+    default:
+        fatalError ("readBMPImage bogus fit %d", (int)fit);
+        break;
     }
 
+    // fill bands of rows in parallel, we help while waiting
+    #define MAX_FIT_BANDS 8
+    int n_bands = CLAMPF (taskPoolSize(), 1, MAX_FIT_BANDS);
+    FitBand bands[MAX_FIT_BANDS];
+    TaskFuture futures[MAX_FIT_BANDS];
+    for (int i = 0; i < n_bands; i++) {
+        FitBand &fb = bands[i];
+        fb.img_565 = img_565;
+        fb.img_w = img_w;
+        fb.box_565 = box_565;
+        fb.box_w = box.w;
+        fb.xmap = xmap;
+        fb.ymap = ymap;
+        fb.y0 = i * box.h / n_bands;
+        fb.y1 = (i+1) * box.h / n_bands;
+        futures[i] = startTask (fitBandTask, &fb);
+    }
+    for (int i = 0; i < n_bands; i++)
+        waitTask (futures[i]);
+
     if (debugLevel(DEBUG_BMP, 1)) {
         struct timeval tv1;
         gettimeofday (&tv1, NULL);
-        Serial.printf ("BMP: crop time %ld us\n", (long)TVDELUS(tv0,tv1));
+        Serial.printf ("BMP: fit %d x %d to %d x %d in %d bands time %ld us\n", img_w, img_h, box.w, box.h,
+                                n_bands, (long)TVDELUS(tv0,tv1));
     }
 }
 
@@ -403,8 +401,8 @@ static void cropU16Image (const uint16_t *img_565, int img_w, int img_h, uint16_
  */
 bool readBMPHeader (GenReader &gr, int &img_w, int &img_h, int &img_bpp, int &img_pad, Message &ynot)
 {
-    // set endian
-    we_are_big_endian = determineBigEndian();
+    if (debugLevel (DEBUG_BMP, 2))
+        Serial.printf ("BMP: we are %s-endian\n", we_are_big_endian ? "big" : "lil");
 
     // size of initial header common to all formats and size of original BMP subsequent header
     #define COMMONHEADER        14
@@ -544,9 +542,6 @@ bool readBMPHeader (GenReader &gr, int &img_w, int &img_h, int &img_bpp, int &im
  */
 bool readBMPImage (GenReader &gr, const SBox &box, uint16_t *&box_565, ImageRefit fit, Message &ynot)
 {
-    // set endian
-    we_are_big_endian = determineBigEndian();
-
     // get size info and position gr at first pixel
     int img_w, img_h, img_bpp, img_pad;
     if (!readBMPHeader (gr, img_w, img_h, img_bpp, img_pad, ynot))
@@ -588,20 +583,7 @@ bool readBMPImage (GenReader &gr, const SBox &box, uint16_t *&box_565, ImageRefi
     }
 
     // fit img to box using desired method
-    switch (fit) {
-    case FIT_CROP:
-        cropU16Image (img_565, img_w, abs(img_h), box_565, box);
-        break;
-    case FIT_RESIZE:
-        resizeU16Image (img_565, img_w, abs(img_h), box_565, box);
-        break;
-    case FIT_FILL:
-        fillU16Image (img_565, img_w, abs(img_h), box_565, box);
-        break;
-    default:
-        fatalError ("readBMPImage bogus fit %d", (int)fit);
-        break;
-    }
+    fitU16Image (img_565, img_w, abs(img_h), box_565, box, fit);
 
     // ok!
     return (true);
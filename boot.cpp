@@ -0,0 +1,124 @@
+/* startup trace and warm-up.
+ *
+ * setup() and initSys() call bootPhase() as each stage of startup begins, so each phase runs until the next
+ * one starts. The trace ends at the first loop() after which every pane has drawn once, which is as close
+ * as we can tell to the first complete screen, and is reported by get_sys.txt.
+ *
+ * The warm-up starts the downloads the first screen will need all at once in the background, so they
+ * proceed concurrently in the fetch engine and map prefetch task while the rest of startup carries on,
+ * rather than each pane waiting its turn on the network when it is first drawn. startWarmUp() runs as
+ * soon as time is known; startPaneWarmUp() runs once the panes and DX location have been read from NV.
+ */
+
+#include "HamClock.h"
+
+
+#define MAX_BOOT_PHASES 20                      // more than enough
+
+
+static BootPhase boot_phases[MAX_BOOT_PHASES];  // each phase in order
+static int n_boot_phases;                       // n used in boot_phases[]
+static uint32_t phase_t0;                       // millis() when last phase started
+static uint32_t boot_ms;                        // millis() from first phase to first complete screen
+static bool boot_done;                          // set when first complete screen is up
+
+
+/* finish the current phase, if any.
+ */
+static void endPhase (uint32_t t)
+{
+    if (n_boot_phases > 0) {
+        BootPhase &bp = boot_phases[n_boot_phases-1];
+        bp.ms = t - phase_t0;
+        Serial.printf ("Boot: %s %u ms\n", bp.name, bp.ms);
+    }
+}
+
+/* finish the current phase, if any, then start the named one.
+ * N.B. name must be static
+ */
+void bootPhase (const char *name)
+{
+    if (boot_done)
+        return;
+
+    uint32_t t = millis();
+    endPhase (t);
+
+    // just let the last phase keep running if full
+    if (n_boot_phases < MAX_BOOT_PHASES) {
+        boot_phases[n_boot_phases].name = name;
+        boot_phases[n_boot_phases].ms = 0;
+        n_boot_phases++;
+        phase_t0 = t;
+    }
+}
+
+/* end the trace once every pane in use has drawn at least once.
+ * N.B. can not use next_update[] for this because some panes poll with it always 0.
+ * call after updateWiFi() each loop.
+ */
+void checkBootDone (void)
+{
+    if (boot_done)
+        return;
+
+    for (int i = PANE_0; i < PANE_N; i++)
+        if (plot_ch[i] != PLOT_CH_NONE && !pane_drawn[i])
+            return;
+
+    endPhase (millis());
+    boot_done = true;
+    boot_ms = 0;
+    for (int i = 0; i < n_boot_phases; i++)
+        boot_ms += boot_phases[i].ms;
+    Serial.printf ("Boot: first complete screen after %u ms\n", boot_ms);
+}
+
+/* pass back the list of boot phases and return how many.
+ * total_ms is the total so far; done is set once the first complete screen is up.
+ */
+int getBootTrace (const BootPhase **phases, uint32_t &total_ms, bool &done)
+{
+    // update phase still running
+    if (!boot_done && n_boot_phases > 0)
+        boot_phases[n_boot_phases-1].ms = millis() - phase_t0;
+
+    if (boot_done)
+        total_ms = boot_ms;
+    else {
+        total_ms = 0;
+        for (int i = 0; i < n_boot_phases; i++)
+            total_ms += boot_phases[i].ms;
+    }
+
+    done = boot_done;
+    *phases = boot_phases;
+    return (n_boot_phases);
+}
+
+/* start background downloads of the datasets that do not depend on pane choices.
+ * N.B. call after time and DE are known
+ */
+void startWarmUp (void)
+{
+    Serial.println ("Boot: starting warm-up");
+
+    prefetchCoreMap();
+    prefetchCtyFile();
+    prefetchCitiesFile();
+    (void) checkForNewSpaceWx();
+}
+
+/* start background downloads of the datasets only needed by panes in use.
+ * N.B. call after panes and DX have been read from NV
+ */
+void startPaneWarmUp (void)
+{
+    if (findPaneForChoice (PLOT_CH_BC) != PANE_NONE)
+        prefetchBandConditions();
+    if (findPaneForChoice (PLOT_CH_CONTESTS) != PANE_NONE)
+        prefetchContestsFile();
+    if (findPaneForChoice (PLOT_CH_DXPEDS) != PANE_NONE)
+        prefetchDXPedsFile();
+}
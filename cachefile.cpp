@@ -53,37 +53,43 @@ static bool fileAgeOk (const char *path, int max_age)
 }
 
 
-/* open the given local file or download fresh if too old or too small.
- * if download fails retain fn as long as it's large enough, tolerating too old.
+// downloads started ahead of need by prefetchCachedFile()
+typedef struct {
+    char fn[100];                               // local cache file name
+    char url[200];                              // page being fetched, just for messages
+    int min_size;                               // min acceptable size
+    int fetch_id;                               // fetch.cpp id
+} CachePrefetch;
+static CachePrefetch *cache_prefetch;           // malloced list
+static int n_cache_prefetch;                    // n in list
+
+
+/* return whether the given local file exists and is neither too small nor too old.
  */
-FILE *openCachedFile (const char *fn, const char *url, int max_age, int min_size)
+static bool cachedFileOk (const char *fn_path, int max_age, int min_size)
 {
-    // try local first
-    char fn_path[1000];
-    snprintf (fn_path, sizeof(fn_path), "%s/%s", our_dir.c_str(), fn);
-    FILE *fp = fopen (fn_path, "r");
-    if (fp) {
-        // file exists, now check the age and size
-        if (fileSizeOk (fn_path, min_size) && fileAgeOk (fn_path, max_age)) {
-            // still good!
-            return (fp);
-        } else {
-            // open again after download
-            fclose (fp);
-            Serial.printf ("Cache: %s not suitable -- downloading %s\n", fn, url);
-        }
-    } else
-        Serial.printf ("Cache: %s not found -- downloading %s\n", fn, url);
+    return (access (fn_path, R_OK) == 0 && fileSizeOk (fn_path, min_size) && fileAgeOk (fn_path, max_age));
+}
 
-    // download
-    WiFiClient cache_client;
-    Serial.println (url);
-    if (cache_client.connect(backend_host, backend_port)) {
+/* remove cache_prefetch[i] and return its fetch id.
+ */
+static int removePrefetch (int i)
+{
+    int fetch_id = cache_prefetch[i].fetch_id;
+    cache_prefetch[i] = cache_prefetch[--n_cache_prefetch];
+    return (fetch_id);
+}
 
-        updateClocks(false);
+/* save the HTTP response in the given fetch fd as local file fn if it looks ok, fd is always closed.
+ * any existing fn is left intact unless the download is good.
+ */
+static void saveCachedFile (const char *fn, const char *url, int fetch_fd, int min_size)
+{
+    char fn_path[1000];
+    snprintf (fn_path, sizeof(fn_path), "%s/%s", our_dir.c_str(), fn);
 
-        // query web page
-        httpHCGET (cache_client, backend_host, url);
+    WiFiClient cache_client (fetch_fd);
+    if (cache_client) {
 
         // skip header
         if (!httpSkipHeader (cache_client)) {
@@ -94,7 +100,7 @@ FILE *openCachedFile (const char *fn, const char *url, int max_age, int min_size
         // start new temp file near first so it can be renamed
         char tmp_path[1000];
         snprintf (tmp_path, sizeof(tmp_path), "%s/x.%s", our_dir.c_str(), fn);
-        fp = fopen (tmp_path, "w");
+        FILE *fp = fopen (tmp_path, "w");
         if (!fp) {
             Serial.printf ("Cache: %s: x.%s\n", fn, strerror(errno));
             goto out;
@@ -132,8 +138,50 @@ FILE *openCachedFile (const char *fn, const char *url, int max_age, int min_size
 
   out:
 
-    // insure socket is closed
+    // insure response is closed
     cache_client.stop();
+}
+
+
+/* open the given local file or download fresh if too old or too small.
+ * if download fails retain fn as long as it's large enough, tolerating too old.
+ * N.B. call only from main thread
+ */
+FILE *openCachedFile (const char *fn, const char *url, int max_age, int min_size)
+{
+    // try local first
+    char fn_path[1000];
+    snprintf (fn_path, sizeof(fn_path), "%s/%s", our_dir.c_str(), fn);
+    FILE *fp = fopen (fn_path, "r");
+    if (fp) {
+        // file exists, now check the age and size
+        if (fileSizeOk (fn_path, min_size) && fileAgeOk (fn_path, max_age)) {
+            // still good!
+            return (fp);
+        } else {
+            // open again after download
+            fclose (fp);
+            Serial.printf ("Cache: %s not suitable -- downloading %s\n", fn, url);
+        }
+    } else
+        Serial.printf ("Cache: %s not found -- downloading %s\n", fn, url);
+
+    // join a prefetch already under way, else download in the background, keeping the clocks running meanwhile
+    int fetch_id = 0;
+    for (int i = 0; i < n_cache_prefetch; i++) {
+        if (strcmp (cache_prefetch[i].fn, fn) == 0) {
+            fetch_id = removePrefetch (i);
+            break;
+        }
+    }
+    if (!fetch_id) {
+        Serial.println (url);
+        fetch_id = startHCFetch (url);
+    }
+    int fetch_fd = -1;
+    if (fetch_id)
+        (void) waitFetch (fetch_id, &fetch_fd);
+    saveCachedFile (fn, url, fetch_fd, min_size);
 
     // open again but now tolerate too old if must
     fp = fopen (fn_path, "r");
@@ -144,6 +192,60 @@ FILE *openCachedFile (const char *fn, const char *url, int max_age, int min_size
     return (NULL);
 }
 
+/* start downloading fn in the background if it is missing, too old or too small, then return at once.
+ * the fresh copy is installed by checkCachePrefetches() or by openCachedFile() if it gets there first.
+ * N.B. call only from main thread
+ */
+void prefetchCachedFile (const char *fn, const char *url, int max_age, int min_size)
+{
+    // skip if already under way
+    for (int i = 0; i < n_cache_prefetch; i++)
+        if (strcmp (cache_prefetch[i].fn, fn) == 0)
+            return;
+
+    // skip if local copy is still good
+    char fn_path[1000];
+    snprintf (fn_path, sizeof(fn_path), "%s/%s", our_dir.c_str(), fn);
+    if (cachedFileOk (fn_path, max_age, min_size))
+        return;
+
+    int fetch_id = startHCFetch (url);
+    if (!fetch_id)
+        return;
+
+    cache_prefetch = (CachePrefetch *) realloc (cache_prefetch, (n_cache_prefetch+1)*sizeof(CachePrefetch));
+    if (!cache_prefetch)
+        fatalError ("No memory for cache prefetch %s", fn);
+    CachePrefetch &cp = cache_prefetch[n_cache_prefetch++];
+    snprintf (cp.fn, sizeof(cp.fn), "%s", fn);
+    snprintf (cp.url, sizeof(cp.url), "%s", url);
+    cp.min_size = min_size;
+    cp.fetch_id = fetch_id;
+
+    Serial.printf ("Cache: prefetching %s\n", url);
+}
+
+/* install any prefetches that have completed, without waiting for the others.
+ * N.B. call only from main thread
+ */
+void checkCachePrefetches (void)
+{
+    for (int i = 0; i < n_cache_prefetch; ) {
+        int fd = -1;
+        FetchState fs = checkFetch (cache_prefetch[i].fetch_id, &fd);
+        if (fs == FETCH_PENDING) {
+            i++;
+            continue;
+        }
+        CachePrefetch cp = cache_prefetch[i];
+        (void) removePrefetch (i);
+        if (fs == FETCH_OK)
+            saveCachedFile (cp.fn, cp.url, fd, cp.min_size);
+        else
+            Serial.printf ("Cache: prefetch %s failed\n", cp.url);
+    }
+}
+
 /* remove files that contain the given string and older than the given age in seconds
  * return whether any where removed.
  */
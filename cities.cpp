@@ -13,9 +13,8 @@ static const char cities_fn[] = "cities2.txt";
 #define CITIES_SZ       1000                    // min believable size
 #define CRETRY_DT       (60)                    // retry preiod on error, secs
 
-// malloced sorted kdtree
-static KD3Node *city_malloc;                    // malloced array
-static KD3Node *city_root;                      // tree root somewhere within the array
+// kdtree, data are malloced names
+static KD3Tree city_tree;
 static int n_cities;                            // number in use
 
 // pixel width of longest city
@@ -27,12 +26,10 @@ static int max_city_len;
 static void readCities()
 {
         // insure reset
-        if (city_malloc) {
-            freeKD3NodeTree (city_malloc, n_cities);
-            city_root = NULL;
-            city_malloc = NULL;
-            n_cities = 0;
-        }
+        for (int i = 0; i < city_tree.n_pts; i++)
+            free (city_tree.pts[i].data);
+        freeKD3Tree (city_tree);
+        n_cities = 0;
 
         // open file from cache
         FILE *fp = openCachedFile (cities_fn, cities_page, CITIES_DT, CITIES_SZ);
@@ -43,10 +40,11 @@ static void readCities()
         char **names = NULL;                    // temp malloced list of persistent malloced names
         LatLong *lls = NULL;                    // temp malloced list of locations
         int n_malloced = 0;                     // number malloced in each list
-        char line[200];
+        GenReader gr(fp);
+        char *line;
         max_city_len = 0;
 
-        while (fgets (line, sizeof(line), fp)) {
+        while (gr.getLine (&line)) {
 
             // crack
             char name[101];                     // N.B. match length-1 in sscanf
@@ -85,22 +83,17 @@ static void readCities()
         // finished with file
         fclose (fp);
 
-        // build tree -- N.B. can not build as we read because realloc could move left/right pointers
-        city_malloc = (KD3Node *) calloc (n_cities, sizeof(KD3Node));
-        if (!city_malloc && n_cities > 0)
-            fatalError ("alloc cities tree: %d", n_cities);
+        // bulk load tree
+        KD3Point *pts = allocKD3Points (city_tree, n_cities);
         for (int i = 0; i < n_cities; i++) {
-            KD3Node *kp = &city_malloc[i];
-            ll2KD3Node (lls[i], kp);
-            kp->data = (void*) names[i];
+            ll2KD3Point (lls[i], &pts[i]);
+            pts[i].data = (void*) names[i];
         }
+        buildKD3Tree (city_tree);
 
-        // finished with temporary lists -- names themselves live forever
+        // finished with temporary lists -- names themselves now belong to city_tree
         free (names);
         free (lls);
-
-        // transform array into proper KD3 tree
-        city_root = mkKD3NodeTree (city_malloc, n_cities, 0);
 }
 
 /* return name of nearest city and location but no farther than MAX_CSR_DIST from the given ll, else NULL.
@@ -112,13 +105,13 @@ const char *getNearestCity (const LatLong &ll, LatLong &city_ll, int *max_cl)
         static time_t next_update;
         if (myNow() > next_update) {
             readCities();
-            if (!city_root) {
+            if (n_cities == 0) {
                 next_update = myNow() + CRETRY_DT;
                 Serial.printf ("%s failed, next update in %d\n", cities_fn, CRETRY_DT);
             } else
                 next_update = myNow() + CITIES_DT;
         }
-        if (!city_root) {
+        if (n_cities == 0) {
             Serial.printf ("still no %s after refresh attempt", cities_fn);
             return (NULL);
         }
@@ -128,18 +121,12 @@ const char *getNearestCity (const LatLong &ll, LatLong &city_ll, int *max_cl)
             *max_cl = max_city_len;
 
         // search
-        KD3Node seach_city;
-        ll2KD3Node (ll, &seach_city);
-        const KD3Node *best_city = NULL;
-        float best_dist = 0;
-        int n_visited = 0;
-        nearestKD3Node (city_root, &seach_city, 0, &best_city, &best_dist, &n_visited);
-        // printf ("**** visted %d\n", n_visited);
+        float best_dist;
+        const KD3Point *best_city = nearestKD3Point (city_tree, ll, &best_dist);
 
         // report results if successful
-        best_dist = nearestKD3Dist2Miles (best_dist);   // convert to miles
-        if (best_dist < MAX_CSR_DIST) {
-            KD3Node2ll (*best_city, &city_ll);
+        if (best_city && best_dist < MAX_CSR_DIST) {
+            KD3Point2ll (*best_city, &city_ll);
             return ((char*)(best_city->data));
         } else {
             return (NULL);
@@ -147,3 +134,9 @@ const char *getNearestCity (const LatLong &ll, LatLong &city_ll, int *max_cl)
 
 }
 
+/* start refreshing the cities file in the background if it is missing or stale, return at once.
+ */
+void prefetchCitiesFile (void)
+{
+        prefetchCachedFile (cities_fn, cities_page, CITIES_DT, CITIES_SZ);
+}
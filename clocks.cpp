@@ -101,9 +101,11 @@ static time_t getTime(void)
         time_src = getNMEAFile();
         t = getNMEAUTC();
     } else {
-        NTPServer *ntp = findBestNTP();         // include user's if set
-        time_src = ntp->server;
-        t = getNTPUTC(ntp);
+        uint16_t ms;
+        t = getNTPUTC(ms);
+        time_src = findBestNTP()->server;       // include user's if set
+        if (t)
+            setSyncMillis (ms);
     }
 
     if (t) {
@@ -311,7 +311,8 @@ static void cfg2file (const char *cfg_name, char fn[], size_t fn_l)
 }
 
 /* convert the given file name to a config name.
- * return whether file name and contents meet basic requirements.
+ * return whether file name and contents meet basic requirements, ie, the start of an eeprom file in either
+ * the binary format or the original text format.
  */
 static bool file2cfg (const char *fn, char cfg[], size_t cfg_l)
 {
@@ -324,12 +325,16 @@ static bool file2cfg (const char *fn, char cfg[], size_t cfg_l)
             snprintf (path, sizeof(path), "%s/%s/%s", our_dir.c_str(), cfg_dir, fn);
             FILE *fp = fopen (path, "r");
             if (fp) {
-                if (fgets(path,sizeof(path),fp) && !feof(fp) && !ferror(fp) && !strcmp(path,"00000000 00\n")){
+                static const char text_hdr[] = "00000000 00\n";
+                char hdr[sizeof(text_hdr)];
+                size_t n_hdr = fread (hdr, 1, sizeof(hdr)-1, fp);
+                fclose (fp);
+                if ((n_hdr >= sizeof(EE_MAGIC)-1 && memcmp (hdr, EE_MAGIC, sizeof(EE_MAGIC)-1) == 0)
+                                || (n_hdr == sizeof(text_hdr)-1 && memcmp (hdr, text_hdr, n_hdr) == 0)) {
                     // looks plausible!
                     strncpySubChar (cfg, fn, ' ', '_', basename_l+1);   // include room for EOS
                     return (true);
                 }
-                fclose (fp);
             }
         }
     }
@@ -384,7 +389,8 @@ static void engageCfgFile (const char *cfg_name)
     if (!from_fp)
         fatalError ("%s: %s", buf, strerror(errno));
 
-    // overwrite existing
+    // overwrite existing, first writing anything pending so it can not overwrite us later
+    (void) EEPROM.flush();
     const char *eeprom = EEPROM.getFilename();
     FILE *to_fp = fopen (eeprom, "w");
     if (!to_fp)
@@ -412,6 +418,16 @@ static void engageCfgFile (const char *cfg_name)
  */
 static void saveCfgFile (const char *cfg_name)
 {
+    // read existing, including anything pending. flush also creates it if nothing has been committed yet
+    // but just skip the save if it still can not be read.
+    (void) EEPROM.flush();
+    const char *eeprom = EEPROM.getFilename();
+    FILE *from_fp = fopen (eeprom, "r");
+    if (!from_fp) {
+        Serial.printf ("CFG: can not save '%s': %s: %s\n", cfg_name, eeprom, strerror(errno));
+        return;
+    }
+
     // create new
     char buf[2000];
     cfg2file (cfg_name, buf, sizeof(buf));
@@ -423,12 +439,6 @@ static void saveCfgFile (const char *cfg_name)
     if (fchown (fileno(to_fp), getuid(), getgid()) < 0)
         Serial.printf ("CFG: chown(%s,%d,%d): %s\n", buf, getuid(), getgid(), strerror(errno));
 
-    // read existing
-    const char *eeprom = EEPROM.getFilename();
-    FILE *from_fp = fopen (eeprom, "r");
-    if (!from_fp)
-        fatalError ("%s: %s", eeprom, strerror(errno));
-
     // copy
     size_t n_r;
     while ((n_r = fread (buf, 1, sizeof(buf), from_fp)) > 0) {
@@ -639,3 +639,10 @@ int getContests (char **&titles, char **&dates)
 
     return (cts_ss.n_data);
 }
+
+/* start refreshing the contests file in the background if it is missing or stale, return at once.
+ */
+void prefetchContestsFile (void)
+{
+    prefetchCachedFile (contests_fn, contests_page, CONTESTS_MAXAGE, CONTESTS_MINSIZ);
+}
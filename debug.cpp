@@ -40,6 +40,12 @@ bool setDebugLevel (const char *name, int level)
     if (dlp) {
         dlp->level = level;
         Serial.printf ("DEBUG: set %s=%d\n", dlp->name, dlp->level);
+
+        // subsystem traces are logged with LOGD so they need at least that level to show
+        if (level > 0 && log_level < LOG_DEBUG) {
+            log_level = LOG_DEBUG;
+            Serial.printf ("DEBUG: log level now debug\n");
+        }
         return (true);
     }
 
@@ -5,6 +5,10 @@
  * We actually keep two lists:
  *   dxc_spots: the complete raw list, not filtered nor sorted; length in n_dxspots.
  *   dxwl_spots: watchlist-filtered and time-sorted for display; length in dxc_ss.n_data.
+ *
+ * Incoming spots are collected in dxc_ring, a fixed-capacity ring in arrival order with a hash index on
+ * tx_call and band, so dup checks, aging and appending each cost O(1) no matter how busy the cluster.
+ * dxc_spots is a plain copy of the live ring entries, rebuilt only when someone looks after a change.
  * 
  */
 
@@ -36,11 +40,29 @@ static uint8_t dxc_age;                               // one of above, once set
 #define DXCMSG_DT       500                     // delay before sending each cluster message, millis
 #define HBEAT_MS        60000                   // heatbeat interval, millis
 
+// ring of incoming spots, oldest at dxc_head. a spot superseded by a later report of the same call and
+// band is left in place as a hole and the new one appended, so the ring stays in arrival order.
+#define DXC_MAXSPOTS    4000                    // ring capacity, oldest is dropped to make room
+#define DXC_NHASH       8192                    // n dxc_hash buckets, power of 2
+typedef struct {
+    uint32_t hash;                              // hash of tx_call and band
+    int next;                                   // next dxc_ring index in same dxc_hash bucket, else -1
+    HamBandSetting band;                        // band of kHz
+    bool live;                                  // false once superseded or removed
+} DXRingInfo;
+static DXSpot *dxc_ring;                        // malloced DXC_MAXSPOTS spots
+static DXRingInfo *dxc_rinfo;                   // malloced, parallel to dxc_ring
+static int dxc_head;                            // dxc_ring index of oldest entry
+static int dxc_nring;                           // n entries from dxc_head, including holes
+static int dxc_hash[DXC_NHASH];                 // first dxc_ring index in each bucket, else -1
+static bool dxc_ring_changed;                   // set when dxc_spots must be rebuilt from dxc_ring
+
 // state
-static DXSpot *dxc_spots;                       // malloced list of all spots
+static DXSpot *dxc_spots;                       // malloced list of all live spots, see refreshDXSpots()
 static int n_dxspots;                           // n spots in dxc_spots
 static DXSpot *dxwl_spots;                      // malloced list, filtered for display, count in dxc_ss.n_data
 static ScrollState dxc_ss;                      // scrolling info, and count of dxwl_spots
+static SpotIndex dxc_six, dxwl_six;             // getClosestSpot() indices of dxc_spots and dxwl_spots
 static bool dxc_showbio;                        // whether click shows bio
 static bool dxc_spots_changed;                  // set to rebuild display because dxc_spots changed
 static bool dxc_updateDE;                       // request to send DE location when possible
@@ -84,10 +106,132 @@ static void drawClearListBtn (bool draw)
     tft.print ("CLR");
 }
 
+/* return hash of the given call and band
+ */
+static uint32_t hashDXSpot (const char *call, HamBandSetting band)
+{
+    uint32_t h = 2166136261U ^ (uint32_t)band;
+    while (*call)
+        h = (h ^ (uint8_t)*call++) * 16777619U;
+    return (h);
+}
+
+/* insure the ring is allocated and empty
+ */
+static void initDXRing (void)
+{
+    if (!dxc_ring) {
+        dxc_ring = (DXSpot *) malloc (DXC_MAXSPOTS * sizeof(DXSpot));
+        dxc_rinfo = (DXRingInfo *) malloc (DXC_MAXSPOTS * sizeof(DXRingInfo));
+        dxc_spots = (DXSpot *) malloc (DXC_MAXSPOTS * sizeof(DXSpot));
+        if (!dxc_ring || !dxc_rinfo || !dxc_spots)
+            fatalError ("No memory for %d DX spots", DXC_MAXSPOTS);
+        dxc_head = dxc_nring = 0;
+        n_dxspots = 0;
+        for (int i = 0; i < DXC_NHASH; i++)
+            dxc_hash[i] = -1;
+    }
+}
+
+/* remove dxc_ring[slot] from the hash index and mark it a hole
+ */
+static void killDXSlot (int slot)
+{
+    DXRingInfo &ri = dxc_rinfo[slot];
+    if (!ri.live)
+        return;
+    int *linkp = &dxc_hash[ri.hash & (DXC_NHASH-1)];
+    while (*linkp != slot)
+        linkp = &dxc_rinfo[*linkp].next;
+    *linkp = ri.next;
+    ri.live = false;
+    dxc_ring_changed = true;
+}
+
+/* return dxc_ring index of the live spot with the given call and band, else -1
+ */
+static int findDXSlot (const char *call, HamBandSetting band, uint32_t hash)
+{
+    for (int slot = dxc_hash[hash & (DXC_NHASH-1)]; slot >= 0; slot = dxc_rinfo[slot].next) {
+        const DXRingInfo &ri = dxc_rinfo[slot];
+        if (ri.hash == hash && ri.band == band && strcmp (dxc_ring[slot].tx_call, call) == 0)
+            return (slot);
+    }
+    return (-1);
+}
+
+/* remove the oldest entry from dxc_ring
+ */
+static void popDXRing (void)
+{
+    killDXSlot (dxc_head);
+    dxc_head = (dxc_head + 1) % DXC_MAXSPOTS;
+    dxc_nring--;
+}
+
+/* remove holes and spots older than ancient from the old end of dxc_ring.
+ * N.B. spots that arrived out of order may linger behind newer ones, refreshDXSpots() skips them.
+ */
+static void ageDXRing (time_t ancient)
+{
+    while (dxc_nring > 0) {
+        if (dxc_rinfo[dxc_head].live) {
+            const DXSpot &spot = dxc_ring[dxc_head];
+            if (spot.spotted >= ancient)
+                break;
+            dxcLog ("%s %g: aged out\n", spot.tx_call, spot.kHz);
+            dxc_spots_changed = true;                   // update GUI with updated list
+        }
+        popDXRing();
+    }
+}
+
+/* append spot to dxc_ring, dropping the oldest if full
+ */
+static void pushDXRing (const DXSpot &spot, HamBandSetting band, uint32_t hash)
+{
+    if (dxc_nring == DXC_MAXSPOTS) {
+        if (dxc_rinfo[dxc_head].live)
+            dxcLog ("%s %g: dropped to make room\n", dxc_ring[dxc_head].tx_call, dxc_ring[dxc_head].kHz);
+        popDXRing();
+    }
+
+    int slot = (dxc_head + dxc_nring++) % DXC_MAXSPOTS;
+    dxc_ring[slot] = spot;
+    DXRingInfo &ri = dxc_rinfo[slot];
+    ri.hash = hash;
+    ri.band = band;
+    ri.live = true;
+    int &bucket = dxc_hash[hash & (DXC_NHASH-1)];
+    ri.next = bucket;
+    bucket = slot;
+    dxc_ring_changed = true;
+}
+
+/* rebuild dxc_spots from dxc_ring if changed.
+ * call this before using dxc_spots or n_dxspots.
+ */
+static void refreshDXSpots (void)
+{
+    if (!dxc_ring_changed)
+        return;
+
+    time_t ancient = myNow() - MAXKEEP_DT;
+    n_dxspots = 0;
+    for (int i = 0; i < dxc_nring; i++) {
+        int slot = (dxc_head + i) % DXC_MAXSPOTS;
+        if (dxc_rinfo[slot].live && dxc_ring[slot].spotted >= ancient)
+            dxc_spots[n_dxspots++] = dxc_ring[slot];
+    }
+    dxc_ring_changed = false;
+    resetSpotIndex (dxc_six);
+}
+
 /* handy check whether we are, or should, show the New spots symbol
  */
 static bool showingNewSpot(void)
 {
+    refreshDXSpots();
     return (scrolledaway_tm > 0 && n_dxspots > 0 && dxc_spots[n_dxspots-1].spotted > scrolledaway_tm);
 }
 
@@ -99,6 +243,7 @@ static void rebuildDXWatchList(void)
     freshenADIFFile();
 
     // extract qualifying spots
+    refreshDXSpots();
     time_t oldest = myNow() - 60*dxc_age;               // oldest time to display, seconds
     dxc_ss.n_data = 0;                                  // reset count, don't bother to resize dxwl_spots
     for (int i = 0; i < n_dxspots; i++) {
@@ -113,6 +258,7 @@ static void rebuildDXWatchList(void)
 
     // resort and scroll to newest
     qsort (dxwl_spots, dxc_ss.n_data, sizeof(DXSpot), qsDXCSpotted);
+    resetSpotIndex (dxwl_six);
     dxc_ss.scrollToNewest();
 }
 
@@ -186,7 +332,7 @@ static void logDXSpot (const char *label, const DXSpot &spot)
                                 spot_time->tm_hour, spot_time->tm_min);
 }
 
-/* add a potentially new spot to dxc_spots[].
+/* add a potentially new spot to dxc_ring[].
  * set dxc_spots_changed if dxc_spots changed in either content or count.
  * set DX too if asked and desired.
  */
@@ -207,50 +353,47 @@ static void addDXClusterSpot (DXSpot &new_spot, bool set_dx)
 
     // handy
     HamBandSetting new_band = findHamBand(new_spot.kHz);
+    uint32_t new_hash = hashDXSpot (new_spot.tx_call, new_band);
 
-    // check for dup, and remove any ancient spots along the way
-    bool same_spot = false;
-    for (int i = 0; i < n_dxspots; i++) {
-        DXSpot &spot = dxc_spots[i];
-        if (spot.spotted < ancient) {
-            dxcLog ("%s %g: aged out\n", spot.tx_call, spot.kHz);
-            memmove (&dxc_spots[i], &dxc_spots[i+1], (--n_dxspots - i) * sizeof(DXSpot));
-            i -= 1;                                     // examine new [i] again next loop
-            dxc_spots_changed = true;                   // update GUI with updated list
-        } else if (!strcmp (spot.tx_call, new_spot.tx_call) && findHamBand (spot.kHz) == new_band) {
-            // consider dupe if same tx call and band
-            int spt_hr = hour(spot.spotted);
-            int spt_mn = minute(spot.spotted);
-            int new_hr = hour(new_spot.spotted);
-            int new_mn = minute(new_spot.spotted);
-            same_spot = true;
-            if (new_spot.spotted > spot.spotted) {
-                dxcLog ("%s %g: updated %02d%02dZ > %02d%02dZ\n", new_spot.tx_call, new_spot.kHz,
-                                                                new_hr, new_mn, spt_hr, spt_mn);
-                spot = new_spot;                        // update info
-                dxc_spots_changed = true;               // update GUI with new age
-            } else if (new_spot.spotted == spot.spotted) {
-                dxcLog ("%s %g: dup time %02d%02dZ\n", spot.tx_call, spot.kHz, spt_hr, spt_mn);
-            } else {
-                dxcLog ("%s %g: superseded %02d%02dZ < %02d%02dZ\n", spot.tx_call, spot.kHz,
-                                                                new_hr, new_mn, spt_hr, spt_mn);
-            }
-        }
+    // remove any ancient spots
+    initDXRing();
+    ageDXRing (ancient);
+
+    // check for dup, ie, same tx call and band, ignoring any ancient that arrived out of order
+    int dup_slot = findDXSlot (new_spot.tx_call, new_band, new_hash);
+    if (dup_slot >= 0 && dxc_ring[dup_slot].spotted < ancient) {
+        killDXSlot (dup_slot);
+        dup_slot = -1;
     }
-    
-    // that's it if already in dxc_spots
-    if (same_spot)
+    if (dup_slot >= 0) {
+        const DXSpot &spot = dxc_ring[dup_slot];
+        int spt_hr = hour(spot.spotted);
+        int spt_mn = minute(spot.spotted);
+        int new_hr = hour(new_spot.spotted);
+        int new_mn = minute(new_spot.spotted);
+        if (new_spot.spotted > spot.spotted) {
+            dxcLog ("%s %g: updated %02d%02dZ > %02d%02dZ\n", new_spot.tx_call, new_spot.kHz,
+                                                            new_hr, new_mn, spt_hr, spt_mn);
+            killDXSlot (dup_slot);                      // update info by moving to newest end
+            pushDXRing (new_spot, new_band, new_hash);
+            dxc_spots_changed = true;                   // update GUI with new age
+        } else if (new_spot.spotted == spot.spotted) {
+            dxcLog ("%s %g: dup time %02d%02dZ\n", spot.tx_call, spot.kHz, spt_hr, spt_mn);
+        } else {
+            dxcLog ("%s %g: superseded %02d%02dZ < %02d%02dZ\n", spot.tx_call, spot.kHz,
+                                                            new_hr, new_mn, spt_hr, spt_mn);
+        }
+
+        // that's it if already in dxc_ring
         return;
+    }
 
     // tweak map location for unique picking
     ditherLL (new_spot.tx_ll);
     ditherLL (new_spot.rx_ll);
 
-    // append to dxc_spots
-    dxc_spots = (DXSpot *) realloc (dxc_spots, (n_dxspots+1) * sizeof(DXSpot));
-    if (!dxc_spots)
-        fatalError ("No memory for %d DX spots", n_dxspots+1);
-    dxc_spots[n_dxspots++] = new_spot;
+    // append to dxc_ring
+    pushDXRing (new_spot, new_band, new_hash);
 
     // set new DX if desired
     if (set_dx) {
@@ -399,17 +542,25 @@ static void requestRecentSpots (void)
  */
 static void resetDXMem()
 {
-    if (dxc_spots) {
+    if (dxc_ring) {
+        free (dxc_ring);
+        free (dxc_rinfo);
         free (dxc_spots);
+        dxc_ring = NULL;
+        dxc_rinfo = NULL;
         dxc_spots = NULL;
+        dxc_nring = 0;
         n_dxspots = 0;
+        dxc_ring_changed = false;
     }
+    resetSpotIndex (dxc_six);
 
     if (dxwl_spots) {
         free (dxwl_spots);
         dxwl_spots = NULL;
         dxc_ss.n_data = 0;
     }
+    resetSpotIndex (dxwl_six);
 }
 
 /* return whether the given host appears to be a multicast address
@@ -1009,7 +1160,9 @@ bool updateDXCluster (const SBox &box, bool fresh)
 
     if (dxc_ss.atNewest()) {
         // rebuild displayed spots list when master list changes or oldest spot ages out
-        if (dxc_spots_changed || (n_dxspots > 0 && dxc_spots[0].spotted < myNow() - MAXKEEP_DT)) {
+        if (dxc_ring)
+            ageDXRing (myNow() - MAXKEEP_DT);
+        if (dxc_spots_changed) {
             rebuildDXWatchList();
             dxc_spots_changed = false;
             dxc_ss.drawNewSpotsSymbol (false, false);           // insure off
@@ -1145,6 +1298,7 @@ bool checkDXClusterTouch (const SCoord &s, const SBox &box)
 bool getDXClusterSpots (DXSpot **spp, uint8_t *nspotsp)
 {
     if (useDXCluster()) {
+        refreshDXSpots();
         *spp = dxc_spots;
         *nspotsp = n_dxspots;
         return (true);
@@ -1182,6 +1336,7 @@ void drawDXClusterSpotsOnMap ()
     bool just_dxpeds = dxpeds_using && !dxc_using;
 
     // must use full list if not using DXC pane
+    refreshDXSpots();
     DXSpot *spots          = just_dxpeds ? dxc_spots : dxwl_spots;
     int n_spots            = just_dxpeds ? n_dxspots : dxc_ss.n_data;
     LabelOnMapDot tx_label = just_dxpeds ? LOMD_JUSTDOT : LOMD_ALL;
@@ -1224,12 +1379,14 @@ bool getClosestDXCluster (LatLong &ll, DXSpot *sp, LatLong *llp)
     bool just_dxpeds = dxpeds_using && !dxc_using;
 
     // must use full list if not using DXC pane, else limit to just peds
+    refreshDXSpots();
+    SpotIndex &six = just_dxpeds ? dxc_six : dxwl_six;
     DXSpot *spots  = just_dxpeds ? dxc_spots : dxwl_spots;
     int n_spots    = just_dxpeds ? n_dxspots : dxc_ss.n_data;
     SpotFilter sfp = just_dxpeds ? findDXPedsCall : NULL;
 
     // find closest spot, if any
-    bool found = getClosestSpot (spots, n_spots, sfp, LOME_BOTH, ll, sp, llp);
+    bool found = getClosestSpot (six, spots, n_spots, sfp, SPOTS_ALLBANDS, LOME_BOTH, ll, sp, llp);
     if (!found)
         return (false);
 
@@ -1309,6 +1466,7 @@ const DXSpot *findDXCCall (const char *call)
 {
     // only if dxpeds wants it and we are actually running
     if (dxpedsWatchingCluster() && isDXClusterConnected()) {
+        refreshDXSpots();
         for (int i = 0; i < n_dxspots; i++)
             if (strcasecmp (dxc_spots[i].tx_call, call) == 0)
                 return (&dxc_spots[i]);
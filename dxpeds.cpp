@@ -53,6 +53,7 @@ static bool show_current;                       // whether to show only the acti
 static bool show_hidden;                        // whether to show peds marked as hidden
 static bool watch_cluster;                      // whether to watch cluster for spots
 static ScrollState dxp_ss;                      // scrolling context, max_vis/2 if showing date
+static KD3Tree dxp_kd3;                         // index of dxpeds[].ll, empty until needed
 static DXPCredit *credits;                      // malloced list of each credit
 static int n_credits;                           // n credits
 static ADIFWList *adif_worked;                  // malloced list of ADIF worked band+mode
@@ -528,10 +529,19 @@ static int qsDXPedStart (const void *v1, const void *v2)
 }
 
 
+/* discard the getClosestDXPed() index, call whenever dxpeds[] changes.
+ */
+static void resetDXPedsKD3 (void)
+{
+    freeKD3Tree (dxp_kd3);
+}
+
 /* free all heap memory used by dxpeds
  */
 static void freeDXPeds (void)
 {
+    resetDXPedsKD3();
+
     if (dxp_ss.n_data > 0) {
         for (int i = 0; i < dxp_ss.n_data; i++) {
             DXPedEntry &de = dxpeds[i];
@@ -755,6 +765,9 @@ static bool retrieveDXPeds (const SBox &box)
 
 out:
 
+    // list has changed whether or not ok
+    resetDXPedsKD3();
+
     // sort by start time
     if (ok) {
         qsort (dxpeds, dxp_ss.n_data, sizeof(DXPedEntry), qsDXPedStart);
@@ -781,6 +794,7 @@ static bool checkActiveDXPeds (void)
             memmove (cp, cp+1, (--dxp_ss.n_data - i) * sizeof(DXPedEntry));
             i -= 1;                             // examine new [i] again next loop
             any_past = true;
+            resetDXPedsKD3();
         } else if (cp->start_t <= now && !cp->was_active) {
             cp->was_active = true;
             newly_active = true;
@@ -971,18 +985,24 @@ bool getPaneDXPed (const SCoord &s, DXPedEntry *&dxp)
  */
 bool getClosestDXPed (LatLong &ll, DXPedEntry *&dxp)
 {
-    int min_i = -1;
-    float min_d = 1e10;
-    for (int i = 0; i < dxp_ss.n_data; i++) {
-        float d = ll.GSD(dxpeds[i].ll);
-        if (d < min_d) {
-            min_d = d;
-            min_i = i;
+    if (dxp_ss.n_data <= 0)
+        return (false);
+
+    // (re)build index if list has changed
+    if (dxp_kd3.n_pts == 0) {
+        KD3Point *pts = allocKD3Points (dxp_kd3, dxp_ss.n_data);
+        for (int i = 0; i < dxp_ss.n_data; i++) {
+            ll2KD3Point (dxpeds[i].ll, &pts[i]);
+            pts[i].data = &dxpeds[i];
         }
+        buildKD3Tree (dxp_kd3);
     }
 
-    if (min_i >= 0 && min_d*ERAD_M < MAX_CSR_DIST) {
-        dxp = &dxpeds[min_i];
+    // find closest
+    float min_d;
+    const KD3Point *best = nearestKD3Point (dxp_kd3, ll, &min_d);
+    if (best && min_d < MAX_CSR_DIST) {
+        dxp = (DXPedEntry *) best->data;
         return (true);
     }
 
@@ -1093,3 +1113,10 @@ bool dxpedsWatchingCluster()
 {
     return (watch_cluster && useDXCluster() && findPaneForChoice (PLOT_CH_DXPEDS) != PANE_NONE);
 }
+
+/* start refreshing the DXPeditions file in the background if it is missing or stale, return at once.
+ */
+void prefetchDXPedsFile (void)
+{
+    prefetchCachedFile (dxpeds_fn, dxpeds_page, DXPEDS_MAXAGE, DXPEDS_MINSIZ);
+}
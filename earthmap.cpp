@@ -40,6 +40,41 @@ uint8_t show_lp;                                // display long path, else short
 #define GRAYLINE_POW    (0.75F)                 // cos power exponent, sqrt is too severe, 1 is too gradual
 static SCoord moremap_s;                        // drawMoreEarth() scanning location 
 
+/* cache of the projection of each map_b app pixel so drawMapCoord() need not run s2ll() trig on each
+ * sweep. the table depends only on the projection, DE, pan/zoom, center lng and map_b; rows are filled
+ * on demand the first time they are needed after any of those change.
+ */
+typedef struct {
+    float lat_d, lng_d;                         // location, degs; lat_d is MPLL_NONE if not over globe
+    float slat, clat;                           // handy trig of lat
+} MapPixLL;
+#define MPLL_NONE       1000.0F                 // any impossible lat_d
+static MapPixLL *mpll_tbl;                      // EARTH_W x EARTH_H, malloced once
+static bool mpll_rowok[EARTH_H];                // whether each mpll_tbl row has been filled
+
+// the state on which mpll_tbl depends
+typedef struct {
+    uint8_t proj;
+    float de_lat_d, de_lng_d;
+    PanZoom pz;
+    int16_t center_lng;
+    bool user_map;
+    SBox b;
+} MapPixLLKey;
+static MapPixLLKey mpll_key = {MAPP_N, 0, 0, {0, 0, 0}, 0, false, {0, 0, 0, 0}};
+
+/* the map is drawn one row per loop() unless map_threads > 0 in which case the entire map is rendered at
+ * once as that many horizontal bands of rows on the task pool. this is opt-in with -t because a full render
+ * every MAP_BANDS_DT keeps all cores busy in bursts, whereas one row per loop() barely shows on any cpu.
+ */
+int map_threads = 0;                            // set with -t
+#define MAP_BANDS_DT    5000                    // ms between full map renders when using bands
+static uint32_t map_bands_ms;                   // millis() of last full band render
+static bool map_bands_now;                      // set to render bands asap
+typedef struct {
+    uint16_t y0, y1;                            // first and last+1 app rows in band
+} MapBand;
+
 // cached grid colors
 uint16_t EARTH_GRIDC, EARTH_GRIDC00;            // main and highlighted
 
@@ -911,6 +946,206 @@ static void drawMapMenu()
 
 }
 
+/* convert screen coord within map_b to ll without regard to overlays such as RSS or the view button.
+ * return whether location is really over the globe.
+ */
+static bool s2llProj (const SCoord &s, LatLong &ll)
+{
+    switch ((MapProjection)map_proj) {
+
+    case MAPP_AZIMUTHAL: {
+        // radius from center of point's hemisphere
+        bool on_right = s.x > map_b.x + map_b.w/2;
+        float dx = on_right ? s.x - (map_b.x + 3*map_b.w/4) : s.x - (map_b.x + map_b.w/4);
+        float dy = (map_b.y + map_b.h/2) - s.y;
+        float r2 = dx*dx + dy*dy;
+
+        // see if really on surface
+        float w2 = map_b.w*map_b.w/16;
+        if (r2 > w2)
+            return(false);
+
+        // use screen triangle to find globe
+        float b = sqrtf((float)r2/w2)*(M_PI_2F);
+        float A = (M_PI_2F) - atan2f (dy, dx);
+        float ca, B;
+        solveSphere (A, b, (on_right ? -1 : 1) * sdelat, cdelat, &ca, &B);
+        ll.lat = M_PI_2F - acosf(ca);
+        ll.lat_d = rad2deg(ll.lat);
+        ll.lng = fmodf (de_ll.lng + B + (on_right?6:5)*M_PIF, 2*M_PIF) - M_PIF;
+        ll.lng_d = rad2deg(ll.lng);
+
+        } break;
+
+    case MAPP_AZIM1: {
+
+        // radius from center
+        float dx = s.x - (map_b.x + map_b.w/2);
+        float dy = (map_b.y + map_b.h/2) - s.y;
+        float r2 = dx*dx + dy*dy;
+
+        // see if really on surface
+        float h2 = map_b.h*map_b.h/4;
+        if (r2 > h2)
+            return(false);
+
+        // use screen triangle to find globe
+        float b = powf((float)r2/h2, AZIM1_FISHEYE/2.0F) * M_PIF / AZIM1_ZOOM;     // /2 just for sqrt
+        float A = (M_PI_2F) - atan2f (dy, dx);
+        float ca, B;
+        solveSphere (A, b, sdelat, cdelat, &ca, &B);
+        ll.lat = M_PI_2F - acosf(ca);
+        ll.lat_d = rad2deg(ll.lat);
+        ll.lng = fmodf (de_ll.lng + B + 5*M_PIF, 2*M_PIF) - M_PIF;
+        ll.lng_d = rad2deg(ll.lng);
+
+        } break;
+
+    case MAPP_MERCATOR: {
+
+        // straight rectangular mercator projection
+        ll.lat_d = 180.0F*((map_b.y + map_b.h/2 - s.y)/(float)pan_zoom.zoom + pan_zoom.pan_y)/map_b.h;
+        ll.lng_d = 360.0F*((s.x - map_b.x - map_b.w/2)/(float)pan_zoom.zoom + pan_zoom.pan_x)/map_b.w;
+        if (core_map != CM_USER)
+            ll.lng_d += getCenterLng();
+        ll.normalize();
+
+        } break;
+
+    case MAPP_ROB:
+
+        return (s2llRobinson (s, ll));
+        break;
+
+    default:
+        fatalError ("s2ll() bad map_proj %d", map_proj);
+    }
+
+
+    return (true);
+}
+
+/* discard mpll_tbl if any of the state on which it depends has changed.
+ */
+static void checkMapPixLL()
+{
+    MapPixLLKey &k = mpll_key;
+    int16_t center_lng = getCenterLng();
+    bool user_map = core_map == CM_USER;
+
+    if (k.proj != map_proj || k.de_lat_d != de_ll.lat_d || k.de_lng_d != de_ll.lng_d
+                    || k.pz.zoom != pan_zoom.zoom || k.pz.pan_x != pan_zoom.pan_x
+                    || k.pz.pan_y != pan_zoom.pan_y || k.center_lng != center_lng || k.user_map != user_map
+                    || k.b.x != map_b.x || k.b.y != map_b.y || k.b.w != map_b.w || k.b.h != map_b.h) {
+        k.proj = map_proj;
+        k.de_lat_d = de_ll.lat_d;
+        k.de_lng_d = de_ll.lng_d;
+        k.pz = pan_zoom;
+        k.center_lng = center_lng;
+        k.user_map = user_map;
+        k.b = map_b;
+        memset (mpll_rowok, 0, sizeof(mpll_rowok));
+    }
+}
+
+/* return the mpll_tbl entry for the given screen coord, filling its row if not already, or NULL if
+ * s is not within map_b.
+ */
+static const MapPixLL *getMapPixLL (const SCoord &s)
+{
+    if (s.x < map_b.x || s.x >= map_b.x + EARTH_W || s.y < map_b.y || s.y >= map_b.y + EARTH_H)
+        return (NULL);
+
+    if (!mpll_tbl) {
+        mpll_tbl = (MapPixLL *) malloc (EARTH_W * EARTH_H * sizeof(MapPixLL));
+        if (!mpll_tbl)
+            fatalError ("No memory for %d x %d map projection cache", EARTH_W, EARTH_H);
+    }
+
+    int row = s.y - map_b.y;
+    MapPixLL *rowp = &mpll_tbl[row*EARTH_W];
+
+    if (!mpll_rowok[row]) {
+        SCoord rs;
+        rs.y = s.y;
+        for (int col = 0; col < EARTH_W; col++) {
+            MapPixLL &mp = rowp[col];
+            LatLong ll;
+            rs.x = map_b.x + col;
+            if (s2llProj (rs, ll)) {
+                mp.lat_d = ll.lat_d;
+                mp.lng_d = ll.lng_d;
+                mp.slat = sinf(ll.lat);
+                mp.clat = cosf(ll.lat);
+            } else
+                mp.lat_d = MPLL_NONE;
+        }
+        mpll_rowok[row] = true;
+    }
+
+    return (&rowp[s.x - map_b.x]);
+}
+
+/* pool task to fill the projection cache for one band of map rows.
+ * N.B. each band's rows are disjoint so no lock is needed
+ */
+static void fillMapBandTask (void *arg)
+{
+    MapBand *bp = (MapBand *) arg;
+    SCoord s;
+    s.x = map_b.x;
+    for (s.y = bp->y0; s.y < bp->y1; s.y++)
+        (void) getMapPixLL (s);
+}
+
+/* pool task to draw one band of map rows.
+ * N.B. plotEarth() writes only the SCALESZ rows beneath each app row so bands never overlap
+ */
+static void drawMapBandTask (void *arg)
+{
+    MapBand *bp = (MapBand *) arg;
+    SCoord s;
+    for (s.y = bp->y0; s.y < bp->y1; s.y++)
+        for (s.x = map_b.x; s.x < map_b.x + EARTH_W; s.x++)
+            drawMapCoord (s);
+}
+
+/* run fp on each of n bands of map_b rows in parallel on the task pool, return after all have finished.
+ */
+static void runMapBands (TaskFunc fp, int n)
+{
+    MapBand bands[MAX_MAP_THREADS];
+    TaskFuture futures[MAX_MAP_THREADS];
+
+    for (int i = 0; i < n; i++) {
+        bands[i].y0 = map_b.y + (i*EARTH_H)/n;
+        bands[i].y1 = map_b.y + ((i+1)*EARTH_H)/n;
+        if (i > 0)
+            futures[i] = startTask (fp, &bands[i]);
+    }
+
+    // do the first band ourselves while the pool does the others
+    (*fp) (&bands[0]);
+
+    for (int i = 1; i < n; i++)
+        waitTask (futures[i]);
+}
+
+/* render the entire map at once using map_threads bands.
+ * the projection cache is filled completely before drawing because each row needs the row below.
+ */
+static void drawEarthBands()
+{
+    // insure cache memory exists before any tasks need it
+    SCoord s;
+    s.x = map_b.x;
+    s.y = map_b.y;
+    (void) getMapPixLL (s);
+
+    runMapBands (fillMapBandTask, map_threads);
+    runMapBands (drawMapBandTask, map_threads);
+}
+
 /* restart map for current projection and de_ll and dx_ll
  */
 void initEarthMap()
@@ -943,6 +1178,9 @@ void initEarthMap()
     ll2s (deap_ll, deap_c.s, DEAP_R);
     ll2s (dx_ll, dx_c.s, DX_R);
 
+    // discard projection cache if it no longer applies
+    checkMapPixLL();
+
     // show updated info
     drawDEInfo();
     drawDXInfo();
@@ -957,87 +1195,122 @@ void initEarthMap()
     // init scan line in map_b
     moremap_s.x = 0;                    // avoid updateCircumstances() first call to drawMoreEarth()
     moremap_s.y = map_b.y;
+    map_bands_now = true;
 
     // now main loop can resume with drawMoreEarth()
 }
 
-/* display another earth map row at mmoremap_s.
+/* finish up after the last map row has been drawn.
  */
-void drawMoreEarth()
+static void finishEarthSweep()
 {
+    // draw goodies unless showing CM_USER
+    if (core_map != CM_USER) {
+        drawMapGrid();
+        drawSatPathAndFoot();
+        if (waiting4DXPath())
+            drawDXPath();
+        drawPSKPaths ();
+        drawAllSymbols();
+        drawSatName();
+        drawInfoBox();
+    }
 
-    uint16_t last_x = map_b.x + EARTH_W - 1;
-
-    // draw next row
-    for (moremap_s.x = map_b.x; moremap_s.x <= last_x; moremap_s.x++)
-        drawMapCoord (moremap_s);               // does not draw grid
-
-    // advance row, wrap and reset and finish up at the end
-    if ((moremap_s.y += 1) >= map_b.y + EARTH_H) {
-
-        // draw goodies unless showing CM_USER
-        if (core_map != CM_USER) {
-            drawMapGrid();
-            drawSatPathAndFoot();
-            if (waiting4DXPath())
-                drawDXPath();
-            drawPSKPaths ();
-            drawAllSymbols();
-            drawSatName();
-            drawInfoBox();
-        }
+    // draw now
+    tft.drawPR();
 
-        // draw now
-        tft.drawPR();
+    // check pending events
+    if (mapmenu_pending) {
+        drawMapMenu();
+        mapmenu_pending = false;
+    }
+    if (map_popup.pending) {
+        drawMapPopup();
+        map_popup.pending = false;
+    }
 
-        // check pending events
-        if (mapmenu_pending) {
-            drawMapMenu();
-            mapmenu_pending = false;
-        }
-        if (map_popup.pending) {
-            drawMapPopup();
-            map_popup.pending = false;
-        }
+    // rotate?
+    checkBGMap();
+
+    // prep for next
+    updateCircumstances();
+    moremap_s.y = map_b.y;
+
+// #define TIME_MAP_DRAW                             // RBF
+#if defined(TIME_MAP_DRAW)
+    static struct timeval tv0;
+    struct timeval tv1;
+    gettimeofday (&tv1, NULL);
+    if (tv0.tv_sec != 0)
+        Serial.printf ("****** map %ld us\n", TVDELUS (tv0, tv1));
+    tv0 = tv1;
+#endif // TIME_MAP_DRAW
+}
 
-        // rotate?
-        checkBGMap();
+/* display another earth map row at mmoremap_s, or the entire map if using bands.
+ */
+void drawMoreEarth()
+{
+    // center lng can change at any time so check projection cache at the start of each sweep
+    if (moremap_s.y == map_b.y)
+        checkMapPixLL();
+
+    if (map_threads > 0) {
+
+        // render whole map periodically or immediately if something changed or is waiting
+        if (map_bands_now || mapmenu_pending || map_popup.pending || timesUp (&map_bands_ms, MAP_BANDS_DT)) {
+            drawEarthBands();
+            finishEarthSweep();
+            map_bands_ms = millis();
+            map_bands_now = false;
+        }
 
-        // prep for next
-        updateCircumstances();
-        moremap_s.y = map_b.y;
+    } else {
 
-    // #define TIME_MAP_DRAW                             // RBF
-    #if defined(TIME_MAP_DRAW)
-        static struct timeval tv0;
-        struct timeval tv1;
-        gettimeofday (&tv1, NULL);
-        if (tv0.tv_sec != 0)
-            Serial.printf ("****** map %ld us\n", TVDELUS (tv0, tv1));
-        tv0 = tv1;
-    #endif // TIME_MAP_DRAW
+        // draw next row
+        uint16_t last_x = map_b.x + EARTH_W - 1;
+        for (moremap_s.x = map_b.x; moremap_s.x <= last_x; moremap_s.x++)
+            drawMapCoord (moremap_s);               // does not draw grid
 
+        // advance row, wrap and reset and finish up at the end
+        if ((moremap_s.y += 1) >= map_b.y + EARTH_H)
+            finishEarthSweep();
     }
 }
 
-/* convert lat and long in radians to scaled screen coords.
+/* capture the current map projection state used by ll2sRaw().
+ * padding is zeroed so snapshots may be compared with memcmp().
+ */
+void getMapProj (MapProj &mp)
+{
+    memset (&mp, 0, sizeof(mp));
+    mp.b = map_b;
+    mp.pz = pan_zoom;
+    mp.proj = map_proj;
+    mp.center_lng = getCenterLng();
+    mp.de_lng = de_ll.lng;
+    mp.sdelat = sdelat;
+    mp.cdelat = cdelat;
+}
+
+/* convert lat and long in radians to scaled screen coords using the given projection state.
  * keep result no closer than the given raw edge distance.
  * probably should return false bool for zoomed mercator but we just set s.x = 0 for segmentSpanOk()
  */
-static void ll2sScaled (const LatLong &ll, SCoord &s, uint8_t edge, int scale)
+static void ll2sProj (const MapProj &mp, const LatLong &ll, SCoord &s, uint8_t edge, int scale)
 {
 
-    uint16_t map_x = scale*map_b.x;
-    uint16_t map_y = scale*map_b.y;
-    uint16_t map_w = scale*map_b.w;
-    uint16_t map_h = scale*map_b.h;
+    uint16_t map_x = scale*mp.b.x;
+    uint16_t map_y = scale*mp.b.y;
+    uint16_t map_w = scale*mp.b.w;
+    uint16_t map_h = scale*mp.b.h;
 
-    switch ((MapProjection)map_proj) {
+    switch ((MapProjection)mp.proj) {
 
     case MAPP_AZIMUTHAL: {
         // sph tri between de, dx and N pole
         float ca, B;
-        solveSphere (ll.lng - de_ll.lng, M_PI_2F-ll.lat, sdelat, cdelat, &ca, &B);
+        solveSphere (ll.lng - mp.de_lng, M_PI_2F-ll.lat, mp.sdelat, mp.cdelat, &ca, &B);
         if (ca > 0) {
             // front (left) side, centered at DE
             float a = acosf (ca);
@@ -1060,7 +1333,7 @@ static void ll2sScaled (const LatLong &ll, SCoord &s, uint8_t edge, int scale)
     case MAPP_AZIM1: {
         // sph tri between de, dx and N pole
         float ca, B;
-        solveSphere (ll.lng - de_ll.lng, M_PI_2F-ll.lat, sdelat, cdelat, &ca, &B);
+        solveSphere (ll.lng - mp.de_lng, M_PI_2F-ll.lat, mp.sdelat, mp.cdelat, &ca, &B);
         float a = AZIM1_ZOOM*acosf (ca);
         float R = fminf (map_h/2*powf(a/M_PIF,1/AZIM1_FISHEYE), map_h/2 - edge - 1);
         float dx = R*sinf(B);
@@ -1074,16 +1347,16 @@ static void ll2sScaled (const LatLong &ll, SCoord &s, uint8_t edge, int scale)
         // straight rectangular Mercator projection
 
         // find distance from center of scaled but unzoomed map
-        float dx = map_w*(ll.lng_d-getCenterLng())/360 - scale*pan_zoom.pan_x;
+        float dx = map_w*(ll.lng_d-mp.center_lng)/360 - scale*mp.pz.pan_x;
 
         // this is still full scale so will be visible for sure so wrap onto map
         dx = fmodf (dx + 5*map_w/2, map_w) - map_w/2;
 
         // now zoom and place on real map
-        s.x = roundf (map_x + map_w/2 + pan_zoom.zoom*dx);
+        s.x = roundf (map_x + map_w/2 + mp.pz.zoom*dx);
 
         // y is much easier because there's no getCenterLat() and it doesn't wrap
-        s.y = roundf (map_y + map_h/2 - pan_zoom.zoom * (map_h*ll.lat_d/180 - scale*pan_zoom.pan_y));
+        s.y = roundf (map_y + map_h/2 - mp.pz.zoom * (map_h*ll.lat_d/180 - scale*mp.pz.pan_y));
 
         // guard edge or mark as invisible to inBox() and segmentSpanOk()
         if (s.x < map_x || s.x >= map_x + map_w || s.y < map_y || s.y >= map_y + map_h) {
@@ -1106,14 +1379,23 @@ static void ll2sScaled (const LatLong &ll, SCoord &s, uint8_t edge, int scale)
         } break;
 
     case MAPP_ROB:
-        ll2sRobinson (ll, s, edge, scale);
+        ll2sRobinson (mp, ll, s, edge, scale);
         break;
 
     default:
-        fatalError ("ll2sRaw() bad map_proj %d", map_proj);
+        fatalError ("ll2sRaw() bad map_proj %d", mp.proj);
     }
 }
 
+/* same using the current projection state
+ */
+static void ll2sScaled (const LatLong &ll, SCoord &s, uint8_t edge, int scale)
+{
+    MapProj mp;
+    getMapProj (mp);
+    ll2sProj (mp, ll, s, edge, scale);
+}
+
 /* the first overload wants rads, the second wants fully populated LatLong
  */
 void ll2s (float lat, float lng, SCoord &s, uint8_t edge)
@@ -1146,6 +1428,18 @@ void ll2sRaw (const LatLong &ll, SCoord &s, uint8_t edge)
     ll2sScaled (ll, s, edge, tft.SCALESZ);
 }
 
+/* same but with projection state from getMapProj(), so safe to call off the loop() thread
+ */
+void ll2sRaw (const MapProj &mp, float lat, float lng, SCoord &s, uint8_t edge)
+{
+    LatLong ll;
+    ll.lat = lat;
+    ll.lat_d = rad2deg(ll.lat);
+    ll.lng = lng;
+    ll.lng_d = rad2deg(ll.lng);
+    ll2sProj (mp, ll, s, edge, tft.SCALESZ);
+}
+
 /* convert a screen coord to lat and long.
  * return whether location is really over valid map.
  */
@@ -1162,78 +1456,7 @@ bool s2ll (const SCoord &s, LatLong &ll)
     if (!overMap(s))
         return (false);
 
-    switch ((MapProjection)map_proj) {
-
-    case MAPP_AZIMUTHAL: {
-        // radius from center of point's hemisphere
-        bool on_right = s.x > map_b.x + map_b.w/2;
-        float dx = on_right ? s.x - (map_b.x + 3*map_b.w/4) : s.x - (map_b.x + map_b.w/4);
-        float dy = (map_b.y + map_b.h/2) - s.y;
-        float r2 = dx*dx + dy*dy;
-
-        // see if really on surface
-        float w2 = map_b.w*map_b.w/16;
-        if (r2 > w2)
-            return(false);
-
-        // use screen triangle to find globe
-        float b = sqrtf((float)r2/w2)*(M_PI_2F);
-        float A = (M_PI_2F) - atan2f (dy, dx);
-        float ca, B;
-        solveSphere (A, b, (on_right ? -1 : 1) * sdelat, cdelat, &ca, &B);
-        ll.lat = M_PI_2F - acosf(ca);
-        ll.lat_d = rad2deg(ll.lat);
-        ll.lng = fmodf (de_ll.lng + B + (on_right?6:5)*M_PIF, 2*M_PIF) - M_PIF;
-        ll.lng_d = rad2deg(ll.lng);
-
-        } break;
-
-    case MAPP_AZIM1: {
-
-        // radius from center
-        float dx = s.x - (map_b.x + map_b.w/2);
-        float dy = (map_b.y + map_b.h/2) - s.y;
-        float r2 = dx*dx + dy*dy;
-
-        // see if really on surface
-        float h2 = map_b.h*map_b.h/4;
-        if (r2 > h2)
-            return(false);
-
-        // use screen triangle to find globe
-        float b = powf((float)r2/h2, AZIM1_FISHEYE/2.0F) * M_PIF / AZIM1_ZOOM;     // /2 just for sqrt
-        float A = (M_PI_2F) - atan2f (dy, dx);
-        float ca, B;
-        solveSphere (A, b, sdelat, cdelat, &ca, &B);
-        ll.lat = M_PI_2F - acosf(ca);
-        ll.lat_d = rad2deg(ll.lat);
-        ll.lng = fmodf (de_ll.lng + B + 5*M_PIF, 2*M_PIF) - M_PIF;
-        ll.lng_d = rad2deg(ll.lng);
-
-        } break;
-
-    case MAPP_MERCATOR: {
-
-        // straight rectangular mercator projection
-        ll.lat_d = 180.0F*((map_b.y + map_b.h/2 - s.y)/(float)pan_zoom.zoom + pan_zoom.pan_y)/map_b.h;
-        ll.lng_d = 360.0F*((s.x - map_b.x - map_b.w/2)/(float)pan_zoom.zoom + pan_zoom.pan_x)/map_b.w;
-        if (core_map != CM_USER)
-            ll.lng_d += getCenterLng();
-        ll.normalize();
-
-        } break;
-
-    case MAPP_ROB:
-
-        return (s2llRobinson (s, ll));
-        break;
-
-    default:
-        fatalError ("s2ll() bad map_proj %d", map_proj);
-    }
-
-
-    return (true);
+    return (s2llProj (s, ll));
 }
 
 /* given numeric difference between two longitudes in degrees, return shortest diff
@@ -1261,9 +1484,11 @@ void drawMapCoord (const SCoord &s)
 {
     // draw one map pixel at full screen resolution. requires lat/lng gradients.
 
-    // find lat/lng at this screen location, bale if not over map
-    LatLong lls;
-    if (!s2ll(s,lls))
+    // find lat/lng at this screen location from the projection cache, bale if not over map
+    if (!overMap(s))
+        return;
+    const MapPixLL *lls = getMapPixLL (s);
+    if (!lls || lls->lat_d == MPLL_NONE)
         return; 
 
     /* even though we only draw one application point, s, plotEarth needs points r and d to
@@ -1273,21 +1498,20 @@ void drawMapCoord (const SCoord &s)
      *   d
      */
     SCoord sr, sd;
-    LatLong llr, lld;
     sr.x = s.x + 1;
     sr.y = s.y;
-    if (!s2ll(sr,llr))
+    const MapPixLL *llr = overMap(sr) ? getMapPixLL(sr) : NULL;
+    if (!llr || llr->lat_d == MPLL_NONE)
         llr = lls;
     sd.x = s.x;
     sd.y = s.y + 1;
-    if (!s2ll(sd,lld))
+    const MapPixLL *lld = overMap(sd) ? getMapPixLL(sd) : NULL;
+    if (!lld || lld->lat_d == MPLL_NONE)
         lld = lls;
 
     // find angle between subsolar point and any visible near this location
     // TODO: actually different at each subpixel, this causes striping
-    float clat = cosf(lls.lat);
-    float slat = sinf(lls.lat);
-    float cos_t = ssslat*slat + csslat*clat*cosf(sun_ss_ll.lng-lls.lng);
+    float cos_t = ssslat*lls->slat + csslat*lls->clat*cosf(sun_ss_ll.lng-deg2rad(lls->lng_d));
 
     // decide day, night or twilight
     float fract_day;
@@ -1303,8 +1527,8 @@ void drawMapCoord (const SCoord &s)
     }
 
     // draw the full res map point
-    tft.plotEarth (s.x, s.y, lls.lat_d, lls.lng_d, llr.lat_d - lls.lat_d, llr.lng_d - lls.lng_d,
-                    lld.lat_d - lls.lat_d, lld.lng_d - lls.lng_d, fract_day);
+    tft.plotEarth (s.x, s.y, lls->lat_d, lls->lng_d, llr->lat_d - lls->lat_d, llr->lng_d - lls->lng_d,
+                    lld->lat_d - lls->lat_d, lld->lng_d - lls->lng_d, fract_day);
 }
 
 /* draw sun symbol.
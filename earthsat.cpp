@@ -101,6 +101,7 @@ typedef struct {
     NV_Name nv_name;                                    // NV property for persistent name
     NV_Name nv_flags;                                   // NV property for persistent option flags
     ColorSelection cs;                                  // path control
+    uint32_t path_seq;                                  // bumped as each path is started or sat changes
 } SatState;
 static SatState sat_state[MAX_ACTIVE_SATS];             // [1].sat is set only if [0].sat is also set
 static bool new_pass;                                   // set when new pass is ready
@@ -187,6 +188,8 @@ static void unsetSat (SatState &s)
         free (s.path);
         s.path = NULL;
     }
+    s.n_path = 0;
+    s.path_seq++;                                       // orphan any path in progress
     for (int i = 0; i < N_FOOT; i++) {
         if (s.foot[i]) {
             free (s.foot[i]);
@@ -285,78 +288,26 @@ static void findNextPass (Satellite *sat, const char *name, time_t t, SatRiseSet
     // measure how long this takes
     uint32_t t0 = millis();
 
-    #define COARSE_DT   90L             // seconds/step forward for fast search
-    #define FINE_DT     (-2L)           // seconds/step backward for refined search
-    float pel;                          // previous elevation
-    long dt = COARSE_DT;                // search time step size, seconds
+    // search up to a few days ahead for the next two events (for example for moon), starting beyond any
+    // previous solution
+    #define PASS_T0_DT  2L              // search start after t, seconds
+    #define PASS_DAYS   2.0F            // search duration, days
     DateTime t_now = userDateTime(t);   // search starting time
-    DateTime t_srch = t_now + -FINE_DT; // search time, start beyond any previous solution
-    float tel, taz, trange, trate;      // target el and az, degrees
+    SatEvent ev[2];
+    int n_ev = findSatEvents (sat, obs, t_now + PASS_T0_DT, PASS_DAYS, ev, 2, rs.ever_up, rs.ever_down);
 
-    // init pel and make first step
-    sat->predict (t_srch);
-    sat->topo (obs, pel, taz, trange, trate);
-    t_srch += dt;
-
-    // search up to a few days ahead for next rise and set times (for example for moon)
+    // first event is a set if pass is in progress
     rs.set_ok = rs.rise_ok = false;
-    rs.ever_up = rs.ever_down = false;
-    while ((!rs.set_ok || !rs.rise_ok) && t_srch < t_now + 2.0F) {
-
-        // find circumstances at time t_srch
-        sat->predict (t_srch);
-        sat->topo (obs, tel, taz, trange, trate);
-
-        // check for rising or setting events
-        if (tel >= SAT_MIN_EL) {
-            rs.ever_up = true;
-            if (pel < SAT_MIN_EL) {
-                if (dt == FINE_DT) {
-                    // found a refined set event (recall we are going backwards),
-                    // record and resume forward time.
-                    rs.set_time = t_srch;
-                    rs.set_az = taz;
-                    rs.set_ok = true;
-                    dt = COARSE_DT;
-                    pel = tel;
-                } else if (!rs.rise_ok) {
-                    // found a coarse rise event, go back slower looking for better set
-                    dt = FINE_DT;
-                    pel = tel;
-                }
-            }
+    for (int i = 0; i < n_ev; i++) {
+        if (ev[i].rising) {
+            rs.rise_time = ev[i].t;
+            rs.rise_az = ev[i].az;
+            rs.rise_ok = true;
         } else {
-            rs.ever_down = true;
-            if (pel > SAT_MIN_EL) {
-                if (dt == FINE_DT) {
-                    // found a refined rise event (recall we are going backwards).
-                    // record and resume forward time but skip if set is within COARSE_DT because we
-                    // would jump over it and find the NEXT set.
-                    float check_tel, check_taz;
-                    DateTime check_set = t_srch + COARSE_DT;
-                    sat->predict (check_set);
-                    sat->topo (obs, check_tel, check_taz, trange, trate);
-                    if (check_tel >= SAT_MIN_EL) {
-                        rs.rise_time = t_srch;
-                        rs.rise_az = taz;
-                        rs.rise_ok = true;
-                    }
-                    // regardless, resume forward search
-                    dt = COARSE_DT;
-                    pel = tel;
-                } else if (!rs.set_ok) {
-                    // found a coarse set event, go back slower looking for better rise
-                    dt = FINE_DT;
-                    pel = tel;
-                }
-            }
+            rs.set_time = ev[i].t;
+            rs.set_az = ev[i].az;
+            rs.set_ok = true;
         }
-
-        // Serial.printf ("R %d S %d dt %ld from_now %8.3fs tel %g\n", rs.rise_ok, rs.set_ok, dt, SECSPERDAY*(t_srch - t_now), tel);
-
-        // advance time and save tel
-        t_srch += dt;
-        pel = tel;
     }
 
     // new pass ready
@@ -741,6 +692,14 @@ static void fatalSatError (const char *fmt, ...)
 }
 
 
+/* return how many days the elements of the named sat may be used either side of their epoch.
+ */
+static float satMaxTLEAge (const char *name)
+{
+    // N.B. can not use isSatMoon because sat_name is not set
+    return (strcasecmp(name,"Moon") == 0 ? 1.5F : maxTLEAgeDays());
+}
+
 /* return whether sat epoch is known to be good at the given time.
  */
 static bool satEpochOk (Satellite *sat, const char *name, time_t t)
@@ -750,9 +709,7 @@ static bool satEpochOk (Satellite *sat, const char *name, time_t t)
 
     DateTime t_now = userDateTime(t);
     DateTime t_sat = sat->epoch();
-
-    // N.B. can not use isSatMoon because sat_name is not set
-    float max_age = strcasecmp(name,"Moon") == 0 ? 1.5F : maxTLEAgeDays();
+    float max_age = satMaxTLEAge (name);
 
     bool ok = t_sat + max_age > t_now && t_now + max_age > t_sat;
 
@@ -1511,7 +1468,83 @@ void updateSatPass()
     }
 }
 
-/* compute satellite geocentric _path_ into path[] and footprint into s.foot[].
+/* one satellite path being computed on the task pool, see updateSatPath()
+ */
+typedef struct {
+    int sat_i;                                          // sat_state[] index
+    uint32_t seq;                                       // its path_seq when started
+    Satellite sat;                                      // private copy so predict() never races updateSatPass()
+    DateTime t;                                         // time at path[0]
+    float satlat, satlng;                               // location at t, rads
+    uint16_t max_path;                                  // n steps to show 1 rev
+    bool dashed;                                        // whether path is dashed
+    int lw;                                             // raw path line width
+    MapProj mp;                                         // map projection when started
+    SCoord *path;                                       // MAX_PATHPTS malloced when started
+    int n_path;                                         // n path[] used
+} SatPathJob;
+
+/* pool task to fill in a SatPathJob.
+ */
+static void satPathTask (void *arg)
+{
+    SatPathJob *jp = (SatPathJob *) arg;
+
+    float period = jp->sat.period();
+    float satlat = jp->satlat, satlng = jp->satlng;
+    DateTime t = jp->t;
+    jp->n_path = 0;
+
+    int dashed = 0;
+    for (uint16_t p = 0; p < jp->max_path; p++) {
+
+        // place dashed line points off screen courtesy overMap()
+        if (jp->dashed && (dashed++ & (MAX_PATHPTS>>5))) {        // first always on for center dot
+            jp->path[jp->n_path] = {OFFSCRN, OFFSCRN};
+        } else {
+            // compute next point along path
+            ll2sRaw (jp->mp, satlat, satlng, jp->path[jp->n_path], 2*jp->lw);   // allow for end dot
+        }
+
+        // skip duplicate points
+        if (jp->n_path == 0 || memcmp (&jp->path[jp->n_path], &jp->path[jp->n_path-1], sizeof(SCoord)))
+            jp->n_path++;
+
+        t += period/jp->max_path;   // show 1 rev
+        jp->sat.predict (t);
+        jp->sat.geo (satlat, satlng);
+    }
+}
+
+/* back on the loop() thread after satPathTask(): install the new path unless the sat or the map
+ * projection changed meanwhile.
+ */
+static void satPathDone (void *arg)
+{
+    SatPathJob *jp = (SatPathJob *) arg;
+    SatState &s = sat_state[jp->sat_i];
+    MapProj mp;
+    getMapProj (mp);
+
+    if (s.sat && jp->seq == s.path_seq && !memcmp (&mp, &jp->mp, sizeof(mp))) {
+        // Serial.printf ("%s n_path %u / %u\n", s.name, jp->n_path, MAX_PATHPTS);
+
+        // replace, reducing memory to only points actually used
+        free (s.path);
+        s.path = (SCoord *) realloc (jp->path, jp->n_path * sizeof(SCoord));
+        s.n_path = jp->n_path;
+
+        // set map name location
+        setSatMapNameLoc(s);
+    } else
+        free (jp->path);
+
+    delete jp;
+}
+
+/* compute satellite footprint into s.foot[] and start geocentric _path_ for s.path[].
+ * the path is computed on the task pool and replaces s.path when complete, usually well before the map
+ * sweep finishes, so the size of the path never holds up loop().
  * called once at the top of each map sweep.
  * the _pass_ is updated in updateSatPass().
  */
@@ -1529,12 +1562,6 @@ void updateSatPath()
 
         // from here we have a valid sat to report
 
-        // free s.path first since it was last to be malloced
-        if (s.path) {
-            free (s.path);
-            s.path = NULL;
-        }
-
         // fill s.foot
         time_t t_wo = nowWO();
         DateTime t = userDateTime(t_wo);
@@ -1545,51 +1572,23 @@ void updateSatPath()
             Serial.printf ("SAT: JD %.6f Lat %7.3f Lng %8.3f\n", t_wo/86400.0+2440587.5,
                                                         rad2deg(satlat), rad2deg(satlng));
         updateFootPrint (s, satlat, satlng);
-        updateClocks(false);
 
-        // start s.path max size, then reduce when know size needed
-        s.path = (SCoord *) malloc (MAX_PATHPTS * sizeof(SCoord));
-        if (!s.path)
+        // start path max size, satPathDone() reduces it when know size needed
+        SatPathJob *jp = new SatPathJob;
+        jp->path = (SCoord *) malloc (MAX_PATHPTS * sizeof(SCoord));
+        if (!jp->path)
             fatalError ("No memory for satellite path");
-
-        // decide line width, if used
-        int lw = getRawPathWidth(s.cs);
-
-        // fill s.path
-        float period = s.sat->period();
-        s.n_path = 0;
-
-        // moon is just the current location
-        uint16_t max_path = !strcasecmp (s.name, "Moon") ? 1 : MAX_PATHPTS;
-
-        int dashed = 0;
-        for (uint16_t p = 0; p < max_path; p++) {
-
-            // place dashed line points off screen courtesy overMap()
-            if (getPathDashed(s.cs) && (dashed++ & (MAX_PATHPTS>>5))) {   // first always on for center dot
-                s.path[s.n_path] = {OFFSCRN, OFFSCRN};
-            } else {
-                // compute next point along path
-                ll2sRaw (satlat, satlng, s.path[s.n_path], 2*lw);   // allow for end dot
-            }
-
-            // skip duplicate points
-            if (s.n_path == 0 || memcmp (&s.path[s.n_path], &s.path[s.n_path-1], sizeof(SCoord)))
-                s.n_path++;
-
-            t += period/max_path;   // show 1 rev
-            s.sat->predict (t);
-            s.sat->geo (satlat, satlng);
-        }
-
-        updateClocks(false);
-        // Serial.printf ("%s n_path %u / %u\n", s.name, s.n_path, MAX_PATHPTS);
-
-        // reduce memory to only points actually used
-        s.path = (SCoord *) realloc (s.path, s.n_path * sizeof(SCoord));
-
-        // set map name location
-        setSatMapNameLoc(s);
+        jp->sat_i = i;
+        jp->seq = ++s.path_seq;
+        jp->sat = *s.sat;
+        jp->t = t;
+        jp->satlat = satlat;
+        jp->satlng = satlng;
+        jp->max_path = !strcasecmp (s.name, "Moon") ? 1 : MAX_PATHPTS;     // moon is just the current location
+        jp->dashed = getPathDashed(s.cs);
+        jp->lw = getRawPathWidth(s.cs);
+        getMapProj (jp->mp);
+        runTask (satPathTask, satPathDone, jp);
     }
 }
 
@@ -1605,7 +1604,7 @@ void drawSatPathAndFoot()
 
         // draw path if on with arrows
         int pw = getRawPathWidth(s.cs);
-        if (s.show_path && pw) {
+        if (s.show_path && pw && s.n_path > 0) {                // path may still be on its way
             static const float cos_20 = 0.940F;
             static const float sin_20 = 0.342F;
             const bool dashed = getPathDashed(s.cs);
@@ -2000,59 +1999,57 @@ static int nextSatRSEvents (SatState &s, time_t **rises, float **raz, time_t **s
     // start now
     time_t t0 = nowWO();
     DateTime t0dt = userDateTime(t0);
-    time_t t = t0;
+    if (!satEpochOk(s.sat, s.name, t0))
+        return (0);
 
-    // make lists for duration of elements
+    // find every event in one sweep for as long as the elements remain good, allowing for at most one
+    // pass per orbit plus one per day for earth's rotation
+    float days = (s.sat->epoch() + satMaxTLEAge(s.name)) - t0dt;
+    int max_ev = 2*(int)(days*(fmaxf (1.0F/s.sat->period(), 1.0F) + 1.0F) + 2);
+    SatEvent *ev = (SatEvent *) malloc (max_ev * sizeof(SatEvent));
+    if (!ev)
+        fatalError ("No memory for %d sat events", max_ev);
+    bool ever_up, ever_down;
+    int n_ev = findSatEvents (s.sat, obs, t0dt, days, ev, max_ev, ever_up, ever_down);
+
+    // make lists of each rise followed by its set, skipping any pass already in progress
     int n_table = 0;
-    while (satEpochOk(s.sat, s.name, t)) {
-
-        SatRiseSet rs;
-        findNextPass (s.sat, s.name, t, rs);
+    for (int i = 0; i < n_ev - 1; i++) {
 
-        // avoid messy edge cases
-        if (rs.rise_ok && rs.set_ok) {
-
-            // UTC
-            time_t rt = t0 + SECSPERDAY*(rs.rise_time - t0dt);
-            time_t st = t0 + SECSPERDAY*(rs.set_time - t0dt);
-            int up = SECSPERDAY*(rs.set_time - rs.rise_time);
-
-            // avoid messy edge cases
-            if (up > 0) {
-
-                // init tables for realloc
-                if (n_table == 0) {
-                    *rises = NULL;
-                    *raz = NULL;
-                    *sets = NULL;
-                    *saz = NULL;
-                }
-
-                *rises = (time_t *) realloc (*rises, (n_table+1) * sizeof(time_t *));
-                *raz = (float *) realloc (*raz, (n_table+1) * sizeof(float *));
-                *sets = (time_t *) realloc (*sets, (n_table+1) * sizeof(time_t *));
-                *saz = (float *) realloc (*saz, (n_table+1) * sizeof(float *));
+        if (!ev[i].rising || ev[i+1].rising)
+            continue;
 
-                (*rises)[n_table] = rt;
-                (*raz)[n_table] = rs.rise_az;
-                (*sets)[n_table] = st;
-                (*saz)[n_table] = rs.set_az;
+        // UTC
+        time_t rt = t0 + SECSPERDAY*(ev[i].t - t0dt);
+        time_t st = t0 + SECSPERDAY*(ev[i+1].t - t0dt);
 
-                n_table++;
+        // avoid messy edge cases
+        if (st > rt) {
+
+            // init tables for realloc
+            if (n_table == 0) {
+                *rises = NULL;
+                *raz = NULL;
+                *sets = NULL;
+                *saz = NULL;
             }
 
-            // start next search half an orbit after set
-            t = st + s.sat->period()*SECSPERDAY/2;
+            *rises = (time_t *) realloc (*rises, (n_table+1) * sizeof(time_t));
+            *raz = (float *) realloc (*raz, (n_table+1) * sizeof(float));
+            *sets = (time_t *) realloc (*sets, (n_table+1) * sizeof(time_t));
+            *saz = (float *) realloc (*saz, (n_table+1) * sizeof(float));
 
-        } else if (!rs.ever_up || !rs.ever_down) {
+            (*rises)[n_table] = rt;
+            (*raz)[n_table] = ev[i].az;
+            (*sets)[n_table] = st;
+            (*saz)[n_table] = ev[i+1].az;
 
-            break;
+            n_table++;
         }
-
-        // don't go completely dead
-        updateClocks(false);
     }
 
+    free (ev);
+
     // return count
     return (n_table);
 }
@@ -0,0 +1,759 @@
+/* asynchronous HTTP fetch engine.
+ *
+ * one worker thread carries every outstanding request concurrently using non-blocking sockets driven by
+ * epoll on linux, poll elsewhere. the complete response, header and all, is spooled to an unlinked temp
+ * file which is handed back rewound, so the caller may parse it with the usual WiFiClient(fd) and
+ * getTCPLine() code without ever waiting on the network itself.
+ *
+ * main thread usage:
+ *   id = startFetch (host, port, request);     begin, request is the complete HTTP request text
+ *   checkFetch (id, &fd)                       FETCH_PENDING, or FETCH_OK with fd set, or FETCH_FAILED.
+ *                                              id is retired by any return other than FETCH_PENDING.
+ *   waitFetch (id, &fd)                        same but keep the clocks running until not pending.
+ *   cancelFetch (id)                           abandon id, any partial response is discarded.
+ *
+ * to build and run a stand-alone test against a local HTTP stand-in server:
+ *    g++ -Wall -O2 -D_UNIT_TEST -o x.fetch fetch.cpp -lpthread
+ *    ./x.fetch
+ */
+
+#if defined (_UNIT_TEST)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <pthread.h>
+#include <poll.h>
+#include <netdb.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#if defined(__linux__)
+#define _IS_LINUX
+#endif
+
+typedef enum {
+    FETCH_PENDING,
+    FETCH_OK,
+    FETCH_FAILED,
+} FetchState;
+
+#define Serial_printf   printf
+static bool fetchDebug (void) { return (false); }
+static void updateClocks (bool) { }
+
+#else // !_UNIT_TEST
+
+#include "HamClock.h"
+
+#define Serial_printf   Serial.printf
+static bool fetchDebug (void) { return (debugLevel (DEBUG_NET, 1)); }
+
+#endif // _UNIT_TEST
+
+#include <poll.h>
+#if defined(_IS_LINUX)
+#include <sys/epoll.h>
+#endif
+
+
+#define FETCH_TIMEOUT   30                      // max seconds for any one request
+#define FETCH_NEVENTS   32                      // max io events serviced per wait
+#define FETCH_WAIT_MS   1000                    // max io wait so deadlines are checked regularly
+
+// request progress
+typedef enum {
+    FP_RESOLVE,                                 // waiting for worker to look up host and connect
+    FP_CONNECT,                                 // non-blocking connect in progress
+    FP_SEND,                                    // sending request
+    FP_RECV,                                    // collecting response
+} FetchPhase;
+
+// one request.
+// N.B. while state is FETCH_PENDING only the worker touches it except abandoned, which is under fetch_lock.
+typedef struct {
+    int id;                                     // handle given to caller, > 0
+    FetchState state;                           // changed only under fetch_lock
+    FetchPhase phase;                           // worker progress
+    bool abandoned;                             // cancelled while pending, worker disposes
+    char *host;                                 // malloced server name
+    int port;                                   // server port
+    char *req;                                  // malloced complete request text
+    int req_len, req_sent;                      // request length and n already sent
+    int sock;                                   // server socket, or -1
+    int fd;                                     // unlinked temp file collecting response, or -1
+    long n_rcvd;                                // response bytes so far
+    time_t deadline;                            // give up if still pending after this time
+} FetchReq;
+
+static FetchReq **fetch_reqs;                   // malloced list of malloced requests, done or not
+static int n_fetch_reqs;                        // n in list
+static int fetch_next_id = 1;                   // next id to assign
+static pthread_mutex_t fetch_lock = PTHREAD_MUTEX_INITIALIZER;
+static int fetch_wake[2] = {-1, -1};            // pipe written by main to wake the worker
+static bool fetch_running;                      // set once worker is started
+#if defined(_IS_LINUX)
+static int fetch_epoll = -1;                    // epoll instance
+#endif
+
+
+/* find id in fetch_reqs[], return index or -1.
+ * N.B. caller must hold fetch_lock
+ */
+static int findFetch (int id)
+{
+    for (int i = 0; i < n_fetch_reqs; i++)
+        if (fetch_reqs[i]->id == id)
+            return (i);
+    return (-1);
+}
+
+/* remove fetch_reqs[i] from the list and free it, closing anything still open.
+ * N.B. caller must hold fetch_lock
+ */
+static void freeFetch (int i)
+{
+    FetchReq *fr = fetch_reqs[i];
+    if (fr->sock >= 0)
+        close (fr->sock);
+    if (fr->fd >= 0)
+        close (fr->fd);
+    free (fr->host);
+    free (fr->req);
+    free (fr);
+    fetch_reqs[i] = fetch_reqs[--n_fetch_reqs];
+}
+
+/* add fr->sock to the set being watched, or modify it, according to fr->phase.
+ */
+static void watchFetch (FetchReq *fr, bool add)
+{
+#if defined(_IS_LINUX)
+    struct epoll_event ev;
+    memset (&ev, 0, sizeof(ev));
+    ev.events = fr->phase == FP_RECV ? EPOLLIN : EPOLLOUT;
+    ev.data.ptr = fr;
+    if (epoll_ctl (fetch_epoll, add ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, fr->sock, &ev) < 0)
+        Serial_printf ("Fetch: epoll_ctl(%d): %s\n", fr->sock, strerror(errno));
+#else
+    // poll() rebuilds its set from fetch_reqs[] each time
+    (void) fr;
+    (void) add;
+#endif
+}
+
+/* wait up to ms for any sockets to be ready, return each in ready[] and the count.
+ */
+static int waitFetchIO (FetchReq *ready[FETCH_NEVENTS], int ms)
+{
+    int n_ready = 0;
+
+#if defined(_IS_LINUX)
+
+    struct epoll_event evs[FETCH_NEVENTS];
+    int n = epoll_wait (fetch_epoll, evs, FETCH_NEVENTS, ms);
+    if (n < 0 && errno != EINTR)
+        Serial_printf ("Fetch: epoll_wait: %s\n", strerror(errno));
+    for (int i = 0; i < n; i++) {
+        if (evs[i].data.ptr)
+            ready[n_ready++] = (FetchReq *) evs[i].data.ptr;
+        else {
+            char drain[64];
+            (void) !read (fetch_wake[0], drain, sizeof(drain));
+        }
+    }
+
+#else
+
+    // build the poll set from all sockets in progress, plus the wake pipe
+    struct pollfd pfds[FETCH_NEVENTS+1];
+    FetchReq *pfrs[FETCH_NEVENTS];
+    int n_pfds = 0;
+    pfds[n_pfds].fd = fetch_wake[0];
+    pfds[n_pfds].events = POLLIN;
+    n_pfds++;
+    pthread_mutex_lock (&fetch_lock);
+    for (int i = 0; i < n_fetch_reqs && n_pfds <= FETCH_NEVENTS; i++) {
+        FetchReq *fr = fetch_reqs[i];
+        if (fr->state == FETCH_PENDING && fr->phase != FP_RESOLVE && fr->sock >= 0) {
+            pfrs[n_pfds-1] = fr;
+            pfds[n_pfds].fd = fr->sock;
+            pfds[n_pfds].events = fr->phase == FP_RECV ? POLLIN : POLLOUT;
+            n_pfds++;
+        }
+    }
+    pthread_mutex_unlock (&fetch_lock);
+
+    int n = poll (pfds, n_pfds, ms);
+    if (n < 0 && errno != EINTR)
+        Serial_printf ("Fetch: poll: %s\n", strerror(errno));
+    if (n > 0) {
+        if (pfds[0].revents) {
+            char drain[64];
+            (void) !read (fetch_wake[0], drain, sizeof(drain));
+        }
+        for (int i = 1; i < n_pfds; i++)
+            if (pfds[i].revents)
+                ready[n_ready++] = pfrs[i-1];
+    }
+
+#endif
+
+    return (n_ready);
+}
+
+/* worker is finished with fr: close the socket and publish the final state, or dispose of fr if the caller
+ * abandoned it meanwhile. on success the temp file is rewound for the caller.
+ * N.B. caller must hold fetch_lock. fr may be freed on return.
+ */
+static void finishFetchLocked (FetchReq *fr, FetchState state, const char *why)
+{
+    if (fr->sock >= 0) {
+#if defined(_IS_LINUX)
+        (void) epoll_ctl (fetch_epoll, EPOLL_CTL_DEL, fr->sock, NULL);
+#endif
+        close (fr->sock);
+        fr->sock = -1;
+    }
+
+    if (state == FETCH_OK) {
+        if (lseek (fr->fd, 0, SEEK_SET) < 0) {
+            why = strerror(errno);
+            state = FETCH_FAILED;
+        }
+    }
+
+    if (state == FETCH_FAILED)
+        Serial_printf ("Fetch: %d %s:%d failed: %s\n", fr->id, fr->host, fr->port, why);
+    else if (fetchDebug())
+        Serial_printf ("Fetch: %d %s:%d %ld bytes\n", fr->id, fr->host, fr->port, fr->n_rcvd);
+
+    if (fr->abandoned)
+        freeFetch (findFetch (fr->id));
+    else
+        fr->state = state;
+}
+
+/* same as finishFetchLocked() for use without fetch_lock.
+ */
+static void finishFetch (FetchReq *fr, FetchState state, const char *why)
+{
+    pthread_mutex_lock (&fetch_lock);
+    finishFetchLocked (fr, state, why);
+    pthread_mutex_unlock (&fetch_lock);
+}
+
+/* look up fr->host and begin a non-blocking connect.
+ * N.B. getaddrinfo() can block so this is called without fetch_lock.
+ */
+static void connectFetch (FetchReq *fr)
+{
+    struct addrinfo hints, *aip;
+    char port_str[16];
+    memset (&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    snprintf (port_str, sizeof(port_str), "%d", fr->port);
+    int error = getaddrinfo (fr->host, port_str, &hints, &aip);
+    if (error) {
+        finishFetch (fr, FETCH_FAILED, gai_strerror(error));
+        return;
+    }
+
+    // temp file to collect the response
+    FILE *tfp = tmpfile();
+    if (tfp) {
+        fr->fd = dup (fileno (tfp));
+        fclose (tfp);
+    }
+    if (fr->fd < 0) {
+        freeaddrinfo (aip);
+        finishFetch (fr, FETCH_FAILED, "no temp file");
+        return;
+    }
+
+    fr->sock = socket (aip->ai_family, aip->ai_socktype, aip->ai_protocol);
+    if (fr->sock < 0) {
+        freeaddrinfo (aip);
+        finishFetch (fr, FETCH_FAILED, strerror(errno));
+        return;
+    }
+    fcntl (fr->sock, F_SETFL, fcntl (fr->sock, F_GETFL, 0) | O_NONBLOCK);
+    fcntl (fr->sock, F_SETFD, FD_CLOEXEC);
+    fcntl (fr->fd, F_SETFD, FD_CLOEXEC);
+
+    int cs = connect (fr->sock, aip->ai_addr, aip->ai_addrlen);
+    freeaddrinfo (aip);
+    if (cs < 0 && errno != EINPROGRESS) {
+        finishFetch (fr, FETCH_FAILED, strerror(errno));
+        return;
+    }
+
+    // writable means connected, or not
+    fr->phase = FP_CONNECT;
+    watchFetch (fr, true);
+}
+
+/* make whatever progress is possible on fr now that its socket is ready.
+ */
+static void serviceFetch (FetchReq *fr)
+{
+    switch (fr->phase) {
+
+    case FP_RESOLVE:
+        break;
+
+    case FP_CONNECT: {
+        int err = 0;
+        socklen_t len = sizeof(err);
+        if (getsockopt (fr->sock, SOL_SOCKET, SO_ERROR, &err, &len) < 0)
+            err = errno;
+        if (err) {
+            finishFetch (fr, FETCH_FAILED, strerror(err));
+            break;
+        }
+        fr->phase = FP_SEND;
+        }
+        // fallthru now that connected
+
+    case FP_SEND: {
+        int nw = write (fr->sock, fr->req + fr->req_sent, fr->req_len - fr->req_sent);
+        if (nw < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                finishFetch (fr, FETCH_FAILED, strerror(errno));
+            break;
+        }
+        fr->req_sent += nw;
+        if (fr->req_sent == fr->req_len) {
+            fr->phase = FP_RECV;
+            watchFetch (fr, false);
+        }
+        } break;
+
+    case FP_RECV: {
+        char buf[16384];
+        int nr = read (fr->sock, buf, sizeof(buf));
+        if (nr < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                finishFetch (fr, FETCH_FAILED, strerror(errno));
+        } else if (nr == 0) {
+            finishFetch (fr, fr->n_rcvd > 0 ? FETCH_OK : FETCH_FAILED, "empty response");
+        } else if (write (fr->fd, buf, nr) != nr) {
+            finishFetch (fr, FETCH_FAILED, "temp file full");
+        } else {
+            fr->n_rcvd += nr;
+        }
+        } break;
+    }
+}
+
+/* worker thread: forever start new requests, service those in progress, retire those timed out or
+ * abandoned.
+ */
+static void *fetchThread (void *unused)
+{
+    (void) unused;
+
+    for (;;) {
+
+        // connect any new requests, one at a time so the lock is not held during getaddrinfo()
+        for (;;) {
+            FetchReq *fr = NULL;
+            pthread_mutex_lock (&fetch_lock);
+            for (int i = 0; i < n_fetch_reqs && !fr; i++) {
+                FetchReq *fri = fetch_reqs[i];
+                if (fri->state == FETCH_PENDING && fri->phase == FP_RESOLVE && !fri->abandoned)
+                    fr = fri;
+            }
+            pthread_mutex_unlock (&fetch_lock);
+            if (!fr)
+                break;
+            connectFetch (fr);
+        }
+
+        // service whatever is ready
+        FetchReq *ready[FETCH_NEVENTS];
+        int n_ready = waitFetchIO (ready, FETCH_WAIT_MS);
+        for (int i = 0; i < n_ready; i++)
+            serviceFetch (ready[i]);
+
+        // dispose of abandoned requests and fail those past their deadline, all without releasing the
+        // lock so the list can not change beneath us. walk backwards because freeFetch() swaps in the last.
+        time_t now = time(NULL);
+        pthread_mutex_lock (&fetch_lock);
+        for (int i = n_fetch_reqs; --i >= 0; ) {
+            FetchReq *fr = fetch_reqs[i];
+            if (fr->state != FETCH_PENDING)
+                continue;
+            if (fr->abandoned) {
+#if defined(_IS_LINUX)
+                if (fr->sock >= 0)
+                    (void) epoll_ctl (fetch_epoll, EPOLL_CTL_DEL, fr->sock, NULL);
+#endif
+                freeFetch (i);
+            } else if (now > fr->deadline) {
+                finishFetchLocked (fr, FETCH_FAILED, "timed out");
+            }
+        }
+        pthread_mutex_unlock (&fetch_lock);
+    }
+
+    return (NULL);
+}
+
+/* start the worker thread if not already, return whether it's running.
+ * N.B. caller must hold fetch_lock
+ */
+static bool startFetchThread (void)
+{
+    if (fetch_running)
+        return (true);
+
+    if (pipe (fetch_wake) < 0) {
+        Serial_printf ("Fetch: pipe: %s\n", strerror(errno));
+        return (false);
+    }
+    fcntl (fetch_wake[0], F_SETFL, fcntl (fetch_wake[0], F_GETFL, 0) | O_NONBLOCK);
+    fcntl (fetch_wake[1], F_SETFL, fcntl (fetch_wake[1], F_GETFL, 0) | O_NONBLOCK);
+
+#if defined(_IS_LINUX)
+    fetch_epoll = epoll_create1 (EPOLL_CLOEXEC);
+    if (fetch_epoll < 0) {
+        Serial_printf ("Fetch: epoll_create: %s\n", strerror(errno));
+        return (false);
+    }
+    struct epoll_event ev;
+    memset (&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL;                         // NULL marks the wake pipe
+    if (epoll_ctl (fetch_epoll, EPOLL_CTL_ADD, fetch_wake[0], &ev) < 0) {
+        Serial_printf ("Fetch: epoll_ctl(wake): %s\n", strerror(errno));
+        return (false);
+    }
+#endif
+
+    pthread_t tid;
+    int e = pthread_create (&tid, NULL, fetchThread, NULL);
+    if (e) {
+        Serial_printf ("Fetch: pthread_create: %s\n", strerror(e));
+        return (false);
+    }
+    pthread_detach (tid);
+
+    fetch_running = true;
+    return (true);
+}
+
+/* poke the worker so it notices a change promptly
+ */
+static void wakeFetchThread (void)
+{
+    (void) !write (fetch_wake[1], "x", 1);
+}
+
+/* begin fetching the response to the given complete HTTP request from host:port in the background.
+ * return id for use with checkFetch() et al, or 0 if can not start at all.
+ */
+int startFetch (const char *host, int port, const char *request)
+{
+    FetchReq *fr = (FetchReq *) calloc (1, sizeof(FetchReq));
+    if (!fr)
+        return (0);
+    fr->state = FETCH_PENDING;
+    fr->phase = FP_RESOLVE;
+    fr->host = strdup (host);
+    fr->port = port;
+    fr->req = strdup (request);
+    fr->req_len = strlen (request);
+    fr->sock = -1;
+    fr->fd = -1;
+    fr->deadline = time(NULL) + FETCH_TIMEOUT;
+
+    pthread_mutex_lock (&fetch_lock);
+    if (!startFetchThread()) {
+        pthread_mutex_unlock (&fetch_lock);
+        free (fr->host);
+        free (fr->req);
+        free (fr);
+        return (0);
+    }
+    fr->id = fetch_next_id++;
+    if (fetch_next_id <= 0)
+        fetch_next_id = 1;
+    fetch_reqs = (FetchReq **) realloc (fetch_reqs, (n_fetch_reqs+1)*sizeof(FetchReq *));
+    fetch_reqs[n_fetch_reqs++] = fr;
+    int id = fr->id;
+    pthread_mutex_unlock (&fetch_lock);
+
+    if (fetchDebug())
+        Serial_printf ("Fetch: %d started %s:%d\n", id, host, port);
+
+    wakeFetchThread();
+    return (id);
+}
+
+/* return the state of the given fetch without waiting.
+ * if FETCH_OK *fd is a rewound file containing the complete response, caller must close it.
+ * any state other than FETCH_PENDING retires id.
+ */
+FetchState checkFetch (int id, int *fd)
+{
+    FetchState state = FETCH_FAILED;
+
+    pthread_mutex_lock (&fetch_lock);
+    int i = findFetch (id);
+    if (i >= 0) {
+        FetchReq *fr = fetch_reqs[i];
+        state = fr->state;
+        if (state == FETCH_OK) {
+            *fd = fr->fd;
+            fr->fd = -1;                        // now belongs to caller
+        }
+        if (state != FETCH_PENDING)
+            freeFetch (i);
+    }
+    pthread_mutex_unlock (&fetch_lock);
+
+    return (state);
+}
+
+/* same as checkFetch() but wait while pending, keeping the clocks running meanwhile.
+ */
+FetchState waitFetch (int id, int *fd)
+{
+    FetchState state;
+    while ((state = checkFetch (id, fd)) == FETCH_PENDING) {
+        updateClocks (false);
+        usleep (10000);
+    }
+    return (state);
+}
+
+/* abandon the given fetch, discarding anything received so far.
+ */
+void cancelFetch (int id)
+{
+    pthread_mutex_lock (&fetch_lock);
+    int i = findFetch (id);
+    if (i >= 0) {
+        if (fetch_reqs[i]->state == FETCH_PENDING)
+            fetch_reqs[i]->abandoned = true;    // worker disposes
+        else
+            freeFetch (i);
+    }
+    pthread_mutex_unlock (&fetch_lock);
+
+    wakeFetchThread();
+}
+
+
+
+#if defined (_UNIT_TEST)
+
+/* local HTTP stand-in: GET /<delay_ms>/<n_lines> waits delay_ms then returns n_lines numbered lines.
+ */
+
+static void *serveOne (void *arg)
+{
+    int s = (int)(long)arg;
+
+    // read request through the blank line
+    char req[1024];
+    int n = 0;
+    while (n < (int)sizeof(req)-1) {
+        int nr = read (s, req+n, sizeof(req)-1-n);
+        if (nr <= 0)
+            break;
+        n += nr;
+        req[n] = '\0';
+        if (strstr (req, "\r\n\r\n"))
+            break;
+    }
+    req[n] = '\0';
+
+    int delay_ms = 0, n_lines = 0;
+    if (sscanf (req, "GET /%d/%d", &delay_ms, &n_lines) == 2) {
+        usleep (delay_ms*1000);
+        FILE *fp = fdopen (s, "w");
+        fprintf (fp, "HTTP/1.0 200 OK\r\nContent-Type: text/plain\r\n\r\n");
+        for (int i = 0; i < n_lines; i++)
+            fprintf (fp, "line %d of %d\n", i, n_lines);
+        fclose (fp);
+    } else
+        close (s);
+
+    return (NULL);
+}
+
+static void *serveAll (void *arg)
+{
+    int ls = (int)(long)arg;
+    for (;;) {
+        int s = accept (ls, NULL, NULL);
+        if (s < 0)
+            continue;
+        pthread_t tid;
+        pthread_create (&tid, NULL, serveOne, (void*)(long)s);
+        pthread_detach (tid);
+    }
+    return (NULL);
+}
+
+static double secsSince (const struct timeval &t0)
+{
+    struct timeval t1;
+    gettimeofday (&t1, NULL);
+    return ((t1.tv_sec - t0.tv_sec) + (t1.tv_usec - t0.tv_usec)/1e6);
+}
+
+/* check the response in fd is a valid 200 with n_lines numbered lines, close fd and return whether ok.
+ */
+static bool checkResponse (int fd, int n_lines)
+{
+    FILE *fp = fdopen (fd, "r");
+    char line[200];
+    bool ok = fgets (line, sizeof(line), fp) && strncmp (line, "HTTP/1.0 200", 12) == 0;
+    while (ok && fgets (line, sizeof(line), fp) && strcmp (line, "\r\n") != 0)
+        continue;
+    int i;
+    for (i = 0; ok && fgets (line, sizeof(line), fp); i++) {
+        int li, ln;
+        if (sscanf (line, "line %d of %d", &li, &ln) != 2 || li != i || ln != n_lines)
+            ok = false;
+    }
+    fclose (fp);
+    return (ok && i == n_lines);
+}
+
+int main (int ac, char *av[])
+{
+    (void) ac; (void) av;
+
+    // start stand-in server on an ephemeral localhost port
+    int ls = socket (AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in sa;
+    memset (&sa, 0, sizeof(sa));
+    sa.sin_family = AF_INET;
+    sa.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+    socklen_t sa_len = sizeof(sa);
+    if (bind (ls, (struct sockaddr *)&sa, sizeof(sa)) < 0 || listen (ls, 64) < 0
+                                || getsockname (ls, (struct sockaddr *)&sa, &sa_len) < 0) {
+        printf ("server: %s\n", strerror(errno));
+        return (1);
+    }
+    int port = ntohs (sa.sin_port);
+    pthread_t tid;
+    pthread_create (&tid, NULL, serveAll, (void*)(long)ls);
+    printf ("stand-in server on port %d\n", port);
+
+    int n_bad = 0;
+
+    // many slow requests concurrently: total time should be about one delay, not the sum
+    const int N_CONC = 20;
+    const int DELAY_MS = 500;
+    int ids[N_CONC];
+    struct timeval t0;
+    gettimeofday (&t0, NULL);
+    for (int i = 0; i < N_CONC; i++) {
+        char req[200];
+        snprintf (req, sizeof(req), "GET /%d/%d HTTP/1.0\r\nHost: localhost\r\n\r\n", DELAY_MS, 100*(i+1));
+        ids[i] = startFetch ("localhost", port, req);
+    }
+    printf ("started %d fetches in %.3f s\n", N_CONC, secsSince(t0));
+    int n_done = 0;
+    int n_polls = 0;
+    while (n_done < N_CONC) {
+        for (int i = 0; i < N_CONC; i++) {
+            if (ids[i] == 0)
+                continue;
+            int fd;
+            FetchState fs = checkFetch (ids[i], &fd);
+            if (fs == FETCH_PENDING)
+                continue;
+            if (fs != FETCH_OK || !checkResponse (fd, 100*(i+1))) {
+                printf ("fetch %d: bad response\n", i);
+                n_bad++;
+            }
+            ids[i] = 0;
+            n_done++;
+        }
+        n_polls++;
+        usleep (1000);
+    }
+    double dt = secsSince(t0);
+    printf ("%d concurrent %d ms fetches completed in %.3f s (serial would be %.1f s), %d polls\n",
+                N_CONC, DELAY_MS, dt, N_CONC*DELAY_MS/1000.0, n_polls);
+    if (dt > 2.0*DELAY_MS/1000.0) {
+        printf ("not concurrent\n");
+        n_bad++;
+    }
+
+    // a large response
+    int fd;
+    int id = startFetch ("localhost", port, "GET /0/200000 HTTP/1.0\r\n\r\n");
+    if (waitFetch (id, &fd) != FETCH_OK || !checkResponse (fd, 200000)) {
+        printf ("large fetch failed\n");
+        n_bad++;
+    } else
+        printf ("large fetch ok\n");
+
+    // refused: a port that was bound but never listened
+    int cs = socket (AF_INET, SOCK_STREAM, 0);
+    sa.sin_port = 0;
+    sa_len = sizeof(sa);
+    (void) bind (cs, (struct sockaddr *)&sa, sizeof(sa));
+    (void) getsockname (cs, (struct sockaddr *)&sa, &sa_len);
+    id = startFetch ("localhost", ntohs (sa.sin_port), "GET /0/1 HTTP/1.0\r\n\r\n");
+    if (waitFetch (id, &fd) != FETCH_FAILED) {
+        printf ("refused fetch did not fail\n");
+        n_bad++;
+    } else
+        printf ("refused fetch failed as expected\n");
+    close (cs);
+
+    // unknown host
+    id = startFetch ("no.such.host.invalid", 80, "GET / HTTP/1.0\r\n\r\n");
+    if (waitFetch (id, &fd) != FETCH_FAILED) {
+        printf ("bogus host did not fail\n");
+        n_bad++;
+    } else
+        printf ("bogus host failed as expected\n");
+
+    // cancel requests at all stages including as they finish, every one must still be disposed
+    const int N_CANCEL = 50;
+    for (int i = 0; i < N_CANCEL; i++) {
+        int cid = startFetch ("localhost", port, "GET /0/100 HTTP/1.0\r\n\r\n");
+        usleep (i*100);
+        cancelFetch (cid);
+    }
+    int n_left = -1;
+    for (int i = 0; i < 200 && n_left != 0; i++) {
+        usleep (10000);
+        pthread_mutex_lock (&fetch_lock);
+        n_left = n_fetch_reqs;
+        pthread_mutex_unlock (&fetch_lock);
+    }
+    if (n_left != 0) {
+        printf ("%d cancelled fetches never disposed\n", n_left);
+        n_bad++;
+    } else
+        printf ("%d cancelled fetches all disposed\n", N_CANCEL);
+
+    // unknown id
+    if (checkFetch (12345, &fd) != FETCH_FAILED) {
+        printf ("unknown id did not fail\n");
+        n_bad++;
+    }
+
+    printf ("%s\n", n_bad ? "FAIL" : "PASS");
+    return (n_bad ? 1 : 0);
+}
+
+#endif // _UNIT_TEST
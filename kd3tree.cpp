@@ -1,11 +1,25 @@
 /* kd tree specifically for fast nearest-neighbor of lat and long.
  *
- * inspired by https://rosettacode.org/wiki/K-d_tree
+ * points are stored as xyz on the unit sphere so straight-line chord distance sorts the same as great
+ * circle distance and no trig is needed while searching.
  *
- * usage: call mkKD3NodeTree() once then nearestKD3Node() for each lookup; see unit test for usage.
+ * the tree is implicit: pts[] is arranged so the node for range [lo,hi) is at mid = lo+(hi-lo)/2, its left
+ * subtree is [lo,mid) and its right subtree is [mid+1,hi). each node splits on whichever axis its range
+ * spans most widely, recorded in what would otherwise be struct padding. no pointers are kept so the whole
+ * tree is one contiguous array that may be realloced freely.
  *
- * to build and run a stand-alone main test:
- *    g++ -Wall -O2 -D_UNIT_TEST -o x.kd3tree kd3tree.cpp && ./x.kd3tree 
+ * usage:
+ *   bulk:        allocKD3Points(), fill in each with ll2KD3Point() and data, then buildKD3Tree().
+ *   incremental: addKD3Point(). new points are searched linearly until enough collect to warrant a rebuild.
+ *   queries:     nearestKD3Point(), nearestKD3PointFilter(), kNearestKD3Points(), radiusKD3Points(),
+ *                nearestKD3Batch(). see unit test for usage.
+ *
+ * the original pointer tree, inspired by https://rosettacode.org/wiki/K-d_tree, lives on in the unit test
+ * as the benchmark reference.
+ *
+ * to build and run a stand-alone main test and benchmark on the given cities2.txt file, else the one
+ * cached in ~/.hamclock, else random points:
+ *    g++ -Wall -O2 -D_UNIT_TEST -o x.kd3tree kd3tree.cpp && ./x.kd3tree [cities2.txt]
  */
 
 
@@ -17,10 +31,13 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
 #include <math.h>
+#include <errno.h>
 #include <time.h>
 #include <sys/time.h>
+#include <unistd.h>
 
 
 #define _IS_UNIX
@@ -35,17 +52,26 @@ typedef struct {
 #define ERAD_M  3959.0F                 // earth radius, miles
 
 
- 
+
 #define deg2rad(d)      ((M_PIF/180)*(d))
 #define rad2deg(d)      ((180/M_PIF)*(d))
 
-struct kd_node_t {
+static void fatalError (const char *fmt, ...) { printf ("%s\n", fmt); exit(1); }
+
+typedef struct {
     float s[3];                         // xyz coords on unit sphere
-    struct kd_node_t *left, *right;     // branches
+    uint8_t axis;                       // split axis if in tree, fits in padding
     void *data;                         // user data
-};
- 
-typedef struct kd_node_t KD3Node;
+} KD3Point;
+
+typedef struct {
+    KD3Point *pts;                      // malloced, [0,n_tree) in tree order then any pending
+    int n_pts;                          // n pts[] in use
+    int n_tree;                         // n pts[] arranged as tree, rest are pending a rebuild
+    int n_malloced;                     // n pts[] malloced
+} KD3Tree;
+
+typedef bool (*KD3Filter)(const KD3Point *pp, void *arg);
 
 
 #else // !_UNIT_TEST
@@ -59,21 +85,421 @@ typedef struct kd_node_t KD3Node;
 
 #if defined(_IS_UNIX)
 
+// rebuild once pending points exceed this many or 1/KD3_PENDFRAC of the tree, whichever is more
+#define KD3_MINPEND     32
+#define KD3_PENDFRAC    8
+
+// points sampled to choose each split axis, all of them in ranges smaller than this
+#define KD3_NSPREAD     512
+
 // handy
 static float sqr(float a) { return (a*a); }
 
 
-/* return distance metric between two nodes
+/* state shared by one search of the tree.
+ * found[] holds the best n so far in increasing distance unless all_within, then they are in tree order.
+ */
+typedef struct {
+    float s[3];                         // query location
+    KD3Filter filter;                   // optional acceptance test
+    void *arg;                          // passed to filter
+    const KD3Point **found;             // caller's array of results
+    float *found_d2;                    // distance to each found[], unless NULL
+    int max_found;                      // room in found[]
+    int n_found;                        // n found so far, may exceed max_found if all_within
+    bool all_within;                    // true: count everything within max_d2; false: keep nearest max_found
+    float max_d2;                       // prune anything farther than this
+} KD3Query;
+
+
+/* return square of chord distance between two points on the unit sphere
+ */
+static float kd3dist2 (const float a[3], const float b[3])
+{
+    return (sqr(a[0] - b[0]) + sqr(a[1] - b[1]) + sqr(a[2] - b[2]));
+}
+
+/* convert square chord distance on unit sphere to earth surface miles
+ */
+static float kd3d2Miles (float d2)
+{
+    float c = sqrtf(d2);
+    return (c >= 2 ? M_PIF*ERAD_M : 2*asinf(c/2)*ERAD_M);
+}
+
+/* convert earth surface miles to square chord distance on unit sphere
+ */
+static float kd3Miles2d2 (float miles)
+{
+    float ang = miles/ERAD_M;
+    return (ang >= M_PIF ? 4.0F : sqr(2*sinf(ang/2)));
+}
+
+/* convert ll to xyz on the unit sphere
+ */
+static void ll2xyz (const LatLong &ll, float s[3])
+{
+    float clat = cosf(ll.lat);
+    s[0] = clat*cosf(ll.lng);
+    s[1] = clat*sinf(ll.lng);
+    s[2] = sinf(ll.lat);
+}
+
+static void kd3swap (KD3Point *x, KD3Point *y)
+{
+    KD3Point tmp = *x;
+    *x = *y;
+    *y = tmp;
+}
+
+/* partially sort p[lo,hi) on the given axis such that p[k] is where it would be if fully sorted and
+ * everything before it is <= and everything after it is >=. like std::nth_element: average O(hi-lo).
+ * N.B. Hoare partition stops on values equal to the pivot so long runs of equal values stay balanced.
+ */
+static void selectKD3 (KD3Point *p, int lo, int hi, int k, int axis)
+{
+    while (hi - lo > 2) {
+
+        // median of three pivot, which is always present in the range so the scans below stop
+        float a = p[lo].s[axis];
+        float b = p[lo + (hi-lo)/2].s[axis];
+        float c = p[hi-1].s[axis];
+        float pivot = a < b ? (b < c ? b : (a < c ? c : a)) : (a < c ? a : (b < c ? c : b));
+
+        // partition into [lo,j] <= pivot, (j,i) == pivot, [i,hi) >= pivot
+        int i = lo, j = hi - 1;
+        while (i <= j) {
+            while (p[i].s[axis] < pivot)
+                i++;
+            while (p[j].s[axis] > pivot)
+                j--;
+            if (i <= j)
+                kd3swap (&p[i++], &p[j--]);
+        }
+
+        // continue in whichever side holds k, done if it landed between them
+        if (k <= j)
+            hi = j + 1;
+        else if (k >= i)
+            lo = i;
+        else
+            return;
+    }
+
+    if (hi - lo == 2 && p[lo].s[axis] > p[lo+1].s[axis])
+        kd3swap (&p[lo], &p[lo+1]);
+}
+
+/* arrange p[lo,hi) into implicit tree order.
+ */
+static void buildKD3Range (KD3Point *p, int lo, int hi)
+{
+    while (hi - lo > 1) {
+
+        // split on the widest axis, estimated from at most about KD3_NSPREAD points.
+        // N.B. branchless min/max because random data mispredicts badly.
+        float min[3], max[3];
+        for (int a = 0; a < 3; a++)
+            min[a] = max[a] = p[lo].s[a];
+        int step = (hi - lo)/KD3_NSPREAD + 1;
+        for (int i = lo+step; i < hi; i += step) {
+            for (int a = 0; a < 3; a++) {
+                float v = p[i].s[a];
+                min[a] = v < min[a] ? v : min[a];
+                max[a] = v > max[a] ? v : max[a];
+            }
+        }
+        int axis = 0;
+        for (int a = 1; a < 3; a++)
+            if (max[a] - min[a] > max[axis] - min[axis])
+                axis = a;
+
+        int mid = lo + (hi-lo)/2;
+        selectKD3 (p, lo, hi, mid, axis);
+        p[mid].axis = axis;
+        buildKD3Range (p, lo, mid);
+        lo = mid + 1;                           // tail loop on the right side
+    }
+
+    if (hi - lo == 1)
+        p[lo].axis = 0;
+}
+
+/* consider pp at square distance d2 for inclusion in q.
+ */
+static void offerKD3 (KD3Query &q, const KD3Point *pp, float d2)
+{
+    if (d2 > q.max_d2 || (q.filter && !(*q.filter)(pp, q.arg)))
+        return;
+
+    if (q.all_within) {
+        // just collect whatever fits but keep counting
+        if (q.n_found < q.max_found) {
+            q.found[q.n_found] = pp;
+            if (q.found_d2)
+                q.found_d2[q.n_found] = d2;
+        }
+        q.n_found++;
+        return;
+    }
+
+    // insertion sort into the nearest max_found, dropping the farthest if full
+    if (q.n_found == q.max_found && d2 >= q.found_d2[q.n_found-1])
+        return;
+    int i = q.n_found < q.max_found ? q.n_found++ : q.max_found - 1;
+    while (i > 0 && q.found_d2[i-1] > d2) {
+        q.found[i] = q.found[i-1];
+        q.found_d2[i] = q.found_d2[i-1];
+        i--;
+    }
+    q.found[i] = pp;
+    q.found_d2[i] = d2;
+
+    // once full nothing farther than the last can matter
+    if (q.n_found == q.max_found)
+        q.max_d2 = q.found_d2[q.n_found-1];
+}
+
+/* search p[lo,hi) for q.
+ */
+static void searchKD3Range (const KD3Point *p, int lo, int hi, KD3Query &q)
+{
+    while (lo < hi) {
+
+        int mid = lo + (hi-lo)/2;
+        const KD3Point *np = &p[mid];
+        float d2 = kd3dist2 (np->s, q.s);
+        if (d2 <= q.max_d2)
+            offerKD3 (q, np, d2);
+
+        // search the side containing q first, then the other side only if it could hold anything closer
+        float dx = q.s[np->axis] - np->s[np->axis];
+        if (dx < 0) {
+            searchKD3Range (p, lo, mid, q);
+            lo = mid + 1;
+        } else {
+            searchKD3Range (p, mid + 1, hi, q);
+            hi = mid;
+        }
+        if (sqr(dx) > q.max_d2)
+            return;
+    }
+}
+
+/* run q over the tree then over any pending points.
+ */
+static void searchKD3Tree (const KD3Tree &t, KD3Query &q)
+{
+    searchKD3Range (t.pts, 0, t.n_tree, q);
+    for (int i = t.n_tree; i < t.n_pts; i++)
+        offerKD3 (q, &t.pts[i], kd3dist2 (t.pts[i].s, q.s));
+}
+
+/* set t to hold n points, growing as necessary, and return pts[] for the caller to fill in.
+ * N.B. the points are not searchable as a tree until buildKD3Tree().
+ */
+KD3Point *allocKD3Points (KD3Tree &t, int n)
+{
+    if (n > t.n_malloced) {
+        t.pts = (KD3Point *) realloc (t.pts, n * sizeof(KD3Point));
+        if (!t.pts)
+            fatalError ("No mem for %d kd3 points", n);
+        t.n_malloced = n;
+    }
+    t.n_pts = n;
+    t.n_tree = 0;
+    return (t.pts);
+}
+
+/* arrange all of t.pts[] into tree order, O(n log n).
+ */
+void buildKD3Tree (KD3Tree &t)
+{
+    buildKD3Range (t.pts, 0, t.n_pts);
+    t.n_tree = t.n_pts;
+}
+
+/* add one point to t, rebuilding once enough have accumulated to be worth it.
+ * N.B. any KD3Point pointers previously returned from t may no longer be valid.
+ */
+void addKD3Point (KD3Tree &t, const LatLong &ll, void *data)
+{
+    if (t.n_pts == t.n_malloced) {
+        t.n_malloced += t.n_malloced/2 + KD3_MINPEND;
+        t.pts = (KD3Point *) realloc (t.pts, t.n_malloced * sizeof(KD3Point));
+        if (!t.pts)
+            fatalError ("No mem for %d kd3 points", t.n_malloced);
+    }
+
+    KD3Point &pt = t.pts[t.n_pts++];
+    ll2xyz (ll, pt.s);
+    pt.data = data;
+
+    int n_pend = t.n_pts - t.n_tree;
+    if (n_pend > KD3_MINPEND && n_pend > t.n_tree/KD3_PENDFRAC)
+        buildKD3Tree (t);
+}
+
+/* free storage used by t and reset to empty.
+ * N.B. user data is not freed.
+ */
+void freeKD3Tree (KD3Tree &t)
+{
+    free (t.pts);
+    t = {};
+}
+
+/* return the point in t closest to ll for which filter returns true, else NULL if none.
+ * set *miles to its distance unless miles is NULL.
+ */
+const KD3Point *nearestKD3PointFilter (const KD3Tree &t, const LatLong &ll, KD3Filter filter, void *arg,
+float *miles)
+{
+    const KD3Point *best;
+    float best_d2;
+    KD3Query q = {};
+    ll2xyz (ll, q.s);
+    q.filter = filter;
+    q.arg = arg;
+    q.found = &best;
+    q.found_d2 = &best_d2;
+    q.max_found = 1;
+    q.max_d2 = 4;                               // diameter of unit sphere, squared
+
+    searchKD3Tree (t, q);
+    if (q.n_found == 0)
+        return (NULL);
+    if (miles)
+        *miles = kd3d2Miles (best_d2);
+    return (best);
+}
+
+/* return the point in t closest to ll, else NULL if t is empty.
+ * set *miles to its distance unless miles is NULL.
  */
-static float kd3dist (const KD3Node *a, const KD3Node *b)
+const KD3Point *nearestKD3Point (const KD3Tree &t, const LatLong &ll, float *miles)
 {
-    float d2 = sqr(a->s[0] - b->s[0]);
-    d2 += sqr(a->s[1] - b->s[1]);
-    d2 += sqr(a->s[2] - b->s[2]);
-    return (d2);
+    return (nearestKD3PointFilter (t, ll, NULL, NULL, miles));
 }
 
-static void kd3swap(KD3Node *x, KD3Node *y)
+/* fill found[] with up to k points in t nearest ll, closest first, and miles[] with their distances
+ * unless miles is NULL. return number found, which is k unless t has fewer points.
+ */
+int kNearestKD3Points (const KD3Tree &t, const LatLong &ll, int k, const KD3Point *found[], float miles[])
+{
+    if (k <= 0)
+        return (0);
+
+    float *d2 = (float *) malloc (k * sizeof(float));
+    if (!d2)
+        fatalError ("No mem for %d kd3 distances", k);
+
+    KD3Query q = {};
+    ll2xyz (ll, q.s);
+    q.found = found;
+    q.found_d2 = d2;
+    q.max_found = k;
+    q.max_d2 = 4;
+
+    searchKD3Tree (t, q);
+    if (miles)
+        for (int i = 0; i < q.n_found; i++)
+            miles[i] = kd3d2Miles (d2[i]);
+
+    free (d2);
+    return (q.n_found);
+}
+
+/* fill found[] with up to max_found points in t within the given miles of ll, in no particular order.
+ * return the total number within range, which may exceed max_found.
+ */
+int radiusKD3Points (const KD3Tree &t, const LatLong &ll, float miles, const KD3Point *found[], int max_found)
+{
+    KD3Query q = {};
+    ll2xyz (ll, q.s);
+    q.found = found;
+    q.max_found = max_found;
+    q.all_within = true;
+    q.max_d2 = kd3Miles2d2 (miles);
+
+    searchKD3Tree (t, q);
+    return (q.n_found);
+}
+
+/* find the nearest point in t to each of n_lls lls[] and store in found[] and, unless NULL, miles[].
+ * each search starts bounded by the distance to the previous answer, so this is fastest when lls[] are
+ * spatially coherent such as along a screen row.
+ * N.B. found[] will be all NULL if t is empty.
+ */
+void nearestKD3Batch (const KD3Tree &t, const LatLong lls[], int n_lls, const KD3Point *found[], float miles[])
+{
+    const KD3Point *prev = NULL;
+
+    for (int i = 0; i < n_lls; i++) {
+
+        const KD3Point *best = NULL;
+        float best_d2 = 0;
+        KD3Query q = {};
+        ll2xyz (lls[i], q.s);
+        q.found = &best;
+        q.found_d2 = &best_d2;
+        q.max_found = 1;
+        q.max_d2 = 4;
+
+        // seed with previous answer, it is no better than it should be so can only help pruning
+        if (prev) {
+            best = prev;
+            best_d2 = kd3dist2 (prev->s, q.s);
+            q.n_found = 1;
+            q.max_d2 = best_d2;
+        }
+
+        searchKD3Tree (t, q);
+
+        found[i] = prev = q.n_found ? best : NULL;
+        if (miles)
+            miles[i] = q.n_found ? kd3d2Miles (best_d2) : 0;
+    }
+}
+
+/* handy convert ll.lat/lng to KD3Point
+ */
+void ll2KD3Point (const LatLong &ll, KD3Point *kp)
+{
+    ll2xyz (ll, kp->s);
+}
+
+/* handy convert KD3Point to ll
+ */
+void KD3Point2ll (const KD3Point &n, LatLong *llp)
+{
+    llp->lat = asinf (n.s[2]);
+    llp->lat_d = rad2deg(llp->lat);
+
+    llp->lng = atan2f (n.s[1], n.s[0]);
+    llp->lng_d = rad2deg(llp->lng);
+}
+
+#endif // _IS_UNIX
+
+
+
+
+#if defined (_UNIT_TEST)
+
+
+/* the original pointer tree, kept for comparison.
+ */
+
+struct kd_node_t {
+    float s[3];                         // xyz coords on unit sphere
+    struct kd_node_t *left, *right;     // branches
+    void *data;                         // user data
+};
+
+typedef struct kd_node_t KD3Node;
+
+static void oldswap(KD3Node *x, KD3Node *y)
 {
     KD3Node tmp = *x;
     *x = *y;
@@ -91,35 +517,32 @@ static KD3Node* find_median(KD3Node *start, KD3Node *end, int level)
     float pivot;
     while (1) {
         pivot = md->s[level];
- 
-        kd3swap(md, end - 1);
+
+        oldswap(md, end - 1);
         for (store = p = start; p < end; p++) {
             if (p->s[level] < pivot) {
                 if (p != store)
-                    kd3swap(p, store);
+                    oldswap(p, store);
                 store++;
             }
         }
-        kd3swap(store, end - 1);
- 
+        oldswap(store, end - 1);
+
         /* median has duplicate values */
         if (store->s[level] == md->s[level])
             return md;
- 
+
         if (store > md) end = store;
         else          start = store;
     }
 }
- 
-/* transform and array of KD3Node into a proper kd3tree in place.
- * initial call with level 0.
- */
-KD3Node *mkKD3NodeTree (KD3Node *t, int len, int level)
+
+static KD3Node *mkKD3NodeTree (KD3Node *t, int len, int level)
 {
     KD3Node *n;
- 
+
     if (!len) return NULL;
- 
+
     if ((n = find_median(t, t + len, level))) {
         level = (level + 1) % 3;
         n->left  = mkKD3NodeTree(t, n - t, level);
@@ -128,155 +551,281 @@ KD3Node *mkKD3NodeTree (KD3Node *t, int len, int level)
     return n;
 }
 
-/* free the given kd3 array and its data.
- * N.B. a is NOT the root node, it is the array of all nodes (the logical root could be anywhere)
- * N.B. call this only if the data elements were malloced.
- */
-void freeKD3NodeTree (KD3Node *a, int n_a)
-{
-    for (int i = 0; i < n_a; i++)
-        free (a[i].data);
-    free (a);
-}
-
- 
-/* given a kd3tree created with mkKD3NodeTree, find the closest entry to nd.
- * initial call with level 0.
- */
-void nearestKD3Node (const KD3Node *root, const KD3Node *nd, int level, const KD3Node **best, float *best_dist,
-    int *n_visited)
+static void nearestKD3Node (const KD3Node *root, const KD3Node *nd, int level, const KD3Node **best,
+    float *best_dist, int *n_visited)
 {
     float d, dx, dx2;
-    
+
     if (!root) return;
-    d = kd3dist (root, nd);
+    d = kd3dist2 (root->s, nd->s);
     dx = root->s[level] - nd->s[level];
     dx2 = dx * dx;
- 
+
     (*n_visited)++;
- 
+
     if (!*best || d < *best_dist) {
         *best_dist = d;
         *best = root;
     }
 
     level = (level + 1) % 3;
- 
+
     nearestKD3Node(dx > 0 ? root->left : root->right, nd, level, best, best_dist, n_visited);
     if (dx2 >= *best_dist) return;
     nearestKD3Node(dx > 0 ? root->right : root->left, nd, level, best, best_dist, n_visited);
 }
 
-/* handy convert ll.lat/lng to KD3Node
- */
-void ll2KD3Node (const LatLong &ll, KD3Node *kp)
-{
-    float clat = cosf(ll.lat);
-    kp->s[0] = clat*cosf(ll.lng);
-    kp->s[1] = clat*sinf(ll.lng);
-    kp->s[2] = sinf(ll.lat);
-}
 
-/* handy convert KD3Node to ll
- */
-void KD3Node2ll (const KD3Node &n, LatLong *llp)
-{
-    llp->lat = asinf (n.s[2]);
-    llp->lat_d = rad2deg(llp->lat);
+// N nodes in random test tree if no cities file
+#define N_RAND          1000000
 
-    llp->lng = atan2f (n.s[1], n.s[0]);
-    llp->lng_d = rad2deg(llp->lng);
-}
+// number of random queries to time
+#define N_QUERIES       200000
 
-/* handy convert nearestKD3Node() best_dist to earth distance in miles
- * this is actually the chordal distance, close enough especially for small distances.
- */
-float nearestKD3Dist2Miles(float d)
+#define rand1() (rand() / (float)RAND_MAX)
+
+// set ll to a random location
+static void rand_ll (LatLong &ll)
 {
-    return (ERAD_M*sqrtf(d));
+    ll.lat = M_PIF*rand1() - M_PIF/2;
+    ll.lng = 2*M_PIF*rand1() - M_PIF;
+    ll.lat_d = rad2deg(ll.lat);
+    ll.lng_d = rad2deg(ll.lng);
 }
 
-#endif // _IS_UNIX
-
- 
-
-
-#if defined (_UNIT_TEST)
-
+static long usSince (const struct timeval &tv0)
+{
+    struct timeval tv1;
+    gettimeofday (&tv1, NULL);
+    return ((tv1.tv_sec-tv0.tv_sec)*1000000 + (tv1.tv_usec-tv0.tv_usec));
+}
 
-// N nodes in test tree
-#define N 1000000
+// read cities2.txt into lls[], return count
+static int readCitiesFile (const char *fn, LatLong **lls)
+{
+    FILE *fp = fopen (fn, "r");
+    if (!fp) {
+        printf ("%s: %s\n", fn, strerror(errno));
+        exit(1);
+    }
 
-#define rand1() (rand() / (float)RAND_MAX)
+    char line[200];
+    int n = 0, n_malloced = 0;
+    *lls = NULL;
+    while (fgets (line, sizeof(line), fp)) {
+        float lat, lng;
+        if (sscanf (line, "%f, %f,", &lat, &lng) != 2)
+            continue;
+        if (n == n_malloced)
+            *lls = (LatLong *) realloc (*lls, (n_malloced += 1000) * sizeof(LatLong));
+        LatLong &ll = (*lls)[n++];
+        ll.lat_d = lat;
+        ll.lng_d = lng;
+        ll.lat = deg2rad(lat);
+        ll.lng = deg2rad(lng);
+    }
+    fclose (fp);
+    return (n);
+}
 
-// set kp to a random location
-void rand_pt (KD3Node *kp)
+// filter to test nearestKD3PointFilter: only accept even indices
+static bool evenFilter (const KD3Point *pp, void *arg)
 {
-    LatLong ll;
-    ll.lat = M_PIF*rand1() - M_PIF/2;
-    ll.lng = 2*M_PIF*rand1() - M_PIF;
-    ll2KD3Node (ll, kp);
+    return (((long)pp->data & 1) == 0);
 }
 
 
-int main(int ac, char *av[])
+int main (int ac, char *av[])
 {
-    int i;
-    KD3Node testNode;
-    KD3Node *root, *found, *million;
-    float best_dist;
-    int visited;
- 
-    million = (KD3Node*) calloc(N, sizeof(KD3Node));
-
+    // load data set: real cities are clustered and duplicated unlike random points, so prefer them
+    const char *fn = ac > 1 ? av[1] : NULL;
+    char home_fn[1000];
+    const char *home = getenv ("HOME");
+    if (!fn && home) {
+        snprintf (home_fn, sizeof(home_fn), "%s/.hamclock/cities2.txt", home);
+        if (access (home_fn, R_OK) == 0)
+            fn = home_fn;
+    }
+    LatLong *lls;
+    int n_lls;
     srand(time(NULL));
-    for (i = 0; i < N; i++) {
-        rand_pt (&million[i]);
-        char buf[100];
-        snprintf (buf, sizeof(buf), "%6d %g %g %g", i, million[i].s[0], million[i].s[1], million[i].s[2]);
-        million[i].data = strdup(buf);
+    if (fn) {
+        n_lls = readCitiesFile (fn, &lls);
+        printf ("%d cities from %s\n", n_lls, fn);
+    } else {
+        printf ("no cities2.txt given or in ~/.hamclock, using random points\n");
+        n_lls = N_RAND;
+        lls = (LatLong *) malloc (n_lls * sizeof(LatLong));
+        for (int i = 0; i < n_lls; i++)
+            rand_ll (lls[i]);
+        printf ("%d random points\n", n_lls);
     }
- 
-    root = mkKD3NodeTree(million, N, 0);
-
-    rand_pt(&testNode);
-    visited = 0;
-    found = NULL;
-    best_dist = 0;
-    visited = 0;
-    nearestKD3Node(root, &testNode, 0, &found, &best_dist, &visited);
- 
-    printf(">> Million tree once\nsearching for (%g, %g, %g)\n"
-            "found (%g, %g, %g) '%s' dist %g\nvisited %d nodes\n",
-            testNode.s[0], testNode.s[1], testNode.s[2],
-            found->s[0], found->s[1], found->s[2], (char*)found->data,
-            sqrtf(best_dist), visited);
- 
-    /* search many random points in million tree to see average behavior.
-     */
-
-    int seen = 0, test_runs = 10000;
-    struct timeval tv0, tv1;
-    float worst_dist = 0;
-    gettimeofday(&tv0, NULL);
-    for (i = 0; i < test_runs; i++) {
-        rand_pt(&testNode);
-        found = NULL;
-        best_dist = 0;
-        nearestKD3Node(root, &testNode, 0, &found, &best_dist, &seen);
-        if (best_dist > worst_dist)
-            worst_dist = best_dist;
+    if (n_lls < 10) {
+        printf ("too few points\n");
+        return (1);
     }
-    gettimeofday(&tv1, NULL);
-    printf(">> Million tree %d times\n"
-            "visited %d nodes for %d random findings (%f per lookup)\n"
-            "worst dist %g\n",
-            test_runs, seen, test_runs, seen/(float)test_runs, sqrtf(worst_dist));
-    printf ("time %ld us\n", (tv1.tv_sec-tv0.tv_sec)*1000000 + (tv1.tv_usec-tv0.tv_usec));
- 
-    free(million);
- 
-    return 0;
+
+    // random queries
+    LatLong *qlls = (LatLong *) malloc (N_QUERIES * sizeof(LatLong));
+    for (int i = 0; i < N_QUERIES; i++)
+        rand_ll (qlls[i]);
+
+    struct timeval tv0;
+
+
+    // build old tree
+    gettimeofday (&tv0, NULL);
+    KD3Node *old = (KD3Node *) calloc (n_lls, sizeof(KD3Node));
+    for (int i = 0; i < n_lls; i++) {
+        ll2xyz (lls[i], old[i].s);
+        old[i].data = (void*)(long)i;
+    }
+    KD3Node *root = mkKD3NodeTree (old, n_lls, 0);
+    printf ("old build    %8ld us\n", usSince(tv0));
+
+    // build new tree
+    gettimeofday (&tv0, NULL);
+    KD3Tree t = {};
+    KD3Point *pts = allocKD3Points (t, n_lls);
+    for (int i = 0; i < n_lls; i++) {
+        ll2KD3Point (lls[i], &pts[i]);
+        pts[i].data = (void*)(long)i;
+    }
+    buildKD3Tree (t);
+    printf ("new build    %8ld us\n", usSince(tv0));
+
+
+    // time old nearest
+    const KD3Node **old_found = (const KD3Node **) malloc (N_QUERIES * sizeof(KD3Node*));
+    int visited = 0;
+    gettimeofday (&tv0, NULL);
+    for (int i = 0; i < N_QUERIES; i++) {
+        KD3Node qn;
+        ll2xyz (qlls[i], qn.s);
+        float best_dist = 0;
+        old_found[i] = NULL;
+        nearestKD3Node (root, &qn, 0, &old_found[i], &best_dist, &visited);
+    }
+    long old_us = usSince(tv0);
+    printf ("old nearest  %8ld us for %d queries, %.1f visits each\n", old_us, N_QUERIES,
+                                    visited/(float)N_QUERIES);
+
+    // time new nearest
+    const KD3Point **new_found = (const KD3Point **) malloc (N_QUERIES * sizeof(KD3Point*));
+    gettimeofday (&tv0, NULL);
+    for (int i = 0; i < N_QUERIES; i++)
+        new_found[i] = nearestKD3Point (t, qlls[i], NULL);
+    long new_us = usSince(tv0);
+    printf ("new nearest  %8ld us, %.2fx\n", new_us, old_us/(float)new_us);
+
+    // must agree, allowing for ties
+    int n_bad = 0;
+    for (int i = 0; i < N_QUERIES; i++) {
+        KD3Point qp;
+        ll2KD3Point (qlls[i], &qp);
+        if (kd3dist2 (old_found[i]->s, qp.s) != kd3dist2 (new_found[i]->s, qp.s))
+            n_bad++;
+    }
+    printf ("nearest disagreements: %d\n", n_bad);
+
+    // time batch along rows of a 1 degree grid, the typical map scan pattern
+    int n_grid = 180*360;
+    LatLong *grid = (LatLong *) malloc (n_grid * sizeof(LatLong));
+    for (int i = 0; i < n_grid; i++) {
+        grid[i].lat_d = (i/360) - 89.5F;
+        grid[i].lng_d = (i%360) - 179.5F;
+        grid[i].lat = deg2rad(grid[i].lat_d);
+        grid[i].lng = deg2rad(grid[i].lng_d);
+    }
+    const KD3Point **grid_found = (const KD3Point **) malloc (n_grid * sizeof(KD3Point*));
+    gettimeofday (&tv0, NULL);
+    for (int i = 0; i < n_grid; i++)
+        grid_found[i] = nearestKD3Point (t, grid[i], NULL);
+    long single_us = usSince(tv0);
+    const KD3Point **batch_found = (const KD3Point **) malloc (n_grid * sizeof(KD3Point*));
+    gettimeofday (&tv0, NULL);
+    nearestKD3Batch (t, grid, n_grid, batch_found, NULL);
+    long batch_us = usSince(tv0);
+    n_bad = 0;
+    for (int i = 0; i < n_grid; i++) {
+        KD3Point qp;
+        ll2KD3Point (grid[i], &qp);
+        if (kd3dist2 (grid_found[i]->s, qp.s) != kd3dist2 (batch_found[i]->s, qp.s))
+            n_bad++;
+    }
+    printf ("grid single  %8ld us, batch %ld us, %.2fx, %d disagreements\n", single_us, batch_us,
+                                    single_us/(float)batch_us, n_bad);
+
+
+    // check k-nearest, radius and filter against brute force on a few queries
+    #define N_CHECK 50
+    #define K_CHECK 10
+    int n_kbad = 0, n_rbad = 0, n_fbad = 0;
+    for (int i = 0; i < N_CHECK; i++) {
+
+        KD3Point qp;
+        ll2KD3Point (qlls[i], &qp);
+
+        // k nearest: k'th distance must match the k'th smallest brute force distance
+        const KD3Point *kfound[K_CHECK];
+        float kmiles[K_CHECK];
+        int nk = kNearestKD3Points (t, qlls[i], K_CHECK, kfound, kmiles);
+        float kth_d2 = kd3dist2 (kfound[nk-1]->s, qp.s);
+        int n_closer = 0;
+        for (int j = 0; j < n_lls; j++)
+            if (kd3dist2 (pts[j].s, qp.s) < kth_d2)
+                n_closer++;
+        for (int j = 1; j < nk; j++)
+            if (kmiles[j] < kmiles[j-1])
+                n_kbad++;
+        if (nk != K_CHECK || n_closer >= K_CHECK)
+            n_kbad++;
+
+        // radius: count must match brute force, use the k'th distance so there is always something
+        float r_miles = kmiles[nk-1] * 1.001F;
+        float r_d2 = kd3Miles2d2 (r_miles);
+        int n_brute = 0;
+        for (int j = 0; j < n_lls; j++)
+            if (kd3dist2 (pts[j].s, qp.s) <= r_d2)
+                n_brute++;
+        const KD3Point *rfound[100];
+        int nr = radiusKD3Points (t, qlls[i], r_miles, rfound, 100);
+        if (nr != n_brute)
+            n_rbad++;
+
+        // filter: nearest even index
+        float f_d2 = 4;
+        for (int j = 0; j < n_lls; j++)
+            if (((long)pts[j].data & 1) == 0 && kd3dist2 (pts[j].s, qp.s) < f_d2)
+                f_d2 = kd3dist2 (pts[j].s, qp.s);
+        const KD3Point *fp = nearestKD3PointFilter (t, qlls[i], evenFilter, NULL, NULL);
+        if (!fp || kd3dist2 (fp->s, qp.s) != f_d2)
+            n_fbad++;
+    }
+    printf ("k-nearest failures %d, radius failures %d, filter failures %d, of %d\n", n_kbad, n_rbad,
+                                    n_fbad, N_CHECK);
+
+    // incremental: grow a tree one point at a time and check against the bulk tree
+    gettimeofday (&tv0, NULL);
+    KD3Tree inc = {};
+    for (int i = 0; i < n_lls; i++)
+        addKD3Point (inc, lls[i], (void*)(long)i);
+    printf ("incremental  %8ld us to add %d, %d pending\n", usSince(tv0), inc.n_pts, inc.n_pts - inc.n_tree);
+    n_bad = 0;
+    for (int i = 0; i < N_CHECK*100; i++) {
+        float bulk_miles, inc_miles;
+        nearestKD3Point (t, qlls[i], &bulk_miles);
+        nearestKD3Point (inc, qlls[i], &inc_miles);
+        if (bulk_miles != inc_miles)
+            n_bad++;
+    }
+    printf ("incremental disagreements: %d\n", n_bad);
+
+    freeKD3Tree (inc);
+    freeKD3Tree (t);
+    free (old);
+
+    return (0);
 }
- 
- #endif // _UNIT_TEST
+
+#endif // _UNIT_TEST
@@ -54,6 +54,7 @@ char live_html[] =  R"_raw_html_(
         var want_fs, tried_fs;          // whether user wants full screen and has succeeded once
         var wsclose_reload = 1;         // whether to reload if lose ws connection
         var cvs, ctx;                   // handy
+        var draw_chain = Promise.resolve(); // serializes drawing when several updates arrive together
 
         // define functions, onLoad follows near the bottom
 
@@ -116,11 +117,84 @@ char live_html[] =  R"_raw_html_(
                 console.log ("canvas is " + hc_w + " x " + hc_h + " app_scale " + app_scale);
         }
 
-        // display the given full png uint8
-        function drawFullImage (png8) {
+        // return whether the given uint8 is a png image
+        function isPNG (img8) {
+            return (img8[0] == 137 && img8[1] == 80 && img8[2] == 78 && img8[3] == 71);
+        }
+
+        // return whether the given uint8 is a qoi image
+        function isQOI (img8) {
+            return (img8[0] == 113 && img8[1] == 111 && img8[2] == 105 && img8[3] == 102);
+        }
+
+        // decode the given RGB qoi uint8 to ImageData -- see qoi.cpp
+        function qoiToImageData (qoi8) {
+            const w = (qoi8[4] << 24 | qoi8[5] << 16 | qoi8[6] << 8 | qoi8[7]) >>> 0;
+            const h = (qoi8[8] << 24 | qoi8[9] << 16 | qoi8[10] << 8 | qoi8[11]) >>> 0;
+            const idata = new ImageData (Math.max(w,1), h);
+            const px = idata.data;
+            const index = new Uint8Array (64*4);
+            let r = 0, g = 0, b = 0, a = 255;
+            let ip = 14;
+            let run = 0;
+            for (let op = 0; op < 4*w*h; op += 4) {
+                if (run > 0) {
+                    run--;
+                } else {
+                    const b1 = qoi8[ip++];
+                    if (b1 == 0xfe) {                       // RGB
+                        r = qoi8[ip++];
+                        g = qoi8[ip++];
+                        b = qoi8[ip++];
+                    } else if (b1 == 0xff) {                // RGBA
+                        r = qoi8[ip++];
+                        g = qoi8[ip++];
+                        b = qoi8[ip++];
+                        a = qoi8[ip++];
+                    } else if ((b1 & 0xc0) == 0x00) {       // INDEX
+                        r = index[4*b1];
+                        g = index[4*b1+1];
+                        b = index[4*b1+2];
+                        a = index[4*b1+3];
+                    } else if ((b1 & 0xc0) == 0x40) {       // DIFF
+                        r = (r + ((b1 >> 4) & 3) - 2) & 0xff;
+                        g = (g + ((b1 >> 2) & 3) - 2) & 0xff;
+                        b = (b + (b1 & 3) - 2) & 0xff;
+                    } else if ((b1 & 0xc0) == 0x80) {       // LUMA
+                        const b2 = qoi8[ip++];
+                        const dg = (b1 & 0x3f) - 32;
+                        r = (r + dg - 8 + ((b2 >> 4) & 0x0f)) & 0xff;
+                        g = (g + dg) & 0xff;
+                        b = (b + dg - 8 + (b2 & 0x0f)) & 0xff;
+                    } else {                                // RUN
+                        run = b1 & 0x3f;
+                    }
+                    const hi = 4*((r*3 + g*5 + b*7 + a*11) % 64);
+                    index[hi] = r;
+                    index[hi+1] = g;
+                    index[hi+2] = b;
+                    index[hi+3] = a;
+                }
+                px[op] = r;
+                px[op+1] = g;
+                px[op+2] = b;
+                px[op+3] = a;
+            }
+            return (idata);
+        }
+
+        // return a promise for an ImageBitmap of the given png or qoi uint8
+        function decodeImage (img8) {
+            if (isQOI (img8))
+                return (createImageBitmap (qoiToImageData (img8)));
+            return (createImageBitmap (new Blob ([img8], {type:"image/png"})));
+        }
+
+        // display the given full png or qoi uint8
+        function drawFullImage (img8) {
 
-            var pngbl = new Blob ([png8], {type:"image/png"});
-            createImageBitmap (pngbl)
+            draw_chain = draw_chain
+            .then(function() { return decodeImage (img8); })
             .then(function(ibm) {
                 if (drawing_verbose)
                     console.log ("drawFullImage size " + ibm.width + " x " + ibm.height);
@@ -132,8 +206,8 @@ char live_html[] =  R"_raw_html_(
             });
         }
 
-        // update given header and png sprites image -- see liveweb.cpp::updateExistingClient()
-        function drawUpdate (hdr8, png8) {
+        // update given header and png or qoi sprites image -- see liveweb.cpp::encodeLiveDelta()
+        function drawUpdate (hdr8, img8) {
 
             // extract 4-byte header preamble
             const blok_w = hdr8[0];                         // block width, pixels
@@ -159,9 +233,9 @@ char live_html[] =  R"_raw_html_(
 
             // walk down remainder of header and draw each region
             if (n_regn > 0) {
-                // png8 is one image blok_h hi of n_regns contiguous regions each variable width
-                let pngbl = new Blob ([png8], {type:"image/png"});
-                createImageBitmap (pngbl)
+                // img8 is one image blok_h hi of n_regns contiguous regions each variable width
+                draw_chain = draw_chain
+                .then(function() { return decodeImage (img8); })
                 .then(function(ibm) {
                     // render each region.
                     let regn_x = 0;                         // walk region x along img
@@ -371,6 +445,10 @@ char live_html[] =  R"_raw_html_(
             ws.binaryType = "arraybuffer";
             ws.onopen = function () {
                 console.log('WS connection established.');
+                // hamclock picks qoi on a LAN else png, override with live.html?codec=png or qoi
+                const codec = new URLSearchParams (location.search).get ("codec");
+                if (codec)
+                    sendWSMsg ("set_codec?codec=" + codec);
             };
             ws.onclose = function () {
                 console.log('WS connection closed.');
@@ -393,8 +471,8 @@ char live_html[] =  R"_raw_html_(
                     // received whole or update image
 
                     var data8 = new Uint8Array (e.data);
-                    if (data8[0] == 137 && data8[1] == 80 && data8[2] == 78 && data8[3] == 71) {
-                        // this is a PNG image -- show whole if alone else assume its part of an update
+                    if (isPNG (data8) || isQOI (data8)) {
+                        // this is an image -- show whole if alone else assume its part of an update
                         if (ws_abdata) {
                             drawUpdate (new Uint8Array(ws_abdata), data8);
                             ws_abdata = 0;
@@ -3,7 +3,8 @@
  * we listen to liveweb_rw_port and liveweb_ro_port for live.html or web socket upgrades.
  *
  * Browser displays entire HamClock frame buffer. Complete frame is sent initially then only the
- * pixels that change.
+ * pixels that change. All clients on one port share one LiveStream so each change is captured,
+ * diffed and encoded just once regardless of how many clients are watching.
  *
  * N.B. this server-side code must work in concert with client-side code in liveweb-html.cpp.
  */
@@ -49,15 +50,64 @@ static char *liveweb_openurl;                           // malloced url to attem
 static pthread_mutex_t lw_url_lock = PTHREAD_MUTEX_INITIALIZER; // thread-safe access for liveweb_openurl
 
 
+// image encodings a client may choose, both self-identifying by their leading magic bytes.
+// N.B. coordinate with liveweb-html
+typedef enum {
+    LIVE_PNG,                                           // smallest, best over a WAN
+    LIVE_QOI,                                           // many times faster to encode, best on a LAN
+    LIVE_NCODECS
+} LiveCodec;
+static const char *live_codec_names[LIVE_NCODECS] = {"png", "qoi"};
+
 // complete scene on browser for each web socket
 typedef struct {
     ws_cli_conn_t *client;                              // pointer unique to each connection, else NULL
-    uint8_t *pixels;                                    // this client's current display image
+    uint32_t gen;                                       // LiveStream generation on browser, 0 if none yet
+    LiveCodec codec;                                    // image encoding this client wants
 } SessionInfo;
 static SessionInfo *si_list;                            // malloced list
 static int si_n;                                        // n malloced
 static pthread_mutex_t si_lock = PTHREAD_MUTEX_INITIALIZER;     // atomic updates
 
+
+// one encoded image
+typedef struct {
+    uint8_t *mem;                                       // malloced image, NULL until encoded
+    int len;                                            // mem length
+} LiveImg;
+
+// one screen change ready to send to any number of clients, each image encoded when first needed.
+typedef struct {
+    uint32_t gen;                                       // LiveStream generation this brings a client up to
+    uint8_t *hdr;                                       // malloced region header, NULL if full image
+    int hdr_l;                                          // hdr length
+    uint8_t *sprites;                                   // malloced RGB sprites for hdr, NULL if full image
+    int spr_w;                                          // sprites width, pixels
+    LiveImg img[LIVE_NCODECS];                          // sprites or full image in each encoding
+    int refs;                                           // n users including LiveStream, free when 0
+} LiveDelta;
+
+// all clients on the same port see the same image, including the connection counter, so each port has
+// one LiveStream. each screen change becomes a new generation whose update is encoded once and kept in a
+// small ring so a client a few generations behind receives each update it missed in order. a client
+// further behind, or new, gets a full image which is also encoded at most once per generation.
+#define LIVE_NDELTAS    16                              // recent updates retained
+#define LIVE_RWSTREAM   0                               // live_streams index for r/w port
+#define LIVE_ROSTREAM   1                               // live_streams index for r/o port
+#define LIVE_NSTREAMS   2                               // n live_streams
+typedef struct {
+    pthread_mutex_t lock;                               // atomic updates
+    uint8_t *raw;                                       // malloced screen capture without counter
+    uint8_t *shown;                                     // malloced raw plus counter as of gen
+    uint32_t tft_gen;                                   // tft stage generation of raw
+    uint32_t gen;                                       // generation of shown, 0 until first capture
+    int ctr_n;                                          // connection count drawn in shown, -1 if none
+    LiveDelta *deltas[LIVE_NDELTAS];                    // update to each recent gen at [gen%LIVE_NDELTAS]
+    LiveDelta *full;                                    // full image of some gen, else NULL
+    LiveWebStats stats;                                 // performance counters
+} LiveStream;
+static LiveStream live_streams[LIVE_NSTREAMS];
+
 #if defined(__GNUC__)
 static void bye (const char *fmt, ...) __attribute__ ((format (__printf__, 1, 2)));
 #else
@@ -119,118 +169,186 @@ static unsigned char * myZDeflate(unsigned char *data, int data_len, int *out_le
     return (out_mem);
 }
 
-/* stbi_write_png_to_func helper to write the given array to the given ws_cli_conn_t in context.
+/* stbi_write_png_to_func helper to append the given array to the LiveImg in context.
+ */
+static void pngMemWrite_helper (void *context, void *data, int size)
+{
+    LiveImg *ip = (LiveImg *)context;
+    ip->mem = (uint8_t *) realloc (ip->mem, ip->len + size);
+    if (!ip->mem)
+        bye ("No memory for %d byte png\n", ip->len + size);
+    memcpy (ip->mem + ip->len, data, size);
+    ip->len += size;
+}
+
+/* encode the given w x h RGB image with rows stride bytes apart into ip using codec.
+ */
+static void encodeLiveImg (LiveImg *ip, LiveCodec codec, const uint8_t *rgb, int w, int h, int stride)
+{
+    switch (codec) {
+    case LIVE_PNG:
+        stbi_write_png_compression_level = 2;   // faster with hardly any increase in size
+        stbi_write_png_to_func (pngMemWrite_helper, ip, w, h, COMP_RGB, rgb, stride);
+        break;
+    case LIVE_QOI:
+        ip->mem = qoiEncode (rgb, w, h, stride, &ip->len);
+        if (!ip->mem)
+            bye ("No memory for %d x %d qoi\n", w, h);
+        break;
+    case LIVE_NCODECS:
+        break;
+    }
+}
+
+/* return a new LiveDelta for the given generation with one reference.
+ */
+static LiveDelta *newLiveDelta (uint32_t gen)
+{
+    LiveDelta *dp = (LiveDelta *) calloc (1, sizeof(LiveDelta));
+    if (!dp)
+        bye ("No memory for new LiveDelta\n");
+    dp->gen = gen;
+    dp->refs = 1;
+    return (dp);
+}
+
+/* drop one reference to dp, freeing when there are no more.
+ * N.B. we assume the lock of the LiveStream from which dp came is held
+ */
+static void releaseLiveDelta (LiveDelta *dp)
+{
+    if (--dp->refs == 0) {
+        free (dp->hdr);
+        free (dp->sprites);
+        for (int i = 0; i < LIVE_NCODECS; i++)
+            free (dp->img[i].mem);
+        free (dp);
+    }
+}
+
+/* send the given update or full image to client using the given codec.
  */
-static void wifiSTBWrite_helper (void *context, void *data, int size)
+static void sendLiveDelta (ws_cli_conn_t *client, const LiveDelta *dp, LiveCodec codec)
 {
-    ws_cli_conn_t *client = (ws_cli_conn_t *)context;
-    int n_sent = ws_sendframe_bin (client, (const char *) data, size);
-    if (n_sent != size)
-        Serial.printf ("LIVE: client %s: wrong png write len: %d != %d\n", ws_getaddress(client), n_sent, size);
+    // header first if update
+    if (dp->hdr) {
+        int n_hdrsent = ws_sendframe_bin (client, (const char *) dp->hdr, dp->hdr_l);
+        if (n_hdrsent != dp->hdr_l)
+            Serial.printf ("LIVE: client %s: wrong header write %d != %d\n", ws_getaddress(client),
+                                n_hdrsent, dp->hdr_l);
+    }
+
+    // then the image
+    const LiveImg *ip = &dp->img[codec];
+    int n_sent = ws_sendframe_bin (client, (const char *) ip->mem, ip->len);
+    if (n_sent != ip->len)
+        Serial.printf ("LIVE: client %s: wrong %s write len: %d != %d\n", ws_getaddress(client),
+                                live_codec_names[codec], n_sent, ip->len);
     if (debugLevel (DEBUG_WEB, 2)) {
-        Serial.printf ("LIVE: sent image %d bytes\n", size);
+        Serial.printf ("LIVE: client %s: sent gen %u %s %s %d bytes\n", ws_getaddress(client), dp->gen,
+                                live_codec_names[codec], dp->hdr ? "update" : "image", dp->hdr_l + ip->len);
         if (debugLevel (DEBUG_WEB, 3)) {
-            FILE *fp = fopen ("/tmp/live.png", "w");
-            fwrite (data, size, 1, fp);
+            char fn[50];
+            snprintf (fn, sizeof(fn), "/tmp/live.%s", live_codec_names[codec]);
+            FILE *fp = fopen (fn, "w");
+            fwrite (ip->mem, ip->len, 1, fp);
             fclose(fp);
         }
     }
 }
 
-/* return the pixels pointer for the existing client, else NULL.
- * pixels pointer is safe to use outside si_lock and even if si_list is later realloced (and hence moves).
+/* return the live_streams index for the given client
+ */
+static int getLiveStreamIndex (ws_cli_conn_t *client)
+{
+    return (client->port == liveweb_ro_port ? LIVE_ROSTREAM : LIVE_RWSTREAM);
+}
+
+/* find the LiveStream generation and codec for the existing client, return whether found.
  */
-static uint8_t *getSIPixels (ws_cli_conn_t *client)
+static bool getSIGen (ws_cli_conn_t *client, uint32_t &gen, LiveCodec &codec)
 {
     // protect list while manipulating -- N.B. unlock before returning!
     pthread_mutex_lock (&si_lock);
 
     // scan si_list for client
-    SessionInfo *found_sip = NULL;
+    bool found = false;
     for (int i = 0; i < si_n; i++) {
         if (si_list[i].client == client) {
-            found_sip = &si_list[i];
+            gen = si_list[i].gen;
+            codec = si_list[i].codec;
+            found = true;
             break;
         }
     }
 
-    // capture pixels address before unlocking
-    uint8_t *pixels = NULL;
-    if (found_sip)
-        pixels = found_sip->pixels;
-    else
-        Serial.printf ("LIVE: client %s: missing pixels\n", ws_getaddress(client));
-
     // unlock
     pthread_mutex_unlock (&si_lock);
 
-    // return result
-    return (pixels);
+    if (!found)
+        Serial.printf ("LIVE: client %s: missing session\n", ws_getaddress(client));
+
+    return (found);
 }
 
-/* send difference between client's last known screen image and the current image,
- * then store current image back in client's SessionInfo.
+/* save the LiveStream generation now shown on the given client.
  */
-static void updateExistingClient (ws_cli_conn_t *client)
+static void setSIGen (ws_cli_conn_t *client, uint32_t gen)
 {
-    // curious how long these steps take
-    struct timeval tv0;
-    gettimeofday (&tv0, NULL);
-
-    // find client's current pixels
-    uint8_t *pixels = getSIPixels(client);
-    if (!pixels)
-        return;
-
-    // make a copy of client's last known image
-    uint8_t *img_client = (uint8_t *) malloc (LIVE_NBYTES);
-    if (!img_client)
-        bye ("No memory for LIVE update\n");
-    memcpy (img_client, pixels, LIVE_NBYTES);
-
-    // replace clients's pixels with current screen contents
-    if (!tft.getRawPix (pixels, LIVE_NPIX))
-        bye ("getRawPix for update failed\n");
-    uint8_t *img_now = pixels;                      // better name
-
-    if (debugLevel (DEBUG_WEB, 2)) {
-        struct timeval tv1;
-        gettimeofday (&tv1, NULL);
-        Serial.printf ("LIVE: client %s: copying img and reading new pixels took %ld usec\n",
-                                ws_getaddress(client), TVDELUS (tv0,tv1));
+    pthread_mutex_lock (&si_lock);
+    for (int i = 0; i < si_n; i++) {
+        if (si_list[i].client == client) {
+            si_list[i].gen = gen;
+            break;
+        }
     }
+    pthread_mutex_unlock (&si_lock);
+}
 
-    // draw connection counter on main page
-    if (mainpage_up) {
-        #define CTR_RAWW (3*tft.SCALESZ)
-        #define CTR_RAWH (5*tft.SCALESZ)
-        #define CTR_RAWX (tft.SCALESZ*(lkscrn_b.x-4))
-        #define CTR_RAWY (tft.SCALESZ*(lkscrn_b.y+lkscrn_b.h+3))
-        SBox digit_b = {(uint16_t)CTR_RAWX, (uint16_t)CTR_RAWY, (uint16_t)CTR_RAWW, (uint16_t)CTR_RAWH};
-        if (client->port == liveweb_ro_port) {
-            static const uint8_t txt_clr[LIVE_BYPPIX] = {255U,50U,50U};
-            // n_roweb = 1234567890;       // RBF
-            if (n_roweb < 10)
-                digit_b.x += CTR_RAWW;
-            drawImgNumber (n_roweb, img_now, digit_b, txt_clr);
-            digit_b.x += 2*digit_b.w/3;
-            drawImgR (img_now, digit_b, txt_clr);
-            digit_b.x += 3*digit_b.w/2;
-            drawImgO (img_now, digit_b, txt_clr);
-        } else {
-            static const uint8_t txt_clr[LIVE_BYPPIX] = {255U,255U,255U};
-            // n_rwweb = 1234567890;       // RBF
-            if (n_rwweb < 10)
-                digit_b.x += CTR_RAWW;
-            drawImgNumber (n_rwweb, img_now, digit_b, txt_clr);
-            digit_b.x += 2*digit_b.w/3;
-            drawImgR (img_now, digit_b, txt_clr);
-            digit_b.x += 3*digit_b.w/2;
-            drawImgW (img_now, digit_b, txt_clr);
-        }
+/* draw the connection counter for stream ls_i into img.
+ */
+#define CTR_RAWW (3*tft.SCALESZ)
+#define CTR_RAWH (5*tft.SCALESZ)
+#define CTR_RAWX (tft.SCALESZ*(lkscrn_b.x-4))
+#define CTR_RAWY (tft.SCALESZ*(lkscrn_b.y+lkscrn_b.h+3))
+static void drawLiveCounter (int ls_i, int n, uint8_t *img)
+{
+    SBox digit_b = {(uint16_t)CTR_RAWX, (uint16_t)CTR_RAWY, (uint16_t)CTR_RAWW, (uint16_t)CTR_RAWH};
+    if (ls_i == LIVE_ROSTREAM) {
+        static const uint8_t txt_clr[LIVE_BYPPIX] = {255U,50U,50U};
+        // n = 1234567890;       // RBF
+        if (n < 10)
+            digit_b.x += CTR_RAWW;
+        drawImgNumber (n, img, digit_b, txt_clr);
+        digit_b.x += 2*digit_b.w/3;
+        drawImgR (img, digit_b, txt_clr);
+        digit_b.x += 3*digit_b.w/2;
+        drawImgO (img, digit_b, txt_clr);
+    } else {
+        static const uint8_t txt_clr[LIVE_BYPPIX] = {255U,255U,255U};
+        // n = 1234567890;       // RBF
+        if (n < 10)
+            digit_b.x += CTR_RAWW;
+        drawImgNumber (n, img, digit_b, txt_clr);
+        digit_b.x += 2*digit_b.w/3;
+        drawImgR (img, digit_b, txt_clr);
+        digit_b.x += 3*digit_b.w/2;
+        drawImgW (img, digit_b, txt_clr);
     }
+}
+
+/* return a new LiveDelta for gen containing the difference from img_prev to img_now, or NULL if none.
+ * the sprites are not yet encoded, see getLiveImg().
+ * only rows of tiles marked in tile_rows are compared, others are assumed the same.
+ */
+static LiveDelta *encodeLiveDelta (const uint8_t *img_now, const uint8_t *img_prev, const bool tile_rows[],
+uint32_t gen)
+{
+    // curious how long these steps take
+    struct timeval tv0;
+    gettimeofday (&tv0, NULL);
 
-    // we only send small regions that have changed since previous, ie changes from img_client to img_now.
+    // we only send small regions that have changed since previous, ie changes from img_prev to img_now.
     // image is divided into fixed sized blocks and those which have changed are coalesced into regions
     // of height one block but variable length. these are collected and sent as one image of height one
     // block preceded by a header defining the location and size of each region. the coordinates and
@@ -254,9 +372,6 @@ static void updateExistingClient (ws_cli_conn_t *client)
         #error too many live regions
     #endif
 
-    // time block creation
-    gettimeofday (&tv0, NULL);
-
     // set header to location and length of each changed region.
     typedef struct {
         uint8_t x, y, l;                                // region location and length in units of blocks
@@ -268,17 +383,21 @@ static void updateExistingClient (ws_cli_conn_t *client)
     // build locs by checking each region for change across then down
     for (int ry = 0; ry < BLOK_NROWS; ry++) {
 
+        // skip bands in rows of tiles that did not change
+        if (!tile_rows[(ry*BLOK_H)/FB_TILE_SZ])
+            continue;
+
         // pre-check an image band all the way across BLOK_COLS hi, skip entirely if no change anywhere
         int band_start = ry*LIVE_BYPPIX*BLOK_H*BUILD_W;
-        if (memcmp (&img_now[band_start], &img_client[band_start], LIVE_BYPPIX*BLOK_H*BUILD_W) == 0)
+        if (memcmp (&img_now[band_start], &img_prev[band_start], LIVE_BYPPIX*BLOK_H*BUILD_W) == 0)
             continue;
 
         // something changed, scan across this band checking each block
         locs[n_regns].l = 0;                            // init n contiguous blocks that start here
         for (int rx = 0; rx < BLOK_NCOLS; rx++) {
             int blok_start = band_start + rx*BLOK_WBYTES;
-            uint8_t *now0 = &img_now[blok_start];       // first pixel in this block of current image
-            uint8_t *pre0 = &img_client[blok_start];    // first pixel in this block of image in client
+            const uint8_t *now0 = &img_now[blok_start]; // first pixel in this block of current image
+            const uint8_t *pre0 = &img_prev[blok_start];// first pixel in this block of previous image
 
             // check each row of this block for any change, start or add to region 
             bool blok_changed = false;                  // set if any changed pixels in this block
@@ -311,6 +430,10 @@ static void updateExistingClient (ws_cli_conn_t *client)
         }
     }
 
+    // done if nothing actually changed
+    if (n_regns == 0)
+        return (NULL);
+
     // now create one wide image containing each region as a separate sprite.
     // remember each region must work as a separate image of size lx1 blocks.
     uint8_t *chg_regns = (uint8_t*) malloc (n_bloks * BLOK_NBYTES);
@@ -320,7 +443,7 @@ static void updateExistingClient (ws_cli_conn_t *client)
     for (int ry = 0; ry < BLOK_H; ry++) {
         for (int i = 0; i < n_regns; i++) {
             RegnLoc *rp = &locs[i];
-            uint8_t *now0 = &img_now[BUILD_W*LIVE_BYPPIX*(ry+BLOK_H*rp->y) + BLOK_WBYTES*rp->x];
+            const uint8_t *now0 = &img_now[BUILD_W*LIVE_BYPPIX*(ry+BLOK_H*rp->y) + BLOK_WBYTES*rp->x];
             memcpy (chg0, now0, BLOK_WBYTES*rp->l);
             chg0 += BLOK_WBYTES*rp->l;
         }
@@ -328,20 +451,13 @@ static void updateExistingClient (ws_cli_conn_t *client)
     if (n_bloks != (chg0-chg_regns)/BLOK_NBYTES)        // assert
         bye ("live regions %d != %d\n", n_bloks, (int)((chg0-chg_regns)/BLOK_NBYTES));
 
-    if (debugLevel (DEBUG_WEB, 2)) {
-        struct timeval tv1;
-        gettimeofday (&tv1, NULL);
-        Serial.printf ("LIVE: client %s: built %d regions from %d blocks in %ld usec\n",
-                        ws_getaddress(client), n_regns, n_bloks, TVDELUS (tv0, tv1));
-    }
-
-    // time header creation and png write
-    gettimeofday (&tv0, NULL);
-
     // build 4-byte header followed by x,y,l of each of n regions in units of blocks.
-    unsigned hdr_l = 4+3*n_regns;
-    StackMalloc hdr_mem(hdr_l);
-    uint8_t *hdr = (uint8_t *) hdr_mem.getMem();
+    LiveDelta *dp = newLiveDelta (gen);
+    dp->hdr_l = 4+3*n_regns;
+    dp->hdr = (uint8_t *) malloc (dp->hdr_l);
+    if (!dp->hdr)
+        bye ("No memory for %d byte live header\n", dp->hdr_l);
+    uint8_t *hdr = dp->hdr;
     hdr[0] = BLOK_W;                            // block width, pixels
     hdr[1] = BLOK_H;                            // block height, pixels
     hdr[2] = n_regns >> 8;                      // n regions, MSB
@@ -354,50 +470,264 @@ static void updateExistingClient (ws_cli_conn_t *client)
             Serial.printf ("   %d,%d %dx%d\n", locs[i].x*BLOK_W, locs[i].y*BLOK_H, locs[i].l*BLOK_W, BLOK_H);
     }
 
-    // always send header
-    unsigned n_hdrsent = ws_sendframe_bin (client, (const char *) hdr, hdr_l);
-    if (n_hdrsent != hdr_l)
-        Serial.printf ("LIVE: client %s: wrong header write %u != %d\n", ws_getaddress(client), n_hdrsent, hdr_l);
-
-    // followed by one image containing one column BLOK_W wide of all changed regions
-    stbi_write_png_to_func (wifiSTBWrite_helper, client, BLOK_W*n_bloks, BLOK_H,
-                            COMP_RGB, chg_regns, BLOK_WBYTES*n_bloks);
+    // followed by one image containing one column BLOK_W wide of all changed regions, encoded when needed
+    dp->sprites = chg_regns;
+    dp->spr_w = BLOK_W*n_bloks;
 
     if (debugLevel (DEBUG_WEB, 2)) {
         struct timeval tv1;
         gettimeofday (&tv1, NULL);
-        Serial.printf ("LIVE: client %s: write hdr %d bytes and update took %ld usec\n",
-                        ws_getaddress(client), hdr_l, TVDELUS (tv0,tv1));
+        Serial.printf ("LIVE: gen %u: found %d regions from %d blocks in %ld usec\n",
+                        gen, n_regns, n_bloks, TVDELUS (tv0, tv1));
+    }
+
+    return (dp);
+}
+
+/* bring stream ls_i up to date with the screen, encoding any change as a new generation.
+ * N.B. we assume the stream's lock is held
+ */
+static void refreshLiveStream (int ls_i)
+{
+    LiveStream *ls = &live_streams[ls_i];
+
+    // first time
+    if (!ls->raw) {
+        ls->raw = (uint8_t *) malloc (LIVE_NBYTES);
+        ls->shown = (uint8_t *) malloc (LIVE_NBYTES);
+        if (!ls->raw || !ls->shown)
+            bye ("No memory for live stream\n");
+        ls->ctr_n = -1;
+    }
+
+    // capture just the screen tiles that changed since last time
+    bool tile_rows[FB_TILES_H];
+    if (!tft.getRawPix (ls->raw, LIVE_NPIX, ls->tft_gen, tile_rows))
+        bye ("getRawPix for update failed\n");
+    bool any_change = false;
+    for (int ty = 0; ty < FB_TILES_H; ty++)
+        if (tile_rows[ty])
+            any_change = true;
+
+    // connection counter on main page can change even if the screen beneath does not
+    int ctr_n = mainpage_up ? (ls_i == LIVE_ROSTREAM ? n_roweb : n_rwweb) : -1;
+    if (ctr_n != ls->ctr_n) {
+        for (int ty = CTR_RAWY/FB_TILE_SZ; ty <= (CTR_RAWY+CTR_RAWH)/FB_TILE_SZ && ty < FB_TILES_H; ty++)
+            tile_rows[ty] = true;
+        any_change = true;
+    }
+
+    // done if nothing new
+    if (!any_change && ls->gen > 0)
+        return;
+
+    // time what is common to all clients
+    struct timeval tv0;
+    gettimeofday (&tv0, NULL);
+
+    // save rows of shown that will change, if any yet, then update them from raw
+    uint8_t *prev = NULL;
+    if (ls->gen > 0) {
+        prev = (uint8_t *) malloc (LIVE_NBYTES);
+        if (!prev)
+            bye ("No memory for LIVE update\n");
+    }
+    for (int ty = 0; ty < FB_TILES_H; ty++) {
+        if (tile_rows[ty]) {
+            int tr_bytes = FB_TILE_SZ*LIVE_RBYTES;
+            int tr_len = (ty+1)*tr_bytes <= LIVE_NBYTES ? tr_bytes : LIVE_NBYTES - ty*tr_bytes;
+            if (prev)
+                memcpy (&prev[ty*tr_bytes], &ls->shown[ty*tr_bytes], tr_len);
+            memcpy (&ls->shown[ty*tr_bytes], &ls->raw[ty*tr_bytes], tr_len);
+        }
+    }
+    if (ctr_n >= 0)
+        drawLiveCounter (ls_i, ctr_n, ls->shown);
+    ls->ctr_n = ctr_n;
+
+    // first capture has nothing to compare, clients get a full image
+    if (!prev) {
+        ls->gen = 1;
+        return;
+    }
+
+    // encode the change, if any, as the next generation
+    LiveDelta *dp = encodeLiveDelta (ls->shown, prev, tile_rows, ls->gen + 1);
+    free (prev);
+    if (!dp)
+        return;
+    ls->gen += 1;
+    LiveDelta *&slot = ls->deltas[ls->gen % LIVE_NDELTAS];
+    if (slot)
+        releaseLiveDelta (slot);
+    slot = dp;
+
+    // record cost of finding the change, encoding is counted in getLiveImg()
+    struct timeval tv1;
+    gettimeofday (&tv1, NULL);
+    ls->stats.encode_us += TVDELUS (tv0, tv1);
+
+    // record each frame for the qoi.cpp benchmark -- beware this grows quickly
+    if (debugLevel (DEBUG_WEB, 4)) {
+        FILE *fp = fopen ("/tmp/live.rgb", "a");
+        if (fp) {
+            fwrite (ls->shown, LIVE_NBYTES, 1, fp);
+            fclose (fp);
+        }
     }
+}
+
+/* insure dp from stream ls_i is encoded with codec.
+ * N.B. we assume the stream's lock is held
+ */
+static void getLiveImg (int ls_i, LiveDelta *dp, LiveCodec codec)
+{
+    LiveStream *ls = &live_streams[ls_i];
+    LiveImg *ip = &dp->img[codec];
+    if (ip->mem)
+        return;
+
+    struct timeval tv0;
+    gettimeofday (&tv0, NULL);
+
+    if (dp->sprites)
+        encodeLiveImg (ip, codec, dp->sprites, dp->spr_w, BLOK_H, dp->spr_w*LIVE_BYPPIX);
+    else
+        encodeLiveImg (ip, codec, ls->shown, BUILD_W, BUILD_H, LIVE_RBYTES);
 
+    struct timeval tv1;
+    gettimeofday (&tv1, NULL);
+    if (dp->sprites)
+        ls->stats.n_gens++;
+    else
+        ls->stats.n_fulls++;
+    ls->stats.encode_us += TVDELUS (tv0, tv1);
     if (debugLevel (DEBUG_WEB, 2))
-        Serial.printf ("LIVE: client %s: sent update with %d regions %d blocks\n",
-                        ws_getaddress(client), n_regns, n_bloks);
+        Serial.printf ("LIVE: gen %u: encoded %s %s %d bytes in %ld usec\n", dp->gen, live_codec_names[codec],
+                            dp->sprites ? "update" : "image", ip->len, TVDELUS (tv0, tv1));
+}
 
-    // finished with temps
-    free (chg_regns);
-    free (img_client);
+/* return the full image of stream ls_i at its current generation encoded with codec, with an added
+ * reference.
+ * N.B. we assume the stream's lock is held
+ */
+static LiveDelta *getLiveFull (int ls_i, LiveCodec codec)
+{
+    LiveStream *ls = &live_streams[ls_i];
+
+    // start over if none or stale
+    if (!ls->full || ls->full->gen != ls->gen) {
+        if (ls->full)
+            releaseLiveDelta (ls->full);
+        ls->full = newLiveDelta (ls->gen);
+    }
+
+    getLiveImg (ls_i, ls->full, codec);
+    ls->full->refs++;
+    return (ls->full);
 }
 
-/* capture fresh screen image for client and send.
+/* return the update sent to clients already up to date, encoded with codec.
  */
-static void sendClientPNG (ws_cli_conn_t *client)
+static const LiveDelta *getLiveEmpty (LiveCodec codec)
+{
+    static LiveDelta empty_delta;
+    static uint8_t empty_hdr[4] = {BLOK_W, BLOK_H, 0, 0};
+    static pthread_mutex_t empty_lock = PTHREAD_MUTEX_INITIALIZER;
+
+    pthread_mutex_lock (&empty_lock);
+        if (!empty_delta.img[codec].mem) {
+            empty_delta.hdr = empty_hdr;
+            empty_delta.hdr_l = sizeof(empty_hdr);
+            encodeLiveImg (&empty_delta.img[codec], codec, empty_hdr, 0, BLOK_H, 0);
+        }
+    pthread_mutex_unlock (&empty_lock);
+
+    return (&empty_delta);
+}
+
+/* bring the given client up to date with its LiveStream, if full then always send a complete image.
+ */
+static void updateLiveClient (ws_cli_conn_t *client, bool full)
 {
-    // get this client's current pixels array
-    uint8_t *pixels = getSIPixels(client);
-    if (!pixels)
+    // find client's current generation and desired codec
+    uint32_t gen;
+    LiveCodec codec;
+    if (!getSIGen (client, gen, codec))
         return;
 
-    // fresh capture
-    if (!tft.getRawPix (pixels, LIVE_NPIX))
-        bye ("getRawPix for png failed\n");
+    int ls_i = getLiveStreamIndex (client);
+    LiveStream *ls = &live_streams[ls_i];
+    LiveDelta *send[LIVE_NDELTAS];
+    int n_send = 0;
+
+    // collect what client needs, with refs so they survive while sending outside the lock
+    pthread_mutex_lock (&ls->lock);
+
+        refreshLiveStream (ls_i);
+
+        // client can be brought up to date with updates if it is not too far behind
+        bool chain_ok = !full && gen > 0 && gen <= ls->gen && ls->gen - gen <= LIVE_NDELTAS;
+        for (uint32_t g = gen + 1; chain_ok && g <= ls->gen; g++) {
+            LiveDelta *dp = ls->deltas[g % LIVE_NDELTAS];
+            if (dp && dp->gen == g)
+                send[n_send++] = dp;
+            else
+                chain_ok = false;
+        }
+        if (!chain_ok) {
+            n_send = 0;
+            send[n_send++] = getLiveFull (ls_i, codec);
+        } else {
+            for (int i = 0; i < n_send; i++) {
+                getLiveImg (ls_i, send[i], codec);
+                send[i]->refs++;
+            }
+        }
+        uint32_t new_gen = ls->gen;
+
+        ls->stats.n_requests++;
+        ls->stats.n_sent += n_send;
+        for (int i = 0; i < n_send; i++)
+            ls->stats.n_bytes += send[i]->hdr_l + send[i]->img[codec].len;
+
+    pthread_mutex_unlock (&ls->lock);
+
+    // send each, or an empty update if client is already current
+    if (n_send == 0) {
+        sendLiveDelta (client, getLiveEmpty (codec), codec);
+    } else {
+        for (int i = 0; i < n_send; i++)
+            sendLiveDelta (client, send[i], codec);
+    }
+    setSIGen (client, new_gen);
+
+    if (debugLevel (DEBUG_WEB, 2))
+        Serial.printf ("LIVE: client %s: gen %u -> %u with %d %s\n", ws_getaddress(client), gen, new_gen,
+                        n_send, !chain_ok ? "image" : "updates");
+
+    // finished with sent
+    pthread_mutex_lock (&ls->lock);
+        for (int i = 0; i < n_send; i++)
+            releaseLiveDelta (send[i]);
+    pthread_mutex_unlock (&ls->lock);
+}
+
+/* send difference between client's last known screen image and the current image.
+ */
+static void updateExistingClient (ws_cli_conn_t *client)
+{
+    updateLiveClient (client, false);
+}
 
-    // convert image to and send as png
-    stbi_write_png_compression_level = 2;       // faster with hardly any increase in size
-    stbi_write_png_to_func (wifiSTBWrite_helper, client, BUILD_W, BUILD_H, COMP_RGB, pixels, LIVE_RBYTES);
+/* send fresh screen image to client.
+ */
+static void sendClientPNG (ws_cli_conn_t *client)
+{
+    updateLiveClient (client, true);
 
     if (debugLevel (DEBUG_WEB, 1))
-        Serial.printf ("LIVE: client %s: sent full PNG\n", ws_getaddress(client));
+        Serial.printf ("LIVE: client %s: sent full image\n", ws_getaddress(client));
 }
 
 /* send message that user wants full screen.
@@ -429,6 +759,43 @@ static void getLivePNG (ws_cli_conn_t *client, char args[], size_t args_len)
     sendClientPNG (client);
 }
 
+/* client running liveweb-html.cpp is asking for a particular image encoding.
+ */
+static void setLiveCodec (ws_cli_conn_t *client, char args[], size_t args_len)
+{
+    WebArgs wa;
+    wa.nargs = 0;
+    wa.name[wa.nargs++] = "codec";
+
+    // parse
+    if (!parseWebCommand (wa, args, args_len) || !wa.found[0]) {
+        Serial.printf ("LIVE: set_codec garbled: %s\n", args);
+        return;
+    }
+
+    // find
+    int codec;
+    for (codec = 0; codec < LIVE_NCODECS; codec++)
+        if (strcmp (wa.value[0], live_codec_names[codec]) == 0)
+            break;
+    if (codec == LIVE_NCODECS) {
+        Serial.printf ("LIVE: unknown codec %s\n", wa.value[0]);
+        return;
+    }
+
+    // record
+    pthread_mutex_lock (&si_lock);
+    for (int i = 0; i < si_n; i++) {
+        if (si_list[i].client == client) {
+            si_list[i].codec = (LiveCodec) codec;
+            break;
+        }
+    }
+    pthread_mutex_unlock (&si_lock);
+
+    Serial.printf ("LIVE: client %s: set codec %s\n", ws_getaddress(client), live_codec_names[codec]);
+}
+
 /* client running liveweb-html.cpp is asking for incremental screen update.
  * we might also:
  *   send a message to enable fullscreen once ready from setup.cpp. must be sent continuously
@@ -688,8 +1055,19 @@ static void sendLiveFavicon (FILE *sockfp)
         Serial.printf ("LIVE: sent favicon\n");
 }
 
+/* return whether the given dotted IPv4 address is loopback, link-local or private.
+ */
+static bool isLANAddress (const char *addr)
+{
+    unsigned a, b;
+    if (!addr || sscanf (addr, "%u.%u", &a, &b) != 2)
+        return (false);
+    return (a == 10 || a == 127 || (a == 172 && b >= 16 && b <= 31) || (a == 192 && b == 168)
+                        || (a == 169 && b == 254));
+}
+
 /* callback when browser asks for a new websocket connection.
- * assign a fresh si_list for keeping track its pixels.
+ * assign a fresh si_list entry for keeping track of its image generation.
  */
 static void ws_onopen(ws_cli_conn_t *client)
 {
@@ -704,11 +1082,6 @@ static void ws_onopen(ws_cli_conn_t *client)
         SessionInfo *sip = &si_list[i];
         if (!sip->client) {
             new_sip = sip;
-            // insure no stale pixels
-            if (new_sip->pixels) {
-                free (new_sip->pixels);
-                new_sip->pixels = NULL;
-            }
             break;
         }
     }
@@ -728,12 +1101,11 @@ static void ws_onopen(ws_cli_conn_t *client)
         }
     }
 
-    // init including memory for pixels but don't capture until client asks for them
+    // init but client has no image until it asks
     if (new_sip) {
         new_sip->client = client;
-        new_sip->pixels = (uint8_t *) malloc (LIVE_NBYTES);
-        if (!new_sip->pixels)
-            bye ("No memory for new live session pixels\n");
+        new_sip->gen = 0;
+        new_sip->codec = isLANAddress (ws_getaddress(client)) ? LIVE_QOI : LIVE_PNG;
 
         // increment appropriate counter
         if (client->port == liveweb_ro_port) {
@@ -762,12 +1134,6 @@ static void ws_onclose (ws_cli_conn_t *client)
         if (sip->client == client) {
             sip->client = NULL;
 
-            // recycle pixel memory
-            if (sip->pixels) {
-                free (sip->pixels);
-                sip->pixels = NULL;
-            }
-
             // decrement appropriate counter
             if (client->port == liveweb_ro_port) {
                 n_roweb -= 1;
@@ -803,6 +1169,7 @@ static void ws_onmessage (ws_cli_conn_t *client, const unsigned char *msg, uint6
         {"set_touch?",    setLiveTouch},
         {"set_char?",     setLiveChar},
         {"get_live.png?", getLivePNG},
+        {"set_codec?",    setLiveCodec},
     };
 
     // msg as null-terminated string cmd
@@ -887,6 +1254,10 @@ void initLiveWeb (bool verbose)
         // handle all write errors inline
         signal (SIGPIPE, SIG_IGN);
 
+        // prepare shared image streams
+        for (int i = 0; i < LIVE_NSTREAMS; i++)
+            pthread_mutex_init (&live_streams[i].lock, NULL);
+
         // actually start stuff unless not wanted
 
         // R/W service
@@ -948,3 +1319,21 @@ bool isLiveWebTouch (void)
 {
     return (lastest_ws_touch_client != NULL);
 }
+
+/* pass back the sum of the performance counters of all live streams.
+ */
+void getLiveWebStats (LiveWebStats &s)
+{
+    memset (&s, 0, sizeof(s));
+    for (int i = 0; i < LIVE_NSTREAMS; i++) {
+        LiveStream *ls = &live_streams[i];
+        pthread_mutex_lock (&ls->lock);
+            s.n_gens += ls->stats.n_gens;
+            s.n_fulls += ls->stats.n_fulls;
+            s.encode_us += ls->stats.encode_us;
+            s.n_requests += ls->stats.n_requests;
+            s.n_sent += ls->stats.n_sent;
+            s.n_bytes += ls->stats.n_bytes;
+        pthread_mutex_unlock (&ls->lock);
+    }
+}
@@ -18,10 +18,23 @@
 #include "HamClock.h"
 #include "zlib.h"                                       // ours
 
-// persistent state of open files, allows restarting
-static FILE *day_fp, *night_fp;                         // open day and night files
-static int day_nbytes, night_nbytes;                    // bytes mmap'ed
-static char *day_pixels, *night_pixels;                 // pixels mmap'ed
+/* one resident pair of day and night map pixels.
+ * map_cache keeps one per CoreMaps in map_rotset so returning to a map is just a pointer swap.
+ */
+typedef struct {
+    char dfile[100], nfile[100];                        // file names, these also encode style, zoom and units
+    char *day_mem, *night_mem;                          // mmap'ed EarthPyr files, always color
+    int nbytes;                                         // bytes in each
+    time_t d_mtime, n_mtime;                            // file mod times when loaded
+} MapCache;
+
+static MapCache map_cache[CM_N];                        // resident maps, guard with map_cache_lock
+static CoreMaps installed_cm = CM_NONE;                 // map_cache entry now in tft, if any
+static pthread_mutex_t map_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// background prefetch of the next map in rotation, both used only by the loop() thread
+static TaskFuture prefetch_f;                           // prefetchTask() running or not yet reaped, else NULL
+static CoreMaps prefetch_cm;                            // the map it is working on
 
 
 // BMP file format parameters
@@ -81,41 +94,32 @@ static bool downloadZFile (WiFiClient &client, const char *filename, long len)
 }
 
 
-/* invalidate pixel connection until proven good again.
+/* free the pixels in the given cache entry and mark it empty.
+ * N.B. caller must hold map_cache_lock and insure the entry is not installed in tft
  */
-static void invalidatePixels()
+static void freeMapCache (MapCache &mc)
 {
-        // disconnect from tft thread
-        tft.setEarthPix (NULL, NULL, 0, 0);
-
-        if (getGrayDisplay() == GRAY_OFF) {
-            // unmap pixel arrays
-            if (day_pixels) {
-                munmap (day_pixels, day_nbytes);
-                day_pixels = NULL;
-            }
-            if (night_pixels) {
-                munmap (night_pixels, night_nbytes);
-                night_pixels = NULL;
-            }
-        } else {
-            // gray scale pixels are local arrays
-            free (day_pixels);
-            day_pixels = NULL;
-            free (night_pixels);
-            night_pixels = NULL;
-        }
+        if (mc.day_mem)
+            munmap (mc.day_mem, mc.nbytes);
+        if (mc.night_mem)
+            munmap (mc.night_mem, mc.nbytes);
+        mc = {};
 }
 
-/* convert the given RGB565 from color to gray
+/* invalidate pixel connection until proven good again.
+ * also release any resident maps no longer in map_rotset.
  */
-static uint16_t RGB565TOGRAY (uint16_t c)
+static void invalidatePixels()
 {
-        uint16_t r = RGB565_R(c);
-        uint16_t g = RGB565_G(c);
-        uint16_t b = RGB565_B(c);
-        uint16_t gray = RGB2GRAY(r,g,b);
-        return (RGB565 (gray, gray, gray));
+        // disconnect from tft thread
+        tft.setEarthPix (NULL, NULL);
+
+        pthread_mutex_lock (&map_cache_lock);
+        installed_cm = CM_NONE;
+        for (int i = 0; i < CM_N; i++)
+            if (!IS_CMROT(i) && map_cache[i].day_mem)
+                freeMapCache (map_cache[i]);
+        pthread_mutex_unlock (&map_cache_lock);
 }
 
 /* make the day and night file names for the given map style
@@ -139,109 +143,214 @@ static void mkMapFilenames (CoreMaps cm, char dfile[], char nfile[], int zoom, s
         }
 }
 
-/* prepare open day_fp and night_fp for pixel access.
- * gray images are converted into memory arrays.
- * return whether ok
+/* make the name of the tiled pyramid file built from the given BMP file name
  */
-static bool installFilePixels (const char *dfile, const char *nfile)
+static void mkPyrFilename (const char *bmpfile, char pyrfile[], size_t pf_l)
 {
-        bool ok = false;
-
-        // mmap pixels if both files are open
-        if (day_fp && night_fp) {
+        const char *dot = strrchr (bmpfile, '.');
+        int base_l = dot ? (int)(dot - bmpfile) : (int)strlen(bmpfile);
+        snprintf (pyrfile, pf_l, "%.*s.pyr", base_l, bmpfile);
+}
 
-            day_nbytes = BHDRSZ + ZOOM_W*ZOOM_H*BPERBMPPIX;
-            night_nbytes = BHDRSZ + ZOOM_W*ZOOM_H*BPERBMPPIX;
-            day_pixels = (char *)                               // allow OS to choose addrs
-                    mmap (NULL, day_nbytes, PROT_READ, MAP_PRIVATE, fileno(day_fp), 0);
-            night_pixels = (char *)
-                    mmap (NULL, night_nbytes, PROT_READ, MAP_PRIVATE, fileno(night_fp), 0);
+/* return the tiled pyramid for the given open BMP file, or NULL if trouble.
+ * the pyramid is kept in a companion .pyr file, built only if absent or made from an older BMP, then mmap'ed.
+ * the BMP file is always closed. return its mod time in bmp_mtime.
+ * N.B. safe to call from any thread
+ */
+static char *openMapPyramid (const char *bmpfile, FILE *bfp, int zoom, time_t &bmp_mtime)
+{
+        if (!bfp) {
+            Serial.printf ("%s not open\n", bmpfile);
+            return (NULL);
+        }
 
-            ok = day_pixels != MAP_FAILED && night_pixels != MAP_FAILED;
+        const int zoom_w = HC_MAP_W*zoom;
+        const int zoom_h = HC_MAP_H*zoom;
+        const size_t pyr_nbytes = earthPyrSize (zoom_w, zoom_h);
+        char pyrfile[110];
+        mkPyrFilename (bmpfile, pyrfile, sizeof(pyrfile));
+
+        struct stat sbuf;
+        if (fstat (fileno(bfp), &sbuf) < 0) {
+            Serial.printf ("%s: fstat %s\n", bmpfile, strerror(errno));
+            fclose (bfp);
+            return (NULL);
+        }
+        bmp_mtime = sbuf.st_mtime;
+
+        // use existing pyramid if it was built from this very BMP
+        char *pyr = NULL;
+        FILE *pfp = fopenOurs (pyrfile, "r");
+        if (pfp) {
+            pyr = (char *) mmap (NULL, pyr_nbytes, PROT_READ, MAP_PRIVATE, fileno(pfp), 0);
+            if (pyr == MAP_FAILED)
+                pyr = NULL;
+            else if (fstat (fileno(pfp), &sbuf) < 0 || (size_t)sbuf.st_size != pyr_nbytes
+                        || !earthPyrOk ((EarthPyr*)pyr, pyr_nbytes, zoom_w, zoom_h)
+                        || ((EarthPyr*)pyr)->src_mtime != (int64_t)bmp_mtime) {
+                munmap (pyr, pyr_nbytes);
+                pyr = NULL;
+            }
+            fclose (pfp);
         }
 
-        // install pixels if ok
-        if (ok) {
+        // else build a new one, renamed into place when complete so it is never seen partially written
+        if (!pyr) {
+            struct timeval tv0, tv1;
+            gettimeofday (&tv0, NULL);
 
-            // Serial.println ("both mmaps good");
-
-            // don't need files open once mmap has been established
-            fclose(day_fp);
-            day_fp = NULL;
-            fclose(night_fp);
-            night_fp = NULL;
-
-            if (getGrayDisplay() != GRAY_OFF) {
-
-                // convert to gray images in memory
-
-                // prep new arrays
-                const int n_mem_bytes = ZOOM_W*ZOOM_H*BPERBMPPIX;
-                char *mem_day_pixels = (char *) malloc (n_mem_bytes);
-                char *mem_night_pixels = (char *) malloc (n_mem_bytes);
-                if (!mem_day_pixels || !mem_night_pixels)
-                    fatalError ("No memory for gray scale image");
-
-                // handy pixel pointers from mmap to memory
-                uint16_t *fdp = (uint16_t *) (day_pixels + BHDRSZ);
-                uint16_t *fnp = (uint16_t *) (night_pixels + BHDRSZ);
-                uint16_t *tdp = (uint16_t *) (mem_day_pixels);
-                uint16_t *tnp = (uint16_t *) (mem_night_pixels);
-
-                // convert each pixel
-                int n_mem_pix = n_mem_bytes/2;
-                struct timeval tv0, tv1;
-                gettimeofday (&tv0, NULL);
-                while (--n_mem_pix >= 0) {
-                    *tdp++ = RGB565TOGRAY(*fdp++);
-                    *tnp++ = RGB565TOGRAY(*fnp++);
-                }
-                gettimeofday (&tv1, NULL);
-                Serial.printf ("gray conversion took %ld us\n",
+            const size_t bmp_nbytes = BHDRSZ + (size_t)zoom_w*zoom_h*BPERBMPPIX;
+            char *bmp = (char *) mmap (NULL, bmp_nbytes, PROT_READ, MAP_PRIVATE, fileno(bfp), 0);
+            if (bmp == MAP_FAILED) {
+                Serial.printf ("%s mmap failed: %s\n", bmpfile, strerror(errno));
+                fclose (bfp);
+                return (NULL);
+            }
+
+            char tmpfile[120];
+            snprintf (tmpfile, sizeof(tmpfile), "%s.tmp", pyrfile);
+            FILE *tfp = fopenOurs (tmpfile, "w+");
+            char *tpyr = (char *) MAP_FAILED;
+            if (!tfp)
+                Serial.printf ("%s: %s\n", tmpfile, strerror(errno));
+            else if (ftruncate (fileno(tfp), pyr_nbytes) < 0)
+                Serial.printf ("%s: truncate %s\n", tmpfile, strerror(errno));
+            else if ((tpyr = (char *) mmap (NULL, pyr_nbytes, PROT_READ|PROT_WRITE, MAP_SHARED,
+                                                fileno(tfp), 0)) == MAP_FAILED)
+                Serial.printf ("%s mmap failed: %s\n", tmpfile, strerror(errno));
+            else {
+                buildEarthPyr ((const uint16_t *)(bmp + BHDRSZ), zoom_w, zoom_h, bmp_mtime, (EarthPyr*)tpyr);
+                munmap (tpyr, pyr_nbytes);
+                std::string tp = our_dir + tmpfile;
+                std::string pp = our_dir + pyrfile;
+                if (rename (tp.c_str(), pp.c_str()) < 0)
+                    Serial.printf ("%s: rename %s\n", pyrfile, strerror(errno));
+                else if ((pyr = (char *) mmap (NULL, pyr_nbytes, PROT_READ, MAP_PRIVATE, fileno(tfp), 0))
+                                == MAP_FAILED)
+                    pyr = NULL;
+            }
+            if (tfp) {
+                fclose (tfp);
+                if (!pyr)
+                    unlinkOurs (tmpfile);
+            }
+            munmap (bmp, bmp_nbytes);
+
+            gettimeofday (&tv1, NULL);
+            LOGD ("%s: built in %ld us\n", pyrfile,
                                             (tv1.tv_sec-tv0.tv_sec)*1000000 + (tv1.tv_usec - tv0.tv_usec));
+        }
 
-                // replace mmap with gray memory copy
-                munmap (day_pixels, day_nbytes);
-                day_pixels = mem_day_pixels;
-                munmap (night_pixels, night_nbytes);
-                night_pixels = mem_night_pixels;
+        // done with BMP
+        fclose (bfp);
 
-                // install in tft at start of pixels
-                tft.setEarthPix (day_pixels, night_pixels, ZOOM_W, ZOOM_H);
+        return (pyr);
+}
 
-            } else {
-                // install in tft at start of pixels
-                tft.setEarthPix (day_pixels+BHDRSZ, night_pixels+BHDRSZ, ZOOM_W, ZOOM_H);
-            }
+/* load the pyramids for the given open day and night BMP files into mc.
+ * gray display is applied by tft as the pixels are drawn so the pyramids always stay mmap'ed in color.
+ * files are always closed. mc is only changed if return true.
+ * N.B. safe to call from any thread
+ */
+static bool loadMapPixels (const char *dfile, FILE *dfp, const char *nfile, FILE *nfp, int zoom, MapCache &mc)
+{
+        const int nbytes = earthPyrSize (HC_MAP_W*zoom, HC_MAP_H*zoom);
+        time_t d_mtime = 0, n_mtime = 0;
+
+        char *day_pyr = openMapPyramid (dfile, dfp, zoom, d_mtime);
+        char *night_pyr = openMapPyramid (nfile, nfp, zoom, n_mtime);
+        bool ok = day_pyr && night_pyr;
+
+        if (ok) {
+
+            // fill in
+            mc = {};
+            snprintf (mc.dfile, sizeof(mc.dfile), "%s", dfile);
+            snprintf (mc.nfile, sizeof(mc.nfile), "%s", nfile);
+            mc.day_mem = day_pyr;
+            mc.night_mem = night_pyr;
+            mc.nbytes = nbytes;
+            mc.d_mtime = d_mtime;
+            mc.n_mtime = n_mtime;
 
         } else {
 
             // no go -- clean up
+            MapCache bad = {};
+            bad.day_mem = day_pyr;
+            bad.night_mem = night_pyr;
+            bad.nbytes = nbytes;
+            freeMapCache (bad);
+        }
 
-            if (day_fp) {
-                fclose(day_fp);
-                day_fp = NULL;
-            } else
-                Serial.printf ("%s not open\n", dfile);
-            if (day_pixels == MAP_FAILED)
-                Serial.printf ("%s mmap failed: %s\n", dfile, strerror(errno));
-            else if (day_pixels)
-                munmap (day_pixels, day_nbytes);
-            day_pixels = NULL;
-
-            if (night_fp) {
-                fclose(night_fp);
-                night_fp = NULL;
-            } else
-                Serial.printf ("%s not open\n", nfile);
-            if (night_pixels == MAP_FAILED)
-                Serial.printf ("%s mmap failed: %s\n", nfile, strerror(errno));
-            else if (night_pixels)
-                munmap (night_pixels, night_nbytes);
-            night_pixels = NULL;
+        return (ok);
+}
 
-        }
+/* hand map_cache[cm] to tft.
+ * N.B. caller must hold map_cache_lock
+ */
+static void connectMapCache (CoreMaps cm)
+{
+        MapCache &mc = map_cache[cm];
+        tft.setEarthPix ((const EarthPyr *)mc.day_mem, (const EarthPyr *)mc.night_mem);
+        installed_cm = cm;
+}
 
+/* replace map_cache[cm] with mc and install it in tft.
+ */
+static void installMapCache (CoreMaps cm, const MapCache &mc)
+{
+        pthread_mutex_lock (&map_cache_lock);
+        freeMapCache (map_cache[cm]);
+        map_cache[cm] = mc;
+        connectMapCache (cm);
+        pthread_mutex_unlock (&map_cache_lock);
+}
+
+/* discard map_cache[cm], such as before its files might be rewritten.
+ */
+static void dropMapCache (CoreMaps cm)
+{
+        pthread_mutex_lock (&map_cache_lock);
+        if (installed_cm != cm)
+            freeMapCache (map_cache[cm]);
+        pthread_mutex_unlock (&map_cache_lock);
+}
+
+/* return whether the given file still has the given mod time and is not older than max_age.
+ */
+static bool mapFileUnchanged (const char *filename, time_t mtime, int max_age)
+{
+        std::string dp = our_dir + filename;
+        struct stat sbuf;
+        if (stat (dp.c_str(), &sbuf) < 0 || sbuf.st_mtime != mtime)
+            return (false);
+        return (max_age == CACHE_FOREVER || myNow() - mtime <= max_age);
+}
+
+/* return whether map_cache[cm] holds the given files, still current.
+ * N.B. caller must hold map_cache_lock
+ */
+static bool mapCacheOk (CoreMaps cm, const char *dfile, const char *nfile)
+{
+        const MapCache &mc = map_cache[cm];
+        return (mc.day_mem && strcmp (mc.dfile, dfile) == 0 && strcmp (mc.nfile, nfile) == 0
+                    && mapFileUnchanged (dfile, mc.d_mtime, cm_info[cm].max_age)
+                    && mapFileUnchanged (nfile, mc.n_mtime, cm_info[cm].max_age));
+}
+
+/* if map_cache[cm] is still good for the given files install it in tft and return true, else false.
+ */
+static bool useMapCache (CoreMaps cm, const char *dfile, const char *nfile)
+{
+        pthread_mutex_lock (&map_cache_lock);
+        bool ok = mapCacheOk (cm, dfile, nfile);
+        if (ok)
+            connectMapCache (cm);
+        pthread_mutex_unlock (&map_cache_lock);
+
+        if (ok)
+            LOGD ("%s: using resident map\n", cm_info[cm].name);
         return (ok);
 }
 
@@ -308,7 +417,7 @@ long max_age)
             static int use_prev_minute;                 // prev hour ok if current minute is less than this
             if (use_prev_minute == 0) {
                 use_prev_minute = 1 + random(58);       // [1,58]
-                Serial.printf ("maps can update after %d min after the hour\n", use_prev_minute);
+                LOGD ("maps can update after %d min after the hour\n", use_prev_minute);
             }
 
             // reuse previous hour's file if early enough within this hour
@@ -328,17 +437,18 @@ long max_age)
         }
 
         if (ok) {
-            Serial.printf ("%s: using local D and N files\n", style);
+            LOGD ("%s: using local D and N files\n", style);
         } else {
             // download new twin voacap maps
-            Serial.printf ("%s: downloading fresh D and N files\n", style);
+            LOGD ("%s: downloading fresh D and N files\n", style);
+            dropMapCache (core_map);
             updateClocks(false);
             WiFiClient client;
             if (client.connect(backend_host, backend_port)) {
                 mapMsg (0, "%s", msg);
                 char url[2*QBUFLEN];
                 snprintf (url, sizeof(url), "/%s?%s", page, query);
-                Serial.printf ("running %s\n", url);
+                LOGD ("running %s\n", url);
                 httpHCGET (client, backend_host, url);
                 char x_len[100];
                 if (httpSkipHeader (client, "X-2Z-lengths: ", x_len, sizeof(x_len))) {
@@ -357,11 +467,12 @@ long max_age)
             }
         }
 
-        // install if ok
-        if (ok) {
-            day_fp = fopenOurs (q_dfn, "r");
-            night_fp = fopenOurs (q_nfn, "r");
-            ok = installFilePixels (q_dfn, q_nfn);
+        // install if ok, reusing resident copy if still current
+        if (ok && !useMapCache (core_map, q_dfn, q_nfn)) {
+            MapCache mc;
+            ok = loadMapPixels (q_dfn, fopenOurs (q_dfn, "r"), q_nfn, fopenOurs (q_nfn, "r"), pan_zoom.zoom, mc);
+            if (ok)
+                installMapCache (core_map, mc);
         }
 
         // check again
@@ -372,10 +483,11 @@ long max_age)
 }
 
 
-/* open the given CoreMaps RGB565 BMP file, downloading fresh if absent or too old.
+/* open the given CoreMaps RGB565 BMP file at the given zoom, downloading fresh if absent or too old.
+ * show progress on the map using title unless NULL, which also makes this safe to call from any thread.
  * if ok, return open FILE* positioned at first pixel, else return NULL.
  */
-static FILE *openMapFile (CoreMaps cm, const char *filename, const char *title)
+static FILE *openMapFile (CoreMaps cm, const char *filename, const char *title, int zoom)
 {
         // trust but verify
         bool ok = true;
@@ -383,7 +495,7 @@ static FILE *openMapFile (CoreMaps cm, const char *filename, const char *title)
         // open local file
         FILE *fp = fopenOurs (filename, "r");
         if (!fp) {
-            Serial.printf ("%s: not local\n", filename);
+            LOGD ("%s: not local\n", filename);
             ok = false;
         }
 
@@ -396,10 +508,10 @@ static FILE *openMapFile (CoreMaps cm, const char *filename, const char *title)
             } else {
                 long age = myNow() - sbuf.st_mtime;
                 if (age > cm_info[cm].max_age) {
-                    Serial.printf ("%s too old: %ld > %d secs\n", filename, age, cm_info[cm].max_age);
+                    LOGD ("%s too old: %ld > %d secs\n", filename, age, cm_info[cm].max_age);
                     ok = false;
                 } else
-                    Serial.printf ("%s: age ok: %ld < %d\n", filename, age, cm_info[cm].max_age);
+                    LOGD ("%s: age ok: %ld < %d\n", filename, age, cm_info[cm].max_age);
             }
         }
 
@@ -418,7 +530,7 @@ static FILE *openMapFile (CoreMaps cm, const char *filename, const char *title)
         // suitable for Earth map?
         if (ok) {
             // negative img_h is required to indicate pixels can be displayed top-to-bottom
-            if (img_w != ZOOM_W || -img_h != ZOOM_H || img_bpp != 16 || img_pad != 0) {
+            if (img_w != HC_MAP_W*zoom || -img_h != HC_MAP_H*zoom || img_bpp != 16 || img_pad != 0) {
                 Serial.printf ("%s: unsuitable image: w= %d h= %d bpp= %d pad= %d\n", filename,
                                         img_w, img_h, img_bpp, img_pad);
                 ok = false;
@@ -441,11 +553,11 @@ static FILE *openMapFile (CoreMaps cm, const char *filename, const char *title)
                 WiFiClient client;
                 if (client.connect(backend_host, backend_port)) {
                     // show message for larger images
-                    if (BUILD_W * pan_zoom.zoom > 4800)
+                    if (title && BUILD_W * zoom > 4800)
                         mapMsg (0, "%s", title);
                     char url[256];
                     snprintf (url, sizeof(url), "/maps/%s.z", filename);
-                    Serial.printf ("downloading %s\n", url);
+                    LOGD ("downloading %s\n", url);
                     httpHCGET (client, backend_host, url);
                     char c_l[100];
                     if (httpSkipHeader (client, "Content-Length: ", c_l, sizeof(c_l)) &&
@@ -453,8 +565,12 @@ static FILE *openMapFile (CoreMaps cm, const char *filename, const char *title)
                         fp = fopenOurs (filename, "r");
                     client.stop();
                 }
-                if (!fp)
-                    mapMsg (1000, "%s: download failed", title);
+                if (!fp) {
+                    if (title)
+                        mapMsg (1000, "%s: download failed", title);
+                    else
+                        Serial.printf ("%s: download failed\n", filename);
+                }
             }
         }
 
@@ -462,6 +578,38 @@ static FILE *openMapFile (CoreMaps cm, const char *filename, const char *title)
         return (fp);
 }
 
+/* one zoom level of a CM_USER map being built by installWebMapImages()
+ */
+typedef struct {
+    const char *image;                          // entire BMP file in memory
+    long image_len;                             // bytes in image
+    ImageRefit fit;                             // how to fit image to map
+    int zoom;                                   // zoom level to build
+    bool ok;                                    // set if built successfully
+    Message ynot;                               // reason if not
+} WebMapZoom;
+
+/* pool task to build and save one CM_USER zoom level from the image in a WebMapZoom.
+ */
+static void webMapZoomTask (void *arg)
+{
+        WebMapZoom *wz = (WebMapZoom *) arg;
+
+        char dfile[100], nfile[100];
+        GenReader gr(wz->image, wz->image_len);
+        SBox z_b;
+        z_b.x = z_b.y = 0;
+        z_b.w = HC_MAP_W * wz->zoom;
+        z_b.h = HC_MAP_H * wz->zoom;
+        uint16_t *z_565;
+        mkMapFilenames (CM_USER, dfile, nfile, wz->zoom, sizeof(dfile));
+        if (!readBMPImage (gr, z_b, z_565, wz->fit, wz->ynot))                   // N.B. free z_565!
+            return;
+        wz->ok = writeBMP565File (dfile, z_565, z_b.w, z_b.h, wz->ynot)
+                        && writeBMP565File (nfile, z_565, z_b.w, z_b.h, wz->ynot);
+        free (z_565);
+}
+
 /* read any BMP from the given web connection and save for use by CM_USER.
  * client is positioned at start of image.
  * return whether image is suitable with reason why if not.
@@ -490,37 +638,35 @@ bool installWebMapImages (WiFiClient &client, long content_length, ImageRefit fi
         if (debugLevel(DEBUG_BMP, 1)) {
             struct timeval tv1;
             gettimeofday (&tv1, NULL);
-            Serial.printf ("BMP: download %ld bytes in %ld us\n", content_length, (long)TVDELUS(tv0,tv1));
+            LOGD ("BMP: download %ld bytes in %ld us\n", content_length, (long)TVDELUS(tv0,tv1));
         }
 
         // fresh
         rmWebMapImages();
 
-        // save at each possible zoom level
-        for (int z = MIN_ZOOM; z <= MAX_ZOOM; z++) {
-            char dfile[100], nfile[100];
-            GenReader gr(image, content_length);
-            SBox z_b;
-            z_b.x = z_b.y = 0;
-            z_b.w = HC_MAP_W * z;
-            z_b.h = HC_MAP_H * z;
-            uint16_t *z_565;
-            mkMapFilenames (CM_USER, dfile, nfile, z, sizeof(dfile));
-            if (!readBMPImage (gr, z_b, z_565, fit, ynot)) {                    // N.B. free z_565!
-                return(false);
-            }
-            if (!writeBMP565File (dfile, z_565, z_b.w, z_b.h, ynot)) {
-                free (z_565);
-                return(false);
-            }
-            if (!writeBMP565File (nfile, z_565, z_b.w, z_b.h, ynot)) {
-                free (z_565);
-                return(false);
-            }
-            free (z_565);
+        // save at each possible zoom level, all at once on the task pool
+        #define N_WEBZOOM (MAX_ZOOM - MIN_ZOOM + 1)
+        WebMapZoom zooms[N_WEBZOOM];
+        TaskFuture futures[N_WEBZOOM];
+        for (int i = 0; i < N_WEBZOOM; i++) {
+            WebMapZoom &wz = zooms[i];
+            wz.image = image;
+            wz.image_len = content_length;
+            wz.fit = fit;
+            wz.zoom = MIN_ZOOM + i;
+            wz.ok = false;
+            futures[i] = startTask (webMapZoomTask, &wz);
         }
+        for (int i = 0; i < N_WEBZOOM; i++)
+            waitTask (futures[i]);
 
-        // ok!
+        // ok only if all are
+        for (int i = 0; i < N_WEBZOOM; i++) {
+            if (!zooms[i].ok) {
+                ynot = zooms[i].ynot;
+                return (false);
+            }
+        }
         return (true);
 }
 
@@ -552,8 +698,102 @@ bool allWebMapImagesOk (void)
     return (true);
 }
 
+/* return the CoreMaps that follows core_map in map_rotset.
+ */
+static CoreMaps nextRotMap (void)
+{
+    for (int i = 1; i < CM_N; i++) {
+        int ci = (core_map + i) % CM_N;
+        if (IS_CMROT(ci))
+            return ((CoreMaps)ci);
+    }
+    fatalError ("Bogus map rotation set: 0x%x\n", map_rotset);
+    return (CM_NONE);       // lint
+}
+
+/* what prefetchTask() is to load
+ */
+typedef struct {
+    CoreMaps cm;
+    char dfile[100], nfile[100];
+    int zoom;
+} MapPrefetch;
+
+/* pool task to load the files in the malloced MapPrefetch into map_cache, downloading if necessary.
+ */
+static void prefetchTask (void *arg)
+{
+        MapPrefetch *mp = (MapPrefetch *) arg;
+
+        // N.B. old entry can not be installed now because installFileMaps() waits for us
+        dropMapCache (mp->cm);
+
+        FILE *dfp = openMapFile (mp->cm, mp->dfile, NULL, mp->zoom);
+        FILE *nfp = openMapFile (mp->cm, mp->nfile, NULL, mp->zoom);
+        MapCache mc;
+        if (loadMapPixels (mp->dfile, dfp, mp->nfile, nfp, mp->zoom, mc)) {
+            pthread_mutex_lock (&map_cache_lock);
+            if (installed_cm != mp->cm) {
+                freeMapCache (map_cache[mp->cm]);
+                map_cache[mp->cm] = mc;
+            } else
+                freeMapCache (mc);
+            pthread_mutex_unlock (&map_cache_lock);
+            LOGD ("%s: prefetched\n", cm_info[mp->cm].name);
+        }
+
+        free (mp);
+}
+
+/* reap prefetchTask() if it has finished, return whether one is still running.
+ */
+static bool prefetchRunning (void)
+{
+        if (prefetch_f && taskReady (prefetch_f)) {
+            waitTask (prefetch_f);
+            prefetch_f = NULL;
+        }
+        return (prefetch_f != NULL);
+}
+
+/* start loading the given file map in the background unless already resident or busy with another.
+ */
+static void startMapPrefetch (CoreMaps next_cm)
+{
+        if (prefetchRunning() || !CM_ISFILE(next_cm))
+            return;
+
+        // capture everything now so the task need not look at changing state
+        MapPrefetch *mp = (MapPrefetch *) calloc (1, sizeof(MapPrefetch));
+        if (!mp)
+            fatalError ("No memory for map prefetch");
+        mp->cm = next_cm;
+        mp->zoom = pan_zoom.zoom;
+        mkMapFilenames (next_cm, mp->dfile, mp->nfile, mp->zoom, sizeof(mp->dfile));
+
+        // skip if already good
+        pthread_mutex_lock (&map_cache_lock);
+        bool ok = mapCacheOk (next_cm, mp->dfile, mp->nfile);
+        pthread_mutex_unlock (&map_cache_lock);
+        if (ok) {
+            free (mp);
+            return;
+        }
+
+        prefetch_cm = next_cm;
+        prefetch_f = startTask (prefetchTask, mp);
+}
+
+/* start loading core_map in the background if it is a file map, return at once.
+ * installFreshMaps() will wait for it to finish then use it.
+ */
+void prefetchCoreMap (void)
+{
+        startMapPrefetch (core_map);
+}
+
 /* install maps for the given CoreMap that are just files maintained on the server, no update query required.
- * Download only if absent or stale.
+ * use the resident copy if still current, else download only if absent or stale.
  * return whether ok
  */
 static bool installFileMaps (CoreMaps cm)
@@ -576,17 +816,42 @@ static bool installFileMaps (CoreMaps cm)
         // fresh start
         invalidatePixels();
         (void) cleanCache (style, 2*cm_info[cm].max_age);         // don't hammer immediately
-        if (day_fp)
-            fclose(day_fp);
-        if (night_fp)
-            fclose(night_fp);
 
-        // open each file, downloading if newer or not found locally
-        day_fp = openMapFile (cm, dfile, dtitle);
-        night_fp = openMapFile (cm, nfile, ntitle);
+        // let any prefetch of this very map finish so we can use it, keeping the clocks going meanwhile
+        if (prefetchRunning() && prefetch_cm == cm) {
+            while (!taskReady (prefetch_f)) {
+                updateClocks(false);
+                wdDelay(50);
+            }
+            (void) prefetchRunning();
+        }
+
+        // use resident copy if still good
+        bool ok = useMapCache (cm, dfile, nfile);
+        if (!ok) {
+
+            // release old copy before its files might be rewritten
+            dropMapCache (cm);
+
+            // open each file, downloading if newer or not found locally
+            FILE *dfp = openMapFile (cm, dfile, dtitle, pan_zoom.zoom);
+            FILE *nfp = openMapFile (cm, nfile, ntitle, pan_zoom.zoom);
+
+            // install pixels
+            MapCache mc;
+            ok = loadMapPixels (dfile, dfp, nfile, nfp, pan_zoom.zoom, mc);
+            if (ok)
+                installMapCache (cm, mc);
+        }
 
-        // install pixels
-        return (installFilePixels (dfile, nfile));
+        // get the next one ready while this one is showing
+        if (ok && mapIsRotating()) {
+            CoreMaps next_cm = nextRotMap();
+            if (next_cm != core_map)
+                startMapPrefetch (next_cm);
+        }
+
+        return (ok);
 }
 
 /* install fresh core_map.
@@ -1138,17 +1403,7 @@ time_t nextMapUpdate (int interval)
 void rotateNextMap()
 {
     // rotate to the "next" CoreMaps bit after core_map
-    int new_cm = -1;
-    for (int i = 1; i < CM_N; i++) {
-        int ci = (core_map + i) % CM_N;
-        if (IS_CMROT(ci)) {
-            new_cm = ci;
-            break;
-        }
-    }
-    if (new_cm < 0)
-        fatalError ("Bogus map rotation set: 0x%x\n", map_rotset);
-    core_map = (CoreMaps) new_cm;
+    core_map = nextRotMap();
 }
 
 
@@ -1222,7 +1477,7 @@ bool zinfWiFiFILE (WiFiClient &client, int in_n, FILE *out_fp)
     if (ret == Z_STREAM_END) {
         // N.B. an empty file will return Z_STREAM_END!
         if (out_n > in_n) {
-            Serial.printf ("inflated %d -> %d\n", in_n, out_n);
+            LOGD ("inflated %d -> %d\n", in_n, out_n);
             return (true);
         }
         Serial.printf ("inflate did not expand: %d -> %d\n", in_n, out_n);
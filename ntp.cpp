@@ -0,0 +1,497 @@
+/* NTP client.
+ *
+ * A background thread sends a request to every candidate server at once from one UDP socket then collects
+ * the replies as they arrive, so a round takes as long as the slowest server rather than the sum of them.
+ * Each server keeps a short history of offset and delay samples from which a filtered offset and jitter are
+ * found much as in RFC 5905 clock filter. The offsets are kept relative to CLOCK_MONOTONIC so the current
+ * UTC is always available immediately from the best server without waiting on the network, and the
+ * fraction of the second is available too so the sync provider need not sleep to the next whole second.
+ *
+ * for good NTP packet description try
+ *   http://www.cisco.com
+ *      /c/en/us/about/press/internet-protocol-journal/back-issues/table-contents-58/154-ntp.html
+ */
+
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#include "HamClock.h"
+
+
+#define NTP_PORT        123                     // NTP server port
+#define NTP_PKTLEN      48                      // NTP packet length without extensions
+#define NTP_UNIX        2208988800UL            // NTP epoch 1900 to UNIX epoch 1970, secs
+#define NTP_MINPOLL     64                      // secs between rounds when first synced
+#define NTP_MAXPOLL     1024                    // longest secs between rounds as we settle down
+#define NTP_RETRY       10                      // secs between rounds while no server has answered
+#define NTP_NSAMP       8                       // samples kept per server
+#define NTP_MAXMISS     3                       // consecutive misses before a server is not eligible
+#define NTP_PHI         15e-6                   // assumed local clock frequency tolerance, s/s
+#define NTP_MINTIME     1577836800L             // any time before Jan 1 2020 is crazy
+#define NTP_RESOLVE     NTP_MAXPOLL             // secs to keep using an address that keeps answering
+
+
+// list of default NTP servers unless user has set their own
+static NTPServer ntp_list[] = {                 // rsp_time 0 means not yet measured
+    {"time.google.com",     0},
+    {"time.apple.com",      0},
+    {"pool.ntp.org",        0},
+    {"europe.pool.ntp.org", 0},
+    {"asia.pool.ntp.org",   0},
+    {"time.nist.gov",       0},
+};
+#define N_NTP NARRAY(ntp_list)                  // number of possible servers
+
+// or the one server set by user
+static NTPServer user_server;
+
+// private state for each server
+typedef struct {
+    struct sockaddr_in addr;                    // where the current request was sent
+    double addr_t;                              // monoSecs() when addr was resolved, 0 if not valid
+    uint8_t xmt[8];                             // our transmit stamp, echoed back as the originate stamp
+    double t1;                                  // monoSecs() when the current request was sent
+    bool waiting;                               // sent this round, reply not yet in
+    double s_off[NTP_NSAMP];                    // recent offsets of UTC from monoSecs(), secs
+    double s_dly[NTP_NSAMP];                    // their round trip delays, secs
+    double s_t[NTP_NSAMP];                      // monoSecs() when each was measured
+    int n_samp;                                 // n valid s_*
+    int next_samp;                              // s_* index to fill next
+    double offset;                              // filtered offset of UTC from monoSecs(), secs
+    double delay;                               // delay of the sample chosen for offset, secs
+    double jitter;                              // rms of the other offsets about offset, secs
+    int n_miss;                                 // consecutive rounds without a good reply
+} NTPPeer;
+
+// protected shared values set by thread, read by main program
+static NTPServer *ntp_srv;                      // servers in use, ntp_list or &user_server
+static int n_srv;                               // n in ntp_srv[]
+static NTPPeer ntp_peers[N_NTP];                // private to thread, matches ntp_srv[]
+static volatile double ntp_offset;              // offset of UTC from monoSecs() from best server, secs
+static volatile int ntp_best = -1;              // ntp_srv[] index of best server, -1 until one replies
+static pthread_mutex_t ntp_lock = PTHREAD_MUTEX_INITIALIZER;   // atomic access control for ntp_*, rsp_time
+
+
+/* return seconds from an arbitrary fixed point, immune to changes to the system clock.
+ */
+static double monoSecs (void)
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec + ts.tv_nsec*1e-9);
+}
+
+/* convert an array of 4 big-endian network-order bytes into a uint32_t
+ */
+static uint32_t crackBE32 (const uint8_t bp[])
+{
+    union {
+        uint32_t be;
+        uint8_t ba[4];
+    } be4;
+
+    be4.ba[3] = bp[0];
+    be4.ba[2] = bp[1];
+    be4.ba[1] = bp[2];
+    be4.ba[0] = bp[3];
+
+    return (be4.be);
+}
+
+/* crack a big-endian NTP timestamp to UNIX seconds.
+ * N.B. done in 32 bits so we stay correct across the NTP era rollover in 2036
+ */
+static double crackNTPTime (const uint8_t bp[8])
+{
+    return ((uint32_t)(crackBE32(&bp[0]) - NTP_UNIX) + crackBE32(&bp[4])/4294967296.0);
+}
+
+/* update the filtered estimates for the given peer from its sample history.
+ * the sample chosen is the one with the least delay, aged by how much our clock may have wandered since.
+ */
+static void filterPeer (NTPPeer &p, double t_now)
+{
+    int best_i = 0;
+    double best_d = 1e10;
+    for (int i = 0; i < p.n_samp; i++) {
+        double d = p.s_dly[i]/2 + (t_now - p.s_t[i])*NTP_PHI;
+        if (d < best_d) {
+            best_d = d;
+            best_i = i;
+        }
+    }
+    p.offset = p.s_off[best_i];
+    p.delay = p.s_dly[best_i];
+
+    double sum2 = 0;
+    for (int i = 0; i < p.n_samp; i++)
+        sum2 += (p.s_off[i] - p.offset) * (p.s_off[i] - p.offset);
+    p.jitter = p.n_samp > 1 ? sqrt (sum2/(p.n_samp-1)) : 0;
+}
+
+/* choose the best server and publish its offset.
+ * a server is better the smaller its worst case error of half its delay plus its jitter.
+ */
+static void publishBest (void)
+{
+    int best_i = -1;
+    double best_e = 1e10;
+    for (int i = 0; i < n_srv; i++) {
+        NTPPeer &p = ntp_peers[i];
+        if (p.n_samp == 0 || p.n_miss >= NTP_MAXMISS)
+            continue;
+        double e = p.delay/2 + p.jitter;
+        if (e < best_e) {
+            best_e = e;
+            best_i = i;
+        }
+    }
+
+    if (best_i >= 0) {
+        pthread_mutex_lock (&ntp_lock);
+        if (best_i != ntp_best)
+            Serial.printf ("NTP: using %s delay %.1f ms jitter %.1f ms\n", ntp_srv[best_i].server,
+                                1e3*ntp_peers[best_i].delay, 1e3*ntp_peers[best_i].jitter);
+        ntp_best = best_i;
+        ntp_offset = ntp_peers[best_i].offset;
+        pthread_mutex_unlock (&ntp_lock);
+    }
+}
+
+/* record the round trip time of ntp_srv[i] in millis or NTP_TOO_LONG.
+ */
+static void setRspTime (int i, int ms)
+{
+    pthread_mutex_lock (&ntp_lock);
+    ntp_srv[i].rsp_time = ms;
+    pthread_mutex_unlock (&ntp_lock);
+}
+
+/* resolve ntp_srv[i] into ntp_peers[i].addr unless its address is recent and still answering.
+ * return whether addr is usable.
+ */
+static bool resolvePeer (int i)
+{
+    NTPPeer &p = ntp_peers[i];
+
+    // keep a good address a while, else resolve fresh so pools can rotate
+    double t_now = monoSecs();
+    if (p.addr_t > 0 && p.n_miss == 0 && t_now - p.addr_t < NTP_RESOLVE)
+        return (true);
+
+    struct addrinfo hints, *aip;
+    memset (&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    int e = getaddrinfo (ntp_srv[i].server, NULL, &hints, &aip);
+    if (e) {
+        Serial.printf ("NTP: %s: %s\n", ntp_srv[i].server, gai_strerror(e));
+        p.addr_t = 0;
+        return (false);
+    }
+    memcpy (&p.addr, aip->ai_addr, sizeof(p.addr));
+    p.addr.sin_port = htons (NTP_PORT);
+    p.addr_t = t_now;
+    freeaddrinfo (aip);
+
+    return (true);
+}
+
+/* send a request to each server, skipping any whose name does not resolve.
+ * all names are resolved first so a slow resolver can not stagger the sends.
+ * return number sent.
+ */
+static int sendRequests (int sock)
+{
+    bool resolved[N_NTP];
+    for (int i = 0; i < n_srv; i++) {
+        ntp_peers[i].waiting = false;
+        resolved[i] = resolvePeer (i);
+    }
+
+    int n_sent = 0;
+
+    for (int i = 0; i < n_srv; i++) {
+        NTPPeer &p = ntp_peers[i];
+        if (!resolved[i]) {
+            setRspTime (i, NTP_TOO_LONG);
+            p.n_miss++;
+            continue;
+        }
+
+        // client mode 3 version 4, transmit stamp is just random so we can match the reply
+        uint8_t buf[NTP_PKTLEN];
+        memset (buf, 0, sizeof(buf));
+        buf[0] = (4 << 3) | 3;
+        for (int j = 0; j < 8; j++)
+            p.xmt[j] = buf[40+j] = random(256);
+
+        p.t1 = monoSecs();
+        if (sendto (sock, buf, sizeof(buf), 0, (struct sockaddr *)&p.addr, sizeof(p.addr)) < 0) {
+            Serial.printf ("NTP: %s: send %s\n", ntp_srv[i].server, strerror(errno));
+            setRspTime (i, NTP_TOO_LONG);
+            p.n_miss++;
+            continue;
+        }
+
+        p.waiting = true;
+        n_sent++;
+    }
+
+    return (n_sent);
+}
+
+/* crack one reply, return whether it was a good answer to one of our outstanding requests.
+ */
+static bool crackReply (const uint8_t *buf, int len, const struct sockaddr_in &from, double t4)
+{
+    if (len < NTP_PKTLEN)
+        return (false);
+
+    // find who this answers, ignore strays and spoofs
+    int i;
+    for (i = 0; i < n_srv; i++) {
+        NTPPeer &p = ntp_peers[i];
+        if (p.waiting && p.addr.sin_addr.s_addr == from.sin_addr.s_addr && memcmp (p.xmt, &buf[24], 8) == 0)
+            break;
+    }
+    if (i == n_srv)
+        return (false);
+    NTPPeer &p = ntp_peers[i];
+    p.waiting = false;
+
+    // insist on server mode, a real stratum and a synchronized leap indicator
+    int li = buf[0] >> 6;
+    int mode = buf[0] & 0x7;
+    int stratum = buf[1];
+    if (mode != 4 || li == 3 || stratum < 1 || stratum > 15) {
+        Serial.printf ("NTP: %s: unusable reply li %d mode %d stratum %d\n", ntp_srv[i].server,
+                                li, mode, stratum);
+        setRspTime (i, NTP_TOO_LONG);
+        p.n_miss++;
+        return (false);
+    }
+
+    double t2 = crackNTPTime (&buf[32]);        // server receive
+    double t3 = crackNTPTime (&buf[40]);        // server transmit
+    if (t3 < NTP_MINTIME) {
+        Serial.printf ("NTP: %s: crazy small UNIX time: %.0f\n", ntp_srv[i].server, t3);
+        setRspTime (i, NTP_TOO_LONG);
+        p.n_miss++;
+        return (false);
+    }
+
+    // add sample to history
+    double delay = (t4 - p.t1) - (t3 - t2);
+    if (delay < 0)
+        delay = 0;
+    int si = p.next_samp;
+    p.s_off[si] = ((t2 - p.t1) + (t3 - t4))/2;
+    p.s_dly[si] = delay;
+    p.s_t[si] = t4;
+    p.next_samp = (si + 1) % NTP_NSAMP;
+    if (p.n_samp < NTP_NSAMP)
+        p.n_samp++;
+    p.n_miss = 0;
+    filterPeer (p, t4);
+    publishBest();
+
+    // N.B. publish rsp_time last, initWiFi() takes it to mean time is now available
+    int rsp_ms = (int)(1000*(t4 - p.t1) + 0.5);
+    setRspTime (i, rsp_ms > 0 ? rsp_ms : 1);
+
+    LOGD ("NTP: %s %d ms offset %+.1f ms jitter %.1f ms\n", ntp_srv[i].server, rsp_ms,
+                                1e3*(p.s_off[si] - p.offset), 1e3*p.jitter);
+
+    return (true);
+}
+
+/* run one round: send to all servers then collect replies until all are in or NTP_TOO_LONG.
+ * return whether any server answered.
+ */
+static bool ntpRound (int sock)
+{
+    int n_waiting = sendRequests (sock);
+    bool any = false;
+
+    double t_end = monoSecs() + NTP_TOO_LONG/1000.0;
+    while (n_waiting > 0) {
+        int ms_left = (int)(1000*(t_end - monoSecs()));
+        if (ms_left <= 0)
+            break;
+
+        struct pollfd pfd;
+        pfd.fd = sock;
+        pfd.events = POLLIN;
+        int np = poll (&pfd, 1, ms_left);
+        if (np < 0 && errno != EINTR) {
+            Serial.printf ("NTP: poll %s\n", strerror(errno));
+            break;
+        }
+        if (np <= 0)
+            continue;
+
+        uint8_t buf[128];
+        struct sockaddr_in from;
+        socklen_t from_len = sizeof(from);
+        int len = recvfrom (sock, buf, sizeof(buf), 0, (struct sockaddr *)&from, &from_len);
+        double t4 = monoSecs();
+        if (len < 0)
+            continue;
+
+        if (crackReply (buf, len, from, t4))
+            any = true;
+        int n_still = 0;
+        for (int i = 0; i < n_srv; i++)
+            if (ntp_peers[i].waiting)
+                n_still++;
+        n_waiting = n_still;
+    }
+
+    // any still waiting missed this round
+    for (int i = 0; i < n_srv; i++) {
+        NTPPeer &p = ntp_peers[i];
+        if (p.waiting) {
+            Serial.printf ("NTP: %s timed out\n", ntp_srv[i].server);
+            setRspTime (i, NTP_TOO_LONG);
+            p.waiting = false;
+            p.n_miss++;
+        }
+    }
+
+    // rescan in case the best just became ineligible
+    publishBest();
+
+    return (any);
+}
+
+/* thread that polls the servers forever, more often until things settle down.
+ */
+static void *ntpThread (void *sockp)
+{
+    pthread_detach (pthread_self());
+
+    int sock = (int)(long)sockp;
+    int poll_secs = NTP_MINPOLL;
+
+    for (;;) {
+        if (ntpRound (sock)) {
+            sleep (poll_secs);
+            poll_secs = poll_secs*2 <= NTP_MAXPOLL ? poll_secs*2 : NTP_MAXPOLL;
+        } else {
+            pthread_mutex_lock (&ntp_lock);
+            bool have = ntp_best >= 0;
+            pthread_mutex_unlock (&ntp_lock);
+            poll_secs = NTP_MINPOLL;
+            sleep (have ? NTP_MINPOLL : NTP_RETRY);
+        }
+    }
+
+    return (NULL);
+}
+
+/* start the thread if not already.
+ * N.B. call only from the main thread
+ */
+void startNTP (void)
+{
+    // out fast if already running, but we only try once
+    static bool thread_ok;
+    if (thread_ok)
+        return;
+    thread_ok = true;
+
+    // choose server set, never changes
+    if (useLocalNTPHost()) {
+        user_server.server = getLocalNTPHost();
+        ntp_srv = &user_server;
+        n_srv = 1;
+    } else {
+        ntp_srv = ntp_list;
+        n_srv = N_NTP;
+    }
+
+    int sock = socket (AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0) {
+        Serial.printf ("NTP: socket %s\n", strerror(errno));
+        return;
+    }
+    fcntl (sock, F_SETFD, FD_CLOEXEC);
+
+    pthread_t tid;
+    int e = pthread_create (&tid, NULL, ntpThread, (void *)(long)sock);
+    if (e) {
+        Serial.printf ("NTP: pthread_create %s\n", strerror(e));
+        close (sock);
+    }
+}
+
+/* return current UTC from the best NTP server, and ms into that second, else 0 if none have answered yet.
+ * never waits on the network.
+ */
+time_t getNTPUTC (uint16_t &ms)
+{
+    startNTP();
+
+    pthread_mutex_lock (&ntp_lock);
+    bool have = ntp_best >= 0;
+    double utc = monoSecs() + ntp_offset;
+    pthread_mutex_unlock (&ntp_lock);
+
+    if (!have)
+        return (0);
+
+    time_t t = (time_t) floor (utc);
+    ms = (uint16_t) ((utc - t) * 1000);
+    if (ms > 999)
+        ms = 999;
+    return (t);
+}
+
+/* return best ntp server, which will be the user's if they have set their own.
+ * N.B. never return NULL
+ */
+const NTPServer *findBestNTP (void)
+{
+    startNTP();
+
+    pthread_mutex_lock (&ntp_lock);
+    const NTPServer *np = n_srv == 0 ? &ntp_list[0] : &ntp_srv[ntp_best >= 0 ? ntp_best : 0];
+    pthread_mutex_unlock (&ntp_lock);
+
+    return (np);
+}
+
+/* return current NTP server list.
+ * N.B. this is the real data, caller must not modify, and must read rsp_time with getNTPRspTime().
+ */
+int getNTPServers (const NTPServer **listp)
+{
+    startNTP();
+
+    if (n_srv == 0) {
+        *listp = ntp_list;
+        return (N_NTP);
+    }
+    *listp = ntp_srv;
+    return (n_srv);
+}
+
+/* return the latest round trip time of getNTPServers() entry i in millis, 0 if not yet measured or
+ * NTP_TOO_LONG if last attempt failed.
+ */
+int getNTPRspTime (int i)
+{
+    const NTPServer *list;
+    int n = getNTPServers (&list);
+    if (i < 0 || i >= n)
+        return (0);
+
+    pthread_mutex_lock (&ntp_lock);
+    int ms = list[i].rsp_time;
+    pthread_mutex_unlock (&ntp_lock);
+
+    return (ms);
+}
@@ -56,6 +56,7 @@ static DXSpot *onta_spots;                              // malloced list, comple
 static int n_ontaspots;                                 // n spots in onta_spots
 static DXSpot *ontawl_spots;                            // filtered malloced list, count in onta_ss.n_data
 static ScrollState onta_ss;                             // scrolling state
+static SpotIndex ontawl_six;                            // getClosestSpot() index of ontawl_spots
 static uint8_t onta_sortby;                             // one of ONTASort
 static bool onta_showbio;                               // whether click shows bio
 static uint32_t spots_hash, hash_atscroll;              // hash of onta_spots, value when scrolled away
@@ -405,6 +406,7 @@ static void rebuildONTAWatchList(void)
 
     // sort as desired and scroll to newest with new n_data
     qsort (ontawl_spots, onta_ss.n_data, sizeof(DXSpot), onta_sorts[onta_sortby].qsf);
+    resetSpotIndex (ontawl_six);
     onta_ss.scrollToNewest();
 }
 
@@ -549,6 +551,7 @@ static void resetONTAStorage (const SBox &box)
     n_ontaspots = 0;
     free (ontawl_spots);
     ontawl_spots = NULL;
+    resetSpotIndex (ontawl_six);
     onta_ss.init ((box.h - LISTING_Y0)/LISTING_DY, 0, 0, onta_ss.DIR_FROMSETUP);
     onta_ss.scrollToNewest();
     onta_ss.initNewSpotsSymbol (box, ONTA_COLOR);
@@ -787,7 +790,8 @@ void drawOnTheAirSpotsOnMap (void)
 bool getClosestOnTheAirSpot (LatLong &ll, DXSpot *onta_closest, LatLong *ll_closest)
 {
     return (ontawl_spots && findPaneForChoice (PLOT_CH_ONTA) != PANE_NONE && getSpotLabelType() != LBL_NONE
-            && getClosestSpot (ontawl_spots, onta_ss.n_data, NULL, LOME_TXEND, ll, onta_closest, ll_closest));
+            && getClosestSpot (ontawl_six, ontawl_spots, onta_ss.n_data, NULL, SPOTS_ALLBANDS, LOME_TXEND,
+                                        ll, onta_closest, ll_closest));
 }
 
 /* return spot in our pane if under ms 
@@ -7,7 +7,7 @@
 #include "HamClock.h"
 
 
-/* prefixes are cached with fast radix access
+/* prefixes are cached sorted for binary search, with recent calls remembered
  */
 
 static char cty_page[] = "/cty/cty_wt_mod-ll-dxcc.txt";         // web page to download
@@ -19,12 +19,21 @@ typedef struct {
     int call_len;                               // handy strlen(call)
     int dxcc;                                   // DXCC number
 } CtyLoc;
-static CtyLoc *cty_list;                        // malloced list
-static int n_cty, n_malloc;                     // n entries used, n malloced
-#define _N_RADIX ('Z' - '0' + 1)                // radix range, 
-static int cty_radix[_N_RADIX];                 // table of cty_list index from first character
-static char prev_radix;                         // used to detect change in radis index
+static CtyLoc *cty_list;                        // malloced list, sorted by call
+static int n_cty;                               // n entries used
+
+#define CTY_MEMO_SETS   128                     // n sets of recent calls
+#define CTY_MEMO_WAYS   4                       // n calls in each set, least recently used is replaced
+typedef struct {
+    char call[MAX_SPOTCALL_LEN];                // full call as given, "" if unused
+    char dx_call[MAX_SPOTCALL_LEN];             // its dx end
+    const CtyLoc *loc;                          // best cty_list entry for dx_call, NULL if none
+    uint32_t used;                              // cty_memo_clock when last used
+} CtyMemo;
+static CtyMemo cty_memo[CTY_MEMO_SETS][CTY_MEMO_WAYS];
+static uint32_t cty_memo_clock;                 // increments with each use
 static time_t next_refresh;                     // time of next download
+static pthread_mutex_t cty_lock = PTHREAD_MUTEX_INITIALIZER;   // ADIF files are parsed on pool tasks
 #define MAX_CTY_AGE     (1*24*3600)             // normally update city file this often, secs
 #define MIN_CTY_SIZ     800000                  // min believable file size
 #define RETRY_DT        60                      // retry interval if trouble, secs
@@ -810,20 +819,30 @@ void findCallPrefix (const char *call, char prefix[MAX_PREF_LEN])
  * 
  ***********************************************************************************/
 
-/* init cty values for a fresh start
+/* install a freshly built cty list in place of the current one.
+ * N.B. memo entries point into the old list so they go too.
  */
-static void initCty(void)
+static void installCty (CtyLoc *list, int n)
 {
+    pthread_mutex_lock (&cty_lock);
     if (cty_list)
         free (cty_list);
-    cty_list = NULL;
-    n_cty = 0;
-    n_malloc = 0;
+    cty_list = list;
+    n_cty = n;
+    memset (cty_memo, 0, sizeof(cty_memo));
+    pthread_mutex_unlock (&cty_lock);
+}
+
+/* qsort-style compare two CtyLoc by call
+ */
+static int qsCtyLoc (const void *v1, const void *v2)
+{
+    return (strcmp (((const CtyLoc *)v1)->call, ((const CtyLoc *)v2)->call));
 }
 
-/* crack and add another line to cty_list
+/* crack and add another line to the given list being built
  */
-static void addCtyLine (char *line)
+static void addCtyLine (char *line, CtyLoc *&list, int &n, int &n_malloc)
 {
     // skip blank and comment lines
     if (line[0] == '\n' || line[0] == '#')
@@ -837,30 +856,22 @@ static void addCtyLine (char *line)
     }
 
     // add to list, expanding as needed
-    if (n_cty + 1 > n_malloc) {
-        cty_list = (CtyLoc *) realloc (cty_list, (n_malloc += 1000) * sizeof(CtyLoc));
-        if (!cty_list)
+    if (n + 1 > n_malloc) {
+        list = (CtyLoc *) realloc (list, (n_malloc += 1000) * sizeof(CtyLoc));
+        if (!list)
             fatalError ("No memory for cty location list %d\n", n_malloc);
     }
     cl.call_len = strlen(cl.call);
-    cty_list[n_cty++] = cl;
-
-    // update radix index when first char changes
-    if (cl.call[0] != prev_radix) {
-        int radix_index = cl.call[0] - '0';
-        if (radix_index < 0 || radix_index >= _N_RADIX)
-            fatalError ("cty radix out of range %d %d", radix_index, _N_RADIX);
-        cty_radix[radix_index] = n_cty - 1;
-        prev_radix = cl.call[0];
-        // printf ("********* radix %c %5d %5d\n",cl.call[0], radix_index, radix[radix_index]);
-    }
+    list[n++] = cl;
 }
 
-/* insure cty_lst and its supporting radix index are ready to use, even if stale if no other way.
+/* insure cty_list is sorted and ready to use, even if stale if no other way.
  * use local file but if absent or too old try to download.
+ * the new list is built without cty_lock so pool tasks may keep using the old one meanwhile.
  * return whether cty_list is ready.
+ * N.B. call only from main thread: openCachedFile() may wait for a download.
  */
-static bool loadCtyFile(void)
+bool loadCtyFile(void)
 {
     // out fast until next refresh
     if (myNow() < next_refresh)
@@ -870,70 +881,119 @@ static bool loadCtyFile(void)
     FILE *fp = openCachedFile (cty_fn, cty_page, MAX_CTY_AGE, MIN_CTY_SIZ);
     if (!fp) {
         next_refresh = myNow() + RETRY_DT;
-        return (false);
+        return (cty_list != NULL);
     }
 
-    // (re)build cty_list
-    initCty();
-    char line[100];
-    while (fgets (line, sizeof(line), fp)) {
-        chompString (line);
-        addCtyLine (line);
-    }
+    // build new list
+    CtyLoc *list = NULL;
+    int n = 0, n_malloc = 0;
+    GenReader gr(fp);
+    char *line;
+    while (gr.getLine (&line))
+        addCtyLine (line, list, n, n_malloc);
 
     // done
     fclose (fp);
     next_refresh = myNow() + MAX_CTY_AGE;
-    Serial.printf ("CTY: loaded %d locations from %s\n", n_cty, cty_fn);
+
+    // file is already in order but searchCty() depends on it
+    qsort (list, n, sizeof(CtyLoc), qsCtyLoc);
+    Serial.printf ("CTY: loaded %d locations from %s\n", n, cty_fn);
+
+    // swap in unless it came up empty
+    if (list)
+        installCty (list, n);
 
     // real question is whether cty_list exists
     return (cty_list != NULL);
 }
 
-/* search for best CtyLoc for the given prefix.
+/* search for best CtyLoc for the given prefix, ie, the longest cty_list call with which prefix begins.
  * return pointer else NULL
  */
 static const CtyLoc *searchCty (const char *prefix)
 {
-    // start at radix then find longest cty_list call entry that starts with prefix.
-    const CtyLoc *candidate = NULL;
-    int radix_index = prefix[0] - '0';
-    if (radix_index >= 0 && radix_index < _N_RADIX) {
-        int start = cty_radix[radix_index];
-        int len_match = 0;                              // find longest match
-        for (int i = start; i < n_cty; i++) {           // start at this radix, go to end or next radix
-            const CtyLoc *cp = &cty_list[i];
-            if (cp->call[0] != prefix[0])
-                break;                                  // end of this radix
-            if (strncmp (cp->call, prefix, cp->call_len) == 0) {
-                int cc_len = strlen(cp->call);
-                if (cc_len > len_match) {
-                    len_match = cc_len;
-                    candidate = cp;
-                    if (debugLevel (DEBUG_CTY, 1))
-                        Serial.printf ("CTY: match for %s now %s length %d\n", prefix, cp->call, len_match);
-                }
+    // binary search for each leading portion of prefix, longest first
+    int max_len = strlen (prefix);
+    if (max_len > MAX_SPOTCALL_LEN-1)
+        max_len = MAX_SPOTCALL_LEN-1;
+    for (int len = max_len; len > 0; --len) {
+        int lo = 0, hi = n_cty - 1;
+        while (lo <= hi) {
+            int mid = (lo + hi)/2;
+            const CtyLoc *cp = &cty_list[mid];
+            int cmp = strncmp (cp->call, prefix, len);
+            if (cmp == 0)
+                cmp = cp->call_len - len;               // longer call sorts after its own prefix
+            if (cmp == 0) {
+                if (debugLevel (DEBUG_CTY, 1))
+                    Serial.printf ("CTY: match for %s is %s length %d\n", prefix, cp->call, len);
+                return (cp);
             }
+            if (cmp < 0)
+                lo = mid + 1;
+            else
+                hi = mid - 1;
         }
     }
 
-    return (candidate);
+    return (NULL);
 }
 
+/* find the dx end of the given call and its best CtyLoc, else NULL.
+ * recent calls are remembered in cty_memo[] because spots tend to repeat the same calls.
+ */
+static const CtyLoc *lookupCty (const char *call, char dx_call[NV_CALLSIGN_LEN])
+{
+    char home_call[NV_CALLSIGN_LEN];
 
-/* given a call sign or prefix find its lat/long by querying the cty table.
- * return whether successful.
+    // too long to remember
+    if (strlen (call) >= MAX_SPOTCALL_LEN) {
+        splitCallSign (call, home_call, dx_call);
+        return (searchCty (dx_call));
+    }
+
+    // look in its set, noting least recently used in case it's not there
+    uint32_t hash = 2166136261U;
+    for (const char *cp = call; *cp; cp++)
+        hash = (hash ^ (uint8_t)*cp) * 16777619U;
+    CtyMemo *set = cty_memo[hash % CTY_MEMO_SETS];
+    CtyMemo *lru = &set[0];
+    for (int i = 0; i < CTY_MEMO_WAYS; i++) {
+        CtyMemo &m = set[i];
+        if (m.call[0] && strcmp (m.call, call) == 0) {
+            m.used = ++cty_memo_clock;
+            strcpy (dx_call, m.dx_call);
+            return (m.loc);
+        }
+        if (m.used < lru->used)
+            lru = &m;
+    }
+
+    // search then replace lru
+    splitCallSign (call, home_call, dx_call);
+    const CtyLoc *loc = searchCty (dx_call);
+    if (strlen (dx_call) < MAX_SPOTCALL_LEN) {
+        strcpy (lru->call, call);
+        strcpy (lru->dx_call, dx_call);
+        lru->loc = loc;
+        lru->used = ++cty_memo_clock;
+    }
+    return (loc);
+}
+
+
+/* call2LL() with cty_lock held
  */
-bool call2LL (const char *call, LatLong &ll)
+static bool call2LLLocked (const char *call, LatLong &ll)
 {
-    // check cty_list
-    if (!loadCtyFile())
+    // check cty_list, loaded only by our callers
+    if (!cty_list)
         return (false);
 
     // use the dx end of a portable call
-    char home_call[NV_CALLSIGN_LEN];
     char dx_call[NV_CALLSIGN_LEN];
-    splitCallSign (call, home_call, dx_call);
+    const CtyLoc *candidate = lookupCty (call, dx_call);
 
     // require a digit if 3 or more chars
     if (strlen(dx_call) >= 3 && !strHasDigit(dx_call)) {
@@ -941,8 +1001,6 @@ bool call2LL (const char *call, LatLong &ll)
         return (false);
     }
 
-    const CtyLoc *candidate = searchCty (dx_call);
-
     if (candidate) {
         ll.lat_d = candidate->lat_d;
         ll.lng_d = candidate->lng_d;
@@ -958,21 +1016,17 @@ bool call2LL (const char *call, LatLong &ll)
     }
 }
 
-/* given a call sign or prefix find its DXCC number by querying the cty table.
- * return whether successful.
+/* call2DXCC() with cty_lock held
  */
-bool call2DXCC (const char *call, int &dxcc)
+static bool call2DXCCLocked (const char *call, int &dxcc)
 {
-    // check cty_list
-    if (!loadCtyFile())
+    // check cty_list, loaded only by our callers
+    if (!cty_list)
         return (false);
 
     // use the dx end of a portable call
-    char home_call[NV_CALLSIGN_LEN];
     char dx_call[NV_CALLSIGN_LEN];
-    splitCallSign (call, home_call, dx_call);
-
-    const CtyLoc *candidate = searchCty (dx_call);
+    const CtyLoc *candidate = lookupCty (call, dx_call);
 
     if (candidate) {
         dxcc = candidate->dxcc;
@@ -986,3 +1040,40 @@ bool call2DXCC (const char *call, int &dxcc)
         return (false);
     }
 }
+
+/* given a call sign or prefix find its lat/long by querying the cty table.
+ * pool tasks never load the table, they just fail until the main thread has done so.
+ * return whether successful.
+ */
+bool call2LL (const char *call, LatLong &ll)
+{
+    if (!inTaskPool())
+        (void) loadCtyFile();
+
+    pthread_mutex_lock (&cty_lock);
+    bool ok = call2LLLocked (call, ll);
+    pthread_mutex_unlock (&cty_lock);
+    return (ok);
+}
+
+/* given a call sign or prefix find its DXCC number by querying the cty table.
+ * pool tasks never load the table, they just fail until the main thread has done so.
+ * return whether successful.
+ */
+bool call2DXCC (const char *call, int &dxcc)
+{
+    if (!inTaskPool())
+        (void) loadCtyFile();
+
+    pthread_mutex_lock (&cty_lock);
+    bool ok = call2DXCCLocked (call, dxcc);
+    pthread_mutex_unlock (&cty_lock);
+    return (ok);
+}
+
+/* start refreshing the cty file in the background if it is missing or stale, return at once.
+ */
+void prefetchCtyFile (void)
+{
+    prefetchCachedFile (cty_fn, cty_page, MAX_CTY_AGE, MIN_CTY_SIZ);
+}
@@ -26,6 +26,7 @@ static int n_reports;                           // count of reports used in psk_
 static int n_malloced;                          // total n malloced in reports[]
 static int spot_maxrpt[HAMBAND_N];              // indices into reports[] for the farthest spot per band
 static PSKBandStats bstats[HAMBAND_N];          // band stats
+static SpotIndex reports_six;                   // getClosestSpot() index of reports[]
 
 // layout
 #define SUBHEAD_DYUP 15                         // distance up from bottom to subheading
@@ -273,12 +274,13 @@ static bool retrievePSK (void)
 
         // reset lists
         n_reports = 0;
+        resetSpotIndex (reports_six);
         for (int i = 0; i < HAMBAND_N; i++)
             bstats[i] = {};
 
         // read lines -- anything unexpected is considered an error message
-        char line[100];
-        while (getTCPLine (psk_client, line, sizeof(line), NULL)) {
+        char *line;
+        while (psk_client.readLine (&line, NULL)) {
 
             // Serial.printf ("PSK: fetched %s\n", line);
 
@@ -303,28 +305,28 @@ static bool retrievePSK (void)
 
             // convert grids to ll
             if (!maidenhead2ll (new_sp.tx_ll, new_sp.tx_grid)) {
-                Serial.printf ("PSK: RX grid? %s\n", line);
+                LOGD ("PSK: RX grid? %s\n", line);
                 continue;
             }
             if (!maidenhead2ll (new_sp.rx_ll, new_sp.rx_grid)) {
-                Serial.printf ("PSK: RX grid? %s\n", line);
+                LOGD ("PSK: RX grid? %s\n", line);
                 continue;
             }
 
             // check for unknown or unsupported band
             const HamBandSetting band = findHamBand (new_sp.kHz);
             if (band == HAMBAND_NONE) {
-                Serial.printf ("PSK: band? %s\n", line);
+                LOGD ("PSK: band? %s\n", line);
                 continue;
             }
 
             // DXCC
             if (!call2DXCC (new_sp.tx_call, new_sp.tx_dxcc)) {
-                Serial.printf ("PSK: no DXCC for %s\n", new_sp.tx_call);
+                LOGD ("PSK: no DXCC for %s\n", new_sp.tx_call);
                 continue;
             }
             if (!call2DXCC (new_sp.rx_call, new_sp.rx_dxcc)) {
-                Serial.printf ("PSK: no DXCC for %s\n", new_sp.rx_call);
+                LOGD ("PSK: no DXCC for %s\n", new_sp.rx_call);
                 continue;
             }
 
@@ -388,6 +390,7 @@ out:
     }
 
     // finish up
+    resetSpotIndex (reports_six);
     psk_client.stop();
     Serial.printf ("PSK: found %d %s reports %s %s\n",
                         n_reports,
@@ -710,29 +713,10 @@ bool getClosestPSK (LatLong &ll, DXSpot *sp, LatLong *mark_ll)
     
     } else {
 
-        // check all spots in displayed ham_bands.
-        // N.B. can't use getClosestSpot() because of TST_PSKBAND
+        // check all spots in displayed ham_bands, marking the end of interest
 
-        float min_d = 0;
-        int min_i = -1;
-        for (int i = 0; i < n_reports; i++) {
-            DXSpot &s = reports[i];
-            if (TST_PSKBAND(findHamBand(s.kHz))) {
-                float d = ll.GSD(s.rx_ll);
-                if (min_i < 0 || d < min_d) {
-                    min_d = d;
-                    min_i = i;
-                }
-                d = ll.GSD(s.tx_ll);
-                if (min_i < 0 || d < min_d) {
-                    min_d = d;
-                    min_i = i;
-                }
-            }
-        }
-
-        if (min_i >= 0 && min_d*ERAD_M < MAX_CSR_DIST) {
-            *sp = reports[min_i];
+        LatLong closest_ll;
+        if (getClosestSpot (reports_six, reports, n_reports, NULL, psk_bands, LOME_BOTH, ll, sp, &closest_ll)) {
             *mark_ll = of_de ? sp->rx_ll : sp->tx_ll;
             return (true);
         }
@@ -0,0 +1,398 @@
+/* encode RGB images in the "Quite OK Image" format, see https://qoiformat.org.
+ *
+ * QOI is lossless like PNG but needs no deflate so encoding is many times faster, at the cost of larger
+ * output. liveweb offers it for clients on the local network where bandwidth is cheap but latency of
+ * each update matters. the matching decoder is in liveweb-html.cpp.
+ *
+ * to build and run a stand-alone benchmark against PNG on a sequence of raw RGB frames such as
+ * recorded by liveweb with debug level 4:
+ *    g++ -Wall -O2 -D_UNIT_TEST -I. -Izlib-hc -o x.qoi qoi.cpp -Lzlib-hc -lzlib-hc
+ *    ./x.qoi 800 480 /tmp/live.rgb
+ * with no file the benchmark uses a synthetic sequence.
+ */
+
+#if defined (_UNIT_TEST)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/time.h>
+
+#else // !_UNIT_TEST
+
+#include "HamClock.h"
+
+#endif // _UNIT_TEST
+
+
+#define QOI_OP_INDEX    0x00                            // 00xxxxxx
+#define QOI_OP_DIFF     0x40                            // 01xxxxxx
+#define QOI_OP_LUMA     0x80                            // 10xxxxxx
+#define QOI_OP_RUN      0xc0                            // 11xxxxxx
+#define QOI_OP_RGB      0xfe                            // 11111110
+#define QOI_HDR_LEN     14                              // magic, w, h, channels, colorspace
+#define QOI_END_LEN     8                               // 7 0x00 then 0x01
+#define QOI_MAX_RUN     62                              // longest run in one op
+
+#define QOI_HASH(r,g,b) (((r)*3 + (g)*5 + (b)*7 + 255*11) % 64)
+
+
+/* store v as 4 bytes big-endian at p
+ */
+static void qoiPut32 (uint8_t *p, uint32_t v)
+{
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+/* encode the given w x h RGB image whose rows are stride bytes apart.
+ * return malloced QOI image and its length in *len, or NULL if no memory.
+ */
+uint8_t *qoiEncode (const uint8_t *rgb, int w, int h, int stride, int *len)
+{
+    // worst case is every pixel QOI_OP_RGB
+    uint8_t *out = (uint8_t *) malloc (QOI_HDR_LEN + 4*w*h + QOI_END_LEN);
+    if (!out)
+        return (NULL);
+
+    // header
+    uint8_t *op = out;
+    memcpy (op, "qoif", 4);
+    qoiPut32 (op+4, w);
+    qoiPut32 (op+8, h);
+    op[12] = 3;                                         // RGB
+    op[13] = 0;                                         // sRGB with linear alpha
+    op += QOI_HDR_LEN;
+
+    // previously seen pixels as opaque 0xAARRGGBB, starting as transparent so none match
+    uint32_t index[64];
+    memset (index, 0, sizeof(index));
+
+    // previous pixel starts as opaque black
+    uint8_t pr = 0, pg = 0, pb = 0;
+    int run = 0;
+
+    for (int y = 0; y < h; y++) {
+        const uint8_t *ip = rgb + y*stride;
+        for (int x = 0; x < w; x++) {
+            uint8_t r = *ip++;
+            uint8_t g = *ip++;
+            uint8_t b = *ip++;
+
+            // extend run of same pixel
+            if (r == pr && g == pg && b == pb) {
+                if (++run == QOI_MAX_RUN) {
+                    *op++ = QOI_OP_RUN | (run - 1);
+                    run = 0;
+                }
+                continue;
+            }
+            if (run > 0) {
+                *op++ = QOI_OP_RUN | (run - 1);
+                run = 0;
+            }
+
+            // try previously seen, then small difference, then literal
+            int hi = QOI_HASH (r, g, b);
+            uint32_t argb = 0xff000000 | (r << 16) | (g << 8) | b;
+            if (index[hi] == argb) {
+                *op++ = QOI_OP_INDEX | hi;
+            } else {
+                index[hi] = argb;
+
+                int8_t dr = (int8_t)(r - pr);
+                int8_t dg = (int8_t)(g - pg);
+                int8_t db = (int8_t)(b - pb);
+                int8_t dr_dg = dr - dg;
+                int8_t db_dg = db - dg;
+
+                if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+                    *op++ = QOI_OP_DIFF | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2);
+                } else if (dg >= -32 && dg <= 31 && dr_dg >= -8 && dr_dg <= 7 && db_dg >= -8 && db_dg <= 7) {
+                    *op++ = QOI_OP_LUMA | (dg + 32);
+                    *op++ = (dr_dg + 8) << 4 | (db_dg + 8);
+                } else {
+                    *op++ = QOI_OP_RGB;
+                    *op++ = r;
+                    *op++ = g;
+                    *op++ = b;
+                }
+            }
+
+            pr = r;
+            pg = g;
+            pb = b;
+        }
+    }
+    if (run > 0)
+        *op++ = QOI_OP_RUN | (run - 1);
+
+    // end marker
+    memset (op, 0, QOI_END_LEN - 1);
+    op[QOI_END_LEN-1] = 1;
+    op += QOI_END_LEN;
+
+    *len = op - out;
+    return (out);
+}
+
+
+
+
+#if defined (_UNIT_TEST)
+
+// use the same deflate and level as liveweb
+#include "zlib.h"
+static unsigned char *zDeflate (unsigned char *data, int data_len, int *out_len, int quality)
+{
+    int n_out = data_len + 1000;
+    unsigned char *out_mem = (unsigned char *) malloc (n_out);
+    z_stream strm;
+    memset (&strm, 0, sizeof(strm));
+    if (!out_mem || deflateInit (&strm, quality) != Z_OK) {
+        printf ("deflateInit failed\n");
+        exit(1);
+    }
+    strm.avail_in = data_len;
+    strm.next_in = data;
+    strm.avail_out = n_out;
+    strm.next_out = out_mem;
+    if (deflate (&strm, Z_FINISH) != Z_STREAM_END) {
+        printf ("deflate failed\n");
+        exit(1);
+    }
+    *out_len = n_out - strm.avail_out;
+    (void) deflateEnd (&strm);
+    return (out_mem);
+}
+#define STBIW_ZLIB_COMPRESS zDeflate
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
+
+#define BLOK_W  8                                       // same as liveweb at 800x480
+#define BLOK_H  8
+
+/* decode QOI produced by qoiEncode() into rgb, return whether successful.
+ */
+static bool qoiDecode (const uint8_t *qoi, int len, uint8_t *rgb, int w, int h)
+{
+    if (len < QOI_HDR_LEN + QOI_END_LEN || memcmp (qoi, "qoif", 4) != 0)
+        return (false);
+
+    uint32_t index[64];
+    memset (index, 0, sizeof(index));
+    uint8_t r = 0, g = 0, b = 0;
+    const uint8_t *ip = qoi + QOI_HDR_LEN;
+    const uint8_t *end = qoi + len - QOI_END_LEN;
+    int run = 0;
+
+    for (int i = 0; i < w*h; i++) {
+        if (run > 0) {
+            run--;
+        } else if (ip < end) {
+            uint8_t b1 = *ip++;
+            if (b1 == QOI_OP_RGB) {
+                r = *ip++;
+                g = *ip++;
+                b = *ip++;
+            } else if ((b1 & 0xc0) == QOI_OP_INDEX) {
+                r = index[b1] >> 16;
+                g = index[b1] >> 8;
+                b = index[b1];
+            } else if ((b1 & 0xc0) == QOI_OP_DIFF) {
+                r += ((b1 >> 4) & 3) - 2;
+                g += ((b1 >> 2) & 3) - 2;
+                b += (b1 & 3) - 2;
+            } else if ((b1 & 0xc0) == QOI_OP_LUMA) {
+                uint8_t b2 = *ip++;
+                int dg = (b1 & 0x3f) - 32;
+                r += dg - 8 + ((b2 >> 4) & 0x0f);
+                g += dg;
+                b += dg - 8 + (b2 & 0x0f);
+            } else {
+                run = b1 & 0x3f;
+            }
+            index[QOI_HASH (r, g, b)] = 0xff000000 | (r << 16) | (g << 8) | b;
+        } else
+            return (false);
+        *rgb++ = r;
+        *rgb++ = g;
+        *rgb++ = b;
+    }
+
+    return (true);
+}
+
+/* stbi_write_png_to_func helper that just counts bytes
+ */
+static void countBytes (void *context, void *data, int size)
+{
+    (void)data;
+    *(int *)context += size;
+}
+
+/* return microseconds since tv0
+ */
+static long usSince (const struct timeval &tv0)
+{
+    struct timeval tv1;
+    gettimeofday (&tv1, NULL);
+    return ((tv1.tv_sec - tv0.tv_sec)*1000000L + (tv1.tv_usec - tv0.tv_usec));
+}
+
+/* collect changed BLOK_W x BLOK_H blocks from prev to now into one strip BLOK_H high, as liveweb does.
+ * return n blocks.
+ */
+static int buildSprites (const uint8_t *now, const uint8_t *prev, int w, int h, uint8_t *strip)
+{
+    int n_bloks = 0;
+    int rbytes = 3*w;
+    int bw = 3*BLOK_W;
+    int strip_w = w*h/(BLOK_W*BLOK_H);                  // worst case n blocks
+    for (int by = 0; by < h/BLOK_H; by++) {
+        for (int bx = 0; bx < w/BLOK_W; bx++) {
+            const uint8_t *n0 = now + by*BLOK_H*rbytes + bx*bw;
+            const uint8_t *p0 = prev + by*BLOK_H*rbytes + bx*bw;
+            bool changed = false;
+            for (int r = 0; r < BLOK_H && !changed; r++)
+                changed = memcmp (n0 + r*rbytes, p0 + r*rbytes, bw) != 0;
+            if (changed) {
+                for (int r = 0; r < BLOK_H; r++)
+                    memcpy (strip + r*3*BLOK_W*strip_w + n_bloks*bw, n0 + r*rbytes, bw);
+                n_bloks++;
+            }
+        }
+    }
+    return (n_bloks);
+}
+
+/* make a synthetic screen sequence: busy background then a few small changes each frame like a clock.
+ */
+static uint8_t *makeFrames (int w, int h, int n_frames)
+{
+    int nbytes = 3*w*h;
+    uint8_t *frames = (uint8_t *) malloc ((size_t)nbytes*n_frames);
+    uint8_t *f0 = frames;
+    srand (1);
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            uint8_t *p = &f0[3*(y*w+x)];
+            bool map = x > w/6 && y > h/3;
+            p[0] = map ? (uint8_t)(40 + (x*y)/64%80) : 0;
+            p[1] = map ? (uint8_t)(60 + (x+y)%96) : 0;
+            p[2] = map ? (uint8_t)(120 + (x^y)%64) : ((x/40+y/20)%2 ? 30 : 0);
+        }
+    }
+    for (int i = 1; i < n_frames; i++) {
+        uint8_t *f = frames + (size_t)i*nbytes;
+        memcpy (f, f - nbytes, nbytes);
+        for (int k = 0; k < 4; k++) {
+            int rx = rand() % (w-40), ry = rand() % (h-20);
+            uint8_t c = rand();
+            for (int y = ry; y < ry+20; y++)
+                for (int x = rx; x < rx+40; x++)
+                    if ((x+y)%3)
+                        memset (&f[3*(y*w+x)], c, 3);
+        }
+    }
+    return (frames);
+}
+
+int main (int ac, char *av[])
+{
+    if (ac != 1 && ac != 4) {
+        printf ("Purpose: compare PNG and QOI for liveweb updates\n");
+        printf ("Usage: %s [w h frames.rgb]\n", av[0]);
+        return (1);
+    }
+
+    // load or make frames
+    int w = 800, h = 480, n_frames = 100;
+    uint8_t *frames;
+    if (ac == 4) {
+        w = atoi (av[1]);
+        h = atoi (av[2]);
+        FILE *fp = fopen (av[3], "r");
+        if (!fp) {
+            perror (av[3]);
+            return (1);
+        }
+        fseek (fp, 0, SEEK_END);
+        long fsize = ftell (fp);
+        rewind (fp);
+        n_frames = fsize / (3*w*h);
+        frames = (uint8_t *) malloc ((size_t)n_frames*3*w*h);
+        if (n_frames < 2 || fread (frames, 3*w*h, n_frames, fp) != (size_t)n_frames) {
+            printf ("%s: need at least 2 frames of %d x %d\n", av[3], w, h);
+            return (1);
+        }
+        fclose (fp);
+    } else
+        frames = makeFrames (w, h, n_frames);
+
+    int strip_w = w*h/(BLOK_W*BLOK_H);
+    uint8_t *strip = (uint8_t *) malloc (3*BLOK_W*strip_w*BLOK_H);
+    uint8_t *check = (uint8_t *) malloc (3*w*h);
+    stbi_write_png_compression_level = 2;
+
+    // full first frame
+    struct timeval tv0;
+    int png_l = 0, qoi_l = 0;
+    gettimeofday (&tv0, NULL);
+    stbi_write_png_to_func (countBytes, &png_l, w, h, 3, frames, 3*w);
+    long png_us = usSince (tv0);
+    gettimeofday (&tv0, NULL);
+    uint8_t *qoi = qoiEncode (frames, w, h, 3*w, &qoi_l);
+    long qoi_us = usSince (tv0);
+    if (!qoiDecode (qoi, qoi_l, check, w, h) || memcmp (check, frames, 3*w*h) != 0) {
+        printf ("full frame QOI round trip failed\n");
+        return (1);
+    }
+    free (qoi);
+    printf ("Full %dx%d: PNG %8d B %7ld us   QOI %8d B %7ld us\n", w, h, png_l, png_us, qoi_l, qoi_us);
+
+    // each update
+    long png_tot_l = 0, qoi_tot_l = 0, png_tot_us = 0, qoi_tot_us = 0;
+    int n_upd = 0;
+    for (int i = 1; i < n_frames; i++) {
+        const uint8_t *now = frames + (size_t)i*3*w*h;
+        int n_bloks = buildSprites (now, now - 3*w*h, w, h, strip);
+        if (n_bloks == 0)
+            continue;
+        int sw = n_bloks*BLOK_W;
+
+        png_l = 0;
+        gettimeofday (&tv0, NULL);
+        stbi_write_png_to_func (countBytes, &png_l, sw, BLOK_H, 3, strip, 3*BLOK_W*strip_w);
+        png_tot_us += usSince (tv0);
+        png_tot_l += png_l;
+
+        gettimeofday (&tv0, NULL);
+        qoi = qoiEncode (strip, sw, BLOK_H, 3*BLOK_W*strip_w, &qoi_l);
+        qoi_tot_us += usSince (tv0);
+        qoi_tot_l += qoi_l;
+        if (!qoiDecode (qoi, qoi_l, check, sw, BLOK_H)) {
+            printf ("update %d QOI decode failed\n", i);
+            return (1);
+        }
+        for (int r = 0; r < BLOK_H; r++) {
+            if (memcmp (check + r*3*sw, strip + r*3*BLOK_W*strip_w, 3*sw) != 0) {
+                printf ("update %d QOI round trip failed\n", i);
+                return (1);
+            }
+        }
+        free (qoi);
+        n_upd++;
+    }
+
+    if (n_upd > 0)
+        printf ("%d updates, per update: PNG %8ld B %7ld us   QOI %8ld B %7ld us\n", n_upd,
+                    png_tot_l/n_upd, png_tot_us/n_upd, qoi_tot_l/n_upd, qoi_tot_us/n_upd);
+
+    return (0);
+}
+
+#endif // _UNIT_TEST
@@ -64,16 +64,16 @@ static float RobY2Lat (const float Y)
     return (90*y);
 }
 
-/* convert ll to map_b screen coords at the given pixel scale factor.
+/* convert ll to mp.b screen coords at the given pixel scale factor.
  * avoid globe edge by at least the given number of raw pixels.
  */
-void ll2sRobinson (const LatLong &ll, SCoord &s, int edge, int scalesz)
+void ll2sRobinson (const MapProj &mp, const LatLong &ll, SCoord &s, int edge, int scalesz)
 {
     // handy half-sizes and center pix
-    uint16_t hw = map_b.w/2;
-    uint16_t hh = map_b.h/2;
-    uint16_t xc = map_b.x + hw;
-    uint16_t yc = map_b.y + hh;
+    uint16_t hw = mp.b.w/2;
+    uint16_t hh = mp.b.h/2;
+    uint16_t xc = mp.b.x + hw;
+    uint16_t yc = mp.b.y + hh;
 
     // find Robinson Y and X scale at this lat
     float Y = RobLat2Y (ll.lat_d);
@@ -81,8 +81,8 @@ void ll2sRobinson (const LatLong &ll, SCoord &s, int edge, int scalesz)
     float hw_lat = hw * G;                                      // halfwidth at this lat
 
     // pixels from map center
-    float deg_pan = 360.0F*pan_zoom.pan_x/map_b.w;
-    float lng0_d = fmodf (ll.lng_d - getCenterLng() - deg_pan + 7*180, 2*180) - 180; // [-180,180]
+    float deg_pan = 360.0F*mp.pz.pan_x/mp.b.w;
+    float lng0_d = fmodf (ll.lng_d - mp.center_lng - deg_pan + 7*180, 2*180) - 180; // [-180,180]
     float dx = hw * G * lng0_d / 180;                           // pixels right of center
     float dy = hh * Y;                                          // pixels up from center
 
@@ -168,13 +168,20 @@ int main (int ac, char *av[])
     pan_zoom.pan_x = 0;
     pan_zoom.pan_y = 0;
 
+    MapProj mp;
+    memset (&mp, 0, sizeof(mp));
+    mp.b = map_b;
+    mp.pz = pan_zoom;
+    mp.proj = MAPP_ROB;
+    mp.center_lng = getCenterLng();
+
     for (uint16_t y = map_b.y; y < map_b.y + map_b.h; y++) {
         for (uint16_t x = map_b.x; x < map_b.x + map_b.w; x++) {
             SCoord s = {x, y};
             LatLong ll;
             if (s2llRobinson (s, ll)) {
                 SCoord s2;
-                ll2sRobinson (ll, s2, 0, 1);
+                ll2sRobinson (mp, ll, s2, 0, 1);
                 int x_err = (int)s.x - (int)s2.x;
                 int y_err = (int)s.y - (int)s2.y;
                 if (abs(x_err) > 1 || abs(y_err) > 1)
@@ -0,0 +1,474 @@
+/* find satellite horizon crossings by root finding rather than fixed time steps.
+ *
+ * elevation above SAT_MIN_EL, f(t), is sampled forward in time. each step is sized from the elevation rate
+ * seen over the previous step so it lands just beyond where f would reach 0 if it kept going that way,
+ * capped at a fraction of the orbit period or day so the shape of f is never missed. a sign change between
+ * samples brackets a crossing which Brent's method then refines to well under a second. a peak of f just
+ * below 0 at both ends of a step, or a dip just above, is searched for a brief pass that may have slipped
+ * between the samples. events are found in time order for as many passes as wanted in one sweep.
+ *
+ * the fixed step search findNextPass() used before lives on in the unit test as the regression reference.
+ *
+ * to build and run a stand-alone regression test and benchmark on a fixed set of TLEs:
+ *    g++ -Wall -O2 -D_UNIT_TEST -IArduinoLib -o x.satpass satpass.cpp P13.cpp && ./x.satpass
+ */
+
+#include "HamClock.h"
+
+
+#define SP_NSTEPS       24              // min steps per orbit period or day, whichever is shorter
+#define SP_MINSTEP      5.0             // smallest sample step, seconds
+#define SP_OVERSHOOT    1.25            // step this much beyond the predicted crossing to bracket it
+#define SP_GRAZE        15.0            // search peaks and dips this close to SAT_MIN_EL, degrees
+#define SP_TOL          0.1             // crossing time tolerance, seconds
+#define SP_PEAK_TOL     1.0             // peak and dip time tolerance, seconds
+#define SP_MAXITER      60              // max iterations for any one refinement
+
+// what is being searched
+typedef struct {
+    Satellite *sat;                     // satellite
+    const Observer *obs;                // observer
+    DateTime t0;                        // search start time
+} PassSearch;
+
+
+/* return elevation above SAT_MIN_EL secs after ps.t0, also az if azp.
+ */
+static double satElAbove (PassSearch &ps, double secs, float *azp = NULL)
+{
+    DateTime t = ps.t0;
+    t += (float)(secs/SECSPERDAY);
+    float el, az, range, rate;
+    ps.sat->predict (t);
+    ps.sat->topo (ps.obs, el, az, range, rate);
+    if (azp)
+        *azp = az;
+    return (el - SAT_MIN_EL);
+}
+
+/* given f(a) and f(b) differ in sign return the time within SP_TOL of where f crosses 0 between them.
+ * this is Brent's method: inverse quadratic or secant steps while they converge well, else bisection.
+ */
+static double findCrossing (PassSearch &ps, double a, double fa, double b, double fb)
+{
+    double c = a, fc = fa;
+    double d = b - a, e = d;
+
+    for (int iter = 0; iter < SP_MAXITER; iter++) {
+
+        // keep c on the opposite side of 0 from b, and b the better guess
+        if ((fb >= 0) == (fc >= 0)) {
+            c = a;
+            fc = fa;
+            d = e = b - a;
+        }
+        if (fabs(fc) < fabs(fb)) {
+            a = b;  b = c;  c = a;
+            fa = fb; fb = fc; fc = fa;
+        }
+
+        const double tol = SP_TOL/2;
+        double m = (c - b)/2;
+        if (fabs(m) <= tol || fb == 0)
+            return (b);
+
+        // try interpolating, fall back to bisection if it would not shrink the bracket fast enough
+        if (fabs(e) >= tol && fabs(fa) > fabs(fb)) {
+            double s = fb/fa, p, q;
+            if (a == c) {
+                p = 2*m*s;
+                q = 1 - s;
+            } else {
+                double r = fb/fc;
+                q = fa/fc;
+                p = s*(2*m*q*(q - r) - (b - a)*(r - 1));
+                q = (q - 1)*(r - 1)*(s - 1);
+            }
+            if (p > 0)
+                q = -q;
+            else
+                p = -p;
+            if (2*p < fmin (3*m*q - fabs(tol*q), fabs(e*q))) {
+                e = d;
+                d = p/q;
+            } else
+                d = e = m;
+        } else
+            d = e = m;
+
+        a = b;
+        fa = fb;
+        b += fabs(d) > tol ? d : (m > 0 ? tol : -tol);
+        fb = satElAbove (ps, b);
+    }
+
+    return (b);
+}
+
+/* f is below 0 at a and b if sign is 1, or above if -1, and sign*f has a peak between them.
+ * search for a time t where f is on the other side of 0 by golden section; return whether found.
+ */
+static bool findGraze (PassSearch &ps, double a, double b, int sign, double &t)
+{
+    const double gr = (sqrt(5.0) - 1)/2;
+    double x1 = b - gr*(b - a);
+    double x2 = a + gr*(b - a);
+    double g1 = sign*satElAbove (ps, x1);
+    double g2 = sign*satElAbove (ps, x2);
+
+    for (int iter = 0; iter < SP_MAXITER && b - a > SP_PEAK_TOL; iter++) {
+        if (g1 >= 0 || g2 >= 0) {
+            t = g1 >= g2 ? x1 : x2;
+            return (true);
+        }
+        if (g1 > g2) {
+            b = x2;
+            x2 = x1;  g2 = g1;
+            x1 = b - gr*(b - a);
+            g1 = sign*satElAbove (ps, x1);
+        } else {
+            a = x1;
+            x1 = x2;  g1 = g2;
+            x2 = a + gr*(b - a);
+            g2 = sign*satElAbove (ps, x2);
+        }
+    }
+
+    return (false);
+}
+
+/* add the crossing secs after ps.t0 to events[n_events], return new count.
+ */
+static int addEvent (PassSearch &ps, double secs, bool rising, SatEvent events[], int n_events)
+{
+    SatEvent &ev = events[n_events];
+    (void) satElAbove (ps, secs, &ev.az);
+    ev.t = ps.t0;
+    ev.t += (float)(secs/SECSPERDAY);
+    ev.rising = rising;
+    return (n_events + 1);
+}
+
+/* find up to max_events successive times sat crosses SAT_MIN_EL as seen from obs within max_days after t0.
+ * events alternate between rising and setting; the first is a set if the sat is up at t0.
+ * also report whether the sat was ever seen up or down during the search.
+ * return number of events found.
+ */
+int findSatEvents (Satellite *sat, const Observer *obs, const DateTime &t0, float max_days,
+SatEvent events[], int max_events, bool &ever_up, bool &ever_down)
+{
+    ever_up = ever_down = false;
+    if (!sat || !obs || max_events <= 0)
+        return (0);
+
+    PassSearch ps = {sat, obs, t0};
+    const double t_end = (double)max_days*SECSPERDAY;
+    const double h_max = fmin (sat->period(), 1.0F) * SECSPERDAY / SP_NSTEPS;
+    int n_events = 0;
+
+    // ta is the latest sample, tp the one before
+    double ta = 0, fa = satElAbove (ps, ta);
+    double tp = 0, fp = 0;
+    bool have_p = false;
+    if (fa >= 0)
+        ever_up = true;
+    else
+        ever_down = true;
+
+    while (n_events < max_events && ta < t_end) {
+
+        // step to just beyond where the current trend would cross 0, if it's heading that way
+        double h = h_max;
+        if (have_p) {
+            double rate = (fa - fp)/(ta - tp);
+            if (rate != 0 && (fa >= 0) == (rate < 0)) {
+                double h_cross = SP_OVERSHOOT * -fa/rate;
+                h = fmax (SP_MINSTEP, fmin (h_max, h_cross));
+            }
+        }
+        double tb = fmin (ta + h, t_end);
+        double fb = satElAbove (ps, tb);
+        if (fb >= 0)
+            ever_up = true;
+        else
+            ever_down = true;
+
+        if ((fa >= 0) != (fb >= 0)) {
+
+            // bracketed a crossing
+            double tc = findCrossing (ps, ta, fa, tb, fb);
+            n_events = addEvent (ps, tc, fb >= 0, events, n_events);
+
+        } else if (have_p) {
+
+            // check for a brief pass or dip between samples when f turns back toward 0 just short of it
+            int sign = fa >= 0 ? -1 : 1;
+            double t_g;
+            if (sign*fa > sign*fp && sign*fb < sign*fa && fabs(fa) < SP_GRAZE
+                                    && findGraze (ps, tp, tb, sign, t_g)) {
+                double f_g = satElAbove (ps, t_g);
+                if (f_g >= 0)
+                    ever_up = true;
+                else
+                    ever_down = true;
+                double tc = findCrossing (ps, tp, fp, t_g, f_g);
+                n_events = addEvent (ps, tc, f_g >= 0, events, n_events);
+                if (n_events < max_events) {
+                    tc = findCrossing (ps, t_g, f_g, tb, fb);
+                    n_events = addEvent (ps, tc, fb >= 0, events, n_events);
+                }
+            }
+        }
+
+        tp = ta;
+        fp = fa;
+        ta = tb;
+        fa = fb;
+        have_p = true;
+    }
+
+    return (n_events);
+}
+
+
+#if defined(_UNIT_TEST)
+
+#include <sys/time.h>
+
+#define TEST_DAYS       2.0F            // days to search after each start
+#define TEST_TOL        3.0             // max rise or set difference from reference, seconds
+#define TEST_EL_NOISE   0.02            // P13 float el jitter near horizon, degrees
+#define MAX_TEST_EV     200             // plenty for TEST_DAYS
+
+// fixed TLE set, elements modeled on these orbits at one epoch so results never change
+static const struct {
+    const char *name, *l1, *l2;
+} test_tles[] = {
+    {"ISS",
+        "1 25544U 98067A   24149.51140801  .00018442  00000+0  32372-3 0  9998",
+        "2 25544  51.6397  52.8338 0005655 239.3246 313.5976 15.50566673455497"},
+    {"SO-50",
+        "1 27607U 00000A   24149.51140801  .00000861  00000+0  00000-0 0  9990",
+        "2 27607  64.5549 100.1234 0059430 310.5012  49.5402 14.80919812123450"},
+    {"AO-7",
+        "1 07530U 00000A   24149.51140801 -.00000036  00000+0  00000-0 0  9990",
+        "2 07530 101.9911 147.2261 0012210 136.0203 311.6047 12.53687459123450"},
+    {"NOAA-19",
+        "1 33591U 00000A   24149.51140801  .00000210  00000+0  00000-0 0  9990",
+        "2 33591  99.1945 187.0010 0014000 118.3003 241.9597 14.12857813123450"},
+    {"Molniya",
+        "1 28163U 00000A   24149.51140801  .00000012  00000+0  00000-0 0  9990",
+        "2 28163  62.8512 234.5678 7123456 270.1234  14.5678  2.00612345123450"},
+    {"QO-100",
+        "1 43700U 00000A   24149.51140801  .00000140  00000+0  00000-0 0  9990",
+        "2 43700   0.0188 247.1234 0002054 320.0123  84.9876  1.00271612123450"},
+    {"GPS",
+        "1 24876U 00000A   24149.51140801 -.00000056  00000+0  00000-0 0  9990",
+        "2 24876  55.4567  98.7654 0091234  56.7890 303.1234  2.00565432123450"},
+};
+#define N_TEST_TLES ((int)(sizeof(test_tles)/sizeof(test_tles[0])))
+
+static const struct {
+    const char *name;
+    float lat, lng;
+} test_obs[] = {
+    {"Tucson",  32.36F, -111.13F},
+    {"London",  51.50F,   -0.12F},
+    {"Tromso",  69.65F,   18.96F},
+    {"Sydney", -33.87F,  151.21F},
+    {"Quito",   -0.18F,  -78.47F},
+};
+#define N_TEST_OBS ((int)(sizeof(test_obs)/sizeof(test_obs[0])))
+
+// one pass
+typedef struct {
+    DateTime rise, set;
+} TestPass;
+
+/* the original fixed step findNextPass(): step forward 90 s then back 2 s to refine each event.
+ */
+static void refNextPass (Satellite *sat, const Observer *obs, DateTime t_now, DateTime &rise_time, bool &rise_ok,
+DateTime &set_time, bool &set_ok)
+{
+    #define COARSE_DT   90L
+    #define FINE_DT     (-2L)
+    float pel;
+    long dt = COARSE_DT;
+    DateTime t_srch = t_now + -FINE_DT;
+    float tel, taz, trange, trate;
+
+    sat->predict (t_srch);
+    sat->topo (obs, pel, taz, trange, trate);
+    t_srch += dt;
+
+    set_ok = rise_ok = false;
+    while ((!set_ok || !rise_ok) && t_srch < t_now + 2.0F) {
+        sat->predict (t_srch);
+        sat->topo (obs, tel, taz, trange, trate);
+        if (tel >= SAT_MIN_EL) {
+            if (pel < SAT_MIN_EL) {
+                if (dt == FINE_DT) {
+                    set_time = t_srch;
+                    set_ok = true;
+                    dt = COARSE_DT;
+                    pel = tel;
+                } else if (!rise_ok) {
+                    dt = FINE_DT;
+                    pel = tel;
+                }
+            }
+        } else {
+            if (pel > SAT_MIN_EL) {
+                if (dt == FINE_DT) {
+                    float check_tel, check_taz;
+                    DateTime check_set = t_srch + COARSE_DT;
+                    sat->predict (check_set);
+                    sat->topo (obs, check_tel, check_taz, trange, trate);
+                    if (check_tel >= SAT_MIN_EL) {
+                        rise_time = t_srch;
+                        rise_ok = true;
+                    }
+                    dt = COARSE_DT;
+                    pel = tel;
+                } else if (!set_ok) {
+                    dt = FINE_DT;
+                    pel = tel;
+                }
+            }
+        }
+        t_srch += dt;
+        pel = tel;
+    }
+}
+
+/* collect the passes that rise within TEST_DAYS of t0 by restarting the reference just after each set.
+ */
+static int refPasses (Satellite *sat, const Observer *obs, DateTime t0, TestPass passes[], int max_passes)
+{
+    DateTime t_end = t0 + TEST_DAYS;
+    DateTime t = t0;
+    int n = 0;
+    while (n < max_passes && t < t_end) {
+        DateTime rise, set;
+        bool rise_ok, set_ok;
+        refNextPass (sat, obs, t, rise, rise_ok, set, set_ok);
+        if (!set_ok)
+            break;
+        if (rise_ok && rise < set && rise < t_end) {
+            passes[n].rise = rise;
+            passes[n].set = set;
+            n++;
+        }
+        t = set + 60L;
+    }
+    return (n);
+}
+
+/* same using findSatEvents() in one sweep.
+ */
+static int newPasses (Satellite *sat, const Observer *obs, DateTime t0, TestPass passes[], int max_passes)
+{
+    static SatEvent ev[MAX_TEST_EV];
+    bool ever_up, ever_down;
+    int n_ev = findSatEvents (sat, obs, t0, TEST_DAYS + 1, ev, MAX_TEST_EV, ever_up, ever_down);
+    DateTime t_end = t0 + TEST_DAYS;
+    int n = 0;
+    for (int i = 0; i < n_ev - 1 && n < max_passes; i++) {
+        if (ev[i].rising && !ev[i+1].rising && ev[i].t < t_end) {
+            passes[n].rise = ev[i].t;
+            passes[n].set = ev[i+1].t;
+            n++;
+        }
+    }
+    return (n);
+}
+
+// microseconds between two timevals
+static long tvdelus (const struct timeval &tv0, const struct timeval &tv1)
+{
+    return ((tv1.tv_sec - tv0.tv_sec)*1000000L + (tv1.tv_usec - tv0.tv_usec));
+}
+
+int main (int ac, char *av[])
+{
+    (void) ac;
+    (void) av;
+
+    static TestPass ref[MAX_TEST_EV], tst[MAX_TEST_EV];
+    long ref_us = 0, tst_us = 0;
+    int n_bad = 0;
+
+    printf ("%-8s %-7s %5s %5s %8s %8s %6s %6s\n", "Sat", "Obs", "nRef", "nNew", "dRise", "dSet", "Noisy",
+                                    "Extra");
+    for (int si = 0; si < N_TEST_TLES; si++) {
+        Satellite sat (test_tles[si].l1, test_tles[si].l2);
+        DateTime t0 = sat.epoch() + 0.1F;
+
+        for (int oi = 0; oi < N_TEST_OBS; oi++) {
+            Observer obs (test_obs[oi].lat, test_obs[oi].lng, 0);
+
+            struct timeval tv0, tv1, tv2;
+            gettimeofday (&tv0, NULL);
+            int n_ref = refPasses (&sat, &obs, t0, ref, MAX_TEST_EV);
+            gettimeofday (&tv1, NULL);
+            int n_tst = newPasses (&sat, &obs, t0, tst, MAX_TEST_EV);
+            gettimeofday (&tv2, NULL);
+            ref_us += tvdelus (tv0, tv1);
+            tst_us += tvdelus (tv1, tv2);
+
+            // match each reference pass with a new one, the reference may miss brief passes.
+            // where el creeps across the horizon its float jitter allows several crossings a few seconds
+            // apart so a larger difference is also ok if el at the reference time is within that jitter.
+            PassSearch ps = {&sat, &obs, t0};
+            double max_drise = 0, max_dset = 0;
+            int n_match = 0, n_noisy = 0;
+            for (int r = 0; r < n_ref; r++) {
+                bool found = false;
+                for (int n = 0; n < n_tst; n++) {
+                    double drise = SECSPERDAY*(tst[n].rise - ref[r].rise);
+                    double dset = SECSPERDAY*(tst[n].set - ref[r].set);
+                    if (fabs(drise) < 60 && fabs(dset) < 60) {
+                        double f_rise = satElAbove (ps, SECSPERDAY*(ref[r].rise - t0));
+                        double f_set = satElAbove (ps, SECSPERDAY*(ref[r].set - t0));
+                        if (fabs(drise) > TEST_TOL && fabs(f_rise) < TEST_EL_NOISE) {
+                            drise = 0;
+                            n_noisy++;
+                        }
+                        if (fabs(dset) > TEST_TOL && fabs(f_set) < TEST_EL_NOISE) {
+                            dset = 0;
+                            n_noisy++;
+                        }
+                        if (fabs(drise) > fabs(max_drise))
+                            max_drise = drise;
+                        if (fabs(dset) > fabs(max_dset))
+                            max_dset = dset;
+                        found = true;
+                        n_match++;
+                        break;
+                    }
+                }
+                if (!found) {
+                    printf ("FAIL: %s %s: reference pass %d not found\n", test_tles[si].name,
+                                                    test_obs[oi].name, r);
+                    n_bad++;
+                }
+            }
+            if (fabs(max_drise) > TEST_TOL || fabs(max_dset) > TEST_TOL) {
+                printf ("FAIL: %s %s: times differ by more than %g s\n", test_tles[si].name,
+                                                    test_obs[oi].name, TEST_TOL);
+                n_bad++;
+            }
+
+            printf ("%-8s %-7s %5d %5d %7.2fs %7.2fs %6d %6d\n", test_tles[si].name, test_obs[oi].name,
+                                    n_ref, n_tst, max_drise, max_dset, n_noisy, n_tst - n_match);
+        }
+    }
+
+    printf ("reference %ld ms, root finding %ld ms, %.1fx\n", ref_us/1000, tst_us/1000,
+                                    (float)ref_us/(tst_us ? tst_us : 1));
+    printf ("%s\n", n_bad ? "FAILED" : "all passes agree");
+
+    return (n_bad ? 1 : 0);
+}
+
+#endif // _UNIT_TEST
@@ -30,6 +30,18 @@ static NOAASpaceWxData noaasw_cache = {0, false, {'R', 'S', 'G'}, {}};
 static AuroraData aurora_cache;
 static DSTData dst_cache;
 
+// background downloads in progress for each cache, else 0
+static int bzbt_fetch;
+static int sw_fetch;
+static int ssn_fetch;
+static int sf_fetch;
+static int drap_fetch;
+static int xray_fetch;
+static int kp_fetch;
+static int noaasw_fetch;
+static int aurora_fetch;
+static int dst_fetch;
+
 #define X(a,b,c,d,e,f,g,h,i) {a,b,c,d,e,f,g,h,i},     // expands SPCWX_DATA to each array initialization in {}
 SpaceWeather_t space_wx[SPCWX_N] = {
     SPCWX_DATA
@@ -344,11 +356,37 @@ time_t nextRetrieval (PlotChoice pc, int interval)
     return (next_update);
 }
 
+/* return an fd from which to read the backend response to the given page, else -1 if failed.
+ * if !wait and the page is not yet complete, start downloading it in the background if not already,
+ * set pending and return -1; call again later with the same fetch_id to collect it.
+ */
+static int getSWPage (int &fetch_id, const char *page, bool wait, bool &pending)
+{
+    pending = false;
+
+    if (!fetch_id) {
+        fetch_id = startHCFetch (page);
+        if (!fetch_id)
+            return (-1);
+    }
+
+    int fd = -1;
+    FetchState fs = wait ? waitFetch (fetch_id, &fd) : checkFetch (fetch_id, &fd);
+    if (fs == FETCH_PENDING) {
+        pending = true;
+        return (-1);
+    }
+
+    fetch_id = 0;
+    return (fs == FETCH_OK ? fd : -1);
+}
+
 
 /* retrieve sun spot and SPCWX_SSN if it's time, else use cache.
- * return whether transaction was ok (even if data was not)
+ * return whether transaction was ok (even if data was not).
+ * if !wait and the download is still in progress return false without waiting.
  */
-bool retrieveSunSpots (SunSpotData &ssn)
+bool retrieveSunSpots (SunSpotData &ssn, bool wait)
 {
     // check cache first
     if (myNow() < ssn_cache.next_update) {
@@ -358,7 +396,10 @@ bool retrieveSunSpots (SunSpotData &ssn)
 
     // get fresh
     char line[100];
-    WiFiClient ss_client;
+    bool pending;
+    WiFiClient ss_client (getSWPage (ssn_fetch, ssn_page, wait, pending));
+    if (pending)
+        return (false);
     bool ok = false;
 
     // mark value as bad until proven otherwise
@@ -366,12 +407,7 @@ bool retrieveSunSpots (SunSpotData &ssn)
     ssn.data_ok = ssn_cache.data_ok = false;
 
     Serial.println(ssn_page);
-    if (ss_client.connect(backend_host, backend_port)) {
-        updateClocks(false);
-
-        // query web page
-        httpHCGET (ss_client, backend_host, ssn_page);
-
+    if (ss_client) {
         // skip response header
         if (!httpSkipHeader (ss_client)) {
             Serial.print ("SSN: header fail\n");
@@ -429,13 +465,14 @@ static bool checkForNewSunSpots (void)
         return (false);
 
     SunSpotData ssn;
-    return (retrieveSunSpots (ssn));
+    return (retrieveSunSpots (ssn, false));
 }
 
 /* retrieve solar flux and SPCWX_FLUX if it's time, else use cache.
- * return whether transaction was ok (even if data was not)
+ * return whether transaction was ok (even if data was not).
+ * if !wait and the download is still in progress return false without waiting.
  */
-bool retrieveSolarFlux (SolarFluxData &sf)
+bool retrieveSolarFlux (SolarFluxData &sf, bool wait)
 {
     // check cache first
     if (myNow() < sf_cache.next_update) {
@@ -445,7 +482,10 @@ bool retrieveSolarFlux (SolarFluxData &sf)
 
     // get fresh
     char line[120];
-    WiFiClient sf_client;
+    bool pending;
+    WiFiClient sf_client (getSWPage (sf_fetch, sf_page, wait, pending));
+    if (pending)
+        return (false);
     bool ok = false;
 
     // mark value as bad until proven otherwise
@@ -453,12 +493,7 @@ bool retrieveSolarFlux (SolarFluxData &sf)
     sf.data_ok = sf_cache.data_ok = false;
 
     Serial.println (sf_page);
-    if (sf_client.connect(backend_host, backend_port)) {
-        updateClocks(false);
-
-        // query web page
-        httpHCGET (sf_client, backend_host, sf_page);
-
+    if (sf_client) {
         // skip response header
         if (!httpSkipHeader (sf_client)) {
             Serial.print ("SFlux: header fail\n");
@@ -515,14 +550,15 @@ static bool checkForNewSolarFlux (void)
         return (false);
 
     SolarFluxData sf;
-    return (retrieveSolarFlux (sf));
+    return (retrieveSolarFlux (sf, false));
 }
 
 
 /* retrieve DRAP and SPCWX_DRAP if it's time, else use cache.
- * return whether transaction was ok (even if data was not)
+ * return whether transaction was ok (even if data was not).
+ * if !wait and the download is still in progress return false without waiting.
  */
-bool retrieveDRAP (DRAPData &drap)
+bool retrieveDRAP (DRAPData &drap, bool wait)
 {
     // check cache first
     if (myNow() < drap_cache.next_update) {
@@ -536,7 +572,10 @@ bool retrieveDRAP (DRAPData &drap)
     #define _DRAP_MINGOODI      (DRAPDATA_NPTS-3600/DRAPDATA_INTERVAL)  // min index with good data
 
     char line[100];                                                     // text line
-    WiFiClient drap_client;                                             // wifi client connection
+    bool pending;
+    WiFiClient drap_client (getSWPage (drap_fetch, drap_page, wait, pending));
+    if (pending)
+        return (false);
     bool ok = false;                                                    // set iff all ok
 
     // want to find any holes in data so init x values to all 0
@@ -550,12 +589,7 @@ bool retrieveDRAP (DRAPData &drap)
     drap.data_ok = drap_cache.data_ok = false;
 
     Serial.println (drap_page);
-    if (drap_client.connect(backend_host, backend_port)) {
-        updateClocks(false);
-
-        // query web page
-        httpHCGET (drap_client, backend_host, drap_page);
-
+    if (drap_client) {
         // skip response header
         if (!httpSkipHeader (drap_client)) {
             Serial.print ("DRAP: header short\n");
@@ -661,13 +695,14 @@ bool checkForNewDRAP ()
         return (false);
 
     DRAPData drap;
-    return (retrieveDRAP (drap));
+    return (retrieveDRAP (drap, false));
 }
 
 /* retrieve Kp and SPCWX_KP if it's time, else use cache.
- * return whether transaction was ok (even if data was not)
+ * return whether transaction was ok (even if data was not).
+ * if !wait and the download is still in progress return false without waiting.
  */
-bool retrieveKp (KpData &kp)
+bool retrieveKp (KpData &kp, bool wait)
 {
     // check cache first
     if (myNow() < kp_cache.next_update) {
@@ -676,7 +711,10 @@ bool retrieveKp (KpData &kp)
     }
 
     // get fresh
-    WiFiClient kp_client;                               // wifi client connection
+    bool pending;
+    WiFiClient kp_client (getSWPage (kp_fetch, kp_page, wait, pending));
+    if (pending)
+        return (false);
     int kp_i = 0;                                       // next kp index to use
     char line[100];                                     // text line
     bool ok = false;                                    // set if no network errors
@@ -686,12 +724,7 @@ bool retrieveKp (KpData &kp)
     kp.data_ok = kp_cache.data_ok = false;
 
     Serial.println(kp_page);
-    if (kp_client.connect(backend_host, backend_port)) {
-        updateClocks(false);
-
-        // query web page
-        httpHCGET (kp_client, backend_host, kp_page);
-
+    if (kp_client) {
         // skip response header
         if (!httpSkipHeader (kp_client)) {
             Serial.print ("Kp: header short\n");
@@ -746,13 +779,14 @@ static bool checkForNewKp (void)
         return (false);
 
     KpData kp;
-    return (retrieveKp (kp));
+    return (retrieveKp (kp, false));
 }
 
 /* retrieve DST and SPCWX_DST if it's time, else use cache.
- * return whether transaction was ok (even if data was not)
+ * return whether transaction was ok (even if data was not).
+ * if !wait and the download is still in progress return false without waiting.
  */
-bool retrieveDST (DSTData &dst)
+bool retrieveDST (DSTData &dst, bool wait)
 {
     // check cache first
     if (myNow() < dst_cache.next_update) {
@@ -761,7 +795,10 @@ bool retrieveDST (DSTData &dst)
     }
 
     // get fresh
-    WiFiClient dst_client;                              // wifi client connection
+    bool pending;
+    WiFiClient dst_client (getSWPage (dst_fetch, dst_page, wait, pending));
+    if (pending)
+        return (false);
     char line[100];                                     // text line
     bool ok = false;                                    // set if no network errors
 
@@ -770,12 +807,7 @@ bool retrieveDST (DSTData &dst)
     dst.data_ok = dst_cache.data_ok = false;
 
     Serial.println(dst_page);
-    if (dst_client.connect(backend_host, backend_port)) {
-        updateClocks(false);
-
-        // query web page
-        httpHCGET (dst_client, backend_host, dst_page);
-
+    if (dst_client) {
         // skip response header
         if (!httpSkipHeader (dst_client)) {
             Serial.print ("DST: header short\n");
@@ -847,13 +879,14 @@ static bool checkForNewDST (void)
         return (false);
 
     DSTData dst;
-    return (retrieveDST (dst));
+    return (retrieveDST (dst, false));
 }
 
 /* retrieve XRay and SPCWX_XRAY if it's time, else use cache.
- * return whether transaction was ok (even if data was not)
+ * return whether transaction was ok (even if data was not).
+ * if !wait and the download is still in progress return false without waiting.
  */
-bool retrieveXRay (XRayData &xray)
+bool retrieveXRay (XRayData &xray, bool wait)
 {
     // check cache first
     if (myNow() < xray_cache.next_update) {
@@ -862,7 +895,10 @@ bool retrieveXRay (XRayData &xray)
     }
 
     // get fresh
-    WiFiClient xray_client;
+    bool pending;
+    WiFiClient xray_client (getSWPage (xray_fetch, xray_page, wait, pending));
+    if (pending)
+        return (false);
     char line[100];
     uint16_t ll;
     bool ok = false;
@@ -872,12 +908,7 @@ bool retrieveXRay (XRayData &xray)
     xray.data_ok = xray_cache.data_ok = false;
 
     Serial.println(xray_page);
-    if (xray_client.connect(backend_host, backend_port)) {
-        updateClocks(false);
-
-        // query web page
-        httpHCGET (xray_client, backend_host, xray_page);
-
+    if (xray_client) {
         // soak up remaining header
         if (!httpSkipHeader (xray_client)) {
             Serial.print ("XRay: header short\n");
@@ -954,13 +985,14 @@ static bool checkForNewXRay (void)
         return (false);
 
     XRayData xray;
-    return (retrieveXRay (xray));
+    return (retrieveXRay (xray, false));
 }
 
 /* retrieve BzBt data and SPCWX_BZBT if it's time, else use cache.
- * return whether transaction was ok (even if data was not)
+ * return whether transaction was ok (even if data was not).
+ * if !wait and the download is still in progress return false without waiting.
  */
-bool retrieveBzBt (BzBtData &bzbt)
+bool retrieveBzBt (BzBtData &bzbt, bool wait)
 {
     // check cache first
     if (myNow() < bzbt_cache.next_update) {
@@ -970,7 +1002,10 @@ bool retrieveBzBt (BzBtData &bzbt)
 
     // get fresh
     int bzbt_i;                                     // next index to use
-    WiFiClient bzbt_client;
+    bool pending;
+    WiFiClient bzbt_client (getSWPage (bzbt_fetch, bzbt_page, wait, pending));
+    if (pending)
+        return (false);
     char line[100];
     bool ok = false;
     time_t t0 = myNow();
@@ -980,12 +1015,7 @@ bool retrieveBzBt (BzBtData &bzbt)
     bzbt.data_ok = bzbt_cache.data_ok = false;
 
     Serial.println(bzbt_page);
-    if (bzbt_client.connect(backend_host, backend_port)) {
-        updateClocks(false);
-
-        // query web page
-        httpHCGET (bzbt_client, backend_host, bzbt_page);
-
+    if (bzbt_client) {
         // skip over remaining header
         if (!httpSkipHeader (bzbt_client)) {
             Serial.print ("BZBT: header short\n");
@@ -1061,14 +1091,15 @@ static bool checkForNewBzBt(void)
     if (myNow() < bzbt_cache.next_update)
         return (false);
     BzBtData bzbt;
-    return (retrieveBzBt (bzbt));
+    return (retrieveBzBt (bzbt, false));
 }
 
 
 /* retrieve solar wind and SPCWX_SOLWIND if it's time, else use cache.
- * return whether transaction was ok (even if data was not)
+ * return whether transaction was ok (even if data was not).
+ * if !wait and the download is still in progress return false without waiting.
  */
-bool retrieveSolarWind(SolarWindData &sw)
+bool retrieveSolarWind (SolarWindData &sw, bool wait)
 {
     // check cache first
     if (myNow() < sw_cache.next_update) {
@@ -1077,7 +1108,10 @@ bool retrieveSolarWind(SolarWindData &sw)
     }
 
     // get fresh
-    WiFiClient swind_client;
+    bool pending;
+    WiFiClient swind_client (getSWPage (sw_fetch, swind_page, wait, pending));
+    if (pending)
+        return (false);
     char line[80];
     bool ok = false;
 
@@ -1086,12 +1120,7 @@ bool retrieveSolarWind(SolarWindData &sw)
     sw.data_ok = sw_cache.data_ok = false;
 
     Serial.println (swind_page);
-    if (swind_client.connect(backend_host, backend_port)) {
-        updateClocks(false);
-
-        // query web page
-        httpHCGET (swind_client, backend_host, swind_page);
-
+    if (swind_client) {
         // skip response header
         if (!httpSkipHeader (swind_client)) {
             Serial.println ("SolWind: header short");
@@ -1179,13 +1208,14 @@ static bool checkForNewSolarWind (void)
         return (false);
 
     SolarWindData sw;
-    return (retrieveSolarWind (sw));
+    return (retrieveSolarWind (sw, false));
 }
 
 /* retrieve NOAA space weather indices and SPCWX_NOAASPW if it's time, else use cache.
- * return whether transaction was ok (even if data was not)
+ * return whether transaction was ok (even if data was not).
+ * if !wait and the download is still in progress return false without waiting.
  */
-bool retrieveNOAASWx (NOAASpaceWxData &noaasw)
+bool retrieveNOAASWx (NOAASpaceWxData &noaasw, bool wait)
 {
     // check cache first
     if (myNow() < noaasw_cache.next_update) {
@@ -1199,7 +1229,10 @@ bool retrieveNOAASWx (NOAASpaceWxData &noaasw)
     //  G  0 0 0 0
 
     // get fresh
-    WiFiClient noaaswx_client;
+    bool pending;
+    WiFiClient noaaswx_client (getSWPage (noaasw_fetch, noaaswx_page, wait, pending));
+    if (pending)
+        return (false);
     bool ok = false;
 
     // mark data as bad until proven otherwise
@@ -1209,13 +1242,7 @@ bool retrieveNOAASWx (NOAASpaceWxData &noaasw)
     // read scales
     Serial.println(noaaswx_page);
     char line[100];
-    if (noaaswx_client.connect(backend_host, backend_port)) {
-
-        updateClocks(false);
-
-        // fetch page
-        httpHCGET (noaaswx_client, backend_host, noaaswx_page);
-
+    if (noaaswx_client) {
         // skip header then read the data lines
         if (httpSkipHeader (noaaswx_client)) {
 
@@ -1296,14 +1323,15 @@ static bool checkForNewNOAASWx (void)
     if (myNow() < noaasw_cache.next_update)
         return (false);
     NOAASpaceWxData noaasw;
-    return (retrieveNOAASWx(noaasw));
+    return (retrieveNOAASWx (noaasw, false));
 }
 
 
 /* retrieve aurora and SPCWX_AURORA if it's time, else use cache.
- * return whether transaction was ok (even if data was not)
+ * return whether transaction was ok (even if data was not).
+ * if !wait and the download is still in progress return false without waiting.
  */
-bool retrieveAurora (AuroraData &aurora)
+bool retrieveAurora (AuroraData &aurora, bool wait)
 {
     // check cache first
     if (myNow() < aurora_cache.next_update) {
@@ -1312,7 +1340,10 @@ bool retrieveAurora (AuroraData &aurora)
     }
 
     // get fresh
-    WiFiClient aurora_client;                                           // wifi client connection
+    bool pending;
+    WiFiClient aurora_client (getSWPage (aurora_fetch, aurora_page, wait, pending));
+    if (pending)
+        return (false);
     char line[100];                                                     // text line
     bool ok = false;                                                    // set iff all ok
 
@@ -1321,12 +1352,7 @@ bool retrieveAurora (AuroraData &aurora)
     aurora.data_ok = aurora_cache.data_ok = false;
 
     Serial.println (aurora_page);
-    if (aurora_client.connect(backend_host, backend_port)) {
-        updateClocks(false);
-
-        // query web page
-        httpHCGET (aurora_client, backend_host, aurora_page);
-
+    if (aurora_client) {
         // skip response header
         if (!httpSkipHeader (aurora_client)) {
             Serial.print ("AURORA: header short\n");
@@ -1418,7 +1444,7 @@ bool checkForNewAurora ()
     if (myNow() < aurora_cache.next_update)
         return (false);
     AuroraData a;
-    return (retrieveAurora(a));
+    return (retrieveAurora (a, false));
 }
 
 /* update all space_wx stats but no faster than their respective panes would do.
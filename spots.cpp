@@ -4,50 +4,96 @@
 #include "HamClock.h"
 
 
-/* find list element, subject to possible filtering, that is closest to ll on the given end(s).
- * return whether found one within MAX_CSR_DIST.
+/* SpotIndex point data packs the list index, band and end so the search filter need not touch the list.
+ */
+#define SIX_TXEND       1                       // data bit set if point is the tx end, else rx
+#define SIX_BANDSHIFT   1                       // HamBandSetting starts here, room for HAMBAND_NONE
+#define SIX_BANDMASK    0x1F
+#define SIX_LISTSHIFT   6                       // list index starts here
+#define SIX_PACK(i,b,tx)    ((void*)(intptr_t)(((i)<<SIX_LISTSHIFT) | ((b)<<SIX_BANDSHIFT) | ((tx)?SIX_TXEND:0)))
+#define SIX_LISTI(pp)       ((int)((intptr_t)(pp)->data >> SIX_LISTSHIFT))
+#define SIX_BAND(pp)        ((int)(((intptr_t)(pp)->data >> SIX_BANDSHIFT) & SIX_BANDMASK))
+#define SIX_ISTX(pp)        (((intptr_t)(pp)->data & SIX_TXEND) != 0)
+
+/* what getClosestSpot() hands to the kd3 filter
+ */
+typedef struct {
+    const DXSpot *list;                         // spots being searched
+    SpotFilter sfp;                             // optional caller filter
+    uint32_t bands;                             // mask of HamBandSetting to consider
+    LabelOnMapEnd which_end;                    // ends to consider
+} SpotIndexFilter;
+
+/* kd3 filter for getClosestSpot()
  */
-bool getClosestSpot (DXSpot *list, int n_list, SpotFilter sfp, LabelOnMapEnd which_end,
-LatLong &from_ll, DXSpot *closest_sp, LatLong *closest_llp)
+static bool spotIndexFilter (const KD3Point *pp, void *arg)
 {
-    // linear search -- not worth kdtree etc
-    const DXSpot *min_sp = NULL;   
-    float min_d = 1e10;
-    bool min_is_de = false;         
-    for (int i = 0; i < n_list; i++) {
+    const SpotIndexFilter *fp = (const SpotIndexFilter *)arg;
 
-        DXSpot *sp = &list[i];
+    if (!(fp->bands & (1U << SIX_BAND(pp))))
+        return (false);
+    if ((fp->which_end == LOME_TXEND && !SIX_ISTX(pp)) || (fp->which_end == LOME_RXEND && SIX_ISTX(pp)))
+        return (false);
+    return (!fp->sfp || (*fp->sfp)(&fp->list[SIX_LISTI(pp)]));
+}
 
-        // skip if filtered out
-        if (sfp && !(*sfp)(sp))
-            continue;
+/* mark the given index as no longer matching its list.
+ * owners call this whenever they change, reorder or free the list; the index is rebuilt on next use.
+ */
+void resetSpotIndex (SpotIndex &si)
+{
+    si.valid = false;
+}
 
-        // check RX end if used
-        if (which_end == LOME_RXEND || which_end == LOME_BOTH) {
-            float d = sp->rx_ll.GSD(from_ll);
-            if (d < min_d) {
-                min_d = d;
-                min_sp = sp;
-                min_is_de = true;
-            }
-        }
+/* (re)build si from both ends of each spot in list.
+ */
+static void buildSpotIndex (SpotIndex &si, const DXSpot *list, int n_list)
+{
+    KD3Point *pts = allocKD3Points (si.tree, 2 * n_list);
+    for (int i = 0; i < n_list; i++) {
+        const DXSpot &sp = list[i];
+        int band = findHamBand (sp.kHz);
 
-        // check TX end if used
-        if (which_end == LOME_TXEND || which_end == LOME_BOTH) {
-            float d = sp->tx_ll.GSD(from_ll);
-            if (d < min_d) {
-                min_d = d;
-                min_sp = sp;
-                min_is_de = false;
-            }
-        }
+        KD3Point &rx = pts[2*i];
+        ll2KD3Point (sp.rx_ll, &rx);
+        rx.data = SIX_PACK (i, band, false);
+
+        KD3Point &tx = pts[2*i+1];
+        ll2KD3Point (sp.tx_ll, &tx);
+        tx.data = SIX_PACK (i, band, true);
     }
 
+    buildKD3Tree (si.tree);
+    si.valid = true;
+}
+
+/* find list element, subject to possible filtering, that is closest to ll on the given end(s).
+ * si is the caller's index of list, rebuilt here if it has been reset since its last use.
+ * bands is a mask of HamBandSetting to consider, SPOTS_ALLBANDS for all.
+ * return whether found one within MAX_CSR_DIST.
+ */
+bool getClosestSpot (SpotIndex &si, DXSpot *list, int n_list, SpotFilter sfp, uint32_t bands,
+LabelOnMapEnd which_end, LatLong &from_ll, DXSpot *closest_sp, LatLong *closest_llp)
+{
+    if (n_list <= 0)
+        return (false);
+
+    // insure index reflects list
+    if (!si.valid)
+        buildSpotIndex (si, list, n_list);
+
+    // search
+    SpotIndexFilter sif = {list, sfp, bands, which_end};
+    float min_d;
+    const KD3Point *best = nearestKD3PointFilter (si.tree, from_ll, spotIndexFilter, &sif, &min_d);
+
     // use if close enough
-    if (min_sp && min_d*ERAD_M < MAX_CSR_DIST) {
+    if (best && min_d < MAX_CSR_DIST) {
+
+        const DXSpot *min_sp = &list[SIX_LISTI(best)];
 
         // return ll depending on end
-        *closest_llp = min_is_de ? min_sp->rx_ll : min_sp->tx_ll;
+        *closest_llp = SIX_ISTX(best) ? min_sp->tx_ll : min_sp->rx_ll;
 
         // return spot
         *closest_sp = *min_sp;
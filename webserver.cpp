@@ -1620,12 +1620,37 @@ static bool getWiFiSys (WiFiClient &client, char *unused_line, size_t line_len)
         client.print (buf);
     }
 
+    // show startup phases
+    const BootPhase *phases;
+    uint32_t boot_ms;
+    bool boot_done;
+    int n_phases = getBootTrace (&phases, boot_ms, boot_done);
+    for (int i = 0; i < n_phases; i++) {
+        snprintf (buf, sizeof(buf), "Boot     %-14s %6u ms\n", phases[i].name, phases[i].ms);
+        client.print (buf);
+    }
+    snprintf (buf, sizeof(buf), "Boot     %-14s %6u ms%s\n", "total", boot_ms, boot_done ? "" : " so far");
+    client.print (buf);
+
+    // show live web encoding cost per screen change and per client request
+    LiveWebStats lws;
+    getLiveWebStats (lws);
+    uint32_t n_enc = lws.n_gens + lws.n_fulls;
+    snprintf (buf, sizeof(buf), "LiveWeb  %u updates %u images encoded, %u sent for %u requests\n",
+                lws.n_gens, lws.n_fulls, lws.n_sent, lws.n_requests);
+    client.print (buf);
+    snprintf (buf, sizeof(buf), "LiveEnc  %llu us/encode %llu us/request %llu B/request\n",
+                n_enc ? (unsigned long long)(lws.encode_us/n_enc) : 0ULL,
+                lws.n_requests ? (unsigned long long)(lws.encode_us/lws.n_requests) : 0ULL,
+                lws.n_requests ? (unsigned long long)(lws.n_bytes/lws.n_requests) : 0ULL);
+    client.print (buf);
+
     // show NTP servers
     const NTPServer *ntp_list;
     int n_ntp = getNTPServers (&ntp_list);
     for (int i = 0; i < n_ntp; i++) {
         int bl = snprintf (buf, sizeof(buf), "NTP      %s ", ntp_list[i].server);
-        int rsp = ntp_list[i].rsp_time;
+        int rsp = getNTPRspTime (i);
         if (rsp == 0)
             bl += snprintf (buf+bl, sizeof(buf)-bl, "%s\n", "- Not yet measured");
         else if (rsp == NTP_TOO_LONG)
@@ -31,6 +31,8 @@ time_t usr_datetime;
 uint16_t bc_powers[] = {1, 5, 10, 50, 100, 500, 1000};
 const int n_bc_powers = NARRAY(bc_powers);
 static const char bc_page[] = "/fetchBandConditions.pl";
+#define BC_CACHE_AGE    (12*3600L)              // max age of a cached band conditions response, secs
+#define BC_CACHE_MINSZ  100                     // min believable size of same
 static time_t bc_time;                          // nowWO() when bc_matrix was loaded
 BandCdtnMatrix bc_matrix;                       // percentage reliability for each band
 uint16_t bc_power;                              // VOACAP power setting
@@ -71,18 +73,6 @@ static const char locip_page[] = "/fetchIPGeoloc.pl";
 #define MOON_INTERVAL   50                      // annotation update interval, secs
 
 
-// list of default NTP servers unless user has set their own
-static NTPServer ntp_list[] = {                 // init times to 0 insures all get tried initially
-    {"time.google.com",     NTP_TOO_LONG},
-    {"time.apple.com",      NTP_TOO_LONG},
-    {"pool.ntp.org",        NTP_TOO_LONG},
-    {"europe.pool.ntp.org", NTP_TOO_LONG},
-    {"asia.pool.ntp.org",   NTP_TOO_LONG},
-    {"time.nist.gov",       NTP_TOO_LONG},
-};
-#define N_NTP NARRAY(ntp_list)                  // number of possible servers
-
-
 // web site retry interval and max, secs
 #define WIFI_RETRY      (15)
 #define WIFI_MAXRETRY   (5*60)
@@ -98,6 +88,7 @@ static PlotPane revert_pane;                    // which pane is being temporari
  */
 static time_t next_rotation[PANE_N];            // next pane rotation
 time_t next_update[PANE_N];                     // next function call
+bool pane_drawn[PANE_N];                        // set once each pane's update has been called, never reset
 static time_t next_map;                         // next map check
 static time_t map_time;                         // nowWO() when map was loaded
 static bool fresh_redraw[PLOT_CH_N];            // whether full pane redraw is required
@@ -289,44 +280,6 @@ out:
     iploc_client.stop();
 }
 
-/* return best ntp server.
- * if user has set their own then always return that one;
- * else search ntp_list for the fastest so far, if all look bad then just roll through.
- * N.B. never return NULL
- */
-NTPServer *findBestNTP()
-{
-    static NTPServer user_server;
-    static uint8_t prev_fixed;
-
-    // user's first
-    if (useLocalNTPHost()) {
-        user_server.server = getLocalNTPHost();
-        return (&user_server);
-    }
-
-    // else look through ntp_list
-    NTPServer *best_ntp = &ntp_list[0];
-    int rsp_min = ntp_list[0].rsp_time;
-
-    for (int i = 1; i < N_NTP; i++) {
-        NTPServer *np = &ntp_list[i];
-        if (np->rsp_time < rsp_min) {
-            best_ntp = np;
-            rsp_min = np->rsp_time;
-        }
-    }
-
-    // if nothing good there just roll through
-    if (rsp_min == NTP_TOO_LONG) {
-        prev_fixed = (prev_fixed+1) % N_NTP;
-        best_ntp = &ntp_list[prev_fixed];
-    }
-
-    return (best_ntp);
-}
-
-
 /* init and connect, inform via tftMsg() if verbose.
  * non-verbose is used for automatic retries that should not clobber the display.
  */
@@ -419,16 +372,19 @@ void initSys()
 
 
     // insure core_map is defined -- N.B. before initWiFi calls sendUserAgent()
+    bootPhase ("network");
     initCoreMaps();
 
     // start/check WLAN
     initWiFi(true);
 
     // start web servers
+    bootPhase ("web servers");
     initWebServer();
     initLiveWeb(true);
 
     // init location if desired
+    bootPhase ("location");
     if (useGeoIP() || init_iploc || init_locip) {
         if (WiFi.status() == WL_CONNECTED)
             geolocateIP (init_locip);
@@ -488,6 +444,7 @@ void initSys()
 
 
     // init time service as desired
+    bootPhase ("time");
     if (useGPSDTime()) {
         if (getGPSDUTC())
             tftMsg (true, 0, "GPSD: time ok");
@@ -505,56 +462,62 @@ void initSys()
 
     } else if (WiFi.status() == WL_CONNECTED) {
 
-        if (useLocalNTPHost()) {
-
-            // test user choice
-            NTPServer *user_ntp = findBestNTP();        // will always return user's ntp
-            if (getNTPUTC(user_ntp))
-                tftMsg (true, 0, "NTP %s: %d ms\r", user_ntp->server, user_ntp->rsp_time);
-            else
-                tftMsg (true, 0, "NTP %s: fail\r", user_ntp->server);
-
-        } else {
-
-            // try all the NTP servers to find the fastest (with sneaky way out)
-            SCoord s;
-            drainTouch();
-            tftMsg (true, 0, "Finding best NTP ...");
-            NTPServer *best_ntp = NULL;
-            for (int i = 0; i < N_NTP; i++) {
-                NTPServer *np = &ntp_list[i];
-
-                // measure the next. N.B. assumes we stay in sync
-                if (getNTPUTC(np) == 0)
+        // probe all NTP servers at once, showing each as it answers (with sneaky way out)
+        SCoord s;
+        drainTouch();
+        tftMsg (true, 0, useLocalNTPHost() ? "Checking NTP ..." : "Finding best NTP ...");
+        startNTP();
+        const NTPServer *ntp_list;
+        int n_ntp = getNTPServers (&ntp_list);
+        uint32_t shown = 0;                             // bit mask of ntp_list entries already shown
+        uint32_t all_shown = (1UL << n_ntp) - 1;
+        const NTPServer *best_ntp = NULL;
+        int best_rsp = 0;
+        uint32_t t0 = millis();
+        while (shown != all_shown && !timesUp (&t0, NTP_TOO_LONG + 1000)) {
+
+            // show each as its first result comes in
+            for (int i = 0; i < n_ntp; i++) {
+                const NTPServer *np = &ntp_list[i];
+                int rsp = getNTPRspTime (i);
+                if ((shown & (1UL << i)) || rsp == 0)
+                    continue;
+                shown |= 1UL << i;
+                if (rsp == (int)NTP_TOO_LONG)
                     tftMsg (true, 0, "%s: err\r", np->server);
                 else {
-                    tftMsg (true, 0, "%s: %d ms\r", np->server, np->rsp_time);
-                    if (!best_ntp || np->rsp_time < best_ntp->rsp_time)
+                    tftMsg (true, 0, "%s: %d ms\r", np->server, rsp);
+                    if (!best_ntp || rsp < best_rsp) {
                         best_ntp = np;
+                        best_rsp = rsp;
+                    }
                 }
+            }
 
-                // cancel scan if found at least one good and tapped or typed
-                TouchType tt = TT_NONE;
-                if (best_ntp && (skip_skip || tft.getChar(NULL,NULL)
-                                   || ((tt = readCalTouchWS(s)) != TT_NONE && inBox (s, skip_b)))) {
-                    if (tt == TT_TAP_BX)
-                        tooltip (s, skip_ttt);
-                    else {
-                        drawStringInBox ("Skip", skip_b, true, RA8875_WHITE);
-                        Serial.printf ("NTP search cancelled with %s\n", best_ntp->server);
-                        skipped_here = true;
-                        break;
-                    }
+            // cancel wait if found at least one good and tapped or typed
+            TouchType tt = TT_NONE;
+            if (best_ntp && (skip_skip || tft.getChar(NULL,NULL)
+                               || ((tt = readCalTouchWS(s)) != TT_NONE && inBox (s, skip_b)))) {
+                if (tt == TT_TAP_BX)
+                    tooltip (s, skip_ttt);
+                else {
+                    drawStringInBox ("Skip", skip_b, true, RA8875_WHITE);
+                    Serial.printf ("NTP search cancelled with %s\n", best_ntp->server);
+                    skipped_here = true;
+                    break;
                 }
             }
-            if (!skip_skip)
-                wdDelay(800); // linger to show last time
-            if (best_ntp)
-                tftMsg (true, 0, "Best NTP: %s %d ms\r", best_ntp->server, best_ntp->rsp_time);
-            else
-                tftMsg (true, 0, "No NTP\r");
-            drainTouch();
+
+            wdDelay(50);
         }
+        if (!skip_skip && n_ntp > 1)
+            wdDelay(800); // linger to show last time
+        if (best_ntp)
+            tftMsg (true, 0, "%s NTP: %s %d ms\r", n_ntp > 1 ? "Best" : "Using", best_ntp->server,
+                                best_rsp);
+        else
+            tftMsg (true, 0, "No NTP\r");
+        drainTouch();
         tftMsg (true, 0, NULL);   // next row
 
     } else {
@@ -589,9 +552,14 @@ void initSys()
     }
 
     // init space wx
+    bootPhase ("space wx");
     initSpaceWX();
 
+    // start fetching the first screen's data meanwhile
+    startWarmUp();
+
     // offer time to peruse unless alreay opted to skip
+    bootPhase ("ready wait");
     if (!skipped_here) {
         #define     TO_DS 50                                // timeout delay, decaseconds
         drawStringInBox ("Skip", skip_b, false, RA8875_WHITE);
@@ -769,6 +737,29 @@ char *xrayLevel (char *buf, const SpaceWeather_t &xray)
 }
 
 
+/* build the band conditions query for the current circumstances and the name of its local cache file.
+ */
+static void mkBCQuery (char *query, size_t q_len, char *cache_fn, size_t c_len)
+{
+    time_t t = nowWO();
+    snprintf (query, q_len,
+        "%s?YEAR=%d&MONTH=%d&RXLAT=%.3f&RXLNG=%.3f&TXLAT=%.3f&TXLNG=%.3f&UTC=%d&PATH=%d&POW=%d&MODE=%d&TOA=%.1f",
+        bc_page, year(t), month(t), dx_ll.lat_d, dx_ll.lng_d, de_ll.lat_d, de_ll.lng_d,
+        hour(t), show_lp, bc_power, bc_modevalue, bc_toa);
+
+    snprintf (cache_fn, c_len, "bc-%010u.txt", stringHash(query)); // N.B. see cleanCache() below
+}
+
+/* start the band conditions download in the background if not already cached, return at once.
+ */
+void prefetchBandConditions (void)
+{
+    char query[sizeof(bc_page) + 200];
+    char cache_fn[100];
+    mkBCQuery (query, sizeof(query), cache_fn, sizeof(cache_fn));
+    prefetchCachedFile (cache_fn, query, BC_CACHE_AGE, BC_CACHE_MINSZ);
+}
+
 /* retrieve bc_matrix and optional config line underneath PLOT_CH_BC.
  * return whether at least config line was received (even if data was not)
  */
@@ -781,23 +772,16 @@ static bool retrieveBandConditions (char *config)
     bc_matrix.ok = false;
 
     // start by cleaning cache.
-    // N.B. make sure search string match name we use below
+    // N.B. make sure search string match name in mkBCQuery()
     (void) cleanCache ("bc-", BC_INTERVAL);
 
-    // build query
-    time_t t = nowWO();
+    // build query and local cache file name
     char query[sizeof(bc_page) + 200];
-    snprintf (query, sizeof(query),
-        "%s?YEAR=%d&MONTH=%d&RXLAT=%.3f&RXLNG=%.3f&TXLAT=%.3f&TXLNG=%.3f&UTC=%d&PATH=%d&POW=%d&MODE=%d&TOA=%.1f",
-        bc_page, year(t), month(t), dx_ll.lat_d, dx_ll.lng_d, de_ll.lat_d, de_ll.lng_d,
-        hour(t), show_lp, bc_power, bc_modevalue, bc_toa);
-
-    // build local cache file name
     char cache_fn[100];
-    snprintf (cache_fn, sizeof(cache_fn), "bc-%010u.txt", stringHash(query)); // N.B. see cleanCache() above
+    mkBCQuery (query, sizeof(query), cache_fn, sizeof(cache_fn));
 
     // open cache or get fresh
-    FILE *fp = openCachedFile (cache_fn, query, 12*3600L, 100);
+    FILE *fp = openCachedFile (cache_fn, query, BC_CACHE_AGE, BC_CACHE_MINSZ);
     if (fp) {
 
         char buf[100];
@@ -873,23 +857,6 @@ out:
     return (ok);
 }
 
-/* convert an array of 4 big-endian network-order bytes into a uint32_t
- */
-static uint32_t crackBE32 (uint8_t bp[])
-{
-    union {
-        uint32_t be;
-        uint8_t ba[4];
-    } be4;
-
-    be4.ba[3] = bp[0];
-    be4.ba[2] = bp[1];
-    be4.ba[1] = bp[2];
-    be4.ba[0] = bp[3];
-
-    return (be4.be);
-}
-
 /* keep the NCDXF_b up to date.
  * N.B. this is called often so do minimal work.
  */
@@ -1051,112 +1018,6 @@ bool setPlotChoice (PlotPane pp, PlotChoice pc)
 }
 
 
-/* NTP time server query.
- * returns UNIX time if ok, or 0 if trouble.
- * for good NTP packet description try
- *   http://www.cisco.com
- *      /c/en/us/about/press/internet-protocol-journal/back-issues/table-contents-58/154-ntp.html
- */
-time_t getNTPUTC (NTPServer *ntp)
-{
-    // NTP contents packet
-    static const uint8_t timeReqA[] = { 0xE3, 0x00, 0x06, 0xEC };
-    static const uint8_t timeReqB[] = { 0x31, 0x4E, 0x31, 0x34 };
-
-    // create udp endpoint
-    WiFiUDP ntp_udp;
-    if (!ntp_udp.begin(1000+random(50000))) {                   // any local port
-        Serial.println ("NTP: UDP startup failed");
-        return (0);
-    }
-
-    // NTP buffer and timers
-    uint8_t  buf[48];
-    uint32_t tx_ms, rx_ms;
-
-    // Assemble request packet
-    memset(buf, 0, sizeof(buf));
-    memcpy(buf, timeReqA, sizeof(timeReqA));
-    memcpy(&buf[12], timeReqB, sizeof(timeReqB));
-
-    // send
-    Serial.printf("NTP: Issuing request to %s\n", ntp->server);
-    ntp_udp.beginPacket (ntp->server, 123);                     // NTP uses port 123
-    ntp_udp.write(buf, sizeof(buf));
-    tx_ms = millis();                                           // record when packet sent
-    if (!ntp_udp.endPacket()) {
-        Serial.println ("NTP: UDP write failed");
-        ntp->rsp_time = NTP_TOO_LONG;                           // force different choice next time
-        ntp_udp.stop();
-        return (0UL);
-    }
-    // Serial.print ("NTP: Sent 48 ... ");
-
-    // receive response
-    // Serial.print("NTP: Awaiting response ... ");
-    memset(buf, 0, sizeof(buf));
-    uint32_t t0 = millis();
-    while (ntp_udp.parsePacket() == 0) {
-        if (timesUp (&t0, NTP_TOO_LONG)) {
-            Serial.println("NTP: UDP timed out");
-            ntp->rsp_time = NTP_TOO_LONG;                       // force different choice next time
-            ntp_udp.stop();
-            return (0UL);
-        }
-        wdDelay(10);
-    }
-    rx_ms = millis();                                           // record when packet arrived
-
-    // record response time
-    ntp->rsp_time = rx_ms - tx_ms;
-    // Serial.printf ("NTP: %s replied after %d ms\n", ntp->server, ntp->rsp_time);
-
-    // read response
-    if (ntp_udp.read (buf, sizeof(buf)) != sizeof(buf)) {
-        Serial.println ("NTP: UDP read failed");
-        ntp->rsp_time = NTP_TOO_LONG;                           // force different choice next time
-        ntp_udp.stop();
-        return (0UL);
-    }
-
-    // only accept server responses which are mode 4
-    uint8_t mode = buf[0] & 0x7;
-    if (mode != 4) {                                            // insure server packet
-        Serial.printf ("NTP: RX mode must be 4 but it is %d\n", mode);
-        ntp_udp.stop();
-        return (0UL);
-    }
-
-    // crack and advance to next whole second
-    time_t unix_s = crackBE32 (&buf[40]) - 2208988800UL;        // packet transmit time - (1970 - 1900)
-    if ((uint32_t)unix_s > 0x7FFFFFFFUL) {                      // sanity check beyond unsigned value
-        Serial.printf ("NTP: crazy large UNIX time: %ld\n", (long)unix_s);
-        ntp_udp.stop();
-        return (0UL);
-    }
-    uint32_t fraction_more = crackBE32 (&buf[44]);              // x / 10^32 additional second
-    uint16_t ms_more = 1000UL*(fraction_more>>22)/1024UL;       // 10 MSB to ms
-    uint16_t transit_time = (rx_ms - tx_ms)/2;                  // transit = half the round-trip time
-    ms_more += transit_time;                                    // with transit now = unix_s + ms_more
-    uint16_t sec_more = ms_more/1000U+1U;                       // whole seconds behind rounded up
-    wdDelay (sec_more*1000U - ms_more);                         // wait to next whole second
-    unix_s += sec_more;                                         // account for delay
-    // Serial.print ("NTP: Fraction "); Serial.print(ms_more);
-    // Serial.print (", transit "); Serial.print(transit_time);
-    // Serial.print (", seconds "); Serial.print(sec_more);
-    // Serial.print (", UNIX "); Serial.print (unix_s); Serial.println();
-
-    // one more sanity check
-    if (unix_s < 1577836800L) {          // Jan 1 2020
-        Serial.printf ("NTP: crazy small UNIX time: %ld\n", (long)unix_s);
-        ntp_udp.stop();
-        return (0UL);
-    }
-
-    ntp_udp.stop();
-    return (unix_s);
-}
-
 /* read next char from client, waiting a short while if necessary.
  * return whether another character was in fact available.
  */
@@ -1169,17 +1030,15 @@ bool getTCPChar (WiFiClient &client, char *cp)
     return (true);
 }
 
-/* send User-Agent to client
+/* format the complete User-Agent header line into ua[].
  */
-void sendUserAgent (WiFiClient &client)
+static void formatUserAgent (char ua[], size_t ua_len)
 {
     // don't send full list until first time main page is up to insure all subsystems are up.
     static bool ready;
     if (mainpage_up)
         ready = true;
 
-    char ua[400];
-
     if (logUsageOk() && ready) {
 
         // display mode: 0=X11 1=fb0 2=X11full 3=X11+live 4=X11full+live 5=noX
@@ -1361,7 +1220,7 @@ void sendUserAgent (WiFiClient &client)
         (void) autoUpgrade (aup_hr);
 
 
-        snprintf (ua, sizeof(ua),
+        snprintf (ua, ua_len,
             "User-Agent: %s/%s (id %u up %lld) crc %d "
                 "LV7 %s %d %d %d %d %d %d %d %d %d %d %d %d %d %.2f %.2f %d %d %d %d "
                 "%d %d %d %d %d %d %d %d %d %d %d %d "
@@ -1392,13 +1251,18 @@ void sendUserAgent (WiFiClient &client)
             aup_hr, 0);
 
     } else {
-        snprintf (ua, sizeof(ua), "User-Agent: %s/%s (id %u up %lld) crc %d\r\n",
+        snprintf (ua, ua_len, "User-Agent: %s/%s (id %u up %lld) crc %d\r\n",
             platform, hc_version, ESP.getChipId(), (long long)getUptime(NULL,NULL,NULL,NULL), flash_crc_ok);
     }
+}
 
-    // send
+/* send User-Agent to client
+ */
+void sendUserAgent (WiFiClient &client)
+{
+    char ua[400];
+    formatUserAgent (ua, sizeof(ua));
     client.print(ua);
-
 }
 
 /* issue an HTTP Get for an arbitary page
@@ -1422,6 +1286,22 @@ void httpHCGET (WiFiClient &client, const char *server, const char *hc_page)
     httpGET (client, server, full_hc_page);
 }
 
+/* start fetching a /ham/HamClock page from the backend in the background, see fetch.cpp.
+ * return fetch id, or 0 if can not start.
+ */
+int startHCFetch (const char *hc_page)
+{
+    char ua[400];
+    formatUserAgent (ua, sizeof(ua));
+
+    static const char hc[] = "/ham/HamClock";
+    StackMalloc req_mem(strlen(hc_page) + strlen(backend_host) + strlen(ua) + sizeof(hc) + 100);
+    char *req = (char *) req_mem.getMem();
+    snprintf (req, req_mem.getSize(), "GET %s%s HTTP/1.0\r\nHost: %s\r\n%sConnection: close\r\n\r\n",
+                        hc, hc_page, backend_host, ua);
+    return (startFetch (backend_host, backend_port, req));
+}
+
 /* skip the given wifi client stream ahead to just after the first blank line, return whether ok.
  * this is often used so subsequent stop() on client doesn't slam door in client's face with RST.
  * Along the way, if find a header field with the given name (unless NULL) return value in the given string.
@@ -2320,6 +2200,9 @@ void updateWiFi(void)
             break;              // lint
         }
 
+        // first screen is complete once every pane has had a turn, see checkBootDone()
+        pane_drawn[pp] = true;
+
     }
 
     // freshen NCDXF_b
@@ -2328,6 +2211,9 @@ void updateWiFi(void)
     // freshen RSS
     checkRSS();
 
+    // install any cache files fetched ahead of need
+    checkCachePrefetches();
+
     // maps are checked after each full earth draw -- see drawMoreEarth()
 
     // check for server commands
@@ -2340,25 +2226,27 @@ void updateWiFi(void)
  */
 bool getTCPLine (WiFiClient &client, char line[], uint16_t line_len, uint16_t *ll)
 {
-    // decrement available length so there's always room to add '\0'
-    line_len -= 1;
+    // get next line in place
+    char *span;
+    int span_len;
+    if (!client.readLine (&span, &span_len))
+        return (false);
 
+    // copy, removing any stray \r, leaving room for '\0'
     uint16_t i = 0;
-    while (true) {
-        char c;
-        if (!getTCPChar (client, &c))
-            return (false);
-        if (c == '\r')
-            continue;
-        if (c == '\n') {
-            line[i] = '\0';
-            if (ll)
-                *ll = i;
-            // Serial.println(line);
-            return (true);
-        } else if (i < line_len)
-            line[i++] = c;
+    line_len -= 1;
+    if (!memchr (span, '\r', span_len)) {
+        i = span_len < line_len ? span_len : line_len;
+        memcpy (line, span, i);
+    } else {
+        for (int j = 0; j < span_len && i < line_len; j++)
+            if (span[j] != '\r')
+                line[i++] = span[j];
     }
+    line[i] = '\0';
+    if (ll)
+        *ll = i;
+    return (true);
 }
 
 /* arrange for everything to update immediately
@@ -2473,15 +2361,6 @@ void scheduleFreshMap (void)
     next_map = 0;
 }
 
-/* return current NTP response time list.
- * N.B. this is the real data, caller must not modify.
- */
-int getNTPServers (const NTPServer **listp)
-{
-    *listp = ntp_list;
-    return (N_NTP);
-}
-
 /* return when the given pane will next update.
  */
 time_t nextPaneRotation(PlotPane pp)
@@ -24,6 +24,16 @@ typedef struct {
     SBox bound_b[2];                    // app screen coord bounding box, [1].x != only if required
 } ZonePoly;     
                 
+/* raster of zone numbers covering map_b in app coords, rebuilt by updateZoneSCoords().
+ * each cell holds the first zone whose polygon contains it, else 0, so findZoneNumber() is one array read.
+ */
+typedef struct {
+    uint8_t *cells;                     // malloced b.w * b.h, row major
+    SBox b;                             // map_b when built
+} ZoneGrid;
+
+static ZoneGrid zone_grids[2];          // indexed by ZoneID
+
 #define LATC2DEG(l)     ((l) * 0.01F)   // ZoneVertex latitude compressed to degrees    
 #define LNGC2DEG(l)     ((l) * 0.01F)   // ZoneVertex longitude compressed to degrees   
                     
@@ -27899,32 +27909,92 @@ static ZonePoly ituzones[] = {
  */
 
 
-/* return 1 if s lies within poly subpoly i, else 0
+/* mark each cell of zg within poly subpoly i and its bounding box that is not already claimed by an earlier
+ * zone. this gives the same answer as testing each cell with pnpoly but one row at a time: sort the x
+ * crossings of the row and count how many lie to the right of each cell.
  * N.B. derived from Franklin, see above (c)
  */
-static int pnpoly (int npoly, ZoneVertex *poly, int poly_i, const SCoord &s)
+static void rasterZonePoly (ZoneGrid &zg, const ZonePoly *zp, int poly_i)
 {
-    int i, j, c = 0;
+    const SBox &bb = zp->bound_b[poly_i];
+    if (bb.w == 0 || bb.h == 0)
+        return;
 
     // collect just poly_i into si as canonical coords
+    int npoly = zp->n_verts;
     StackMalloc si_mem(npoly*sizeof(SCoord));
     SCoord *si = (SCoord *) si_mem.getMem();
     int nsi = 0;
-    for (i = 0; i < npoly; i++) {
-        if (poly[i].s[poly_i].x) {
+    for (int i = 0; i < npoly; i++) {
+        const SCoord &vs = zp->verts[i].s[poly_i];
+        if (vs.x) {
             SCoord &s = si[nsi++];
-            s.x = poly[i].s[poly_i].x/tft.SCALESZ;
-            s.y = poly[i].s[poly_i].y/tft.SCALESZ;
+            s.x = vs.x/tft.SCALESZ;
+            s.y = vs.y/tft.SCALESZ;
+        }
+    }
+
+    // room for every possible crossing of one row
+    StackMalloc xs_mem(nsi*sizeof(float));
+    float *xs = (float *) xs_mem.getMem();
+
+    // scan each row of bb that lies within the grid
+    int y0 = bb.y > zg.b.y ? bb.y : zg.b.y;
+    int y1 = bb.y + bb.h < zg.b.y + zg.b.h ? bb.y + bb.h : zg.b.y + zg.b.h;
+    int x0 = bb.x > zg.b.x ? bb.x : zg.b.x;
+    int x1 = bb.x + bb.w < zg.b.x + zg.b.w ? bb.x + bb.w : zg.b.x + zg.b.w;
+    for (int y = y0; y < y1; y++) {
+
+        // find where each edge crosses this row, same arithmetic as pnpoly
+        SCoord s;
+        s.y = y;
+        int n_xs = 0;
+        for (int i = 0, j = nsi-1; i < nsi; j = i++) {
+            if ((si[i].y>s.y) != (si[j].y>s.y)) {
+                float x = ((float)si[j].x-si[i].x) * (s.y-si[i].y) / (si[j].y-si[i].y) + si[i].x;
+                int k = n_xs++;
+                while (k > 0 && xs[k-1] > x) {
+                    xs[k] = xs[k-1];
+                    k--;
+                }
+                xs[k] = x;
+            }
+        }
+        if (n_xs == 0)
+            continue;
+
+        // cell is inside if an odd number of crossings lie to its right
+        uint8_t *row = &zg.cells[(y - zg.b.y)*zg.b.w];
+        int k = 0;
+        for (int x = x0; x < x1; x++) {
+            while (k < n_xs && !(x < xs[k]))
+                k++;
+            if (k == n_xs)
+                break;
+            if (((n_xs - k) & 1) && row[x - zg.b.x] == 0)
+                row[x - zg.b.x] = zp->zone_n;
         }
     }
+}
 
-    // check bounds
-    for (i = 0, j = nsi-1; i < nsi; j = i++) {
-        if ( ((si[i].y>s.y) != (si[j].y>s.y)) &&
-            (s.x < ((float)si[j].x-si[i].x) * (s.y-si[i].y) / (si[j].y-si[i].y) + si[i].x) )
-          c = !c;
+/* rebuild zone_grids[id] from the current polygon screen coords.
+ */
+static void buildZoneGrid (ZoneID id, const ZonePoly *zpoly, int n_z)
+{
+    ZoneGrid &zg = zone_grids[id];
+
+    // (re)size for map_b
+    zg.b = map_b;
+    zg.cells = (uint8_t *) realloc (zg.cells, zg.b.w * zg.b.h);
+    if (!zg.cells)
+        fatalError ("No memory for %d x %d zone grid", zg.b.w, zg.b.h);
+    memset (zg.cells, 0, zg.b.w * zg.b.h);
+
+    // paint in the same order findZoneNumber() used to check them so the first one still wins
+    for (const ZonePoly *zp = zpoly; zp < &zpoly[n_z]; zp++) {
+        rasterZonePoly (zg, zp, 0);
+        rasterZonePoly (zg, zp, 1);
     }
-    return c;
 }
 
 
@@ -27932,7 +28002,7 @@ static int pnpoly (int npoly, ZoneVertex *poly, int poly_i, const SCoord &s)
 
 
 /* go through all of the specified zone polygons and update their bounding boxes and vertex screen
- * coordinates. this is in prep for fast calls to findZoneNumber()
+ * coordinates, then rasterize them in prep for fast calls to findZoneNumber()
  */
 void updateZoneSCoords (ZoneID id)
 {
@@ -28105,6 +28175,9 @@ void updateZoneSCoords (ZoneID id)
         }
     }
 
+    // raster for findZoneNumber()
+    buildZoneGrid (id, zpoly, n_z);
+
     // #define _PRINT_ZONES
     #ifdef _PRINT_ZONES
     for (ZonePoly *zp = zpoly; zp < end_zp; zp++) {
@@ -28149,23 +28222,21 @@ bool findZoneNumber (ZoneID id, const SCoord &s, int *zone_n)
         }
     }
 
-    // scan each polygon, fast check with bb then confirm within.
-    // if none, still find closest label
+    // look up in raster
+    const ZoneGrid &zg = zone_grids[id];
+    if (zg.cells && inBox (s, zg.b)) {
+        int zn = zg.cells[(s.y - zg.b.y)*zg.b.w + (s.x - zg.b.x)];
+        if (zn) {
+            *zone_n = zn;
+            return (true);
+        }
+    }
+
+    // not within any polygon so find closest label
     int closest_n = -1;
     int closest_r = 50000;
     const ZonePoly *end_zp = &zpoly[n_z];
     for (const ZonePoly *zp = zpoly; zp < end_zp; zp++) {
-
-        if (inBox (s, zp->bound_b[0]) && pnpoly (zp->n_verts, zp->verts, 0, s)) {
-            *zone_n = zp->zone_n;
-            return (true);
-        }
-
-        if (inBox (s, zp->bound_b[1]) && pnpoly (zp->n_verts, zp->verts, 1, s)) {
-            *zone_n = zp->zone_n;
-            return (true);
-        }
-
         int r = abs((int)zp->s_lbl.x - (int)s.x) + abs((int)zp->s_lbl.y - (int)s.y);
         if (r < closest_r) {
             closest_r = r;